@@ -0,0 +1,77 @@
+package dev.deviceai.core
+
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.CompletableDeferred
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.IO
+import kotlinx.coroutines.NonCancellable
+import kotlinx.coroutines.SupervisorJob
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.flow.update
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+
+/**
+ * Suspends callers on native jobs without holding a thread per request.
+ * A single coroutine drains the native completion channel ([awaitNative]
+ * returns finished job ids, or null on timeout) and resumes whoever waits
+ * on each id. Used by the LLM and speech platform bridges, each creating one
+ * lazily over its own native channel.
+ */
+class JobCompletions(private val awaitNative: (timeoutMs: Int) -> LongArray?) {
+
+    private val lock = Mutex()
+    private val waiters = HashMap<Long, CompletableDeferred<Unit>>()
+
+    // Completions so far; a submit refused for a full queue retries when it moves.
+    private val freed = MutableStateFlow(0L)
+
+    init {
+        CoroutineScope(SupervisorJob() + Dispatchers.IO).launch {
+            while (true) {
+                val ids = awaitNative(POLL_MILLIS) ?: continue
+                lock.withLock { ids.forEach { waiters.remove(it)?.complete(Unit) } }
+                freed.update { it + ids.size }
+            }
+        }
+    }
+
+    /**
+     * Submit a job and suspend until it finishes. [submit] returns the job id,
+     * 0 when the native queue is full — retried after the next completion — or
+     * a negative value on failure. Cancelling the caller cancels the job
+     * through [cancel], which should discard its result.
+     *
+     * @return The finished job's id, or the negative failure value
+     */
+    suspend fun run(submit: () -> Long, cancel: (Long) -> Unit): Long {
+        val done = CompletableDeferred<Unit>()
+        var id: Long
+        while (true) {
+            val seen = freed.value
+            // Registered under the lock, so the poller cannot see the id first.
+            id = lock.withLock { submit().also { if (it > 0) waiters[it] = done } }
+            if (id != 0L) break
+            freed.first { it != seen }
+        }
+        if (id < 0) return id
+
+        try {
+            done.await()
+        } catch (e: CancellationException) {
+            withContext(NonCancellable) { lock.withLock { waiters.remove(id) } }
+            cancel(id)
+            freed.update { it + 1 }
+            throw e
+        }
+        return id
+    }
+
+    private companion object {
+        const val POLL_MILLIS = 1000
+    }
+}
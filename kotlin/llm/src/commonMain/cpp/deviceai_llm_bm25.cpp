@@ -0,0 +1,828 @@
+/**
+ * deviceai_llm_bm25.cpp - Native BM25 inverted index for keyword RAG
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_bm25.h"
+#include "deviceai_llm_mmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmBm25"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+static const size_t   MIN_TERM_CHARS = 3;      // same as BM25RagStore
+static const uint32_t SKIP_INTERVAL  = 128;    // postings per skip entry
+static const uint32_t NO_DOC         = UINT32_MAX;
+
+static const char     FILE_MAGIC[8]  = {'D', 'A', 'I', 'B', 'M', '2', '5', '\0'};
+static const uint32_t FILE_VERSION   = 1;
+
+// ═══════════════════════════════════════════════════════════════
+//                           State
+// ═══════════════════════════════════════════════════════════════
+
+namespace {
+
+// Start of a block of SKIP_INTERVAL postings: the document number before
+// it (the delta base; NO_DOC for the first block) and its byte offset.
+struct skip_entry {
+    uint32_t base;
+    uint32_t offset;
+};
+
+struct term_postings {
+    std::vector<uint8_t>    bytes;            // varint (doc delta, tf) pairs
+    std::vector<skip_entry> skips;
+    uint32_t                n      = 0;       // postings, including dead documents
+    uint32_t                last   = NO_DOC;
+    uint32_t                df     = 0;       // live documents containing the term
+    uint32_t                max_tf = 0;       // bounds for MaxScore; only loosen
+    uint32_t                min_dl = NO_DOC;  // as documents are removed
+};
+
+struct doc_entry {
+    int64_t     id = 0;
+    std::string text;
+    std::string source;
+    bool        has_source = false;
+    uint32_t    length     = 0;   // terms
+    bool        live       = true;
+};
+
+// ── On-disk layout (native endianness, 8-byte aligned sections) ──
+
+struct file_header {
+    char     magic[8];
+    uint32_t version;
+    float    k1;
+    float    b;
+    uint32_t n_docs;
+    uint32_t n_terms;
+    uint32_t reserved;
+    uint64_t total_length;
+    int64_t  next_id;
+    uint64_t docs_off;
+    uint64_t terms_off;
+    uint64_t skips_off;
+    uint64_t postings_off;
+    uint64_t strings_off;
+    uint64_t file_size;
+};
+
+struct file_doc {
+    int64_t  id;
+    uint64_t text_off;
+    uint64_t source_off;
+    uint32_t text_len;
+    uint32_t source_len;
+    uint32_t length;
+    uint32_t has_source;
+};
+
+// Sorted by name for binary search.
+struct file_term {
+    uint64_t name_off;
+    uint64_t postings_off;
+    uint64_t postings_len;
+    uint64_t skips_off;       // index into the skip section
+    uint32_t name_len;
+    uint32_t n;
+    uint32_t n_skips;
+    uint32_t df;
+    uint32_t max_tf;
+    uint32_t min_dl;
+};
+
+struct posting_view {
+    const uint8_t    *bytes   = nullptr;
+    size_t            size    = 0;
+    const skip_entry *skips   = nullptr;
+    uint32_t          n_skips = 0;
+    uint32_t          n       = 0;
+    uint32_t          limit   = NO_DOC;   // document numbers at or above are corrupt
+};
+
+struct term_view {
+    uint32_t     df     = 0;
+    uint32_t     max_tf = 0;
+    uint32_t     min_dl = 0;
+    posting_view postings;
+};
+
+} // namespace
+
+struct dai_llm_bm25 {
+    std::shared_mutex mutex;
+    float             k1 = 1.5f;
+    float             b  = 0.75f;
+
+    uint32_t n_live       = 0;
+    uint64_t total_length = 0;   // terms over live documents
+    int64_t  next_id      = 0;
+
+    // In memory (created, or loaded and then modified)
+    std::vector<doc_entry>                         docs;
+    std::unordered_map<std::string, term_postings> terms;
+    std::unordered_map<int64_t, uint32_t>          by_id;
+    uint32_t                                       n_dead = 0;
+
+    // Memory-mapped (loaded and not modified since)
+    const uint8_t    *map      = nullptr;
+    size_t            map_size = 0;
+    const file_doc   *fdocs    = nullptr;
+    const file_term  *fterms   = nullptr;
+    const skip_entry *fskips   = nullptr;
+    uint32_t          n_fdocs  = 0;
+    uint32_t          n_fterms = 0;
+};
+
+// ═══════════════════════════════════════════════════════════════
+//                       Terms and postings
+// ═══════════════════════════════════════════════════════════════
+
+template <class F>
+static void for_each_term(const std::string &text, F &&f) {
+    std::string term;
+    for (char ch : text) {
+        unsigned char c = (unsigned char)ch;
+        if (c >= 'A' && c <= 'Z') c = (unsigned char)(c - 'A' + 'a');
+        if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9')) {
+            term += (char)c;
+            continue;
+        }
+        if (term.size() >= MIN_TERM_CHARS) f(term);
+        term.clear();
+    }
+    if (term.size() >= MIN_TERM_CHARS) f(term);
+}
+
+static std::unordered_map<std::string, uint32_t> term_counts(const std::string &text, uint32_t &n_terms) {
+    std::unordered_map<std::string, uint32_t> counts;
+    n_terms = 0;
+    for_each_term(text, [&](const std::string &t) {
+        counts[t]++;
+        n_terms++;
+    });
+    return counts;
+}
+
+static void put_varint(std::vector<uint8_t> &out, uint32_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+// Bounds-checked: a truncated or corrupt list reads as ended.
+static bool get_varint(const uint8_t *p, size_t size, size_t &pos, uint32_t &v) {
+    v = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= size) return false;
+        const uint8_t byte = p[pos++];
+        v |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static void append_posting(term_postings &t, uint32_t doc, uint32_t tf, uint32_t dl) {
+    if (t.n % SKIP_INTERVAL == 0) t.skips.push_back({t.last, (uint32_t)t.bytes.size()});
+    put_varint(t.bytes, doc - t.last);   // wraps for the first posting (last = NO_DOC)
+    put_varint(t.bytes, tf);
+    t.last   = doc;
+    t.n++;
+    t.max_tf = std::max(t.max_tf, tf);
+    t.min_dl = std::min(t.min_dl, dl);
+}
+
+namespace {
+
+// Forward iterator over one posting list.
+struct posting_cursor {
+    posting_view p;
+    size_t       pos  = 0;
+    uint32_t     i    = 0;        // postings consumed
+    uint32_t     doc  = NO_DOC;   // current document (NO_DOC once ended)
+    uint32_t     tf   = 0;
+    uint32_t     base = NO_DOC;   // delta base for the next posting
+
+    explicit posting_cursor(const posting_view &view) : p(view) { next(); }
+
+    void next() {
+        uint32_t delta = 0;
+        if (i == p.n || !get_varint(p.bytes, p.size, pos, delta) || !get_varint(p.bytes, p.size, pos, tf)) {
+            doc = NO_DOC;
+            i   = p.n;
+            return;
+        }
+        base += delta;
+        if (base >= p.limit) {
+            doc = NO_DOC;
+            i   = p.n;
+            return;
+        }
+        doc = base;
+        i++;
+    }
+
+    // First posting with doc >= target.
+    void seek(uint32_t target) {
+        if (doc == NO_DOC || doc >= target) return;
+        uint32_t block = i / SKIP_INTERVAL;
+        uint32_t skip  = block;
+        while (skip + 1 < p.n_skips && p.skips[skip + 1].base < target) skip++;
+        if (skip > block && p.skips[skip].offset < p.size) {
+            i    = skip * SKIP_INTERVAL;
+            pos  = p.skips[skip].offset;
+            base = p.skips[skip].base;
+        }
+        do next(); while (doc != NO_DOC && doc < target);
+    }
+};
+
+} // namespace
+
+// ═══════════════════════════════════════════════════════════════
+//                    Views over both storages
+// ═══════════════════════════════════════════════════════════════
+
+static uint32_t n_slots(const dai_llm_bm25 *x) {
+    return x->map ? x->n_fdocs : (uint32_t)x->docs.size();
+}
+
+static bool doc_live(const dai_llm_bm25 *x, uint32_t d) {
+    return x->map ? true : x->docs[d].live;   // saved files hold live documents only
+}
+
+static uint32_t doc_length(const dai_llm_bm25 *x, uint32_t d) {
+    return x->map ? x->fdocs[d].length : x->docs[d].length;
+}
+
+static bool find_term(const dai_llm_bm25 *x, const std::string &name, term_view &out) {
+    if (!x->map) {
+        auto it = x->terms.find(name);
+        if (it == x->terms.end()) return false;
+        const term_postings &t = it->second;
+        out.df       = t.df;
+        out.max_tf   = t.max_tf;
+        out.min_dl   = t.min_dl;
+        out.postings = {t.bytes.data(), t.bytes.size(), t.skips.data(), (uint32_t)t.skips.size(), t.n,
+                        (uint32_t)x->docs.size()};
+        return true;
+    }
+
+    auto less = [x](const file_term &t, const std::string &key) {
+        const int c = memcmp(x->map + t.name_off, key.data(), std::min<size_t>(t.name_len, key.size()));
+        return c < 0 || (c == 0 && t.name_len < key.size());
+    };
+    const file_term *end = x->fterms + x->n_fterms;
+    const file_term *t   = std::lower_bound(x->fterms, end, name, less);
+    if (t == end || t->name_len != name.size() || memcmp(x->map + t->name_off, name.data(), name.size()) != 0) {
+        return false;
+    }
+    out.df       = t->df;
+    out.max_tf   = t->max_tf;
+    out.min_dl   = t->min_dl;
+    out.postings = {x->map + t->postings_off, (size_t)t->postings_len, x->fskips + t->skips_off, t->n_skips, t->n,
+                    x->n_fdocs};
+    return true;
+}
+
+static dai_llm_bm25_hit make_hit(const dai_llm_bm25 *x, uint32_t d, float score) {
+    dai_llm_bm25_hit h;
+    h.score = score;
+    if (x->map) {
+        const file_doc &f = x->fdocs[d];
+        h.id         = f.id;
+        h.text.assign((const char *)x->map + f.text_off, f.text_len);
+        h.source.assign((const char *)x->map + f.source_off, f.source_len);
+        h.has_source = f.has_source != 0;
+    } else {
+        const doc_entry &e = x->docs[d];
+        h.id         = e.id;
+        h.text       = e.text;
+        h.source     = e.source;
+        h.has_source = e.has_source;
+    }
+    return h;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                  Memory mapping / materialising
+// ═══════════════════════════════════════════════════════════════
+
+static void unmap(dai_llm_bm25 *x) {
+    dai_llm_unmap_file(x->map, x->map_size);
+    x->map      = nullptr;
+    x->map_size = 0;
+    x->fdocs    = nullptr;
+    x->fterms   = nullptr;
+    x->fskips   = nullptr;
+    x->n_fdocs  = 0;
+    x->n_fterms = 0;
+}
+
+static bool in_file(uint64_t off, uint64_t len, size_t size) {
+    return off <= size && len <= size - off;
+}
+
+static bool validate(const dai_llm_bm25 *x, const file_header &h) {
+    const size_t size = x->map_size;
+    if (h.file_size != size) return false;
+    if (!in_file(h.docs_off,  (uint64_t)h.n_docs  * sizeof(file_doc),  size)) return false;
+    if (!in_file(h.terms_off, (uint64_t)h.n_terms * sizeof(file_term), size)) return false;
+    if (h.skips_off > h.postings_off || h.postings_off > h.strings_off || h.strings_off > size) return false;
+    if (h.docs_off % 8 || h.terms_off % 8 || h.skips_off % 8) return false;
+
+    const uint64_t n_skips = (h.postings_off - h.skips_off) / sizeof(skip_entry);
+    for (uint32_t i = 0; i < h.n_docs; i++) {
+        const file_doc &d = x->fdocs[i];
+        if (!in_file(d.text_off, d.text_len, size) || !in_file(d.source_off, d.source_len, size)) return false;
+    }
+    for (uint32_t i = 0; i < h.n_terms; i++) {
+        const file_term &t = x->fterms[i];
+        if (!in_file(t.name_off, t.name_len, size))         return false;
+        if (!in_file(t.postings_off, t.postings_len, size)) return false;
+        if (t.skips_off > n_skips || t.n_skips > n_skips - t.skips_off) return false;
+    }
+    return true;
+}
+
+// Copy a mapped index into memory before its first modification.
+static void materialise(dai_llm_bm25 *x) {
+    if (!x->map) return;
+
+    x->docs.resize(x->n_fdocs);
+    x->by_id.reserve(x->n_fdocs);
+    for (uint32_t d = 0; d < x->n_fdocs; d++) {
+        dai_llm_bm25_hit h = make_hit(x, d, 0.0f);
+        doc_entry &e = x->docs[d];
+        e.id         = h.id;
+        e.text       = std::move(h.text);
+        e.source     = std::move(h.source);
+        e.has_source = h.has_source;
+        e.length     = x->fdocs[d].length;
+        x->by_id[e.id] = d;
+    }
+
+    x->terms.reserve(x->n_fterms);
+    for (uint32_t i = 0; i < x->n_fterms; i++) {
+        const file_term &f = x->fterms[i];
+        term_postings &t = x->terms[std::string((const char *)x->map + f.name_off, f.name_len)];
+        t.bytes.assign(x->map + f.postings_off, x->map + f.postings_off + f.postings_len);
+        t.skips.assign(x->fskips + f.skips_off, x->fskips + f.skips_off + f.n_skips);
+        t.n      = f.n;
+        t.df     = f.df;
+        t.max_tf = f.max_tf;
+        t.min_dl = f.min_dl;
+
+        // The delta base for the next append is the last document in the list.
+        posting_cursor c({t.bytes.data(), t.bytes.size(), t.skips.data(), (uint32_t)t.skips.size(), t.n,
+                          x->n_fdocs});
+        c.seek(NO_DOC - 1);
+        t.last = c.base;
+    }
+    unmap(x);
+}
+
+// Rewrite every posting list without dead documents, renumbering the live
+// ones in order. Tightens the MaxScore bounds as a side effect.
+static void compact(dai_llm_bm25 *x) {
+    std::vector<uint32_t> remap(x->docs.size(), NO_DOC);
+    std::vector<doc_entry> docs;
+    docs.reserve(x->n_live);
+    for (uint32_t d = 0; d < x->docs.size(); d++) {
+        if (!x->docs[d].live) continue;
+        remap[d] = (uint32_t)docs.size();
+        docs.push_back(std::move(x->docs[d]));
+    }
+
+    for (auto it = x->terms.begin(); it != x->terms.end();) {
+        term_postings &old = it->second;
+        if (old.df == 0) {
+            it = x->terms.erase(it);
+            continue;
+        }
+        term_postings fresh;
+        fresh.df = old.df;
+        posting_cursor c({old.bytes.data(), old.bytes.size(), old.skips.data(), (uint32_t)old.skips.size(), old.n,
+                          (uint32_t)remap.size()});
+        for (; c.doc != NO_DOC; c.next()) {
+            const uint32_t nd = remap[c.doc];
+            if (nd != NO_DOC) append_posting(fresh, nd, c.tf, docs[nd].length);
+        }
+        old = std::move(fresh);
+        ++it;
+    }
+
+    x->docs = std::move(docs);
+    x->by_id.clear();
+    for (uint32_t d = 0; d < x->docs.size(); d++) x->by_id[x->docs[d].id] = d;
+    x->n_dead = 0;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Lifecycle
+// ═══════════════════════════════════════════════════════════════
+
+dai_llm_bm25 *dai_llm_bm25_create(float k1, float b) {
+    auto *x = new dai_llm_bm25();
+    x->k1 = k1;
+    x->b  = b;
+    return x;
+}
+
+dai_llm_bm25 *dai_llm_bm25_load(const std::string &path) {
+    size_t size = 0;
+    const uint8_t *map = dai_llm_map_file(path, sizeof(file_header), /*random_access=*/false, size);
+    if (!map) return nullptr;
+
+    auto *x = new dai_llm_bm25();
+    x->map      = map;
+    x->map_size = size;
+
+    const auto &h = *reinterpret_cast<const file_header *>(x->map);
+    if (memcmp(h.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || h.version != FILE_VERSION) {
+        LOGE("%s is not a BM25 index (or from another version)", path.c_str());
+        dai_llm_bm25_free(x);
+        return nullptr;
+    }
+    x->fdocs    = reinterpret_cast<const file_doc *>(x->map + h.docs_off);
+    x->fterms   = reinterpret_cast<const file_term *>(x->map + h.terms_off);
+    x->fskips   = reinterpret_cast<const skip_entry *>(x->map + h.skips_off);
+    x->n_fdocs  = h.n_docs;
+    x->n_fterms = h.n_terms;
+    if (!validate(x, h)) {
+        LOGE("BM25 index %s is corrupt", path.c_str());
+        dai_llm_bm25_free(x);
+        return nullptr;
+    }
+
+    x->k1           = h.k1;
+    x->b            = h.b;
+    x->n_live       = h.n_docs;
+    x->total_length = h.total_length;
+    x->next_id      = h.next_id;
+
+    LOGI("BM25 index mapped: %u documents, %u terms from %s", h.n_docs, h.n_terms, path.c_str());
+    return x;
+}
+
+void dai_llm_bm25_free(dai_llm_bm25 *x) {
+    if (!x) return;
+    unmap(x);
+    delete x;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                           Updates
+// ═══════════════════════════════════════════════════════════════
+
+std::vector<int64_t> dai_llm_bm25_add(dai_llm_bm25 *x, const std::vector<dai_llm_bm25_doc> &docs) {
+    std::vector<int64_t> ids;
+    if (!x) return ids;
+
+    // Term extraction is most of the work and needs no index state: do it
+    // before taking the lock, so concurrent adds only serialise on postings.
+    std::vector<std::unordered_map<std::string, uint32_t>> doc_counts(docs.size());
+    std::vector<uint32_t> lengths(docs.size());
+    for (size_t i = 0; i < docs.size(); i++) doc_counts[i] = term_counts(docs[i].text, lengths[i]);
+
+    std::unique_lock<std::shared_mutex> lock(x->mutex);
+    materialise(x);
+
+    ids.reserve(docs.size());
+    for (size_t i = 0; i < docs.size(); i++) {
+        const dai_llm_bm25_doc &in = docs[i];
+        const uint32_t d = (uint32_t)x->docs.size();
+        const uint32_t length = lengths[i];
+        const auto &counts = doc_counts[i];
+
+        doc_entry e;
+        e.id         = x->next_id++;
+        e.text       = in.text;
+        e.source     = in.source;
+        e.has_source = in.has_source;
+        e.length     = length;
+        x->by_id[e.id] = d;
+        x->docs.push_back(std::move(e));
+
+        for (const auto &kv : counts) {
+            term_postings &t = x->terms[kv.first];
+            append_posting(t, d, kv.second, length);
+            t.df++;
+        }
+        x->n_live++;
+        x->total_length += length;
+        ids.push_back(x->docs.back().id);
+    }
+    return ids;
+}
+
+bool dai_llm_bm25_remove(dai_llm_bm25 *x, int64_t id) {
+    if (!x) return false;
+    std::unique_lock<std::shared_mutex> lock(x->mutex);
+    materialise(x);
+
+    auto it = x->by_id.find(id);
+    if (it == x->by_id.end()) return false;
+    doc_entry &e = x->docs[it->second];
+    x->by_id.erase(it);
+
+    uint32_t length = 0;
+    for (const auto &kv : term_counts(e.text, length)) x->terms[kv.first].df--;
+    x->n_live--;
+    x->total_length -= e.length;
+    e.live = false;
+    e.text.clear();
+    e.text.shrink_to_fit();
+    e.source.clear();
+    x->n_dead++;
+
+    if (x->n_dead > x->docs.size() / 2) compact(x);
+    return true;
+}
+
+size_t dai_llm_bm25_size(dai_llm_bm25 *x) {
+    if (!x) return 0;
+    std::shared_lock<std::shared_mutex> lock(x->mutex);
+    return x->n_live;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                            Save
+// ═══════════════════════════════════════════════════════════════
+
+static uint64_t align8(uint64_t v) { return (v + 7) & ~(uint64_t)7; }
+
+static void write_padding(std::ofstream &out, uint64_t from, uint64_t to) {
+    static const char zeros[8] = {};
+    out.write(zeros, (std::streamsize)(to - from));
+}
+
+static bool write_file(const dai_llm_bm25 *x, const std::string &path) {
+    // Live documents, renumbered in order.
+    const uint32_t n_docs = n_slots(x);
+    std::vector<uint32_t> remap(n_docs, NO_DOC);
+    std::vector<uint32_t> live;
+    live.reserve(x->n_live);
+    for (uint32_t d = 0; d < n_docs; d++) {
+        if (!doc_live(x, d)) continue;
+        remap[d] = (uint32_t)live.size();
+        live.push_back(d);
+    }
+
+    // Terms in name order, posting lists re-encoded without dead documents.
+    std::vector<std::pair<std::string, term_postings>> terms;
+    auto add_term = [&](std::string name, const term_view &v) {
+        if (v.df == 0) return;
+        term_postings t;
+        t.df = v.df;
+        for (posting_cursor c(v.postings); c.doc != NO_DOC; c.next()) {
+            if (remap[c.doc] != NO_DOC) append_posting(t, remap[c.doc], c.tf, doc_length(x, c.doc));
+        }
+        if (t.n > 0) terms.emplace_back(std::move(name), std::move(t));
+    };
+    if (x->map) {
+        for (uint32_t i = 0; i < x->n_fterms; i++) {
+            const file_term &f = x->fterms[i];
+            std::string name((const char *)x->map + f.name_off, f.name_len);
+            term_view v;
+            find_term(x, name, v);
+            add_term(std::move(name), v);
+        }
+    } else {
+        for (const auto &kv : x->terms) {
+            term_view v;
+            find_term(x, kv.first, v);
+            add_term(kv.first, v);
+        }
+    }
+    std::sort(terms.begin(), terms.end(), [](const auto &a, const auto &c) { return a.first < c.first; });
+
+    // Layout: header | docs | terms | skips | postings | strings
+    file_header h{};
+    memcpy(h.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    h.version      = FILE_VERSION;
+    h.k1           = x->k1;
+    h.b            = x->b;
+    h.n_docs       = (uint32_t)live.size();
+    h.n_terms      = (uint32_t)terms.size();
+    h.total_length = x->total_length;
+    h.next_id      = x->next_id;
+    h.docs_off     = align8(sizeof(file_header));
+    h.terms_off    = h.docs_off + (uint64_t)h.n_docs * sizeof(file_doc);
+    h.skips_off    = h.terms_off + (uint64_t)h.n_terms * sizeof(file_term);
+
+    uint64_t n_skips = 0, postings_bytes = 0, strings_bytes = 0;
+    for (const auto &t : terms) {
+        n_skips        += t.second.skips.size();
+        postings_bytes += t.second.bytes.size();
+        strings_bytes  += t.first.size();
+    }
+    h.postings_off = h.skips_off + n_skips * sizeof(skip_entry);
+    h.strings_off  = h.postings_off + postings_bytes;
+
+    std::vector<file_doc> fdocs(live.size());
+    uint64_t str = h.strings_off + strings_bytes;   // term names first, then documents
+    for (size_t i = 0; i < live.size(); i++) {
+        dai_llm_bm25_hit d = make_hit(x, live[i], 0.0f);
+        file_doc &f  = fdocs[i];
+        f.id         = d.id;
+        f.length     = doc_length(x, live[i]);
+        f.has_source = d.has_source;
+        f.text_off   = str;
+        f.text_len   = (uint32_t)d.text.size();
+        str         += d.text.size();
+        f.source_off = str;
+        f.source_len = (uint32_t)d.source.size();
+        str         += d.source.size();
+    }
+    h.file_size = str;
+
+    std::vector<file_term> fterms(terms.size());
+    uint64_t skip_i = 0, post = h.postings_off, name = h.strings_off;
+    for (size_t i = 0; i < terms.size(); i++) {
+        const term_postings &t = terms[i].second;
+        file_term &f   = fterms[i];
+        f.name_off     = name;
+        f.name_len     = (uint32_t)terms[i].first.size();
+        f.postings_off = post;
+        f.postings_len = t.bytes.size();
+        f.skips_off    = skip_i;
+        f.n_skips      = (uint32_t)t.skips.size();
+        f.n            = t.n;
+        f.df           = t.df;
+        f.max_tf       = t.max_tf;
+        f.min_dl       = t.min_dl;
+        name   += f.name_len;
+        post   += f.postings_len;
+        skip_i += f.n_skips;
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(reinterpret_cast<const char *>(&h), sizeof(h));
+    write_padding(out, sizeof(h), h.docs_off);
+    out.write(reinterpret_cast<const char *>(fdocs.data()), (std::streamsize)(fdocs.size() * sizeof(file_doc)));
+    out.write(reinterpret_cast<const char *>(fterms.data()), (std::streamsize)(fterms.size() * sizeof(file_term)));
+    for (const auto &t : terms) {
+        out.write(reinterpret_cast<const char *>(t.second.skips.data()),
+                  (std::streamsize)(t.second.skips.size() * sizeof(skip_entry)));
+    }
+    for (const auto &t : terms) {
+        out.write(reinterpret_cast<const char *>(t.second.bytes.data()), (std::streamsize)t.second.bytes.size());
+    }
+    for (const auto &t : terms) out.write(t.first.data(), (std::streamsize)t.first.size());
+    for (uint32_t d : live) {
+        dai_llm_bm25_hit doc = make_hit(x, d, 0.0f);
+        out.write(doc.text.data(), (std::streamsize)doc.text.size());
+        out.write(doc.source.data(), (std::streamsize)doc.source.size());
+    }
+    out.close();
+    return !out.fail();
+}
+
+bool dai_llm_bm25_save(dai_llm_bm25 *x, const std::string &path) {
+    if (!x || path.empty()) return false;
+    std::shared_lock<std::shared_mutex> lock(x->mutex);
+
+    // Write next to the target and rename, so a crash mid-write never leaves
+    // a truncated index under the final name (and a mapped one stays valid).
+    const std::string tmp = path + ".tmp";
+    if (!write_file(x, tmp) || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to write BM25 index %s", path.c_str());
+        std::remove(tmp.c_str());
+        return false;
+    }
+    LOGI("BM25 index saved: %u documents to %s", x->n_live, path.c_str());
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                           Search
+// ═══════════════════════════════════════════════════════════════
+
+namespace {
+
+struct query_term {
+    posting_cursor cursor;
+    float          weight;   // query frequency × idf × (k1 + 1)
+    float          bound;    // max contribution to any document's score
+};
+
+struct scored {
+    float    score;
+    uint32_t doc;
+};
+
+// Heap order: the worst result on top. Equal scores rank the earlier document higher.
+struct worse_first {
+    bool operator()(const scored &a, const scored &c) const {
+        return a.score > c.score || (a.score == c.score && a.doc < c.doc);
+    }
+};
+
+} // namespace
+
+std::vector<dai_llm_bm25_hit> dai_llm_bm25_search(dai_llm_bm25 *x, const std::string &query, int top_k) {
+    std::vector<dai_llm_bm25_hit> hits;
+    if (!x || top_k <= 0) return hits;
+    std::shared_lock<std::shared_mutex> lock(x->mutex);
+    if (x->n_live == 0) return hits;
+
+    const float n     = (float)x->n_live;
+    const float avgdl = (float)x->total_length / n;
+    const float k1    = x->k1;
+    const float b     = x->b;
+    auto norm = [&](uint32_t dl) { return k1 * (1.0f - b + b * (float)dl / avgdl); };
+
+    // Repeated query words count once per occurrence, as in BM25RagStore.
+    std::unordered_map<std::string, uint32_t> qtf;
+    for_each_term(query, [&](const std::string &t) { qtf[t]++; });
+
+    std::vector<query_term> terms;
+    for (const auto &kv : qtf) {
+        term_view v;
+        if (!find_term(x, kv.first, v) || v.df == 0) continue;
+        const float idf    = std::log((n - (float)v.df + 0.5f) / ((float)v.df + 0.5f) + 1.0f);
+        const float weight = (float)kv.second * idf * (k1 + 1.0f);
+        const float tf     = (float)v.max_tf;
+        terms.push_back({posting_cursor(v.postings), weight, weight * tf / (tf + norm(v.min_dl))});
+    }
+    if (terms.empty()) return hits;
+
+    // MaxScore: terms by ascending bound; prefix[i] bounds what terms [0, i) can add.
+    std::sort(terms.begin(), terms.end(), [](const query_term &a, const query_term &c) { return a.bound < c.bound; });
+    std::vector<float> prefix(terms.size() + 1, 0.0f);
+    for (size_t i = 0; i < terms.size(); i++) prefix[i + 1] = prefix[i] + terms[i].bound;
+
+    const size_t k = (size_t)top_k;
+    std::vector<scored> heap;
+    heap.reserve(k + 1);
+    size_t first_essential = 0;
+
+    for (;;) {
+        // Once the heap is full, documents matching only the non-essential
+        // terms [0, first_essential) cannot beat its worst entry.
+        if (heap.size() == k) {
+            while (first_essential < terms.size() && prefix[first_essential + 1] <= heap.front().score) {
+                first_essential++;
+            }
+        }
+
+        uint32_t doc = NO_DOC;
+        for (size_t i = first_essential; i < terms.size(); i++) doc = std::min(doc, terms[i].cursor.doc);
+        if (doc == NO_DOC) break;
+
+        const bool  live = doc_live(x, doc);
+        const float nd   = live ? norm(doc_length(x, doc)) : 0.0f;
+        float score = 0.0f;
+        for (size_t i = first_essential; i < terms.size(); i++) {
+            posting_cursor &c = terms[i].cursor;
+            if (c.doc != doc) continue;
+            if (live) score += terms[i].weight * (float)c.tf / ((float)c.tf + nd);
+            c.next();
+        }
+        if (!live) continue;
+
+        for (size_t i = first_essential; i-- > 0;) {
+            if (heap.size() == k && score + prefix[i + 1] <= heap.front().score) break;
+            posting_cursor &c = terms[i].cursor;
+            c.seek(doc);
+            if (c.doc == doc) score += terms[i].weight * (float)c.tf / ((float)c.tf + nd);
+        }
+
+        if (score <= 0.0f) continue;
+        if (heap.size() < k) {
+            heap.push_back({score, doc});
+            std::push_heap(heap.begin(), heap.end(), worse_first());
+        } else if (score > heap.front().score) {
+            std::pop_heap(heap.begin(), heap.end(), worse_first());
+            heap.back() = {score, doc};
+            std::push_heap(heap.begin(), heap.end(), worse_first());
+        }
+    }
+
+    std::sort_heap(heap.begin(), heap.end(), worse_first());
+    hits.reserve(heap.size());
+    for (const scored &s : heap) hits.push_back(make_hit(x, s.doc, s.score));
+    return hits;
+}
@@ -0,0 +1,72 @@
+#ifndef DEVICEAI_LLM_BM25_H
+#define DEVICEAI_LLM_BM25_H
+
+/**
+ * deviceai_llm_bm25.h - Native BM25 inverted index for keyword RAG
+ *
+ * Scoring every chunk per query does not scale to large corpora. This index
+ * keeps one posting list per term: delta-encoded document numbers and term
+ * frequencies as varints, with a skip entry every SKIP_INTERVAL postings.
+ * Queries run MaxScore: each term has an upper bound on its contribution,
+ * and once the top-k threshold is high enough, the low-bound terms are only
+ * probed (skipping through their lists) for documents the others found.
+ *
+ * Documents can be added and removed at any time. Removal marks the
+ * document dead and updates the statistics. Its postings are dropped when
+ * more than half of the documents are dead, and on save.
+ *
+ * dai_llm_bm25_save writes a single file that dai_llm_bm25_load memory-maps
+ * and queries in place, so a saved index is usable immediately on app start.
+ * The first add or remove on a loaded index copies it into memory.
+ *
+ * Terms follow the Kotlin BM25RagStore: ASCII-lowercased runs of [a-z0-9]
+ * of at least three characters. Scores are Okapi BM25 with the same idf.
+ *
+ * All functions are thread-safe; searches run concurrently.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct dai_llm_bm25;
+
+struct dai_llm_bm25_doc {
+    std::string text;
+    std::string source;
+    bool        has_source = false;
+};
+
+struct dai_llm_bm25_hit {
+    int64_t     id    = 0;
+    float       score = 0.0f;
+    std::string text;
+    std::string source;
+    bool        has_source = false;
+};
+
+/** Create an empty index. k1 = term-frequency saturation, b = length normalisation. */
+dai_llm_bm25 *dai_llm_bm25_create(float k1 = 1.5f, float b = 0.75f);
+
+/** Map an index written by dai_llm_bm25_save. nullptr if missing or not a valid index file. */
+dai_llm_bm25 *dai_llm_bm25_load(const std::string &path);
+
+void dai_llm_bm25_free(dai_llm_bm25 *index);
+
+/** Index documents. Returns their ids, stable across save/load. */
+std::vector<int64_t> dai_llm_bm25_add(dai_llm_bm25 *index, const std::vector<dai_llm_bm25_doc> &docs);
+
+/** Remove a document. False if the id is unknown or already removed. */
+bool dai_llm_bm25_remove(dai_llm_bm25 *index, int64_t id);
+
+/** Live documents. */
+size_t dai_llm_bm25_size(dai_llm_bm25 *index);
+
+/** Write the index to path (via a temporary file and rename). */
+bool dai_llm_bm25_save(dai_llm_bm25 *index, const std::string &path);
+
+/** Up to top_k documents with a positive score, best first (ties: earliest added first). */
+std::vector<dai_llm_bm25_hit> dai_llm_bm25_search(dai_llm_bm25 *index, const std::string &query, int top_k);
+
+#endif // DEVICEAI_LLM_BM25_H
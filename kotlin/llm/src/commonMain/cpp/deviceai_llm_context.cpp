@@ -0,0 +1,152 @@
+/**
+ * deviceai_llm_context.cpp - Sliding-window context shifting
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_context.h"
+
+#include <algorithm>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmContext"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+// Resident tokens compared to tell a continued conversation from a new one
+// that merely shares the pinned prefix.
+static const size_t MATCH_CHECK_TOKENS = 64;
+
+// ═══════════════════════════════════════════════════════════════
+//                         KV shifting
+// ═══════════════════════════════════════════════════════════════
+
+// Remove cells [n_keep, n_keep + n_discard) of sequence 0 and move the ones
+// after them down to close the gap.
+static bool shift_kv(llama_context *ctx, std::vector<llama_token> &resident, size_t n_keep, size_t n_discard) {
+    llama_memory_t mem = llama_get_memory(ctx);
+    if (!llama_memory_can_shift(mem)) return false;
+
+    const llama_pos p0 = (llama_pos)n_keep;
+    const llama_pos p1 = (llama_pos)(n_keep + n_discard);
+    if (!llama_memory_seq_rm(mem, 0, p0, p1)) return false;
+    llama_memory_seq_add(mem, 0, p1, -1, -(llama_pos)n_discard);
+
+    resident.erase(resident.begin() + p0, resident.begin() + p1);
+    return true;
+}
+
+// Evict resident tokens after the pinned ones, in the target and (when it
+// holds the same tokens) the draft context.
+static bool shift_session(dai_llm_session *s, size_t n_discard) {
+    const size_t n_keep = s->shift_keep;
+    if (s->kv_tokens.size() < n_keep + n_discard) return false;
+
+    const bool draft_in_sync = s->draft_ctx &&
+        dai_llm_common_prefix(s->draft_tokens, s->kv_tokens) >= n_keep + n_discard;
+
+    if (!shift_kv(s->ctx, s->kv_tokens, n_keep, n_discard)) return false;
+    // Otherwise the draft resyncs from the common prefix on its next proposal.
+    if (draft_in_sync) shift_kv(s->draft_ctx, s->draft_tokens, n_keep, n_discard);
+
+    LOGI("Context shift: evicted %zu tokens after the first %zu", n_discard, n_keep);
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Public API
+// ═══════════════════════════════════════════════════════════════
+
+size_t dai_llm_context_keep(
+    const llama_vocab *vocab,
+    const dai_llm_gen_params &params,
+    const std::vector<llama_token> &tokens
+) {
+    size_t n_keep = 0;
+    if (params.n_keep >= 0) {
+        n_keep = std::min((size_t)params.n_keep, tokens.size());
+    } else if (!params.keep_prefix.empty()) {
+        n_keep = dai_llm_common_prefix(dai_llm_tokenize_prompt(vocab, params.keep_prefix, params, 0), tokens);
+    }
+    // Never evict BOS: models degrade badly without it.
+    if (n_keep == 0 && !tokens.empty() && tokens[0] == llama_vocab_bos(vocab)) n_keep = 1;
+    return n_keep;
+}
+
+std::string dai_llm_context_system_prefix(
+    const dai_llm_model *model,
+    const std::vector<std::string> &roles,
+    const std::vector<std::string> &contents
+) {
+    size_t n_system = 0;
+    while (n_system < roles.size() && n_system < contents.size() && roles[n_system] == "system") n_system++;
+    if (n_system == 0) return "";
+
+    std::vector<std::string> r(roles.begin(), roles.begin() + n_system);
+    std::vector<std::string> c(contents.begin(), contents.begin() + n_system);
+    return dai_llm_format_chat(model, r, c, /*add_assistant=*/false);
+}
+
+void dai_llm_context_fit(
+    dai_llm_session *s,
+    std::vector<llama_token> &tokens,
+    size_t n_keep,
+    size_t n_reserve
+) {
+    const size_t n_ctx = llama_n_ctx(s->ctx);
+    n_keep    = std::min(n_keep, n_ctx / 2);   // always leave a window to slide
+    n_reserve = std::min(n_reserve, (n_ctx - n_keep) / 2);
+
+    // Same conversation as before (pinned part unchanged and the resident
+    // history follows the evicted range): drop that range again.
+    bool continues =
+        s->n_shifted > 0 && s->shift_keep == n_keep &&
+        tokens.size() > n_keep + s->n_shifted &&
+        s->kv_tokens.size() > n_keep &&
+        dai_llm_common_prefix(s->kv_tokens, tokens) >= n_keep;
+    if (continues) {
+        const size_t n_check = std::min({s->kv_tokens.size() - n_keep,
+                                         tokens.size() - n_keep - s->n_shifted, MATCH_CHECK_TOKENS});
+        continues = std::equal(s->kv_tokens.begin() + n_keep, s->kv_tokens.begin() + n_keep + n_check,
+                               tokens.begin() + n_keep + s->n_shifted);
+    }
+    if (continues) {
+        tokens.erase(tokens.begin() + n_keep, tokens.begin() + n_keep + s->n_shifted);
+    } else {
+        s->n_shifted = 0;
+    }
+    s->shift_keep = n_keep;
+
+    if (tokens.size() + n_reserve <= n_ctx) return;
+
+    // Evict at least a quarter of the window so a growing conversation
+    // shifts every few turns rather than on each one.
+    size_t n_discard = tokens.size() + n_reserve - n_ctx;
+    n_discard = std::max(n_discard, (n_ctx - n_keep) / 4);
+    n_discard = std::min(n_discard, tokens.size() - n_keep - 1);
+
+    // Move the cells if the evicted range is resident; otherwise it is simply
+    // not part of the prompt and the usual prefix reuse takes over.
+    if (dai_llm_common_prefix(s->kv_tokens, tokens) >= n_keep + n_discard) shift_session(s, n_discard);
+
+    tokens.erase(tokens.begin() + n_keep, tokens.begin() + n_keep + n_discard);
+    s->n_shifted += n_discard;
+}
+
+bool dai_llm_context_make_room(dai_llm_session *s, const dai_llm_gen_params &params, size_t n_needed) {
+    const size_t n_ctx = llama_n_ctx(s->ctx);
+    if (s->kv_tokens.size() + n_needed <= n_ctx) return true;
+    if (!params.context_shift || s->kv_tokens.size() <= s->shift_keep + 1) return false;
+
+    const size_t n_discard = std::max((s->kv_tokens.size() - s->shift_keep) / 2,
+                                      s->kv_tokens.size() + n_needed - n_ctx);
+    if (s->shift_keep + n_discard > s->kv_tokens.size() || !shift_session(s, n_discard)) return false;
+    s->n_shifted += n_discard;
+    return true;
+}
@@ -0,0 +1,68 @@
+#ifndef DEVICEAI_LLM_CONTEXT_H
+#define DEVICEAI_LLM_CONTEXT_H
+
+/**
+ * deviceai_llm_context.h - Sliding-window context shifting
+ *
+ * Callers send the whole conversation with every request. Without shifting,
+ * a conversation longer than the context fails to tokenize and the only way
+ * out is to drop the history.
+ *
+ * With dai_llm_gen_params::context_shift, the first n_keep tokens (usually
+ * the system prompt) stay pinned. When the prompt plus room for the reply no
+ * longer fits, the oldest tokens after them are evicted and the remaining
+ * KV cells are moved down in place (llama_memory_seq_rm + seq_add), so the
+ * retained history is not decoded again. The session remembers how many
+ * tokens it evicted and removes the same range from later prompts, which
+ * keeps them aligned with the cache: each turn then only prefills its new
+ * messages, however long the conversation gets.
+ *
+ * A reply that fills the context while it is generated is shifted the same
+ * way, by half the unpinned window (as llama.cpp's examples do).
+ *
+ * Eviction works at token granularity and may cut a turn in half; the model
+ * copes with that as it does in llama.cpp's own context shift.
+ */
+
+#include "deviceai_llm_engine.h"
+
+/**
+ * Tokens to pin for this request: params.n_keep, or the tokens shared with
+ * params.keep_prefix. A leading BOS is always pinned.
+ */
+size_t dai_llm_context_keep(
+    const llama_vocab *vocab,
+    const dai_llm_gen_params &params,
+    const std::vector<llama_token> &tokens
+);
+
+/**
+ * Formatted leading system messages of a conversation, the usual
+ * dai_llm_gen_params::keep_prefix. Empty if it does not start with one.
+ */
+std::string dai_llm_context_system_prefix(
+    const dai_llm_model *model,
+    const std::vector<std::string> &roles,
+    const std::vector<std::string> &contents
+);
+
+/**
+ * Rewrite a full-conversation prompt to the window the session can hold:
+ * drop what earlier shifts evicted, then evict more (moving resident KV
+ * cells in place) until tokens plus n_reserve reply tokens fit the context.
+ * Caller holds session->mutex.
+ */
+void dai_llm_context_fit(
+    dai_llm_session *session,
+    std::vector<llama_token> &tokens,
+    size_t n_keep,
+    size_t n_reserve
+);
+
+/**
+ * Make room for n_needed more tokens in the session's context, shifting if
+ * the request enabled it. Returns false if they do not fit.
+ */
+bool dai_llm_context_make_room(dai_llm_session *session, const dai_llm_gen_params &params, size_t n_needed);
+
+#endif // DEVICEAI_LLM_CONTEXT_H
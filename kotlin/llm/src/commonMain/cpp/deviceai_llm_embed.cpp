@@ -0,0 +1,256 @@
+/**
+ * deviceai_llm_embed.cpp - Batched text embeddings for dense RAG retrieval
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_embed.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmEmbed"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+// One context and its batch; a dai_llm_embed call holds one for its duration.
+struct embed_slot {
+    llama_context *ctx   = nullptr;
+    llama_batch    batch = {};
+};
+
+struct dai_llm_embedder {
+    dai_llm_model *model = nullptr;
+    int            dim        = 0;
+    int            n_batch    = 0;
+    int            n_seq_max  = 0;
+    int            max_tokens = 0;       // per text
+    bool           encoder    = false;   // encoder-only model: llama_encode, no KV cache
+    bool           normalize  = true;
+
+    std::vector<embed_slot> slots;
+    std::vector<int>        idle;   // indexes into slots
+    std::mutex              mutex;
+    std::condition_variable slot_freed;
+};
+
+static void free_slots(dai_llm_embedder *e) {
+    for (embed_slot &slot : e->slots) {
+        if (slot.batch.token) llama_batch_free(slot.batch);
+        llama_free(slot.ctx);
+    }
+    e->slots.clear();
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                         Lifecycle
+// ═══════════════════════════════════════════════════════════════
+
+static enum llama_pooling_type to_llama_pooling(dai_llm_pooling pooling) {
+    switch (pooling) {
+        case DAI_LLM_POOLING_MEAN: return LLAMA_POOLING_TYPE_MEAN;
+        case DAI_LLM_POOLING_CLS:  return LLAMA_POOLING_TYPE_CLS;
+        case DAI_LLM_POOLING_LAST: return LLAMA_POOLING_TYPE_LAST;
+        default:                   return LLAMA_POOLING_TYPE_UNSPECIFIED;
+    }
+}
+
+static llama_context *create_context(dai_llm_embedder *e, const dai_llm_model_params &mparams,
+                                     enum llama_pooling_type pooling) {
+    llama_context_params cparams = dai_llm_context_params(mparams);
+    cparams.n_ctx        = (uint32_t)e->n_batch;
+    cparams.n_batch      = (uint32_t)e->n_batch;
+    // Non-causal models attend over the whole sequence, so every text must
+    // fit in one physical batch.
+    cparams.n_ubatch     = (uint32_t)e->n_batch;
+    cparams.n_seq_max    = (uint32_t)e->n_seq_max;
+    cparams.kv_unified   = true;   // the batch's texts share n_ctx, not n_ctx / n_seq_max each
+    cparams.embeddings   = true;
+    cparams.pooling_type = pooling;
+    return llama_init_from_model(e->model->model, cparams);
+}
+
+dai_llm_embedder *dai_llm_embedder_load(const std::string &path, const dai_llm_embed_params &params) {
+    dai_llm_model_params mparams;
+    mparams.n_threads = params.n_threads;
+    mparams.use_gpu   = params.use_gpu;
+
+    dai_llm_model *model = dai_llm_model_load(path, mparams);
+    if (!model) return nullptr;
+
+    auto *e = new dai_llm_embedder();
+    e->model     = model;
+    e->dim       = llama_model_n_embd(model->model);
+    e->n_batch   = std::max(1, params.n_batch);
+    e->n_seq_max = std::max(1, params.n_seq_max);
+    e->encoder   = llama_model_has_encoder(model->model) && !llama_model_has_decoder(model->model);
+    e->normalize = params.normalize;
+
+    const int n_ctx_train = llama_model_n_ctx_train(model->model);
+    e->max_tokens = n_ctx_train > 0 ? std::min(e->n_batch, n_ctx_train) : e->n_batch;
+
+    llama_context *ctx = create_context(e, mparams, to_llama_pooling(params.pooling));
+    if (ctx && llama_pooling_type(ctx) == LLAMA_POOLING_TYPE_NONE) {
+        // Plain LLMs declare no pooling; averaging their hidden states still
+        // gives a usable sentence vector.
+        llama_free(ctx);
+        ctx = create_context(e, mparams, LLAMA_POOLING_TYPE_MEAN);
+    }
+    if (!ctx || llama_pooling_type(ctx) == LLAMA_POOLING_TYPE_RANK) {
+        LOGE("Cannot embed with %s: %s", path.c_str(), ctx ? "reranker model" : "context creation failed");
+        if (ctx) llama_free(ctx);
+        dai_llm_model_release(model);
+        delete e;
+        return nullptr;
+    }
+    const enum llama_pooling_type pooling = llama_pooling_type(ctx);
+    e->slots.push_back({ctx, llama_batch_init(e->n_batch, 0, 1)});
+
+    // Further contexts reuse the pooling the first one settled on.
+    const int n_contexts = std::max(1, params.n_contexts);
+    while ((int)e->slots.size() < n_contexts) {
+        ctx = create_context(e, mparams, pooling);
+        if (!ctx) {
+            LOGE("Cannot create embedding context %zu of %d for %s", e->slots.size() + 1, n_contexts, path.c_str());
+            free_slots(e);
+            dai_llm_model_release(model);
+            delete e;
+            return nullptr;
+        }
+        e->slots.push_back({ctx, llama_batch_init(e->n_batch, 0, 1)});
+    }
+    for (int i = 0; i < (int)e->slots.size(); i++) e->idle.push_back(i);
+
+    LOGI("Embedding model loaded: %s (dim=%d, pooling=%d, batch=%d tokens / %d texts, %d contexts)",
+         path.c_str(), e->dim, (int)pooling, e->n_batch, e->n_seq_max, n_contexts);
+    return e;
+}
+
+void dai_llm_embedder_free(dai_llm_embedder *e) {
+    if (!e) return;
+    free_slots(e);
+    dai_llm_model_release(e->model);
+    delete e;
+}
+
+int dai_llm_embedder_dim(dai_llm_embedder *e) {
+    return e ? e->dim : 0;
+}
+
+const llama_vocab *dai_llm_embedder_vocab(dai_llm_embedder *e) {
+    return e ? llama_model_get_vocab(e->model->model) : nullptr;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Embedding
+// ═══════════════════════════════════════════════════════════════
+
+static void batch_add_text(llama_batch &batch, const std::vector<llama_token> &tokens, llama_seq_id seq) {
+    for (size_t p = 0; p < tokens.size(); p++) {
+        const int i = batch.n_tokens++;
+        batch.token   [i]    = tokens[p];
+        batch.pos     [i]    = (llama_pos)p;
+        batch.n_seq_id[i]    = 1;
+        batch.seq_id  [i][0] = seq;
+        batch.logits  [i]    = true;   // pooling reads every token's output
+    }
+}
+
+// Decode the slot's pending batch and copy sequence s's pooled vector to rows[s].
+static bool flush(dai_llm_embedder *e, embed_slot &slot, const std::vector<float *> &rows) {
+    if (rows.empty()) return true;
+
+    // Each batch starts from an empty cache: the texts are independent.
+    if (!e->encoder) llama_memory_clear(llama_get_memory(slot.ctx), /*data=*/true);
+
+    const int rc = e->encoder ? llama_encode(slot.ctx, slot.batch) : llama_decode(slot.ctx, slot.batch);
+    slot.batch.n_tokens = 0;
+    if (rc != 0) {
+        LOGE("Embedding batch of %zu texts failed (%d)", rows.size(), rc);
+        return false;
+    }
+
+    for (size_t s = 0; s < rows.size(); s++) {
+        const float *v = llama_get_embeddings_seq(slot.ctx, (llama_seq_id)s);
+        if (!v) {
+            LOGE("No pooled embedding for sequence %zu", s);
+            return false;
+        }
+        float *row = rows[s];
+        std::memcpy(row, v, (size_t)e->dim * sizeof(float));
+
+        if (e->normalize) {
+            double sum = 0.0;
+            for (int j = 0; j < e->dim; j++) sum += (double)row[j] * row[j];
+            if (sum > 0.0) {
+                const float scale = (float)(1.0 / std::sqrt(sum));
+                for (int j = 0; j < e->dim; j++) row[j] *= scale;
+            }
+        }
+    }
+    return true;
+}
+
+// Runs with one of the embedder's contexts, so up to n_contexts calls embed at once.
+static bool embed_with(dai_llm_embedder *e, embed_slot &slot, const std::vector<std::string> &texts, float *out) {
+    const llama_vocab *vocab = llama_model_get_vocab(e->model->model);
+    std::vector<float *> rows;   // output row of each sequence in the pending batch
+    rows.reserve((size_t)e->n_seq_max);
+    size_t n_truncated = 0;
+
+    for (size_t t = 0; t < texts.size(); t++) {
+        float *row = out + t * (size_t)e->dim;
+        std::vector<llama_token> tokens = dai_llm_tokenize(vocab, texts[t], 0);
+        if (tokens.empty()) {
+            std::fill(row, row + e->dim, 0.0f);
+            continue;
+        }
+        if ((int)tokens.size() > e->max_tokens) {
+            // Keep the closing token, usually the EOS/SEP that last-token
+            // pooling reads.
+            const llama_token last = tokens.back();
+            tokens.resize((size_t)e->max_tokens);
+            tokens.back() = last;
+            n_truncated++;
+        }
+
+        if ((int)rows.size() == e->n_seq_max || slot.batch.n_tokens + (int)tokens.size() > e->n_batch) {
+            if (!flush(e, slot, rows)) return false;
+            rows.clear();
+        }
+        batch_add_text(slot.batch, tokens, (llama_seq_id)rows.size());
+        rows.push_back(row);
+    }
+    if (!flush(e, slot, rows)) return false;
+
+    if (n_truncated > 0) LOGI("Embedding: truncated %zu of %zu texts to %d tokens", n_truncated, texts.size(), e->max_tokens);
+    return true;
+}
+
+bool dai_llm_embed(dai_llm_embedder *e, const std::vector<std::string> &texts, float *out) {
+    if (!e || (!out && !texts.empty())) return false;
+
+    int i;
+    {
+        std::unique_lock<std::mutex> lock(e->mutex);
+        e->slot_freed.wait(lock, [&] { return !e->idle.empty(); });
+        i = e->idle.back();
+        e->idle.pop_back();
+    }
+    const bool ok = embed_with(e, e->slots[i], texts, out);
+    {
+        std::lock_guard<std::mutex> lock(e->mutex);
+        e->idle.push_back(i);
+    }
+    e->slot_freed.notify_one();
+    return ok;
+}
@@ -0,0 +1,68 @@
+#ifndef DEVICEAI_LLM_EMBED_H
+#define DEVICEAI_LLM_EMBED_H
+
+/**
+ * deviceai_llm_embed.h - Batched text embeddings for dense RAG retrieval
+ *
+ * Loads a GGUF embedding model (BERT-style encoders or decoder embedding
+ * models) with an embeddings context, and turns texts into pooled vectors.
+ *
+ * Calling the model once per text leaves most of each llama_decode idle:
+ * document chunks are short, and every call pays the same fixed overhead.
+ * dai_llm_embed instead packs as many texts as fit into one batch, each on
+ * its own sequence id, decodes them together and reads one pooled vector per
+ * sequence. A batch holds up to n_batch tokens and n_seq_max texts.
+ *
+ * The weights come from the shared model registry (deviceai_llm_engine.h),
+ * so an embedding model that is also loaded for generation is mapped once.
+ * An embedder has n_contexts contexts, and that many calls run at once;
+ * further calls wait for a free one. Each context holds its own compute
+ * buffers for n_batch tokens and runs n_threads threads.
+ */
+
+#include "deviceai_llm_engine.h"
+
+struct dai_llm_embedder;
+
+// How a text's token embeddings are pooled into one vector.
+enum dai_llm_pooling {
+    DAI_LLM_POOLING_MODEL = 0,   // the model's own setting (mean if it has none)
+    DAI_LLM_POOLING_MEAN  = 1,
+    DAI_LLM_POOLING_CLS   = 2,   // first token (BERT [CLS])
+    DAI_LLM_POOLING_LAST  = 3,   // last token (decoder embedding models)
+};
+
+struct dai_llm_embed_params {
+    int  n_threads = 4;
+    bool use_gpu   = true;
+
+    // Tokens and texts decoded per llama_decode call. Texts longer than
+    // n_batch tokens (or the model's training context) are truncated.
+    int  n_batch   = 2048;
+    int  n_seq_max = 32;
+
+    // Contexts for concurrent calls, e.g. one per dai_llm_ingest worker.
+    int  n_contexts = 1;
+
+    dai_llm_pooling pooling   = DAI_LLM_POOLING_MODEL;
+    bool            normalize = true;   // L2-normalise, so dot product = cosine
+};
+
+/** Load an embedding model. nullptr on failure or for reranker (rank pooling) models. */
+dai_llm_embedder *dai_llm_embedder_load(const std::string &path, const dai_llm_embed_params &params);
+
+void dai_llm_embedder_free(dai_llm_embedder *embedder);
+
+/** Vector length (the model's n_embd). */
+int dai_llm_embedder_dim(dai_llm_embedder *embedder);
+
+/** The embedding model's tokenizer, for sizing chunks in its tokens. */
+const llama_vocab *dai_llm_embedder_vocab(dai_llm_embedder *embedder);
+
+/**
+ * Embed texts into out, row-major: texts.size() * dim floats. Texts that
+ * tokenize to nothing get a zero vector. False if a decode fails.
+ */
+bool dai_llm_embed(dai_llm_embedder *embedder, const std::vector<std::string> &texts, float *out);
+
+#endif // DEVICEAI_LLM_EMBED_H
@@ -0,0 +1,657 @@
+/**
+ * deviceai_llm_engine.cpp - Platform-neutral llama.cpp generation core
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_engine.h"
+#include "deviceai_llm_scheduler.h"
+#include "deviceai_llm_speculative.h"
+#include "deviceai_llm_prefix_cache.h"
+#include "deviceai_llm_grammar.h"
+#include "deviceai_llm_context.h"
+#include "deviceai_llm_metrics.h"
+#include "deviceai_llm_threads.h"
+#include "deviceai_llm_jobs.h"
+#include "deviceai_llm_stop.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmEngine"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGW(...) fprintf(stderr, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+// ═══════════════════════════════════════════════════════════════
+//                       Model registry
+// Loaded models keyed by (path, gpu layers). A second init of the same GGUF
+// returns the existing weights instead of mapping them again. Loading runs
+// outside the mutex: an entry without a model marks a load in progress,
+// which other loads of the same key wait for on g_registry_cv.
+// ═══════════════════════════════════════════════════════════════
+
+struct registry_entry {
+    std::string          path;
+    int                  n_gpu_layers = 0;
+    dai_llm_model_params params;             // of the load that created the entry
+    dai_llm_model       *model = nullptr;    // nullptr while loading
+};
+
+static std::mutex                  g_registry_mutex;
+static std::condition_variable     g_registry_cv;
+static std::vector<registry_entry> g_models;   // guarded by g_registry_mutex
+
+// Compiled grammars kept per model.
+static const int GRAMMAR_CACHE_ENTRIES = 32;
+
+static ggml_type to_ggml_type(dai_llm_kv_type type) {
+    switch (type) {
+        case DAI_LLM_KV_Q8_0: return GGML_TYPE_Q8_0;
+        case DAI_LLM_KV_Q4_0: return GGML_TYPE_Q4_0;
+        default:              return GGML_TYPE_F16;
+    }
+}
+
+llama_model_params dai_llm_model_load_params(const dai_llm_model_params &params) {
+    llama_model_params mparams = llama_model_default_params();
+    mparams.n_gpu_layers = params.use_gpu ? 99 : 0;
+    mparams.use_mmap     = params.use_mmap;
+    mparams.use_mlock    = params.use_mlock;
+    return mparams;
+}
+
+llama_context_params dai_llm_context_params(const dai_llm_model_params &params) {
+    llama_context_params cparams = llama_context_default_params();
+    cparams.n_ctx     = (uint32_t)std::max(0, params.n_ctx);
+    if (params.n_batch  > 0) cparams.n_batch  = (uint32_t)params.n_batch;
+    if (params.n_ubatch > 0) cparams.n_ubatch = (uint32_t)params.n_ubatch;
+    cparams.n_threads       = params.n_threads;
+    cparams.n_threads_batch = params.n_threads_batch > 0 ? params.n_threads_batch : params.n_threads;
+    const int n_seq = std::max(params.max_candidates, params.score_sequences);
+    if (n_seq > 1) {
+        // Candidates and scored continuations fork from the prompt's cells,
+        // so they must share one pool.
+        cparams.n_seq_max  = (uint32_t)n_seq;
+        cparams.kv_unified = true;
+    }
+    cparams.type_k    = to_ggml_type(params.type_k);
+    cparams.type_v    = to_ggml_type(params.type_v);
+
+    cparams.flash_attn_type = params.flash_attn < 0  ? LLAMA_FLASH_ATTN_TYPE_AUTO
+                            : params.flash_attn == 0 ? LLAMA_FLASH_ATTN_TYPE_DISABLED
+                            :                          LLAMA_FLASH_ATTN_TYPE_ENABLED;
+    if (params.flash_attn == 0 && params.type_v != DAI_LLM_KV_F16) {
+        // llama.cpp refuses a quantized V cache without flash attention.
+        LOGI("Quantized V cache needs flash attention; using F16 for V");
+        cparams.type_v = GGML_TYPE_F16;
+    }
+    return cparams;
+}
+
+// Everything but the threads, which dai_llm_set_threads can change later.
+static bool same_load_params(const dai_llm_model_params &a, const dai_llm_model_params &b) {
+    return a.n_ctx == b.n_ctx && a.n_batch == b.n_batch && a.n_ubatch == b.n_ubatch &&
+           a.type_k == b.type_k && a.type_v == b.type_v && a.flash_attn == b.flash_attn &&
+           a.use_mmap == b.use_mmap && a.use_mlock == b.use_mlock && a.n_parallel == b.n_parallel &&
+           a.max_candidates == b.max_candidates && a.score_sequences == b.score_sequences &&
+           a.draft_path == b.draft_path && a.prefix_cache_bytes == b.prefix_cache_bytes &&
+           a.job_workers == b.job_workers && a.job_queue == b.job_queue;
+}
+
+static dai_llm_model *load_model(const std::string &path, const dai_llm_model_params &params, int n_gpu_layers) {
+    llama_model_params mparams = dai_llm_model_load_params(params);
+
+    llama_model *model = llama_model_load_from_file(path.c_str(), mparams);
+    if (!model) {
+        LOGE("Failed to load model from %s", path.c_str());
+        return nullptr;
+    }
+
+    auto *m = new dai_llm_model();
+    m->model        = model;
+    m->path         = path;
+    m->n_gpu_layers = n_gpu_layers;
+    m->n_parallel   = std::max(1, params.n_parallel);
+    m->max_candidates = std::max(1, params.max_candidates);
+    m->cparams      = dai_llm_context_params(params);
+    m->threads      = dai_llm_threads_from_params(params);
+    m->refs         = 1;
+    m->prefix_cache = dai_llm_prefix_cache_create(params.prefix_cache_bytes);
+    m->grammar_cache = dai_llm_grammar_cache_create(GRAMMAR_CACHE_ENTRIES);
+    m->metrics      = dai_llm_metrics_create();
+    m->job_workers  = params.job_workers;
+    m->job_queue    = params.job_queue;
+
+    const std::string &draft_path = params.draft_path;
+    if (m->n_parallel > 1) {
+        if (!draft_path.empty()) LOGI("Draft model ignored: speculation needs parallel=1");
+        m->scheduler = dai_llm_scheduler_create(m, m->n_parallel);
+        if (!m->scheduler) {
+            dai_llm_prefix_cache_free(m->prefix_cache);
+            dai_llm_grammar_cache_free(m->grammar_cache);
+            dai_llm_metrics_free(m->metrics);
+            llama_model_free(model);
+            delete m;
+            return nullptr;
+        }
+    } else if (!draft_path.empty()) {
+        llama_model *draft = llama_model_load_from_file(draft_path.c_str(), mparams);
+        if (!draft || !dai_llm_draft_compatible(model, draft)) {
+            LOGE("Draft model %s %s", draft_path.c_str(), draft ? "has an incompatible vocabulary" : "failed to load");
+            if (draft) llama_model_free(draft);
+            dai_llm_prefix_cache_free(m->prefix_cache);
+            dai_llm_grammar_cache_free(m->grammar_cache);
+            dai_llm_metrics_free(m->metrics);
+            llama_model_free(model);
+            delete m;
+            return nullptr;
+        }
+        m->draft      = draft;
+        m->draft_path = draft_path;
+    }
+
+    LOGI("LLM model loaded: %s (threads=%d/%d, gpu=%d, ctx=%d, kv=%d/%d, fa=%d, parallel=%d, draft=%s, prefix cache=%zu bytes)",
+         path.c_str(), m->threads.n_threads, m->threads.n_threads_batch, params.use_gpu, params.n_ctx, params.type_k, params.type_v,
+         params.flash_attn, m->n_parallel, m->draft ? m->draft_path.c_str() : "none", params.prefix_cache_bytes);
+    return m;
+}
+
+dai_llm_model *dai_llm_model_load(const std::string &path, const dai_llm_model_params &params) {
+    const int n_gpu_layers = params.use_gpu ? 99 : 0;
+    auto find = [&] {
+        return std::find_if(g_models.begin(), g_models.end(), [&](const registry_entry &e) {
+            return e.path == path && e.n_gpu_layers == n_gpu_layers;
+        });
+    };
+
+    std::unique_lock<std::mutex> lock(g_registry_mutex);
+    for (auto it = find(); it != g_models.end(); it = find()) {
+        if (!it->model) {   // another thread is loading it
+            g_registry_cv.wait(lock);
+            continue;
+        }
+        if (!same_load_params(it->params, params)) {
+            LOGW("LLM model %s already loaded; keeping its context, KV, parallel and draft settings", path.c_str());
+        }
+        it->model->refs++;
+        return it->model;
+    }
+    g_models.push_back({path, n_gpu_layers, params, nullptr});
+    lock.unlock();
+
+    dai_llm_model *m = load_model(path, params, n_gpu_layers);
+
+    lock.lock();
+    auto it = find();
+    if (m) it->model = m;
+    else   g_models.erase(it);   // a waiting load retries
+    g_registry_cv.notify_all();
+    return m;
+}
+
+void dai_llm_model_release(dai_llm_model *model) {
+    if (!model) return;
+    std::lock_guard<std::mutex> lock(g_registry_mutex);
+
+    if (--model->refs > 0) return;
+
+    g_models.erase(std::remove_if(g_models.begin(), g_models.end(),
+                                  [model](const registry_entry &e) { return e.model == model; }),
+                   g_models.end());
+    dai_llm_jobs_free(model->jobs.load());
+    if (model->scheduler) dai_llm_scheduler_free(model->scheduler);
+    if (model->draft)     llama_model_free(model->draft);
+    dai_llm_prefix_cache_free(model->prefix_cache);
+    dai_llm_grammar_cache_free(model->grammar_cache);
+    dai_llm_metrics_free(model->metrics);
+    llama_model_free(model->model);
+    delete model;
+}
+
+// ggml checks this between graph nodes; true makes llama_decode return
+// DAI_LLM_DECODE_ABORTED.
+static bool session_aborted(void *data) {
+    return static_cast<dai_llm_session *>(data)->cancel.load(std::memory_order_relaxed);
+}
+
+dai_llm_session *dai_llm_session_create(dai_llm_model *model) {
+    if (!model || !model->model) return nullptr;
+
+    if (model->scheduler) {
+        auto *s = new dai_llm_session();
+        s->model     = model;
+        s->scheduler = model->scheduler;
+        return s;
+    }
+
+    // n_ctx = 0 → llama.cpp uses the model's native context size from GGUF metadata
+    llama_context_params cparams = model->cparams;
+
+    llama_context *ctx = llama_init_from_model(model->model, cparams);
+    if (!ctx) {
+        LOGE("Failed to create llama context");
+        return nullptr;
+    }
+
+    llama_context *draft_ctx = nullptr;
+    if (model->draft) {
+        // The draft must hold everything the target holds, in sequence 0 only.
+        cparams.n_ctx      = llama_n_ctx(ctx);
+        cparams.n_seq_max  = 1;
+        cparams.kv_unified = false;
+        draft_ctx = llama_init_from_model(model->draft, cparams);
+        if (!draft_ctx) {
+            LOGE("Failed to create draft context");
+            llama_free(ctx);
+            return nullptr;
+        }
+    }
+
+    auto *s = new dai_llm_session();
+    s->model     = model;
+    s->ctx       = ctx;
+    s->draft_ctx = draft_ctx;
+
+    llama_set_abort_callback(ctx, session_aborted, s);
+    if (draft_ctx) llama_set_abort_callback(draft_ctx, session_aborted, s);
+
+    LOGI("LLM session created (ctx=%d, draft=%d)", llama_n_ctx(ctx), draft_ctx != nullptr);
+    return s;
+}
+
+void dai_llm_session_free(dai_llm_session *session) {
+    if (!session) return;
+    dai_llm_jobs_drop_session(session->model->jobs.load(), session);
+    session->cancel = true;
+    {
+        // Wait for an in-flight generate to observe the cancel flag.
+        std::lock_guard<std::mutex> lock(session->mutex);
+        if (session->ctx)       { llama_free(session->ctx);       session->ctx       = nullptr; }
+        if (session->draft_ctx) { llama_free(session->draft_ctx); session->draft_ctx = nullptr; }
+        dai_llm_threads_release(session->threads);
+    }
+    delete session;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                         Helpers
+// ═══════════════════════════════════════════════════════════════
+
+std::vector<llama_token> dai_llm_tokenize(const llama_vocab *vocab, const std::string &text, int n_max,
+                                          bool add_special) {
+    const bool unbounded = n_max <= 0;
+    // Rarely more tokens than bytes (+ BOS/EOS); a negative result gives the exact count.
+    std::vector<llama_token> tokens(unbounded ? text.size() + 2 : (size_t)n_max);
+    auto run = [&] {
+        return llama_tokenize(vocab, text.c_str(), (int)text.size(), tokens.data(), (int)tokens.size(),
+                              add_special, /*parse_special=*/true);
+    };
+    int n_tokens = run();
+    if (n_tokens < 0 && unbounded) {
+        tokens.resize((size_t)-n_tokens);
+        n_tokens = run();
+    }
+    if (n_tokens <= 0) return {};
+    tokens.resize(n_tokens);
+    return tokens;
+}
+
+std::vector<llama_token> dai_llm_tokenize_prompt(const llama_vocab *vocab, const std::string &prompt,
+                                                 const dai_llm_gen_params &params, int n_max) {
+    const size_t at = params.splice_marker.empty() ? std::string::npos : prompt.find(params.splice_marker);
+    if (at == std::string::npos) return dai_llm_tokenize(vocab, prompt, n_max);
+
+    // The template puts the marker after a line break, where tokenizers split
+    // anyway, so the pieces tokenize as the whole prompt would.
+    std::vector<llama_token> tokens = dai_llm_tokenize(vocab, prompt.substr(0, at), 0);
+    if (tokens.empty() && at > 0) return {};
+    tokens.insert(tokens.end(), params.splice_tokens.begin(), params.splice_tokens.end());
+
+    const std::string tail = prompt.substr(at + params.splice_marker.size());
+    if (!tail.empty()) {
+        std::vector<llama_token> rest = dai_llm_tokenize(vocab, tail, 0, /*add_special=*/false);
+        if (rest.empty()) return {};
+        tokens.insert(tokens.end(), rest.begin(), rest.end());
+    }
+    if (tokens.empty() || (n_max > 0 && tokens.size() > (size_t)n_max)) return {};
+    return tokens;
+}
+
+size_t dai_llm_common_prefix(const std::vector<llama_token> &a, const std::vector<llama_token> &b) {
+    size_t n = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < n && a[i] == b[i]) i++;
+    return i;
+}
+
+// Drop everything in the session's KV cache and forget the cached tokens.
+static void reset_kv_cache(dai_llm_session *s) {
+    llama_memory_clear(llama_get_memory(s->ctx), /*data=*/false);
+    s->kv_tokens.clear();
+}
+
+void dai_llm_kv_rollback(dai_llm_session *s) {
+    if (!llama_memory_seq_rm(llama_get_memory(s->ctx), 0, (llama_pos)s->kv_tokens.size(), -1)) reset_kv_cache(s);
+}
+
+bool dai_llm_prefill(
+    dai_llm_session *s,
+    const std::vector<llama_token> &tokens,
+    int chunk,
+    const dai_llm_progress_cb &on_progress
+) {
+    // Chunk by chunk: prompts longer than n_batch cannot go in one llama_decode
+    // call, and chunking lets cancel take effect (and progress be observed)
+    // during long RAG prefills.
+    const int n_total = (int)tokens.size();
+    if (on_progress) on_progress((int)s->kv_tokens.size(), n_total);
+
+    for (int i = (int)s->kv_tokens.size(); i < n_total; i += chunk) {
+        if (s->cancel.load()) return false;   // decoded chunks stay cached for reuse
+
+        const int n = std::min(chunk, n_total - i);
+        llama_batch batch = llama_batch_get_one(const_cast<llama_token *>(tokens.data()) + i, n);
+        const int rc = llama_decode(s->ctx, batch);
+        if (rc == DAI_LLM_DECODE_ABORTED) {
+            dai_llm_kv_rollback(s);
+            return false;
+        }
+        if (rc) {
+            LOGE("llama_decode prompt failed");
+            reset_kv_cache(s);
+            return false;
+        }
+        s->kv_tokens.insert(s->kv_tokens.end(), tokens.begin() + i, tokens.begin() + i + n);
+        if (on_progress) on_progress(i + n, n_total);
+    }
+    return true;
+}
+
+int dai_llm_prefill_chunk(const dai_llm_gen_params &params, int n_batch) {
+    if (params.prefill_chunk <= 0) return n_batch;
+    return std::min(params.prefill_chunk, n_batch);
+}
+
+llama_sampler *dai_llm_build_sampler(const dai_llm_gen_params &p, dai_llm_model *model) {
+    const llama_vocab *vocab = llama_model_get_vocab(model->model);
+    auto *chain = llama_sampler_chain_init(llama_sampler_chain_default_params());
+    if (!p.grammar.empty()) {
+        // First, so dai_llm_sample can see what it leaves. It may force an
+        // end-of-generation token even under ignore_eos.
+        llama_sampler *grammar = dai_llm_grammar_sampler(model->grammar_cache, vocab, p.grammar);
+        if (!grammar) {
+            llama_sampler_free(chain);
+            return nullptr;
+        }
+        llama_sampler_chain_add(chain, grammar);
+    }
+    if (p.ignore_eos) {
+        const int n_vocab = llama_vocab_n_tokens(vocab);
+        std::vector<llama_logit_bias> bias;
+        for (llama_token t = 0; t < n_vocab; t++) {
+            if (llama_vocab_is_eog(vocab, t)) bias.push_back({ t, -INFINITY });
+        }
+        llama_sampler_chain_add(chain, llama_sampler_init_logit_bias(n_vocab, (int32_t)bias.size(), bias.data()));
+    }
+    llama_sampler_chain_add(chain, llama_sampler_init_top_k(p.top_k));
+    llama_sampler_chain_add(chain, llama_sampler_init_top_p(p.top_p, 1));
+    llama_sampler_chain_add(chain, llama_sampler_init_temp(p.temperature));
+    llama_sampler_chain_add(chain, llama_sampler_init_penalties(
+        64,            // last_n penalty window
+        p.repeat_penalty,
+        0.0f,          // freq penalty
+        0.0f           // presence penalty
+    ));
+    llama_sampler_chain_add(chain, llama_sampler_init_dist(p.seed));
+    return chain;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//              Chat-template prompt formatting
+// ═══════════════════════════════════════════════════════════════
+
+std::string dai_llm_format_chat(
+    const dai_llm_model *model,
+    const std::vector<std::string> &roles,
+    const std::vector<std::string> &contents,
+    bool add_assistant
+) {
+    if (!model || !model->model) return "";
+
+    size_t count = std::min(roles.size(), contents.size());
+    if (count == 0) return "";
+
+    std::vector<llama_chat_message> msgs;
+    msgs.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        msgs.push_back({ roles[i].c_str(), contents[i].c_str() });
+    }
+
+    const char *tmpl = llama_model_chat_template(model->model, nullptr);
+    int32_t sz = llama_chat_apply_template(tmpl, msgs.data(), msgs.size(), add_assistant, nullptr, 0);
+    if (sz <= 0) return "";
+
+    std::string out(sz, '\0');
+    llama_chat_apply_template(tmpl, msgs.data(), msgs.size(), add_assistant, out.data(), sz);
+    return out;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                    Core generation loop
+// ═══════════════════════════════════════════════════════════════
+
+// One token per llama_decode call. Expects logits for the last prompt token.
+static std::string sample_loop(
+    dai_llm_session *s,
+    llama_sampler *sampler,
+    const dai_llm_gen_params &params,
+    const dai_llm_token_cb &on_token,
+    dai_llm_metrics_recorder &rec
+) {
+    const llama_vocab *vocab = llama_model_get_vocab(s->model->model);
+
+    std::string result;
+    char piece_buf[256];
+    int n_generated = 0;
+
+    while (n_generated < params.max_tokens && !s->cancel.load()) {
+        const auto t_sample = dai_llm_metrics_recorder::clock::now();
+        llama_token token = dai_llm_sample(sampler, s->ctx, -1);
+        if (token == LLAMA_TOKEN_NULL) break;   // grammar dead end
+        llama_sampler_accept(sampler, token);
+        rec.sampled(t_sample);
+
+        if (llama_vocab_is_eog(vocab, token)) break;
+
+        int n = llama_token_to_piece(vocab, token, piece_buf, sizeof(piece_buf), 0, true);
+        if (n < 0) break;
+
+        std::string piece(piece_buf, n);
+        result += piece;
+        n_generated++;
+        rec.emitted();
+
+        if (!on_token(piece)) break;
+
+        // Decode the new token
+        if (!dai_llm_context_make_room(s, params, 1)) break;
+        llama_batch next = llama_batch_get_one(&token, 1);
+        const int rc = llama_decode(s->ctx, next);
+        if (rc) {
+            if (rc == DAI_LLM_DECODE_ABORTED) {
+                dai_llm_kv_rollback(s);
+            } else {
+                reset_kv_cache(s);
+                rec.m.failed = true;
+            }
+            break;
+        }
+        s->kv_tokens.push_back(token);
+        rec.kv(s->kv_tokens.size());
+    }
+    return result;
+}
+
+bool dai_llm_prepare_prompt(
+    dai_llm_session *s,
+    const std::string &prompt,
+    const dai_llm_gen_params &params,
+    const dai_llm_progress_cb &on_progress,
+    dai_llm_metrics_recorder &rec
+) {
+    const llama_vocab *vocab = llama_model_get_vocab(s->model->model);
+
+    // Tokenize. With context shifting the prompt may hold more history than
+    // fits; it is cut down to the session's window.
+    auto tokens = dai_llm_tokenize_prompt(vocab, prompt, params, params.context_shift ? 0 : (int)llama_n_ctx(s->ctx));
+    if (tokens.empty()) {
+        LOGE("Tokenization failed");
+        return false;
+    }
+    if (params.context_shift) {
+        dai_llm_context_fit(s, tokens, dai_llm_context_keep(vocab, params, tokens), (size_t)std::max(params.max_tokens, 0));
+    } else {
+        s->n_shifted = 0;
+    }
+
+    // Reuse the KV cells of the longest prefix shared with the previous request
+    // (system prompt + earlier turns) and only drop the part that diverges.
+    // At least one token is always re-decoded so the sampler has fresh logits.
+    size_t n_keep = std::min(dai_llm_common_prefix(s->kv_tokens, tokens), tokens.size() - 1);
+
+    // Another session may have prefilled a longer prefix of this prompt.
+    size_t n_cached = dai_llm_prefix_cache_restore(s->model->prefix_cache, s->ctx, 0, tokens, n_keep);
+    if (n_cached != n_keep) {
+        s->kv_tokens.assign(tokens.begin(), tokens.begin() + n_cached);
+        n_keep = std::min(n_cached, tokens.size() - 1);
+    }
+
+    if (!llama_memory_seq_rm(llama_get_memory(s->ctx), 0, (llama_pos)n_keep, -1)) {
+        // Partial removal unsupported (e.g. recurrent models) — start from scratch.
+        reset_kv_cache(s);
+        n_keep = 0;
+    }
+    s->kv_tokens.resize(n_keep);
+
+    // Decode only the new suffix of the prompt
+    rec.m.n_ctx = (int)llama_n_ctx(s->ctx);
+    rec.begin_prefill(tokens.size(), n_keep);
+    const int chunk = dai_llm_prefill_chunk(params, (int)llama_n_batch(s->ctx));
+    if (!dai_llm_prefill(s, tokens, chunk, on_progress)) return false;
+    rec.end_prefill();
+    rec.kv(s->kv_tokens.size());
+    return true;
+}
+
+void dai_llm_store_prefix(dai_llm_session *s, size_t n_reused) {
+    // Shifted cells only approximate a fresh prefill; keep them out of the shared cache.
+    if (s->n_shifted > 0 || s->kv_tokens.size() <= n_reused) return;
+    dai_llm_prefix_cache_store(s->model->prefix_cache, s->ctx, 0, s->kv_tokens, s->kv_tokens.size() - n_reused);
+}
+
+static std::string generate_locked(
+    dai_llm_session *s,
+    const std::string &prompt,
+    const dai_llm_gen_params &params,
+    const dai_llm_token_cb &on_token,
+    const dai_llm_progress_cb &on_progress,
+    dai_llm_metrics_recorder &rec
+) {
+    if (!s->ctx && !s->scheduler) {
+        rec.m.failed = true;
+        return "";
+    }
+
+    s->cancel       = false;
+    s->cancel_at_ns = 0;
+
+    const llama_vocab *vocab = llama_model_get_vocab(s->model->model);
+
+    if (s->scheduler) {
+        auto tokens = dai_llm_tokenize_prompt(vocab, prompt, params, dai_llm_scheduler_n_ctx_seq(s->scheduler));
+        if (tokens.empty()) {
+            LOGE("Tokenization failed");
+            rec.m.failed = true;
+            return "";
+        }
+        return dai_llm_scheduler_generate(s->scheduler, s, tokens, params, on_token, on_progress, &rec);
+    }
+
+    // Build sampler (first: a grammar that does not parse fails the request before prefill)
+    auto *sampler = dai_llm_build_sampler(params, s->model);
+    if (!sampler) {
+        rec.m.failed = true;
+        return "";
+    }
+
+    dai_llm_threads_apply(s->model, s->threads, s->ctx, s->draft_ctx);
+    if (!dai_llm_prepare_prompt(s, prompt, params, on_progress, rec)) {
+        llama_sampler_free(sampler);
+        rec.m.failed = !s->cancel;
+        return "";
+    }
+
+    std::string result = (s->draft_ctx || params.prompt_lookup) && params.n_draft > 0
+        ? dai_llm_speculative_loop(s, sampler, params, on_token, rec)
+        : sample_loop(s, sampler, params, on_token, rec);
+
+    llama_sampler_free(sampler);
+    // The reply is part of the next turn's prompt, so it is cached along with it.
+    dai_llm_store_prefix(s, rec.m.cached_tokens);
+    return result;
+}
+
+std::string dai_llm_generate(
+    dai_llm_session *s,
+    const std::string &prompt,
+    const dai_llm_gen_params &params,
+    const dai_llm_token_cb &on_token,
+    const dai_llm_progress_cb &on_progress,
+    dai_llm_gen_metrics *metrics
+) {
+    if (!s) return "";
+    dai_llm_metrics_recorder rec;   // started before the lock: waiting counts toward ttft
+
+    dai_llm_stop_filter stop;
+    dai_llm_token_cb    cb = on_token;
+    if (dai_llm_stop_init(stop, params, on_token)) {
+        cb = [&stop](const std::string &piece) { return dai_llm_stop_feed(stop, piece); };
+    }
+
+    std::string result;
+    {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        result = generate_locked(s, prompt, params, cb, on_progress, rec);
+        dai_llm_stop_finish(stop, result);
+    }
+    rec.cancel_at_ns = s->cancel_at_ns.load();
+    rec.m.stop_reason = stop.reason;
+    dai_llm_gen_metrics m = dai_llm_metrics_finish(rec, s->model->metrics);
+    if (metrics) *metrics = m;
+    return result;
+}
+
+void dai_llm_cancel(dai_llm_session *session) {
+    if (!session) return;
+    // Timestamp first: the generating thread may return as soon as it sees cancel.
+    int64_t expected = 0;
+    session->cancel_at_ns.compare_exchange_strong(expected, dai_llm_metrics_now_ns());
+    session->cancel = true;
+}
+
+dai_llm_spec_stats dai_llm_speculative_stats(dai_llm_session *session) {
+    if (!session) return {};
+    std::lock_guard<std::mutex> lock(session->stats_mutex);
+    return session->spec;
+}
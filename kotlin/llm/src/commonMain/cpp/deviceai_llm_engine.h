@@ -0,0 +1,439 @@
+#ifndef DEVICEAI_LLM_ENGINE_H
+#define DEVICEAI_LLM_ENGINE_H
+
+/**
+ * deviceai_llm_engine.h - Platform-neutral llama.cpp generation core
+ *
+ * Shared by the JNI bridge (deviceai_llm_jni.cpp, Android + JVM desktop) and
+ * the iOS C API (llm_ios.cpp). The bridges only marshal arguments; all model,
+ * session and decode-loop logic lives here.
+ *
+ * Ownership model:
+ *   dai_llm_model   — one loaded GGUF. Reference-counted and de-duplicated by
+ *                     path, so several sessions on the same file share weights.
+ *   dai_llm_session — one llama_context on a shared model: its own KV cache,
+ *                     sampler and cancel flag. Sessions are independent and
+ *                     may generate concurrently from different threads.
+ *
+ * A model may carry a smaller draft model of the same family; sessions on it
+ * then get a second (draft) context and decode speculatively
+ * (see deviceai_llm_speculative.h).
+ */
+
+#include "llama.h"
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <functional>
+
+// ═══════════════════════════════════════════════════════════════
+//                           TYPES
+// ═══════════════════════════════════════════════════════════════
+
+struct dai_llm_scheduler;
+struct dai_llm_prefix_cache;
+struct dai_llm_grammar_cache;
+struct dai_llm_metrics;
+struct dai_llm_gen_metrics;
+struct dai_llm_metrics_recorder;
+struct dai_llm_jobs;
+
+// CPU threads of a model's contexts. Decode (one token per step) is memory-
+// bound and often fastest on fewer, big cores; prefill and other batches are
+// compute-bound and scale further. Changeable at runtime (deviceai_llm_threads.h).
+struct dai_llm_threads {
+    int      n_threads       = 4;       // single-token decode steps
+    int      n_threads_batch = 4;       // prompt prefill and multi-token batches
+    uint64_t cpu_mask        = 0;       // CPUs (bit i = CPU i) for decode threads; 0 = unpinned
+    uint64_t cpu_mask_batch  = 0;       // same for batch threads; 0 = cpu_mask
+    bool     strict_cpu      = false;   // one thread per CPU of the mask instead of floating within it
+
+    bool operator==(const dai_llm_threads &o) const {
+        return n_threads == o.n_threads && n_threads_batch == o.n_threads_batch && cpu_mask == o.cpu_mask &&
+               cpu_mask_batch == o.cpu_mask_batch && strict_cpu == o.strict_cpu;
+    }
+};
+
+// Threads applied to one context (plus its draft), owned by whoever decodes on it.
+struct dai_llm_ctx_threads {
+    uint32_t          version    = 0;         // dai_llm_model::threads_version last applied
+    ggml_threadpool_t pool       = nullptr;   // pinned pools, only with CPU masks
+    ggml_threadpool_t pool_batch = nullptr;
+};
+
+struct dai_llm_model {
+    llama_model *model = nullptr;
+    std::string  path;
+    int          n_gpu_layers   = 0;
+    int          n_parallel     = 1;   // > 1 → sessions share one batched context
+    int          max_candidates = 1;   // most dai_llm_generate_n candidates on own contexts
+    int          refs           = 0;   // guarded by the registry mutex
+
+    // Template for every context created on the model (sizes, threads,
+    // KV cache types, flash attention), fixed by the first load.
+    llama_context_params cparams = {};
+
+    // Current thread configuration. Contexts compare threads_version with
+    // the one they applied before each decode, so a change needs no reload.
+    std::mutex            threads_mutex;
+    dai_llm_threads       threads;              // guarded by threads_mutex
+    std::atomic<uint32_t> threads_version{1};
+
+    // Continuous-batching scheduler, created at load time when n_parallel > 1.
+    dai_llm_scheduler *scheduler = nullptr;
+
+    // Optional draft model for speculative decoding (same vocabulary family).
+    llama_model *draft = nullptr;
+    std::string  draft_path;
+
+    // Prompt-prefix states shared by all sessions on this model.
+    dai_llm_prefix_cache *prefix_cache = nullptr;
+
+    // Compiled grammars of recent constrained requests (deviceai_llm_grammar.h).
+    dai_llm_grammar_cache *grammar_cache = nullptr;
+
+    // Aggregate of every finished request (deviceai_llm_metrics.h).
+    dai_llm_metrics *metrics = nullptr;
+
+    // Asynchronous job executor (deviceai_llm_jobs.h), started by the first
+    // submit with job_workers threads (0 = n_parallel) and room for job_queue
+    // waiting jobs.
+    int                         job_workers = 0;
+    int                         job_queue   = 16;
+    std::once_flag              jobs_once;
+    std::atomic<dai_llm_jobs *> jobs{nullptr};
+
+    // Identity of the weights file for on-disk KV snapshots, computed on
+    // first use (see deviceai_llm_snapshot.h).
+    std::once_flag fingerprint_once;
+    uint64_t       fingerprint = 0;
+};
+
+// Cumulative speculative-decoding counters for one session.
+struct dai_llm_spec_stats {
+    int64_t n_drafted  = 0;   // tokens proposed by the draft model or prompt lookup
+    int64_t n_accepted = 0;   // proposed tokens the target model agreed with
+    int64_t n_rounds   = 0;   // target verification passes
+};
+
+struct dai_llm_session {
+    dai_llm_model *model = nullptr;
+    llama_context *ctx   = nullptr;   // own context (nullptr for scheduler sessions)
+
+    // Set instead of ctx when the model runs a batching scheduler: requests are
+    // queued and decoded together with other sessions' requests.
+    dai_llm_scheduler *scheduler = nullptr;
+
+    // Tokens currently resident in the own context's KV cache (sequence 0), in
+    // position order. Lets dai_llm_generate reuse the shared prefix of consecutive chat turns
+    // instead of re-prefilling the whole conversation on every request.
+    std::vector<llama_token> kv_tokens;
+
+    // Thread pools of ctx and draft_ctx (guarded by mutex).
+    dai_llm_ctx_threads threads;
+
+    // Draft model context and its resident tokens, when the model has a draft.
+    llama_context           *draft_ctx = nullptr;
+    std::vector<llama_token> draft_tokens;
+
+    // Context shifting (deviceai_llm_context.h): the conversation's tokens
+    // [shift_keep, shift_keep + n_shifted) were evicted from the KV cache and
+    // the rest moved down, so kv_tokens = history minus that range.
+    size_t shift_keep = 0;
+    size_t n_shifted  = 0;
+
+    // Also polled by ctx's and draft_ctx's abort callback, so a cancel stops a
+    // llama_decode between graph nodes instead of after the whole batch.
+    std::atomic<bool>    cancel{false};
+    std::atomic<int64_t> cancel_at_ns{0};   // steady_clock time of dai_llm_cancel, 0 = none
+    std::mutex           mutex;             // serialises generate calls on this session
+
+    // Counters readable while a generation is running.
+    std::mutex         stats_mutex;
+    dai_llm_spec_stats spec;          // guarded by stats_mutex
+};
+
+// KV cache element types. Quantized caches cut KV memory to ~53% (Q8_0) or
+// ~28% (Q4_0) of F16; a quantized V cache needs flash attention.
+enum dai_llm_kv_type {
+    DAI_LLM_KV_F16  = 0,
+    DAI_LLM_KV_Q8_0 = 1,
+    DAI_LLM_KV_Q4_0 = 2,
+};
+
+struct dai_llm_model_params {
+    int         n_threads  = 4;
+    bool        use_gpu    = true;
+
+    // Prefill threads (0 = n_threads) and optional CPU pinning; see dai_llm_threads.
+    int         n_threads_batch = 0;
+    uint64_t    cpu_mask        = 0;
+    uint64_t    cpu_mask_batch  = 0;
+    bool        strict_cpu      = false;
+
+    // Context sizing. 0 keeps llama.cpp's default: the model's native context
+    // length (often 32k-128k tokens) and its default batch sizes. With
+    // n_parallel > 1, n_ctx is shared by all sequences.
+    int         n_ctx      = 0;
+    int         n_batch    = 0;   // max tokens per llama_decode call
+    int         n_ubatch   = 0;   // physical batch; bounds the compute buffer
+
+    dai_llm_kv_type type_k = DAI_LLM_KV_F16;
+    dai_llm_kv_type type_v = DAI_LLM_KV_F16;
+    int         flash_attn = -1;  // -1 auto, 0 off, 1 on (llama_flash_attn_type)
+
+    bool        use_mmap   = true;
+    bool        use_mlock  = false;   // pin weights in RAM (may fail without privileges)
+
+    // > 1 starts a continuous-batching scheduler (deviceai_llm_scheduler.h).
+    int         n_parallel = 1;
+
+    // Sequences of each session's own context: the most candidates one
+    // dai_llm_generate_n call decodes side by side (deviceai_llm_nbest.h).
+    // > 1 makes the KV cache unified so the candidates share prompt cells.
+    int         max_candidates = 1;
+
+    // Continuations one dai_llm_score_continuations pass teacher-forces side
+    // by side (deviceai_llm_score.h); 1 scores them one decode each. Own
+    // contexts get max(max_candidates, score_sequences) sequences, and more
+    // than one makes their KV cache unified.
+    int         score_sequences = 1;
+
+    // Smaller GGUF with a compatible vocabulary used to speculate tokens for
+    // sessions with their own context. Ignored when n_parallel > 1.
+    std::string draft_path;
+
+    // Byte budget for the cross-session prefix cache
+    // (deviceai_llm_prefix_cache.h). 0 disables stored prefixes.
+    size_t      prefix_cache_bytes = 0;
+
+    // Asynchronous jobs (deviceai_llm_jobs.h): worker threads (0 = one per
+    // parallel sequence) and the most jobs waiting before submits are refused.
+    int         job_workers = 0;
+    int         job_queue   = 16;
+};
+
+struct dai_llm_gen_params {
+    int   max_tokens     = 512;
+    float temperature    = 0.7f;
+    float top_p          = 0.9f;
+    int   top_k          = 40;
+    float repeat_penalty = 1.1f;
+
+    // Never sample end-of-generation tokens, so exactly max_tokens are
+    // generated. For benchmarks; output past the natural end is noise.
+    bool  ignore_eos     = false;
+
+    // Sampling seed. LLAMA_DEFAULT_SEED draws a random one per request;
+    // n-best candidate i uses seed + i.
+    uint32_t seed        = LLAMA_DEFAULT_SEED;
+
+    // Prompt tokens decoded per llama_decode call during prefill. Smaller
+    // chunks make cancel and progress more responsive at some throughput
+    // cost. 0 → the context's n_batch (also the upper bound).
+    int   prefill_chunk  = 0;
+
+    // Tokens the draft model proposes per verification pass. Ignored when the
+    // model has no draft; 0 disables speculation for this request.
+    int   n_draft        = 8;
+
+    // Prompt lookup (deviceai_llm_speculative.h): propose up to n_draft tokens
+    // that followed the latest earlier occurrence of the context's last
+    // lookup_ngram tokens (shorter n-grams if none), no draft model needed.
+    // Pays off when the output copies spans of the prompt. Own-context
+    // sessions only; with a draft model, the draft fills in when nothing matches.
+    bool  prompt_lookup  = false;
+    int   lookup_ngram   = 3;
+
+    // Context shifting: instead of failing once the conversation outgrows the
+    // context, evict the oldest tokens after the first n_keep and move the
+    // rest down in place (deviceai_llm_context.h). Sessions with their own
+    // context only. n_keep < 0 pins the tokens of keep_prefix instead,
+    // typically the formatted system prompt.
+    bool        context_shift = false;
+    int         n_keep        = -1;
+    std::string keep_prefix;
+
+    // Already-tokenized prompt text, e.g. packed RAG context
+    // (deviceai_llm_pack.h): the first splice_marker in the prompt stands for
+    // splice_tokens, which are decoded as they are instead of being
+    // detokenized and tokenized again.
+    std::string              splice_marker;
+    std::vector<llama_token> splice_tokens;
+
+    // Early stops (deviceai_llm_stop.h). Generation ends at the first of the
+    // stop strings in the output, even split across tokens; neither it nor
+    // what follows is streamed or returned. repeat_stop_tokens > 1 also ends
+    // it once that many trailing tokens are a short cycle repeated, 0 = off.
+    std::vector<std::string> stop;
+    int                      repeat_stop_tokens = 0;
+
+    // GBNF grammar the output must match, root rule "root"; empty = free
+    // text (deviceai_llm_grammar.h). The request fails when it does not parse.
+    std::string grammar;
+};
+
+// Called for each generated piece; return false to stop generation.
+using dai_llm_token_cb = std::function<bool(const std::string &)>;
+
+// Called after each prefill chunk with prompt tokens processed so far
+// (including reused KV-cache tokens) and the prompt's total token count.
+using dai_llm_progress_cb = std::function<void(int processed, int total)>;
+
+// ═══════════════════════════════════════════════════════════════
+//                        LIFECYCLE
+// ═══════════════════════════════════════════════════════════════
+
+/**
+ * Load a GGUF model, or take another reference to it if the same file is
+ * already loaded with the same GPU setting. Returns nullptr on failure.
+ *
+ * The first load of a file decides every other parameter (threads,
+ * scheduler, draft model, prefix cache); later loads share that instance and
+ * log a warning when their parameters differ. A load of a file that another
+ * thread is still loading waits for it; loads of other files run in parallel.
+ */
+dai_llm_model *dai_llm_model_load(const std::string &path, const dai_llm_model_params &params);
+
+/** Drop one reference; the weights are freed when the last one goes. */
+void dai_llm_model_release(dai_llm_model *model);
+
+/** Create a new session (own llama_context) on a loaded model. */
+dai_llm_session *dai_llm_session_create(dai_llm_model *model);
+
+/**
+ * Free a session's context, after cancelling its asynchronous jobs. Does not
+ * release the model reference.
+ */
+void dai_llm_session_free(dai_llm_session *session);
+
+// ═══════════════════════════════════════════════════════════════
+//                        GENERATION
+// ═══════════════════════════════════════════════════════════════
+
+/**
+ * Render role/content pairs with the model's embedded chat template
+ * (ChatML, Llama 3, Gemma, Mistral, etc.). Returns "" on failure.
+ * add_assistant appends the assistant-turn header; without it the result is
+ * a prefix of any longer conversation starting with the same messages.
+ */
+std::string dai_llm_format_chat(
+    const dai_llm_model *model,
+    const std::vector<std::string> &roles,
+    const std::vector<std::string> &contents,
+    bool add_assistant = true
+);
+
+/**
+ * Tokenize the prompt, decode only the part not already in the session's
+ * KV cache (in chunks of params.prefill_chunk, checking cancel in between),
+ * then run the sampling loop. Returns the full generated string.
+ *
+ * Callbacks always run on the calling thread. metrics, when not null,
+ * receives the request's timings (deviceai_llm_metrics.h).
+ */
+std::string dai_llm_generate(
+    dai_llm_session *session,
+    const std::string &prompt,
+    const dai_llm_gen_params &params,
+    const dai_llm_token_cb &on_token,
+    const dai_llm_progress_cb &on_progress = nullptr,
+    dai_llm_gen_metrics *metrics = nullptr
+);
+
+/**
+ * Request cancellation of the generation running on this session. Own-context
+ * sessions abort inside the current llama_decode; scheduler sessions stop at
+ * the scheduler's next step. The request's metrics report the delay.
+ */
+void dai_llm_cancel(dai_llm_session *session);
+
+/** Speculative-decoding counters accumulated since the session was created. */
+dai_llm_spec_stats dai_llm_speculative_stats(dai_llm_session *session);
+
+// ═══════════════════════════════════════════════════════════════
+//                 Shared helpers (engine-internal)
+// ═══════════════════════════════════════════════════════════════
+
+/**
+ * Tokenize with special tokens parsed. Returns an empty vector on failure,
+ * including when the text has more than n_max tokens (n_max <= 0 = no limit).
+ * add_special adds the model's BOS/EOS as for a whole prompt.
+ */
+std::vector<llama_token> dai_llm_tokenize(const llama_vocab *vocab, const std::string &text, int n_max,
+                                          bool add_special = true);
+
+/**
+ * Tokenize a prompt, splicing in params.splice_tokens at params.splice_marker
+ * (text before the marker gets BOS, text after it no special tokens). Same
+ * failure rules as dai_llm_tokenize.
+ */
+std::vector<llama_token> dai_llm_tokenize_prompt(const llama_vocab *vocab, const std::string &prompt,
+                                                 const dai_llm_gen_params &params, int n_max);
+
+/** Length of the longest common prefix of two token sequences. */
+size_t dai_llm_common_prefix(const std::vector<llama_token> &a, const std::vector<llama_token> &b);
+
+// llama_decode's result when the abort callback stopped it.
+#define DAI_LLM_DECODE_ABORTED 2
+
+/**
+ * Drop the KV cells past kv_tokens, e.g. those of a batch whose llama_decode
+ * was aborted by a cancel, so the cache again holds exactly kv_tokens.
+ */
+void dai_llm_kv_rollback(dai_llm_session *session);
+
+/**
+ * Decode tokens[kv_tokens.size():] into the session's own context in chunks,
+ * appending to kv_tokens. Caller holds session->mutex and has already trimmed
+ * the KV cache to a prefix of tokens. Returns false on cancel (decoded chunks
+ * are kept, even when the cancel aborts a chunk midway) or decode failure
+ * (KV cache is reset).
+ */
+bool dai_llm_prefill(
+    dai_llm_session *session,
+    const std::vector<llama_token> &tokens,
+    int chunk,
+    const dai_llm_progress_cb &on_progress
+);
+
+/**
+ * Everything dai_llm_generate does on an own-context session before
+ * sampling: tokenize (fitting to the window with context shifting), reuse the
+ * KV-cache prefix and the model's prefix cache and prefill the rest.
+ * Afterwards kv_tokens holds the prompt and the context has logits for its
+ * last token. Caller holds session->mutex.
+ */
+bool dai_llm_prepare_prompt(
+    dai_llm_session *session,
+    const std::string &prompt,
+    const dai_llm_gen_params &params,
+    const dai_llm_progress_cb &on_progress,
+    dai_llm_metrics_recorder &rec
+);
+
+/**
+ * Offer sequence 0 (s->kv_tokens) to the model's prefix cache once a request
+ * is done, so copying its state never delays the first token. n_reused is
+ * how many of those tokens the request found in the KV cache
+ * (rec.m.cached_tokens). Skipped after a context shift. Caller holds
+ * session->mutex.
+ */
+void dai_llm_store_prefix(dai_llm_session *session, size_t n_reused);
+
+/** Effective prefill chunk size for a context: params.prefill_chunk clamped to n_batch. */
+int dai_llm_prefill_chunk(const dai_llm_gen_params &params, int n_batch);
+
+/**
+ * Build the sampler chain for one request, grammar first when it has one.
+ * nullptr when params.grammar does not parse. Caller frees with llama_sampler_free.
+ */
+llama_sampler *dai_llm_build_sampler(const dai_llm_gen_params &params, dai_llm_model *model);
+
+/** llama.cpp model / context parameters for a load request. */
+llama_model_params   dai_llm_model_load_params(const dai_llm_model_params &params);
+llama_context_params dai_llm_context_params(const dai_llm_model_params &params);
+
+#endif // DEVICEAI_LLM_ENGINE_H
@@ -0,0 +1,127 @@
+/**
+ * deviceai_llm_grammar.cpp - Grammar-constrained sampling
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_grammar.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmGrammar"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+// ═══════════════════════════════════════════════════════════════
+//                        Compiled grammars
+// ═══════════════════════════════════════════════════════════════
+
+namespace {
+
+struct grammar_entry {
+    std::string    gbnf;
+    llama_sampler *compiled = nullptr;   // never accepts a token; nullptr: does not parse
+};
+
+} // namespace
+
+struct dai_llm_grammar_cache {
+    std::mutex mutex;
+    size_t     max_entries = 0;
+
+    std::list<grammar_entry>                                            lru;       // front = most recently used
+    std::unordered_multimap<size_t, std::list<grammar_entry>::iterator> by_hash;   // hash of gbnf
+};
+
+dai_llm_grammar_cache *dai_llm_grammar_cache_create(int max_entries) {
+    auto *c = new dai_llm_grammar_cache();
+    c->max_entries = (size_t)std::max(1, max_entries);
+    return c;
+}
+
+void dai_llm_grammar_cache_free(dai_llm_grammar_cache *cache) {
+    if (!cache) return;
+    for (grammar_entry &e : cache->lru) {
+        if (e.compiled) llama_sampler_free(e.compiled);
+    }
+    delete cache;
+}
+
+llama_sampler *dai_llm_grammar_sampler(dai_llm_grammar_cache *c, const llama_vocab *vocab, const std::string &gbnf) {
+    const size_t hash = std::hash<std::string>()(gbnf);
+
+    std::lock_guard<std::mutex> lock(c->mutex);
+    auto range = c->by_hash.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (it->second->gbnf != gbnf) continue;
+        c->lru.splice(c->lru.begin(), c->lru, it->second);
+        return it->second->compiled ? llama_sampler_clone(it->second->compiled) : nullptr;
+    }
+
+    llama_sampler *compiled = llama_sampler_init_grammar(vocab, gbnf.c_str(), "root");
+    if (!compiled) LOGE("Grammar does not parse (%zu bytes)", gbnf.size());
+
+    if (c->lru.size() >= c->max_entries) {
+        auto last = std::prev(c->lru.end());
+        auto old  = c->by_hash.equal_range(std::hash<std::string>()(last->gbnf));
+        for (auto it = old.first; it != old.second; ++it) {
+            if (it->second == last) {
+                c->by_hash.erase(it);
+                break;
+            }
+        }
+        if (last->compiled) llama_sampler_free(last->compiled);
+        c->lru.erase(last);
+    }
+    c->lru.push_front({ gbnf, compiled });
+    c->by_hash.emplace(hash, c->lru.begin());
+    return compiled ? llama_sampler_clone(compiled) : nullptr;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                           Sampling
+// ═══════════════════════════════════════════════════════════════
+
+llama_token dai_llm_sample(llama_sampler *chain, llama_context *ctx, int32_t idx) {
+    const int      n_chain = llama_sampler_chain_n(chain);
+    llama_sampler *grammar = n_chain > 0 ? llama_sampler_chain_get(chain, 0) : nullptr;
+    if (!grammar || std::strcmp(llama_sampler_name(grammar), "grammar") != 0) {
+        return llama_sampler_sample(chain, ctx, idx);
+    }
+
+    const llama_vocab *vocab   = llama_model_get_vocab(llama_get_model(ctx));
+    const float       *logits  = llama_get_logits_ith(ctx, idx);
+    const int          n_vocab = llama_vocab_n_tokens(vocab);
+
+    thread_local std::vector<llama_token_data> cur;
+    cur.resize(n_vocab);
+    for (llama_token t = 0; t < n_vocab; t++) cur[t] = { t, logits[t], 0.0f };
+    llama_token_data_array cur_p = { cur.data(), cur.size(), -1, false };
+
+    llama_sampler_apply(grammar, &cur_p);
+
+    // One survivor: top-k, temperature and the rest can only pick it.
+    llama_token only    = LLAMA_TOKEN_NULL;
+    int         n_legal = 0;
+    for (size_t i = 0; i < cur_p.size && n_legal < 2; i++) {
+        if (std::isinf(cur_p.data[i].logit) && cur_p.data[i].logit < 0) continue;
+        only = cur_p.data[i].id;
+        n_legal++;
+    }
+    if (n_legal == 1) return only;
+    if (n_legal == 0) return LLAMA_TOKEN_NULL;   // dead end
+
+    for (int i = 1; i < n_chain; i++) llama_sampler_apply(llama_sampler_chain_get(chain, i), &cur_p);
+    return cur_p.data[cur_p.selected].id;
+}
@@ -0,0 +1,51 @@
+#ifndef DEVICEAI_LLM_GRAMMAR_H
+#define DEVICEAI_LLM_GRAMMAR_H
+
+/**
+ * deviceai_llm_grammar.h - Grammar-constrained sampling
+ *
+ * params.grammar (GBNF, root rule "root") puts llama.cpp's grammar sampler
+ * at the head of the request's sampler chain, so every token sampled keeps
+ * the output inside the grammar. JSON schemas are converted to GBNF on the
+ * Kotlin side before they get here.
+ *
+ * Parsing a grammar is far more work than sampling a token, and structured
+ * output reuses a handful of grammars over and over. Each model therefore
+ * keeps its compiled grammars, keyed by a hash of the text, least recently
+ * used evicted first; a request clones the compiled sampler instead of
+ * parsing. Grammars that fail to parse are remembered too.
+ *
+ * Grammars often leave a single legal token (punctuation, key names, the
+ * closing brace). dai_llm_sample accepts it without running the rest of the
+ * chain.
+ */
+
+#include "deviceai_llm_engine.h"
+
+struct dai_llm_grammar_cache;
+
+/** Create a cache of at most max_entries compiled grammars. */
+dai_llm_grammar_cache *dai_llm_grammar_cache_create(int max_entries);
+
+void dai_llm_grammar_cache_free(dai_llm_grammar_cache *cache);
+
+/**
+ * Fresh grammar sampler for gbnf, cloned from the cached compile (parsed on
+ * a miss). nullptr when the grammar does not parse. Caller frees with
+ * llama_sampler_free, or hands it to a chain.
+ */
+llama_sampler *dai_llm_grammar_sampler(dai_llm_grammar_cache *cache, const llama_vocab *vocab, const std::string &gbnf);
+
+/**
+ * Sample the token at output idx of ctx with a chain from
+ * dai_llm_build_sampler; the drop-in for llama_sampler_sample. When the
+ * chain is grammar-constrained and the grammar allows exactly one token,
+ * that token is returned without applying the rest of the chain. The caller
+ * still accepts the token into the chain.
+ *
+ * LLAMA_TOKEN_NULL when the grammar allows no token at all (a dead end):
+ * the caller ends the reply there and does not accept anything.
+ */
+llama_token dai_llm_sample(llama_sampler *chain, llama_context *ctx, int32_t idx);
+
+#endif // DEVICEAI_LLM_GRAMMAR_H
@@ -0,0 +1,944 @@
+/**
+ * deviceai_llm_hnsw.cpp - Approximate nearest-neighbour index for dense RAG
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_hnsw.h"
+#include "deviceai_llm_mmap.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define DAI_HNSW_X86_DISPATCH 1
+#endif
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmHnsw"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+static const uint32_t NO_NODE      = UINT32_MAX;
+static const int      MAX_M        = 64;
+static const int      MAX_LEVEL    = 15;
+static const size_t   LOCK_STRIPES = 4096;   // per-node locks while inserting, hashed
+
+static const char     FILE_MAGIC[8] = {'D', 'A', 'I', 'H', 'N', 'S', 'W', '\0'};
+static const uint32_t FILE_VERSION  = 1;
+
+// ═══════════════════════════════════════════════════════════════
+//                      Distance kernels
+// ═══════════════════════════════════════════════════════════════
+
+static float dot_f32_scalar(const float *a, const float *b, uint32_t n) {
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < n; i++) sum += a[i] * b[i];
+    return sum;
+}
+
+static int32_t dot_i8_scalar(const int8_t *a, const int8_t *b, uint32_t n) {
+    int32_t sum = 0;
+    for (uint32_t i = 0; i < n; i++) sum += (int32_t)a[i] * b[i];
+    return sum;
+}
+
+#if defined(__aarch64__)
+
+static float dot_f32(const float *a, const float *b, uint32_t n) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f), acc1 = vdupq_n_f32(0.0f);
+    uint32_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i),     vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+    return sum + dot_f32_scalar(a + i, b + i, n - i);
+}
+
+static int32_t dot_i8(const int8_t *a, const int8_t *b, uint32_t n) {
+    int32x4_t acc = vdupq_n_s32(0);
+    uint32_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const int8x16_t va = vld1q_s8(a + i), vb = vld1q_s8(b + i);
+#if defined(__ARM_FEATURE_DOTPROD)
+        acc = vdotq_s32(acc, va, vb);
+#else
+        acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+        acc = vpadalq_s16(acc, vmull_high_s8(va, vb));
+#endif
+    }
+    return vaddvq_s32(acc) + dot_i8_scalar(a + i, b + i, n - i);
+}
+
+#elif defined(DAI_HNSW_X86_DISPATCH)
+
+// Built for the x86-64 baseline; the AVX2 kernels are compiled separately
+// and chosen once at run time.
+__attribute__((target("avx2,fma")))
+static float dot_f32_avx2(const float *a, const float *b, uint32_t n) {
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    uint32_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i),     _mm256_loadu_ps(b + i),     acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    const __m256 acc = _mm256_add_ps(acc0, acc1);
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s) + dot_f32_scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static int32_t dot_i8_avx2(const int8_t *a, const int8_t *b, uint32_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    uint32_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m256i va = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(a + i)));
+        const __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(b + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(va, vb));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(s) + dot_i8_scalar(a + i, b + i, n - i);
+}
+
+static bool has_avx2() {
+    static const bool yes = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    return yes;
+}
+
+static float dot_f32(const float *a, const float *b, uint32_t n) {
+    return has_avx2() ? dot_f32_avx2(a, b, n) : dot_f32_scalar(a, b, n);
+}
+
+static int32_t dot_i8(const int8_t *a, const int8_t *b, uint32_t n) {
+    return has_avx2() ? dot_i8_avx2(a, b, n) : dot_i8_scalar(a, b, n);
+}
+
+#else
+
+static float   dot_f32(const float *a, const float *b, uint32_t n)   { return dot_f32_scalar(a, b, n); }
+static int32_t dot_i8(const int8_t *a, const int8_t *b, uint32_t n)  { return dot_i8_scalar(a, b, n); }
+
+#endif
+
+static inline void prefetch(const void *p) {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_prefetch(p);
+#else
+    (void)p;
+#endif
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                           State
+// ═══════════════════════════════════════════════════════════════
+
+namespace {
+
+struct candidate {
+    float    sim;
+    uint32_t node;
+};
+
+struct by_sim_desc {   // max-heap on similarity
+    bool operator()(const candidate &a, const candidate &b) const { return a.sim < b.sim; }
+};
+struct by_sim_asc {    // min-heap on similarity
+    bool operator()(const candidate &a, const candidate &b) const { return a.sim > b.sim; }
+};
+
+// Visited marks for one search, reset in O(1) by bumping the tag.
+struct visited_list {
+    std::vector<uint16_t> marks;
+    uint16_t              tag = 0;
+
+    void reset(size_t n) {
+        if (marks.size() < n) marks.resize(n, 0);
+        if (++tag == 0) {
+            std::fill(marks.begin(), marks.end(), 0);
+            tag = 1;
+        }
+    }
+    bool test_and_set(uint32_t node) {
+        if (marks[node] == tag) return true;
+        marks[node] = tag;
+        return false;
+    }
+};
+
+struct doc_entry {
+    std::string text;
+    std::string source;
+    bool        has_source = false;
+};
+
+// A vector to compare against: a query or a stored node.
+struct query_vec {
+    const float  *f     = nullptr;
+    const int8_t *q     = nullptr;
+    float         scale = 1.0f;
+};
+
+// ── On-disk layout (native endianness, 8-byte aligned sections) ──
+
+struct file_header {
+    char     magic[8];
+    uint32_t version;
+    uint32_t dim;
+    uint32_t m;
+    uint32_t m0;
+    uint32_t ef_construction;
+    uint32_t ef_search;
+    uint32_t quantized;
+    int32_t  max_level;
+    uint32_t entry;
+    uint32_t n_nodes;
+    uint64_t n_upper;          // uint32 words of upper-level links
+    uint64_t levels_off;
+    uint64_t links0_off;
+    uint64_t upper_start_off;
+    uint64_t upper_off;
+    uint64_t vectors_off;
+    uint64_t scales_off;
+    uint64_t docs_off;
+    uint64_t strings_off;
+    uint64_t file_size;
+};
+
+struct file_doc {
+    uint64_t text_off;
+    uint64_t source_off;
+    uint32_t text_len;
+    uint32_t source_len;
+    uint32_t has_source;
+    uint32_t dead;
+};
+
+} // namespace
+
+struct dai_llm_hnsw {
+    mutable std::shared_mutex mutex;   // shared: search, save; unique: add, remove
+
+    uint32_t dim             = 0;
+    uint32_t m               = 16;
+    uint32_t m0              = 32;
+    uint32_t ef_construction = 200;
+    uint32_t ef_search       = 64;
+    bool     quantized       = false;
+    int      n_threads       = 0;
+    double   level_mult      = 0.0;
+    std::mt19937_64 rng{0x5eed};
+
+    // Graph. Node i has id i. Level-0 links: n × (1 + m0) words, a count
+    // then the neighbours. A node on level L > 0 has L blocks of (1 + m)
+    // words for levels 1..L in `upper`, starting at upper_start[i].
+    uint32_t n         = 0;
+    int      max_level = -1;
+    uint32_t entry     = NO_NODE;
+    std::mutex entry_mutex;            // entry/max_level while inserting
+
+    std::vector<uint8_t>  levels;
+    std::vector<uint32_t> links0;
+    std::vector<uint32_t> upper_start;
+    std::vector<uint32_t> upper;
+    std::vector<float>    fvecs;       // n × dim, when not quantized
+    std::vector<int8_t>   qvecs;       // n × dim, when quantized
+    std::vector<float>    scales;      // n, when quantized
+    std::vector<doc_entry> docs;       // in-memory documents
+
+    std::vector<uint8_t>  dead;        // always in memory, also for mapped indexes
+    uint32_t              n_dead = 0;
+
+    // Memory-mapped (loaded and not added to since)
+    const uint8_t  *map      = nullptr;
+    size_t          map_size = 0;
+    const file_doc *fdocs    = nullptr;
+
+    // Read paths go through these: the vectors above or the mapping.
+    const uint8_t  *v_levels      = nullptr;
+    const uint32_t *v_links0      = nullptr;
+    const uint32_t *v_upper_start = nullptr;
+    const uint32_t *v_upper       = nullptr;
+    const float    *v_fvecs       = nullptr;
+    const int8_t   *v_qvecs       = nullptr;
+    const float    *v_scales      = nullptr;
+    size_t          n_upper       = 0;
+
+    std::unique_ptr<std::mutex[]> locks{new std::mutex[LOCK_STRIPES]};
+
+    std::mutex                                  visited_mutex;
+    std::vector<std::unique_ptr<visited_list>>  visited_pool;
+};
+
+// ═══════════════════════════════════════════════════════════════
+//                         Helpers
+// ═══════════════════════════════════════════════════════════════
+
+static void refresh_views(dai_llm_hnsw *x) {
+    x->v_levels      = x->levels.data();
+    x->v_links0      = x->links0.data();
+    x->v_upper_start = x->upper_start.data();
+    x->v_upper       = x->upper.data();
+    x->v_fvecs       = x->fvecs.data();
+    x->v_qvecs       = x->qvecs.data();
+    x->v_scales      = x->scales.data();
+    x->n_upper       = x->upper.size();
+}
+
+static std::mutex &node_lock(const dai_llm_hnsw *x, uint32_t node) {
+    return x->locks[node % LOCK_STRIPES];
+}
+
+// Link block of node on level: [count, neighbours...]. nullptr when the
+// node does not reach that level or a mapped file is inconsistent.
+static const uint32_t *links_of(const dai_llm_hnsw *x, uint32_t node, int level) {
+    if (level == 0) return x->v_links0 + (size_t)node * (1 + x->m0);
+    if (level > x->v_levels[node]) return nullptr;
+    const size_t off = (size_t)x->v_upper_start[node] + (size_t)(level - 1) * (1 + x->m);
+    return off + 1 + x->m <= x->n_upper ? x->v_upper + off : nullptr;
+}
+
+static uint32_t *links_of_mut(dai_llm_hnsw *x, uint32_t node, int level) {
+    return const_cast<uint32_t *>(links_of(x, node, level));
+}
+
+static uint32_t max_links(const dai_llm_hnsw *x, int level) {
+    return level == 0 ? x->m0 : x->m;
+}
+
+// Copy a node's neighbours, under its lock while other threads insert.
+static void read_links(const dai_llm_hnsw *x, uint32_t node, int level, bool locked, std::vector<uint32_t> &out) {
+    out.clear();
+    std::unique_lock<std::mutex> lock;
+    if (locked) lock = std::unique_lock<std::mutex>(node_lock(x, node));
+    const uint32_t *l = links_of(x, node, level);
+    if (!l) return;
+    const uint32_t count = std::min(l[0], max_links(x, level));
+    out.assign(l + 1, l + 1 + count);
+}
+
+static query_vec node_vec(const dai_llm_hnsw *x, uint32_t node) {
+    query_vec v;
+    if (x->quantized) {
+        v.q     = x->v_qvecs + (size_t)node * x->dim;
+        v.scale = x->v_scales[node];
+    } else {
+        v.f = x->v_fvecs + (size_t)node * x->dim;
+    }
+    return v;
+}
+
+static inline const void *vec_addr(const dai_llm_hnsw *x, uint32_t node) {
+    return x->quantized ? (const void *)(x->v_qvecs + (size_t)node * x->dim)
+                        : (const void *)(x->v_fvecs + (size_t)node * x->dim);
+}
+
+static inline float similarity(const dai_llm_hnsw *x, const query_vec &q, uint32_t node) {
+    if (x->quantized) {
+        return (float)dot_i8(q.q, x->v_qvecs + (size_t)node * x->dim, x->dim) * q.scale * x->v_scales[node];
+    }
+    return dot_f32(q.f, x->v_fvecs + (size_t)node * x->dim, x->dim);
+}
+
+// L2-normalise src into f; with quantization, also to int8 codes + scale.
+static void encode(uint32_t dim, const float *src, float *f, int8_t *q, float *scale) {
+    double sum = 0.0;
+    for (uint32_t i = 0; i < dim; i++) sum += (double)src[i] * src[i];
+    const float inv = sum > 0.0 ? (float)(1.0 / std::sqrt(sum)) : 0.0f;
+    for (uint32_t i = 0; i < dim; i++) f[i] = src[i] * inv;
+
+    if (!q) return;
+    float max_abs = 0.0f;
+    for (uint32_t i = 0; i < dim; i++) max_abs = std::max(max_abs, std::fabs(f[i]));
+    const float s = max_abs > 0.0f ? max_abs / 127.0f : 1.0f;
+    for (uint32_t i = 0; i < dim; i++) q[i] = (int8_t)std::lrintf(f[i] / s);
+    *scale = s;
+}
+
+static std::unique_ptr<visited_list> acquire_visited(dai_llm_hnsw *x) {
+    std::unique_ptr<visited_list> v;
+    {
+        std::lock_guard<std::mutex> lock(x->visited_mutex);
+        if (!x->visited_pool.empty()) {
+            v = std::move(x->visited_pool.back());
+            x->visited_pool.pop_back();
+        }
+    }
+    if (!v) v = std::make_unique<visited_list>();
+    v->reset(x->n);
+    return v;
+}
+
+static void release_visited(dai_llm_hnsw *x, std::unique_ptr<visited_list> v) {
+    std::lock_guard<std::mutex> lock(x->visited_mutex);
+    x->visited_pool.push_back(std::move(v));
+}
+
+static void doc_of(const dai_llm_hnsw *x, uint32_t node, dai_llm_hnsw_hit &h) {
+    if (x->map) {
+        const file_doc &f = x->fdocs[node];
+        h.text.assign((const char *)x->map + f.text_off, f.text_len);
+        h.source.assign((const char *)x->map + f.source_off, f.source_len);
+        h.has_source = f.has_source != 0;
+    } else {
+        const doc_entry &d = x->docs[node];
+        h.text       = d.text;
+        h.source     = d.source;
+        h.has_source = d.has_source;
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                        Graph search
+// ═══════════════════════════════════════════════════════════════
+
+// Greedy walk on one level: move to the most similar neighbour until none improves.
+static candidate greedy(const dai_llm_hnsw *x, const query_vec &q, candidate cur, int level, bool locked,
+                        std::vector<uint32_t> &buf) {
+    for (bool changed = true; changed;) {
+        changed = false;
+        read_links(x, cur.node, level, locked, buf);
+        for (uint32_t nb : buf) {
+            if (nb >= x->n) continue;
+            const float s = similarity(x, q, nb);
+            if (s > cur.sim) {
+                cur = {s, nb};
+                changed = true;
+            }
+        }
+    }
+    return cur;
+}
+
+// Best-first search of width ef on one level. Returns the best ef nodes,
+// most similar first. skip_dead keeps removed nodes out of the results but
+// still walks through them.
+static std::vector<candidate> search_level(
+    const dai_llm_hnsw *x,
+    const query_vec &q,
+    const std::vector<candidate> &entries,
+    uint32_t ef,
+    int level,
+    visited_list &visited,
+    bool locked,
+    bool skip_dead
+) {
+    std::priority_queue<candidate, std::vector<candidate>, by_sim_desc> frontier;
+    std::priority_queue<candidate, std::vector<candidate>, by_sim_asc>  best;
+    std::vector<uint32_t> buf;
+
+    for (const candidate &e : entries) {
+        if (visited.test_and_set(e.node)) continue;
+        frontier.push(e);
+        if (!skip_dead || !x->dead[e.node]) best.push(e);
+    }
+    while (best.size() > ef) best.pop();
+
+    while (!frontier.empty()) {
+        const candidate c = frontier.top();
+        if (best.size() >= ef && c.sim < best.top().sim) break;
+        frontier.pop();
+
+        read_links(x, c.node, level, locked, buf);
+        for (size_t i = 0; i < buf.size(); i++) {
+            const uint32_t nb = buf[i];
+            if (i + 1 < buf.size() && buf[i + 1] < x->n) prefetch(vec_addr(x, buf[i + 1]));
+            if (nb >= x->n || visited.test_and_set(nb)) continue;
+
+            const float s = similarity(x, q, nb);
+            if (best.size() < ef || s > best.top().sim) {
+                frontier.push({s, nb});
+                if (!skip_dead || !x->dead[nb]) {
+                    best.push({s, nb});
+                    if (best.size() > ef) best.pop();
+                }
+            }
+        }
+    }
+
+    std::vector<candidate> out(best.size());
+    for (size_t i = out.size(); i-- > 0;) {
+        out[i] = best.top();
+        best.pop();
+    }
+    return out;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Insertion
+// ═══════════════════════════════════════════════════════════════
+
+// HNSW neighbour heuristic: take candidates in order of similarity, skipping
+// any that is closer to an already chosen neighbour than to the target.
+// Keeps links spread in different directions instead of one tight cluster.
+static void select_neighbors(const dai_llm_hnsw *x, const std::vector<candidate> &sorted, uint32_t max,
+                             std::vector<uint32_t> &out) {
+    out.clear();
+    for (const candidate &c : sorted) {
+        if (out.size() >= max) break;
+        const query_vec cv = node_vec(x, c.node);
+        bool keep = true;
+        for (uint32_t r : out) {
+            if (similarity(x, cv, r) > c.sim) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep) out.push_back(c.node);
+    }
+}
+
+// Add a back link from node to target, re-selecting node's links when full.
+static void link_back(dai_llm_hnsw *x, uint32_t node, uint32_t target, int level) {
+    std::lock_guard<std::mutex> lock(node_lock(x, node));
+    uint32_t *l = links_of_mut(x, node, level);
+    if (!l) return;
+    const uint32_t max = max_links(x, level);
+    for (uint32_t i = 0; i < l[0]; i++) if (l[1 + i] == target) return;
+
+    if (l[0] < max) {
+        l[1 + l[0]++] = target;
+        return;
+    }
+
+    const query_vec nv = node_vec(x, node);
+    std::vector<candidate> cands;
+    cands.reserve(max + 1);
+    for (uint32_t i = 0; i < l[0]; i++) cands.push_back({similarity(x, nv, l[1 + i]), l[1 + i]});
+    cands.push_back({similarity(x, nv, target), target});
+    std::sort(cands.begin(), cands.end(), [](const candidate &a, const candidate &b) { return a.sim > b.sim; });
+
+    std::vector<uint32_t> kept;
+    select_neighbors(x, cands, max, kept);
+    l[0] = (uint32_t)kept.size();
+    std::copy(kept.begin(), kept.end(), l + 1);
+}
+
+static void insert(dai_llm_hnsw *x, uint32_t node, visited_list &visited) {
+    const int level = x->v_levels[node];
+    uint32_t entry;
+    int      top;
+    {
+        std::lock_guard<std::mutex> lock(x->entry_mutex);
+        entry = x->entry;
+        top   = x->max_level;
+    }
+
+    const query_vec q = node_vec(x, node);
+    std::vector<uint32_t> buf, chosen;
+    candidate cur{similarity(x, q, entry), entry};
+    for (int l = top; l > level; l--) cur = greedy(x, q, cur, l, /*locked=*/true, buf);
+
+    std::vector<candidate> entries{cur};
+    for (int l = std::min(level, top); l >= 0; l--) {
+        visited.reset(x->n);
+        std::vector<candidate> found = search_level(x, q, entries, x->ef_construction, l, visited,
+                                                    /*locked=*/true, /*skip_dead=*/false);
+        found.erase(std::remove_if(found.begin(), found.end(), [node](const candidate &c) { return c.node == node; }),
+                    found.end());
+        select_neighbors(x, found, x->m, chosen);
+        {
+            std::lock_guard<std::mutex> lock(node_lock(x, node));
+            uint32_t *l_own = links_of_mut(x, node, l);
+            l_own[0] = (uint32_t)chosen.size();
+            std::copy(chosen.begin(), chosen.end(), l_own + 1);
+        }
+        for (uint32_t nb : chosen) link_back(x, nb, node, l);
+        if (!found.empty()) entries = std::move(found);
+    }
+
+    if (level > top) {
+        std::lock_guard<std::mutex> lock(x->entry_mutex);
+        if (level > x->max_level) {
+            x->entry     = node;
+            x->max_level = level;
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                  Memory mapping / materialising
+// ═══════════════════════════════════════════════════════════════
+
+static bool in_file(uint64_t off, uint64_t len, size_t size) {
+    return off <= size && len <= size - off;
+}
+
+static bool validate(const dai_llm_hnsw *x, const file_header &h) {
+    const size_t size = x->map_size;
+    const size_t vec_bytes = h.quantized ? 1 : sizeof(float);
+    if (h.dim == 0 || h.m == 0 || h.m > MAX_M || h.m0 < h.m || h.m0 > 2 * MAX_M) return false;
+    if (h.file_size != size || h.max_level > MAX_LEVEL) return false;
+    if ((h.n_nodes == 0) != (h.entry == NO_NODE) || (h.n_nodes > 0 && h.entry >= h.n_nodes)) return false;
+
+    const uint64_t n = h.n_nodes;
+    if (!in_file(h.levels_off, n, size) ||
+        !in_file(h.links0_off, n * (1 + h.m0) * sizeof(uint32_t), size) ||
+        !in_file(h.upper_start_off, n * sizeof(uint32_t), size) ||
+        !in_file(h.upper_off, h.n_upper * sizeof(uint32_t), size) ||
+        !in_file(h.vectors_off, n * h.dim * vec_bytes, size) ||
+        !in_file(h.scales_off, h.quantized ? n * sizeof(float) : 0, size) ||
+        !in_file(h.docs_off, n * sizeof(file_doc), size)) {
+        return false;
+    }
+    for (uint64_t i = 0; i < n; i++) {
+        if (x->v_levels[i] > h.max_level) return false;
+        const file_doc &d = x->fdocs[i];
+        if (!in_file(d.text_off, d.text_len, size) || !in_file(d.source_off, d.source_len, size)) return false;
+    }
+    return true;
+}
+
+static void unmap(dai_llm_hnsw *x) {
+    dai_llm_unmap_file(x->map, x->map_size);
+    x->map      = nullptr;
+    x->map_size = 0;
+    x->fdocs    = nullptr;
+}
+
+// Copy a mapped index into memory so it can be modified.
+static void materialise(dai_llm_hnsw *x) {
+    if (!x->map) return;
+    const size_t n = x->n;
+    x->levels.assign(x->v_levels, x->v_levels + n);
+    x->links0.assign(x->v_links0, x->v_links0 + n * (1 + x->m0));
+    x->upper_start.assign(x->v_upper_start, x->v_upper_start + n);
+    x->upper.assign(x->v_upper, x->v_upper + x->n_upper);
+    if (x->quantized) {
+        x->qvecs.assign(x->v_qvecs, x->v_qvecs + n * x->dim);
+        x->scales.assign(x->v_scales, x->v_scales + n);
+    } else {
+        x->fvecs.assign(x->v_fvecs, x->v_fvecs + n * x->dim);
+    }
+    x->docs.resize(n);
+    for (uint32_t i = 0; i < n; i++) {
+        dai_llm_hnsw_hit h;
+        doc_of(x, i, h);
+        x->docs[i] = {std::move(h.text), std::move(h.source), h.has_source};
+    }
+    unmap(x);
+    refresh_views(x);
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Lifecycle
+// ═══════════════════════════════════════════════════════════════
+
+static void set_params(dai_llm_hnsw *x, uint32_t dim, uint32_t m, uint32_t m0, uint32_t ef_c, uint32_t ef_s, bool quantized) {
+    x->dim             = dim;
+    x->m               = m;
+    x->m0              = m0;
+    x->ef_construction = ef_c;
+    x->ef_search       = ef_s;
+    x->quantized       = quantized;
+    x->level_mult      = 1.0 / std::log((double)std::max<uint32_t>(2, m));
+}
+
+dai_llm_hnsw *dai_llm_hnsw_create(const dai_llm_hnsw_params &params) {
+    if (params.dim <= 0) return nullptr;
+    auto *x = new dai_llm_hnsw();
+    const uint32_t m = (uint32_t)std::min(std::max(params.m, 2), MAX_M);
+    set_params(x, (uint32_t)params.dim, m, 2 * m,
+               (uint32_t)std::max(params.ef_construction, (int)m),
+               (uint32_t)std::max(params.ef_search, 1),
+               params.quantize);
+    x->n_threads = params.n_threads;
+    refresh_views(x);
+    return x;
+}
+
+dai_llm_hnsw *dai_llm_hnsw_load(const std::string &path) {
+    size_t size = 0;
+    const uint8_t *map = dai_llm_map_file(path, sizeof(file_header), /*random_access=*/true, size);
+    if (!map) return nullptr;
+
+    auto *x = new dai_llm_hnsw();
+    x->map      = map;
+    x->map_size = size;
+
+    const auto &h = *reinterpret_cast<const file_header *>(x->map);
+    if (memcmp(h.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || h.version != FILE_VERSION) {
+        LOGE("%s is not an HNSW index (or from another version)", path.c_str());
+        dai_llm_hnsw_free(x);
+        return nullptr;
+    }
+    x->v_levels      = x->map + h.levels_off;
+    x->v_links0      = reinterpret_cast<const uint32_t *>(x->map + h.links0_off);
+    x->v_upper_start = reinterpret_cast<const uint32_t *>(x->map + h.upper_start_off);
+    x->v_upper       = reinterpret_cast<const uint32_t *>(x->map + h.upper_off);
+    x->v_fvecs       = h.quantized ? nullptr : reinterpret_cast<const float *>(x->map + h.vectors_off);
+    x->v_qvecs       = h.quantized ? reinterpret_cast<const int8_t *>(x->map + h.vectors_off) : nullptr;
+    x->v_scales      = h.quantized ? reinterpret_cast<const float *>(x->map + h.scales_off) : nullptr;
+    x->n_upper       = h.n_upper;
+    x->fdocs         = reinterpret_cast<const file_doc *>(x->map + h.docs_off);
+    if (!validate(x, h)) {
+        LOGE("HNSW index %s is corrupt", path.c_str());
+        dai_llm_hnsw_free(x);
+        return nullptr;
+    }
+
+    set_params(x, h.dim, h.m, h.m0, h.ef_construction, h.ef_search, h.quantized != 0);
+    x->n         = h.n_nodes;
+    x->max_level = h.max_level;
+    x->entry     = h.entry;
+    x->dead.resize(x->n);
+    for (uint32_t i = 0; i < x->n; i++) {
+        x->dead[i] = x->fdocs[i].dead != 0;
+        x->n_dead += x->dead[i];
+    }
+
+    LOGI("HNSW index mapped: %u vectors (dim=%u, %s) from %s", x->n - x->n_dead, x->dim,
+         x->quantized ? "int8" : "f32", path.c_str());
+    return x;
+}
+
+void dai_llm_hnsw_free(dai_llm_hnsw *x) {
+    if (!x) return;
+    unmap(x);
+    delete x;
+}
+
+int dai_llm_hnsw_dim(dai_llm_hnsw *x) {
+    return x ? (int)x->dim : 0;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Public API
+// ═══════════════════════════════════════════════════════════════
+
+std::vector<int64_t> dai_llm_hnsw_add(dai_llm_hnsw *x, const float *vectors, const std::vector<dai_llm_hnsw_doc> &docs) {
+    if (!x || !vectors || docs.empty()) return {};
+    std::unique_lock<std::shared_mutex> lock(x->mutex);
+    materialise(x);
+
+    const uint32_t first = x->n;
+    const uint32_t count = (uint32_t)docs.size();
+    const uint32_t dim   = x->dim;
+    const uint32_t total = first + count;
+
+    x->levels.resize(total);
+    x->links0.resize((size_t)total * (1 + x->m0), 0);
+    x->upper_start.resize(total, 0);
+    x->dead.resize(total, 0);
+    if (x->quantized) {
+        x->qvecs.resize((size_t)total * dim);
+        x->scales.resize(total);
+    } else {
+        x->fvecs.resize((size_t)total * dim);
+    }
+
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::vector<float> normalized(x->quantized ? dim : 0);
+    for (uint32_t i = 0; i < count; i++) {
+        const uint32_t node = first + i;
+        const int level = std::min((int)(-std::log(std::max(uniform(x->rng), 1e-12)) * x->level_mult), MAX_LEVEL);
+        x->levels[node]      = (uint8_t)level;
+        x->upper_start[node] = (uint32_t)x->upper.size();
+        x->upper.resize(x->upper.size() + (size_t)level * (1 + x->m), 0);
+
+        const float *src = vectors + (size_t)i * dim;
+        if (x->quantized) {
+            encode(dim, src, normalized.data(), x->qvecs.data() + (size_t)node * dim, &x->scales[node]);
+        } else {
+            encode(dim, src, x->fvecs.data() + (size_t)node * dim, nullptr, nullptr);
+        }
+        x->docs.push_back({docs[i].text, docs[i].source, docs[i].has_source});
+    }
+    x->n = total;
+    refresh_views(x);
+
+    uint32_t start = first;
+    if (x->entry == NO_NODE) {
+        x->entry     = first;
+        x->max_level = x->levels[first];
+        start++;
+    }
+
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    const unsigned n_threads = std::min<unsigned>(x->n_threads > 0 ? (unsigned)x->n_threads : hw,
+                                                  std::max(1u, (total - start) / 64));
+    std::atomic<uint32_t> next{start};
+    auto worker = [x, &next, total] {
+        std::unique_ptr<visited_list> visited = acquire_visited(x);
+        for (uint32_t node; (node = next.fetch_add(1)) < total;) insert(x, node, *visited);
+        release_visited(x, std::move(visited));
+    };
+    if (n_threads <= 1) {
+        worker();
+    } else {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < n_threads; t++) threads.emplace_back(worker);
+        for (auto &t : threads) t.join();
+    }
+
+    std::vector<int64_t> ids(count);
+    for (uint32_t i = 0; i < count; i++) ids[i] = first + i;
+    return ids;
+}
+
+bool dai_llm_hnsw_remove(dai_llm_hnsw *x, int64_t id) {
+    if (!x) return false;
+    std::unique_lock<std::shared_mutex> lock(x->mutex);
+    if (id < 0 || id >= (int64_t)x->n || x->dead[(size_t)id]) return false;
+    x->dead[(size_t)id] = 1;
+    x->n_dead++;
+    return true;
+}
+
+size_t dai_llm_hnsw_size(dai_llm_hnsw *x) {
+    if (!x) return 0;
+    std::shared_lock<std::shared_mutex> lock(x->mutex);
+    return x->n - x->n_dead;
+}
+
+std::vector<dai_llm_hnsw_hit> dai_llm_hnsw_search(dai_llm_hnsw *x, const float *query, int top_k, int ef) {
+    if (!x || !query || top_k <= 0) return {};
+    std::shared_lock<std::shared_mutex> lock(x->mutex);
+    if (x->entry == NO_NODE || x->n_dead == x->n) return {};
+
+    std::vector<float>  f(x->dim);
+    std::vector<int8_t> qcodes(x->quantized ? x->dim : 0);
+    query_vec q;
+    encode(x->dim, query, f.data(), x->quantized ? qcodes.data() : nullptr, &q.scale);
+    q.f = f.data();
+    q.q = qcodes.data();
+
+    std::vector<uint32_t> buf;
+    candidate cur{similarity(x, q, x->entry), x->entry};
+    for (int l = x->max_level; l > 0; l--) cur = greedy(x, q, cur, l, /*locked=*/false, buf);
+
+    const uint32_t width = (uint32_t)std::max(ef > 0 ? ef : (int)x->ef_search, top_k);
+    std::unique_ptr<visited_list> visited = acquire_visited(x);
+    std::vector<candidate> found = search_level(x, q, {cur}, width, 0, *visited, /*locked=*/false, /*skip_dead=*/true);
+    release_visited(x, std::move(visited));
+
+    if (found.size() > (size_t)top_k) found.resize((size_t)top_k);
+    std::vector<dai_llm_hnsw_hit> hits(found.size());
+    for (size_t i = 0; i < found.size(); i++) {
+        hits[i].id    = found[i].node;
+        hits[i].score = found[i].sim;
+        doc_of(x, found[i].node, hits[i]);
+    }
+    return hits;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                            Save
+// ═══════════════════════════════════════════════════════════════
+
+static uint64_t align8(uint64_t off) {
+    return (off + 7) & ~uint64_t(7);
+}
+
+static void write_at(std::ofstream &out, uint64_t &pos, uint64_t off, const void *data, size_t len) {
+    static const char zeros[8] = {};
+    while (pos < off) {
+        const size_t pad = (size_t)std::min<uint64_t>(off - pos, sizeof(zeros));
+        out.write(zeros, (std::streamsize)pad);
+        pos += pad;
+    }
+    out.write(static_cast<const char *>(data), (std::streamsize)len);
+    pos += len;
+}
+
+static bool write_file(const dai_llm_hnsw *x, const std::string &path) {
+    const uint64_t n = x->n;
+    const size_t vec_bytes = x->quantized ? 1 : sizeof(float);
+
+    file_header h{};
+    memcpy(h.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    h.version         = FILE_VERSION;
+    h.dim             = x->dim;
+    h.m               = x->m;
+    h.m0              = x->m0;
+    h.ef_construction = x->ef_construction;
+    h.ef_search       = x->ef_search;
+    h.quantized       = x->quantized;
+    h.max_level       = x->max_level;
+    h.entry           = x->entry;
+    h.n_nodes         = x->n;
+    h.n_upper         = x->n_upper;
+    h.levels_off      = align8(sizeof(file_header));
+    h.links0_off      = align8(h.levels_off + n);
+    h.upper_start_off = align8(h.links0_off + n * (1 + x->m0) * sizeof(uint32_t));
+    h.upper_off       = align8(h.upper_start_off + n * sizeof(uint32_t));
+    h.vectors_off     = align8(h.upper_off + h.n_upper * sizeof(uint32_t));
+    h.scales_off      = align8(h.vectors_off + n * x->dim * vec_bytes);
+    h.docs_off        = align8(h.scales_off + (x->quantized ? n * sizeof(float) : 0));
+    h.strings_off     = h.docs_off + n * sizeof(file_doc);
+
+    std::vector<file_doc> fdocs(n);
+    dai_llm_hnsw_hit doc;
+    uint64_t str = h.strings_off;
+    for (uint32_t i = 0; i < n; i++) {
+        doc_of(x, i, doc);
+        file_doc &f  = fdocs[i];
+        f.has_source = doc.has_source;
+        f.dead       = x->dead[i];
+        f.text_off   = str;
+        f.text_len   = (uint32_t)doc.text.size();
+        str         += f.text_len;
+        f.source_off = str;
+        f.source_len = (uint32_t)doc.source.size();
+        str         += f.source_len;
+    }
+    h.file_size = str;
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    uint64_t pos = 0;
+    write_at(out, pos, 0, &h, sizeof(h));
+    write_at(out, pos, h.levels_off, x->v_levels, n);
+    write_at(out, pos, h.links0_off, x->v_links0, n * (1 + x->m0) * sizeof(uint32_t));
+    write_at(out, pos, h.upper_start_off, x->v_upper_start, n * sizeof(uint32_t));
+    write_at(out, pos, h.upper_off, x->v_upper, h.n_upper * sizeof(uint32_t));
+    write_at(out, pos, h.vectors_off, x->quantized ? (const void *)x->v_qvecs : (const void *)x->v_fvecs,
+             n * x->dim * vec_bytes);
+    if (x->quantized) write_at(out, pos, h.scales_off, x->v_scales, n * sizeof(float));
+    write_at(out, pos, h.docs_off, fdocs.data(), fdocs.size() * sizeof(file_doc));
+    for (uint32_t i = 0; i < n; i++) {
+        doc_of(x, i, doc);
+        write_at(out, pos, pos, doc.text.data(), doc.text.size());
+        write_at(out, pos, pos, doc.source.data(), doc.source.size());
+    }
+    out.close();
+    return !out.fail();
+}
+
+bool dai_llm_hnsw_save(dai_llm_hnsw *x, const std::string &path) {
+    if (!x || path.empty()) return false;
+    std::shared_lock<std::shared_mutex> lock(x->mutex);
+
+    // Write next to the target and rename, so a crash mid-write never leaves
+    // a truncated index under the final name (and a mapped one stays valid).
+    const std::string tmp = path + ".tmp";
+    if (!write_file(x, tmp) || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to write HNSW index %s", path.c_str());
+        std::remove(tmp.c_str());
+        return false;
+    }
+    LOGI("HNSW index saved: %u vectors to %s", x->n - x->n_dead, path.c_str());
+    return true;
+}
@@ -0,0 +1,89 @@
+#ifndef DEVICEAI_LLM_HNSW_H
+#define DEVICEAI_LLM_HNSW_H
+
+/**
+ * deviceai_llm_hnsw.h - Approximate nearest-neighbour index for dense RAG
+ *
+ * Comparing a query against every stored embedding costs O(n · dim) per
+ * query and needs all vectors resident. This index is a Hierarchical
+ * Navigable Small World graph (Malkov & Yashunin): each vector links to
+ * up to m close neighbours per level (2·m on level 0), and a query walks
+ * greedily from the sparse top level down, then runs a best-first search
+ * of width ef on level 0. A query touches a few thousand vectors, whatever
+ * the corpus size.
+ *
+ * Similarity is cosine: vectors are L2-normalised on insert and compared by
+ * dot product with AVX2 (x86-64, selected at run time) or NEON (arm64)
+ * kernels. With quantize, vectors are stored as int8 with one scale each,
+ * a quarter of the memory, and compared in int8.
+ *
+ * Inserts run in parallel on n_threads threads with per-node locks.
+ * Removal hides a vector from results; it stays in the graph as a routing
+ * node, and ids are never reused.
+ *
+ * dai_llm_hnsw_save writes a single file that dai_llm_hnsw_load memory-maps
+ * and queries in place. The first add on a loaded index copies it into
+ * memory.
+ *
+ * All functions are thread-safe; searches run concurrently.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct dai_llm_hnsw;
+
+struct dai_llm_hnsw_params {
+    int  dim             = 0;
+    int  m               = 16;    // links per node per level (2·m on level 0)
+    int  ef_construction = 200;   // search width while inserting
+    int  ef_search       = 64;    // default search width for queries
+    bool quantize        = false; // store int8 vectors
+    int  n_threads       = 0;     // insert threads, 0 = all cores
+};
+
+struct dai_llm_hnsw_doc {
+    std::string text;
+    std::string source;
+    bool        has_source = false;
+};
+
+struct dai_llm_hnsw_hit {
+    int64_t     id    = 0;
+    float       score = 0.0f;   // cosine similarity
+    std::string text;
+    std::string source;
+    bool        has_source = false;
+};
+
+/** Create an empty index. nullptr if params.dim <= 0. */
+dai_llm_hnsw *dai_llm_hnsw_create(const dai_llm_hnsw_params &params);
+
+/** Map an index written by dai_llm_hnsw_save. nullptr if missing or not a valid index file. */
+dai_llm_hnsw *dai_llm_hnsw_load(const std::string &path);
+
+void dai_llm_hnsw_free(dai_llm_hnsw *index);
+
+int dai_llm_hnsw_dim(dai_llm_hnsw *index);
+
+/**
+ * Insert docs.size() vectors (row-major, dim floats each) with their
+ * documents. Returns their ids, stable across save/load.
+ */
+std::vector<int64_t> dai_llm_hnsw_add(dai_llm_hnsw *index, const float *vectors, const std::vector<dai_llm_hnsw_doc> &docs);
+
+/** Remove a vector from results. False if the id is unknown or already removed. */
+bool dai_llm_hnsw_remove(dai_llm_hnsw *index, int64_t id);
+
+/** Live vectors. */
+size_t dai_llm_hnsw_size(dai_llm_hnsw *index);
+
+/** Write the index to path (via a temporary file and rename). */
+bool dai_llm_hnsw_save(dai_llm_hnsw *index, const std::string &path);
+
+/** Approximate top_k nearest vectors to query, best first. ef <= 0 → the index's ef_search. */
+std::vector<dai_llm_hnsw_hit> dai_llm_hnsw_search(dai_llm_hnsw *index, const float *query, int top_k, int ef = 0);
+
+#endif // DEVICEAI_LLM_HNSW_H
@@ -0,0 +1,412 @@
+/**
+ * deviceai_llm_ingest.cpp - Parallel document ingestion for the RAG indexes
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_ingest.h"
+#include "deviceai_llm_stream.h"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <thread>
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmIngest"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+static constexpr size_t MIN_PIECE_BYTES = 64 << 10;
+static constexpr size_t MAX_PIECE_BYTES = 4 << 20;
+static constexpr size_t EMBED_CHUNKS    = 64;   // chunks per dai_llm_embed call
+
+// ═══════════════════════════════════════════════════════════════
+//                          Corpus files
+// ═══════════════════════════════════════════════════════════════
+
+struct corpus_file {
+    std::string path;
+    uint64_t    size = 0;
+};
+
+static bool has_extension(const std::string &name, const std::vector<std::string> &extensions) {
+    if (extensions.empty()) return true;
+    const size_t dot = name.rfind('.');
+    if (dot == std::string::npos) return false;
+    std::string ext = name.substr(dot + 1);
+    for (char &c : ext) if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+    for (const auto &e : extensions) {
+        std::string want = e;
+        for (char &c : want) if (c >= 'A' && c <= 'Z') c = (char)(c - 'A' + 'a');
+        if (!want.empty() && want[0] == '.') want.erase(0, 1);
+        if (ext == want) return true;
+    }
+    return false;
+}
+
+// Append path, or the matching files below it in name order.
+static void collect(const std::string &path, bool top_level, const std::vector<std::string> &extensions,
+                    std::vector<corpus_file> &files, uint64_t &missing) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        if (top_level) missing++;
+        return;
+    }
+    if (S_ISREG(st.st_mode)) {
+        const size_t slash = path.rfind('/');
+        if (top_level || has_extension(slash == std::string::npos ? path : path.substr(slash + 1), extensions))
+            files.push_back({path, (uint64_t)st.st_size});
+        return;
+    }
+    if (!S_ISDIR(st.st_mode)) return;
+
+    DIR *dir = opendir(path.c_str());
+    if (!dir) {
+        missing++;
+        return;
+    }
+    std::vector<std::string> names;
+    while (dirent *d = readdir(dir)) {
+        if (d->d_name[0] != '.') names.emplace_back(d->d_name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    const std::string prefix = path.empty() || path.back() == '/' ? path : path + "/";
+    for (const auto &name : names) collect(prefix + name, false, extensions, files, missing);
+}
+
+// Where to end a piece of text: after the last line break in its second
+// half, else before the last UTF-8 character.
+static size_t cut_point(const std::string &text) {
+    const size_t nl = text.rfind('\n');
+    if (nl != std::string::npos && nl + 1 >= text.size() / 2) return nl + 1;
+    size_t i = text.size();
+    while (i > 0 && ((unsigned char)text[i - 1] & 0xC0) == 0x80) i--;
+    return i > 1 ? i - 1 : text.size();
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                           Chunking
+// ═══════════════════════════════════════════════════════════════
+
+static std::vector<llama_token> tokenize_raw(const llama_vocab *vocab, const std::string &text) {
+    // Documents are plain text: no BOS/EOS, and "<|...|>" is not a control token.
+    std::vector<llama_token> tokens(text.size() + 16);
+    int n = llama_tokenize(vocab, text.data(), (int32_t)text.size(), tokens.data(), (int32_t)tokens.size(), false, false);
+    if (n < 0) {
+        tokens.resize((size_t)-n);
+        n = llama_tokenize(vocab, text.data(), (int32_t)text.size(), tokens.data(), (int32_t)tokens.size(), false, false);
+    }
+    tokens.resize((size_t)std::max(0, n));
+    return tokens;
+}
+
+static std::string detokenize(const llama_vocab *vocab, const llama_token *tokens, int n) {
+    std::string text((size_t)n * 4 + 16, '\0');
+    int len = llama_detokenize(vocab, tokens, n, &text[0], (int32_t)text.size(), false, false);
+    if (len < 0) {
+        text.resize((size_t)-len);
+        len = llama_detokenize(vocab, tokens, n, &text[0], (int32_t)text.size(), false, false);
+    }
+    text.resize((size_t)std::max(0, len));
+
+    // A window can start or end inside a character that byte-level tokens
+    // split; drop the partial bytes, then surrounding whitespace.
+    size_t begin = 0;
+    while (begin < text.size() && ((unsigned char)text[begin] & 0xC0) == 0x80) begin++;
+    size_t end = dai_llm_utf8_complete(text);
+    while (begin < end && std::isspace((unsigned char)text[begin])) begin++;
+    while (end > begin && std::isspace((unsigned char)text[end - 1])) end--;
+    return text.substr(begin, end - begin);
+}
+
+// Windows of chunk tokens, each starting chunk - overlap after the last.
+// The final window is moved back to end at the last token, so no chunk is
+// a short tail.
+static std::vector<std::string> split_chunks(const llama_vocab *vocab, const std::vector<llama_token> &tokens,
+                                             int chunk, int overlap) {
+    std::vector<std::string> chunks;
+    const size_t n      = tokens.size();
+    const size_t stride = (size_t)std::max(1, chunk - overlap);
+    for (size_t start = 0; start < n; start += stride) {
+        size_t end = std::min(n, start + (size_t)chunk);
+        if (end == n) start = n > (size_t)chunk ? n - (size_t)chunk : 0;
+        std::string text = detokenize(vocab, tokens.data() + start, (int)(end - start));
+        if (!text.empty()) chunks.push_back(std::move(text));
+        if (end == n) break;
+    }
+    return chunks;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                           Pipeline
+// ═══════════════════════════════════════════════════════════════
+
+struct piece {
+    std::string        text;
+    const std::string *source = nullptr;
+};
+
+struct pipeline {
+    const llama_vocab           *vocab    = nullptr;
+    dai_llm_bm25                *bm25     = nullptr;
+    dai_llm_embedder            *embedder = nullptr;
+    dai_llm_hnsw                *hnsw     = nullptr;
+    const dai_llm_ingest_params *params   = nullptr;
+
+    std::mutex              mutex;
+    std::condition_variable has_work;   // workers: a piece is queued, or the run ended
+    std::condition_variable has_room;   // reader: a piece was indexed
+    std::deque<piece>       queue;
+    size_t                  buffered   = 0;   // bytes queued or being indexed
+    uint64_t                done_bytes = 0;
+    uint64_t                chunks     = 0;
+    uint64_t                tokens     = 0;
+    bool                    closed     = false;   // reader has queued everything
+    bool                    stop       = false;   // cancelled or failed
+    bool                    failed     = false;
+};
+
+static bool index_piece(pipeline &p, const piece &pc, uint64_t &n_chunks, uint64_t &n_tokens) {
+    const std::vector<llama_token> tokens = tokenize_raw(p.vocab, pc.text);
+    const std::vector<std::string> chunks =
+        split_chunks(p.vocab, tokens, p.params->chunk_tokens, p.params->overlap_tokens);
+    n_tokens = tokens.size();
+    n_chunks = chunks.size();
+    if (chunks.empty()) return true;
+
+    if (p.bm25) {
+        std::vector<dai_llm_bm25_doc> docs(chunks.size());
+        for (size_t i = 0; i < chunks.size(); i++) {
+            docs[i].text       = chunks[i];
+            docs[i].source     = *pc.source;
+            docs[i].has_source = true;
+        }
+        dai_llm_bm25_add(p.bm25, docs);
+    }
+
+    if (p.hnsw) {
+        const size_t dim = (size_t)dai_llm_embedder_dim(p.embedder);
+        std::vector<float> vectors;
+        for (size_t i = 0; i < chunks.size(); i += EMBED_CHUNKS) {
+            const size_t n = std::min(EMBED_CHUNKS, chunks.size() - i);
+            std::vector<std::string>      texts(chunks.begin() + (long)i, chunks.begin() + (long)(i + n));
+            std::vector<dai_llm_hnsw_doc> docs(n);
+            vectors.resize(n * dim);
+            if (!dai_llm_embed(p.embedder, texts, vectors.data())) return false;
+            for (size_t j = 0; j < n; j++) {
+                docs[j].text       = std::move(texts[j]);
+                docs[j].source     = *pc.source;
+                docs[j].has_source = true;
+            }
+            dai_llm_hnsw_add(p.hnsw, vectors.data(), docs);
+        }
+    }
+    return true;
+}
+
+static void worker(pipeline &p) {
+    for (;;) {
+        piece pc;
+        {
+            std::unique_lock<std::mutex> lock(p.mutex);
+            p.has_work.wait(lock, [&] { return p.stop || p.closed || !p.queue.empty(); });
+            if (p.stop || p.queue.empty()) return;
+            pc = std::move(p.queue.front());
+            p.queue.pop_front();
+        }
+
+        uint64_t n_chunks = 0, n_tokens = 0;
+        const bool ok = index_piece(p, pc, n_chunks, n_tokens);
+
+        std::lock_guard<std::mutex> lock(p.mutex);
+        p.buffered   -= pc.text.size();
+        p.done_bytes += pc.text.size();
+        p.chunks     += n_chunks;
+        p.tokens     += n_tokens;
+        if (!ok) {
+            LOGE("Embedding failed for %s", pc.source->c_str());
+            p.failed = p.stop = true;
+            p.has_work.notify_all();
+        }
+        p.has_room.notify_all();
+    }
+}
+
+// Progress reporting from the calling thread, with the pipeline lock held
+// on entry and exit. Stops the pipeline if the callback returns false.
+struct reporter {
+    pipeline                         &p;
+    const dai_llm_ingest_progress_cb &cb;
+    uint64_t                          total;
+    uint64_t                          reported  = UINT64_MAX;
+    bool                              cancelled = false;
+
+    void operator()(std::unique_lock<std::mutex> &lock) {
+        if (!cb || p.done_bytes == reported) return;
+        reported = p.done_bytes;
+        lock.unlock();
+        const bool go = cb(reported, total);
+        lock.lock();
+        if (!go && !p.stop) {
+            cancelled = p.stop = true;
+            p.has_work.notify_all();
+        }
+    }
+};
+
+// Queue a piece once the buffer has room for it. False once the run stopped.
+static bool enqueue(pipeline &p, reporter &report, std::string text, const std::string &source) {
+    std::unique_lock<std::mutex> lock(p.mutex);
+    while (!p.stop && p.buffered > 0 && p.buffered + text.size() > p.params->max_buffered_bytes) {
+        p.has_room.wait(lock);
+        report(lock);
+    }
+    if (p.stop) return false;
+    p.buffered += text.size();
+    p.queue.push_back({std::move(text), &source});
+    p.has_work.notify_one();
+    return true;
+}
+
+// Stream a file through the queue in pieces of about piece_bytes. False if
+// it could not be read.
+static bool read_file(pipeline &p, reporter &report, const std::string &path, size_t piece_bytes, uint64_t &bytes) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    std::string carry;
+    std::vector<char> block(piece_bytes);
+    bool ok = true;
+    for (;;) {
+        const size_t n = fread(block.data(), 1, block.size(), f);
+        carry.append(block.data(), n);
+        bytes += n;
+        if (n < block.size()) {
+            ok = !ferror(f);
+            break;
+        }
+        const size_t cut = cut_point(carry);
+        std::string rest = carry.substr(cut);
+        carry.resize(cut);
+        if (!enqueue(p, report, std::move(carry), path)) break;
+        carry = std::move(rest);
+    }
+    fclose(f);
+    if (ok && !carry.empty()) enqueue(p, report, std::move(carry), path);
+    return ok;
+}
+
+bool dai_llm_ingest(
+    const std::vector<std::string> &paths,
+    dai_llm_bm25 *bm25,
+    dai_llm_embedder *embedder,
+    dai_llm_hnsw *hnsw,
+    const dai_llm_ingest_params &params,
+    dai_llm_ingest_stats &stats,
+    const dai_llm_ingest_progress_cb &on_progress
+) {
+    stats = dai_llm_ingest_stats();
+    if (!bm25 && !hnsw) return false;
+    if (hnsw && (!embedder || dai_llm_embedder_dim(embedder) != dai_llm_hnsw_dim(hnsw))) {
+        LOGE("Ingest: HNSW index needs an embedder of dimension %d", dai_llm_hnsw_dim(hnsw));
+        return false;
+    }
+    if (params.chunk_tokens <= 0 || params.overlap_tokens < 0 || params.overlap_tokens >= params.chunk_tokens) {
+        LOGE("Ingest: invalid chunking (%d tokens, %d overlap)", params.chunk_tokens, params.overlap_tokens);
+        return false;
+    }
+
+    // Only the tokenizer is needed: load the vocabulary, not the weights.
+    llama_model *tokenizer = nullptr;
+    const llama_vocab *vocab = nullptr;
+    if (!params.tokenizer_path.empty()) {
+        llama_model_params mparams = llama_model_default_params();
+        mparams.vocab_only = true;
+        tokenizer = llama_model_load_from_file(params.tokenizer_path.c_str(), mparams);
+        if (tokenizer) vocab = llama_model_get_vocab(tokenizer);
+    } else {
+        vocab = dai_llm_embedder_vocab(embedder);
+    }
+    if (!vocab) {
+        LOGE("Ingest: no tokenizer (%s)", params.tokenizer_path.empty() ? "no embedder" : params.tokenizer_path.c_str());
+        if (tokenizer) llama_model_free(tokenizer);
+        return false;
+    }
+
+    std::vector<corpus_file> files;
+    for (const auto &path : paths) collect(path, true, params.extensions, files, stats.failed_files);
+    uint64_t total = 0;
+    for (const auto &f : files) total += f.size;
+
+    const unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    const size_t n_workers = params.n_threads > 0 ? (size_t)params.n_threads : hw;
+    const size_t piece_bytes =
+        std::min(MAX_PIECE_BYTES, std::max(MIN_PIECE_BYTES, params.max_buffered_bytes / (2 * n_workers)));
+
+    pipeline p;
+    p.vocab    = vocab;
+    p.bm25     = bm25;
+    p.embedder = hnsw ? embedder : nullptr;
+    p.hnsw     = hnsw;
+    p.params   = &params;
+
+    LOGI("Ingest: %zu files, %llu bytes, %zu workers, %zu-byte pieces",
+         files.size(), (unsigned long long)total, n_workers, piece_bytes);
+
+    reporter report{p, on_progress, total};
+    std::vector<std::thread> workers;
+    workers.reserve(n_workers);
+    for (size_t i = 0; i < n_workers; i++) workers.emplace_back(worker, std::ref(p));
+
+    for (const auto &f : files) {
+        const bool ok = read_file(p, report, f.path, piece_bytes, stats.bytes);
+        std::lock_guard<std::mutex> lock(p.mutex);
+        if (p.stop) break;
+        if (!ok) {
+            LOGE("Ingest: cannot read %s", f.path.c_str());
+            stats.failed_files++;
+            continue;
+        }
+        stats.files++;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(p.mutex);
+        p.closed = true;
+        p.has_work.notify_all();
+        while (!p.stop && p.buffered > 0) {
+            p.has_room.wait(lock);
+            report(lock);
+        }
+        report(lock);
+    }
+    for (auto &t : workers) t.join();
+    if (tokenizer) llama_model_free(tokenizer);
+
+    stats.chunks    = p.chunks;
+    stats.tokens    = p.tokens;
+    stats.cancelled = report.cancelled;
+    if (p.failed) return false;
+    if (stats.cancelled) return true;
+
+    if (bm25 && !params.bm25_path.empty() && !dai_llm_bm25_save(bm25, params.bm25_path)) return false;
+    if (hnsw && !params.hnsw_path.empty() && !dai_llm_hnsw_save(hnsw, params.hnsw_path)) return false;
+
+    LOGI("Ingest: %llu files, %llu chunks, %llu tokens (%llu files skipped)",
+         (unsigned long long)stats.files, (unsigned long long)stats.chunks,
+         (unsigned long long)stats.tokens, (unsigned long long)stats.failed_files);
+    return true;
+}
@@ -0,0 +1,90 @@
+#ifndef DEVICEAI_LLM_INGEST_H
+#define DEVICEAI_LLM_INGEST_H
+
+/**
+ * deviceai_llm_ingest.h - Parallel document ingestion for the RAG indexes
+ *
+ * Builds BM25 and HNSW indexes straight from files on disk, without the
+ * corpus ever passing through Kotlin lists:
+ *
+ *   reader (calling thread)  files → pieces of at most piece_bytes, cut at
+ *                            line breaks, into a queue bounded by
+ *                            max_buffered_bytes
+ *   workers (n_threads)      tokenize a piece, cut its tokens into windows
+ *                            of chunk_tokens overlapping by overlap_tokens,
+ *                            detokenize each window into a chunk, then add
+ *                            the chunks to the BM25 index and/or embed them
+ *                            and add them to the HNSW index
+ *
+ * Memory is bounded by the buffered text plus the indexes themselves, not
+ * by the corpus size. Chunks are windows over model tokens, so a chunk of
+ * chunk_tokens always fits the embedding model's context, whatever the
+ * language. Overlap does not cross piece boundaries; pieces end at line
+ * breaks, so those are natural chunk boundaries anyway.
+ *
+ * Workers share the embedder: at most its n_contexts of them embed at
+ * once (dai_llm_embed_params::n_contexts), the others wait. With the default
+ * single context, tokenizing, chunking and BM25 indexing run in parallel but
+ * embedding does not.
+ *
+ * Pieces finish in any order, so ids follow completion order, not file
+ * order. Each chunk's source is its file's path.
+ */
+
+#include "deviceai_llm_bm25.h"
+#include "deviceai_llm_embed.h"
+#include "deviceai_llm_hnsw.h"
+
+#include <functional>
+
+struct dai_llm_ingest_params {
+    int    chunk_tokens       = 256;
+    int    overlap_tokens     = 32;
+    int    n_threads          = 0;          // 0 = all cores
+    size_t max_buffered_bytes = 64 << 20;   // text read but not yet indexed
+
+    // GGUF model whose tokenizer sizes the chunks (only its vocabulary is
+    // loaded). Empty: the embedder's model.
+    std::string tokenizer_path;
+
+    // Files taken from directories, by extension (case-insensitive). Empty
+    // takes every file. Paths passed directly are always read.
+    std::vector<std::string> extensions = {"txt", "md", "markdown"};
+
+    // Written after a complete run when not empty.
+    std::string bm25_path;
+    std::string hnsw_path;
+};
+
+struct dai_llm_ingest_stats {
+    uint64_t files        = 0;
+    uint64_t failed_files = 0;   // unreadable; skipped
+    uint64_t bytes        = 0;
+    uint64_t chunks       = 0;
+    uint64_t tokens       = 0;
+    bool     cancelled    = false;
+};
+
+// Called on the calling thread with bytes indexed so far and the corpus
+// size. Return false to stop; chunks already indexed stay in the indexes.
+using dai_llm_ingest_progress_cb = std::function<bool(uint64_t done, uint64_t total)>;
+
+/**
+ * Chunk and index every file in paths (directories are walked recursively,
+ * skipping hidden entries). bm25 and hnsw may each be null, not both; hnsw
+ * needs embedder, with matching dimensions.
+ *
+ * False if the tokenizer cannot be loaded, an embedding batch fails or an
+ * index cannot be saved. Unreadable files are counted and skipped.
+ */
+bool dai_llm_ingest(
+    const std::vector<std::string> &paths,
+    dai_llm_bm25 *bm25,
+    dai_llm_embedder *embedder,
+    dai_llm_hnsw *hnsw,
+    const dai_llm_ingest_params &params,
+    dai_llm_ingest_stats &stats,
+    const dai_llm_ingest_progress_cb &on_progress = nullptr
+);
+
+#endif // DEVICEAI_LLM_INGEST_H
@@ -1,10 +1,24 @@
 #include "deviceai_llm_jni.h"
-#include "llama.h"
+#include "deviceai_llm_engine.h"
+#include "deviceai_llm_snapshot.h"
+#include "deviceai_llm_prefix_cache.h"
+#include "deviceai_llm_memory.h"
+#include "deviceai_llm_stream.h"
+#include "deviceai_llm_context.h"
+#include "deviceai_llm_bm25.h"
+#include "deviceai_llm_embed.h"
+#include "deviceai_llm_hnsw.h"
+#include "deviceai_llm_ingest.h"
+#include "deviceai_llm_pack.h"
+#include "deviceai_llm_metrics.h"
+#include "deviceai_llm_threads.h"
+#include "deviceai_llm_nbest.h"
+#include "deviceai_llm_jobs.h"
+#include "deviceai_llm_score.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
-#include <atomic>
-#include <functional>
 #include <cstring>
 
 #ifdef ANDROID
@@ -18,31 +32,109 @@
 #define LOGE(...) fprintf(stderr, __VA_ARGS__)
 #endif
 
-// ═══════════════════════════════════════════════════════════════
-//                         Global state
-// ═══════════════════════════════════════════════════════════════
-
-static llama_model   *g_model   = nullptr;
-static llama_context *g_ctx     = nullptr;
-static llama_sampler *g_sampler = nullptr;
-static std::atomic<bool> g_cancel{false};
-
 // ═══════════════════════════════════════════════════════════════
 //                         Helpers
 // ═══════════════════════════════════════════════════════════════
 
+// Java string as standard UTF-8. GetStringUTFChars returns modified UTF-8,
+// which splits characters outside the BMP (emoji) into two 3-byte surrogates.
+// A lone surrogate becomes U+FFFD.
 static std::string jstring_to_std(JNIEnv *env, jstring js) {
     if (!js) return "";
-    const char *chars = env->GetStringUTFChars(js, nullptr);
-    std::string s(chars);
-    env->ReleaseStringUTFChars(js, chars);
+    const jsize n = env->GetStringLength(js);
+    const jchar *chars = env->GetStringChars(js, nullptr);
+    std::string s;
+    s.reserve(n);
+    for (jsize i = 0; i < n; i++) {
+        uint32_t c = chars[i];
+        if (c >= 0xD800 && c < 0xDC00 && i + 1 < n && chars[i + 1] >= 0xDC00 && chars[i + 1] < 0xE000) {
+            c = 0x10000 + ((c - 0xD800) << 10) + (chars[++i] - 0xDC00);
+        } else if (c >= 0xD800 && c < 0xE000) {
+            c = 0xFFFD;
+        }
+        if (c < 0x80) {
+            s += (char)c;
+        } else if (c < 0x800) {
+            s += (char)(0xC0 | c >> 6);
+            s += (char)(0x80 | (c & 0x3F));
+        } else if (c < 0x10000) {
+            s += (char)(0xE0 | c >> 12);
+            s += (char)(0x80 | (c >> 6 & 0x3F));
+            s += (char)(0x80 | (c & 0x3F));
+        } else {
+            s += (char)(0xF0 | c >> 18);
+            s += (char)(0x80 | (c >> 12 & 0x3F));
+            s += (char)(0x80 | (c >> 6 & 0x3F));
+            s += (char)(0x80 | (c & 0x3F));
+        }
+    }
+    env->ReleaseStringChars(js, chars);
     return s;
 }
 
-static void cleanup() {
-    if (g_sampler) { llama_sampler_free(g_sampler); g_sampler = nullptr; }
-    if (g_ctx)     { llama_free(g_ctx);              g_ctx     = nullptr; }
-    if (g_model)   { llama_model_free(g_model);      g_model   = nullptr; }
+// UTF-8 bytes as a byte[], for Kotlin to decode with Charsets.UTF_8.
+// (NewStringUTF expects modified UTF-8 and mangles 4-byte characters.)
+static jbyteArray utf8_bytes(JNIEnv *env, const std::string &s) {
+    jbyteArray out = env->NewByteArray((jsize)s.size());
+    if (out) env->SetByteArrayRegion(out, 0, (jsize)s.size(), reinterpret_cast<const jbyte *>(s.data()));
+    return out;
+}
+
+// Search hits as [text0, source0, text1, source1, ...] UTF-8 byte[]s, a null
+// source for hits without one, with the scores written to jScores.
+template <typename Hit>
+static jobjectArray hits_array(JNIEnv *env, const std::vector<Hit> &hits, jfloatArray jScores) {
+    jclass bytesClass = env->FindClass("[B");
+    jobjectArray out = env->NewObjectArray((jsize)(2 * hits.size()), bytesClass, nullptr);
+    env->DeleteLocalRef(bytesClass);
+    if (!out) return nullptr;
+
+    for (size_t i = 0; i < hits.size(); i++) {
+        const Hit &h = hits[i];
+        jbyteArray text = utf8_bytes(env, h.text);
+        env->SetObjectArrayElement(out, (jsize)(2 * i), text);
+        env->DeleteLocalRef(text);
+        if (h.has_source) {
+            jbyteArray source = utf8_bytes(env, h.source);
+            env->SetObjectArrayElement(out, (jsize)(2 * i + 1), source);
+            env->DeleteLocalRef(source);
+        }
+        env->SetFloatArrayRegion(jScores, (jsize)i, 1, &h.score);
+    }
+    return out;
+}
+
+// Elements of a String[] (null array → empty, null element → "").
+static std::vector<std::string> string_array(JNIEnv *env, jobjectArray arr) {
+    std::vector<std::string> out;
+    const int count = arr ? env->GetArrayLength(arr) : 0;
+    out.reserve(count);
+    for (int i = 0; i < count; i++) {
+        auto js = (jstring)env->GetObjectArrayElement(arr, i);
+        out.push_back(jstring_to_std(env, js));
+        env->DeleteLocalRef(js);
+    }
+    return out;
+}
+
+static inline dai_llm_model *as_model(jlong handle) {
+    return reinterpret_cast<dai_llm_model *>(handle);
+}
+
+static inline dai_llm_bm25 *as_bm25(jlong handle) {
+    return reinterpret_cast<dai_llm_bm25 *>(handle);
+}
+
+static inline dai_llm_session *as_session(jlong handle) {
+    return reinterpret_cast<dai_llm_session *>(handle);
+}
+
+static inline dai_llm_embedder *as_embedder(jlong handle) {
+    return reinterpret_cast<dai_llm_embedder *>(handle);
+}
+
+static inline dai_llm_hnsw *as_hnsw(jlong handle) {
+    return reinterpret_cast<dai_llm_hnsw *>(handle);
 }
 
 // ═══════════════════════════════════════════════════════════════
@@ -52,128 +144,181 @@ static void cleanup() {
 // which handles ChatML, Llama 3, Gemma, Mistral, etc. automatically.
 // ═══════════════════════════════════════════════════════════════
 
-static std::string build_prompt(jobjectArray jRoles, jobjectArray jContents, JNIEnv *env) {
-    if (!g_model) return "";
+// system_prefix, when given, receives the formatted leading system messages
+// (the tokens a context shift keeps pinned).
+static std::string build_prompt(
+    dai_llm_session *session, jobjectArray jRoles, jobjectArray jContents, JNIEnv *env,
+    bool add_assistant = true, std::string *system_prefix = nullptr
+) {
+    if (!session) return "";
 
     int count = env->GetArrayLength(jRoles);
-    // Keep content strings alive while we hold pointers into them.
-    // MUST reserve before the loop — any reallocation of storage invalidates all
-    // .c_str() pointers already stored in msgs entries (dangling pointer UB).
-    std::vector<std::string>        storage;
-    std::vector<llama_chat_message> msgs;
-    storage.reserve(count * 2);
+    std::vector<std::string> roles, contents;
+    roles.reserve(count);
+    contents.reserve(count);
 
     for (int i = 0; i < count; i++) {
-        auto role    = jstring_to_std(env, (jstring)env->GetObjectArrayElement(jRoles,    i));
-        auto content = jstring_to_std(env, (jstring)env->GetObjectArrayElement(jContents, i));
-        storage.push_back(std::move(role));
-        storage.push_back(std::move(content));
-        msgs.push_back({ storage[storage.size()-2].c_str(), storage.back().c_str() });
+        auto jRole    = (jstring)env->GetObjectArrayElement(jRoles,    i);
+        auto jContent = (jstring)env->GetObjectArrayElement(jContents, i);
+        roles.push_back(jstring_to_std(env, jRole));
+        contents.push_back(jstring_to_std(env, jContent));
+        env->DeleteLocalRef(jRole);
+        env->DeleteLocalRef(jContent);
     }
 
-    if (msgs.empty()) return "";
-
-    const char *tmpl = llama_model_chat_template(g_model, nullptr);
-    int32_t sz = llama_chat_apply_template(tmpl, msgs.data(), msgs.size(), true, nullptr, 0);
-    if (sz <= 0) return "";
+    if (system_prefix) *system_prefix = dai_llm_context_system_prefix(session->model, roles, contents);
+    return dai_llm_format_chat(session->model, roles, contents, add_assistant);
+}
 
-    std::string out(sz, '\0');
-    llama_chat_apply_template(tmpl, msgs.data(), msgs.size(), true, out.data(), sz);
-    return out;
+static dai_llm_kv_type kv_type(jint code) {
+    return code == DAI_LLM_KV_Q8_0 || code == DAI_LLM_KV_Q4_0 ? (dai_llm_kv_type)code : DAI_LLM_KV_F16;
 }
 
-static llama_sampler *build_sampler(float temperature, float top_p, int top_k, float repeat_penalty) {
-    auto *chain = llama_sampler_chain_init(llama_sampler_chain_default_params());
-    llama_sampler_chain_add(chain, llama_sampler_init_top_k(top_k));
-    llama_sampler_chain_add(chain, llama_sampler_init_top_p(top_p, 1));
-    llama_sampler_chain_add(chain, llama_sampler_init_temp(temperature));
-    llama_sampler_chain_add(chain, llama_sampler_init_penalties(
-        64,            // last_n penalty window
-        repeat_penalty,
-        0.0f,          // freq penalty
-        0.0f           // presence penalty
-    ));
-    llama_sampler_chain_add(chain, llama_sampler_init_dist(LLAMA_DEFAULT_SEED));
-    return chain;
+static dai_llm_model_params model_params(
+    JNIEnv *env, jint maxThreads, jboolean useGpu, jint parallelSequences, jstring jDraftModelPath,
+    jint contextSize, jint batchSize, jint microBatchSize,
+    jint kvTypeK, jint kvTypeV, jint flashAttention, jboolean useMmap
+) {
+    dai_llm_model_params p;
+    p.n_threads  = maxThreads;
+    p.use_gpu    = useGpu;
+    p.n_parallel = parallelSequences;
+    p.draft_path = jstring_to_std(env, jDraftModelPath);
+    p.n_ctx      = contextSize;
+    p.n_batch    = batchSize;
+    p.n_ubatch   = microBatchSize;
+    p.type_k     = kv_type(kvTypeK);
+    p.type_v     = kv_type(kvTypeV);
+    p.flash_attn = flashAttention;
+    p.use_mmap   = useMmap;
+    return p;
 }
 
-// ═══════════════════════════════════════════════════════════════
-//                    Core generation loop
-// Tokenizes prompt, runs decode loop, calls on_token for each piece.
-// Returns the full generated string.
-// ═══════════════════════════════════════════════════════════════
+// Pack the RAG chunks with the session's tokenizer and have the engine
+// splice the tokens in where the marker appears in the prompt.
+static void splice_context(JNIEnv *env, dai_llm_session *s, jstring jMarker, jobjectArray jChunks, jint maxTokens,
+                           dai_llm_gen_params &params) {
+    if (!s || !jMarker || !jChunks) return;
+    params.splice_marker = jstring_to_std(env, jMarker);
+    params.splice_tokens = dai_llm_pack_context(llama_model_get_vocab(s->model->model),
+                                                string_array(env, jChunks), maxTokens).tokens;
+}
 
-static std::string do_generate(
-    const std::string &full_prompt,
-    int max_tokens,
-    float temperature,
-    float top_p,
-    int top_k,
-    float repeat_penalty,
-    std::function<bool(const std::string &)> on_token  // return false to stop
-) {
-    if (!g_model || !g_ctx) return "";
-
-    // Clear the KV cache so each call starts with a fresh context.
-    llama_memory_clear(llama_get_memory(g_ctx), /*data=*/false);
-    llama_perf_context_reset(g_ctx);
-
-    const llama_vocab *vocab = llama_model_get_vocab(g_model);
-
-    // Tokenize
-    int n_prompt_max = llama_n_ctx(g_ctx);
-    std::vector<llama_token> tokens(n_prompt_max);
-    int n_tokens = llama_tokenize(
-        vocab,
-        full_prompt.c_str(),
-        (int)full_prompt.size(),
-        tokens.data(),
-        n_prompt_max,
-        /*add_special=*/true,
-        /*parse_special=*/true
-    );
-    if (n_tokens < 0) {
-        LOGE("Tokenization failed");
-        return "";
-    }
-    tokens.resize(n_tokens);
+// The fields of an LlmGenParamsInternal (LlmJniEngine.kt) as engine
+// parameters, RAG chunks packed with the session's tokenizer.
+static dai_llm_gen_params gen_params(JNIEnv *env, dai_llm_session *s, jobject jParams) {
+    dai_llm_gen_params p;
+    if (!jParams) return p;
 
-    // Decode prompt in one batch
-    llama_batch batch = llama_batch_get_one(tokens.data(), (int)tokens.size());
-    if (llama_decode(g_ctx, batch)) {
-        LOGE("llama_decode prompt failed");
-        return "";
-    }
+    jclass cls = env->GetObjectClass(jParams);
+    auto int_field   = [&](const char *name) { return env->GetIntField(jParams, env->GetFieldID(cls, name, "I")); };
+    auto float_field = [&](const char *name) { return env->GetFloatField(jParams, env->GetFieldID(cls, name, "F")); };
+    auto bool_field  = [&](const char *name) {
+        return env->GetBooleanField(jParams, env->GetFieldID(cls, name, "Z")) == JNI_TRUE;
+    };
+    auto object_field = [&](const char *name, const char *sig) {
+        return env->GetObjectField(jParams, env->GetFieldID(cls, name, sig));
+    };
 
-    // Build sampler
-    auto *sampler = build_sampler(temperature, top_p, top_k, repeat_penalty);
+    p.max_tokens         = int_field("maxTokens");
+    p.temperature        = float_field("temperature");
+    p.top_p              = float_field("topP");
+    p.top_k              = int_field("topK");
+    p.repeat_penalty     = float_field("repeatPenalty");
+    p.seed               = (uint32_t)int_field("seed");   // -1 → LLAMA_DEFAULT_SEED
+    p.prefill_chunk      = int_field("prefillChunk");
+    p.n_draft            = int_field("draftTokens");
+    p.prompt_lookup      = bool_field("promptLookup");
+    p.context_shift      = bool_field("contextShift");
+    p.n_keep             = int_field("keepTokens");
+    p.repeat_stop_tokens = int_field("repeatStopTokens");
 
-    std::string result;
-    char piece_buf[256];
-    int n_generated = 0;
+    auto jStop    = (jobjectArray)object_field("stop", "[Ljava/lang/String;");
+    auto jGrammar = (jstring)object_field("grammar", "Ljava/lang/String;");
+    auto jMarker  = (jstring)object_field("contextMarker", "Ljava/lang/String;");
+    auto jChunks  = (jobjectArray)object_field("contextChunks", "[Ljava/lang/String;");
+    p.stop    = string_array(env, jStop);
+    p.grammar = jstring_to_std(env, jGrammar);
+    splice_context(env, s, jMarker, jChunks, int_field("contextTokens"), p);
+    env->DeleteLocalRef(jStop);
+    env->DeleteLocalRef(jGrammar);
+    env->DeleteLocalRef(jMarker);
+    env->DeleteLocalRef(jChunks);
+    env->DeleteLocalRef(cls);
+    return p;
+}
 
-    while (n_generated < max_tokens && !g_cancel.load()) {
-        llama_token token = llama_sampler_sample(sampler, g_ctx, -1);
-        llama_sampler_accept(sampler, token);
+// Copy a request's metrics into the caller's nullable DoubleArray, laid out
+// as LlmJniEngine expects.
+static void write_metrics(JNIEnv *env, jdoubleArray jOut, const dai_llm_gen_metrics &m) {
+    if (!jOut || env->ExceptionCheck()) return;
+    jdouble values[13] = {
+        (jdouble)m.prompt_tokens, (jdouble)m.cached_tokens, (jdouble)m.generated_tokens,
+        m.ttft_ms, m.prefill_ms, m.decode_ms, m.sample_ms, m.prefill_tps, m.decode_tps,
+        (jdouble)m.kv_peak, (jdouble)m.n_ctx, m.cancel_ms, (jdouble)m.stop_reason,
+    };
+    const jsize n = std::min((jsize)13, env->GetArrayLength(jOut));
+    env->SetDoubleArrayRegion(jOut, 0, n, values);
+}
 
-        if (llama_vocab_is_eog(vocab, token)) break;
+// Wrap a nullable LlmProgressInternal. Generation callbacks run on the thread
+// that called into JNI, so the caller's env is valid inside the lambda. If
+// Kotlin throws, the request is cancelled and the exception is left pending to
+// surface when the native call returns.
+static dai_llm_progress_cb progress_cb(JNIEnv *env, dai_llm_session *s, jobject jProgress) {
+    if (!jProgress) return nullptr;
+    jclass cls = env->GetObjectClass(jProgress);
+    jmethodID onProgress = env->GetMethodID(cls, "onProgress", "(II)V");
+    env->DeleteLocalRef(cls);
+    if (!onProgress) {
+        LOGE("Failed to find LlmProgressInternal.onProgress");
+        env->ExceptionClear();
+        return nullptr;
+    }
+    return [env, s, jProgress, onProgress](int processed, int total) {
+        if (env->ExceptionCheck()) return;
+        env->CallVoidMethod(jProgress, onProgress, (jint)processed, (jint)total);
+        if (env->ExceptionCheck()) s->cancel = true;
+    };
+}
 
-        int n = llama_token_to_piece(vocab, token, piece_buf, sizeof(piece_buf), 0, true);
-        if (n < 0) break;
+// Streams batches through the caller's direct ByteBuffer, used as a ring:
+// each batch is copied in at the write position (wrapping at the end) and
+// announced with LlmStreamInternal.onText(offset, length), or for n-best
+// streams LlmCandidateStreamInternal.onText(index, offset, length). The upcall
+// is synchronous, so Kotlin has read a batch before the next one is written.
+struct ring_writer {
+    JNIEnv   *env     = nullptr;
+    jobject   cb      = nullptr;
+    jmethodID on_text = nullptr;
+    uint8_t  *data    = nullptr;
+    size_t    cap     = 0;
+    size_t    pos     = 0;
+    bool      failed  = false;   // Kotlin threw; the exception is pending
+};
 
-        std::string piece(piece_buf, n);
-        result += piece;
-        n_generated++;
+static bool ring_write(ring_writer &w, const std::string &text, int index = -1) {
+    if (!w.failed) w.failed = w.env->ExceptionCheck();   // e.g. from the progress callback
+    size_t off = 0;
+    while (off < text.size() && !w.failed) {
+        // A batch larger than the ring goes out in pieces split between characters.
+        size_t n = text.size() - off;
+        if (n > w.cap) {
+            n = dai_llm_utf8_complete(text.substr(off, w.cap));
+            if (n == 0) n = w.cap;
+        }
 
-        if (!on_token(piece)) break;
+        const size_t first = std::min(n, w.cap - w.pos);
+        memcpy(w.data + w.pos, text.data() + off, first);
+        memcpy(w.data, text.data() + off + first, n - first);
 
-        // Decode the new token
-        llama_batch next = llama_batch_get_one(&token, 1);
-        if (llama_decode(g_ctx, next)) break;
+        if (index < 0) w.env->CallVoidMethod(w.cb, w.on_text, (jint)w.pos, (jint)n);
+        else           w.env->CallVoidMethod(w.cb, w.on_text, (jint)index, (jint)w.pos, (jint)n);
+        w.failed = w.env->ExceptionCheck();
+        w.pos = (w.pos + n) % w.cap;
+        off  += n;
     }
-
-    llama_sampler_free(sampler);
-    return result;
+    return !w.failed;
 }
 
 // ═══════════════════════════════════════════════════════════════
@@ -182,109 +327,729 @@ static std::string do_generate(
 
 extern "C" {
 
-JNIEXPORT jboolean JNICALL
+JNIEXPORT jlong JNICALL
 Java_dev_deviceai_llm_engine_LlmJniEngine_nativeInit(
     JNIEnv *env, jobject, jstring jModelPath,
-    jint maxThreads, jboolean useGpu
+    jint maxThreads, jboolean useGpu, jint parallelSequences,
+    jstring jDraftModelPath, jlong prefixCacheBytes,
+    jint contextSize, jint batchSize, jint microBatchSize,
+    jint kvTypeK, jint kvTypeV, jint flashAttention,
+    jboolean useMmap, jboolean useMlock,
+    jint batchThreads, jlong cpuMask, jlong batchCpuMask, jboolean strictCpu,
+    jint maxCandidates, jint scoreSequences, jint jobWorkers, jint jobQueue
 ) {
-    cleanup();
+    dai_llm_model_params params = model_params(
+        env, maxThreads, useGpu, parallelSequences, jDraftModelPath,
+        contextSize, batchSize, microBatchSize, kvTypeK, kvTypeV, flashAttention, useMmap);
+    params.prefix_cache_bytes = prefixCacheBytes > 0 ? (size_t)prefixCacheBytes : 0;
+    params.use_mlock          = useMlock;
+    params.n_threads_batch    = batchThreads;
+    params.cpu_mask           = (uint64_t)cpuMask;
+    params.cpu_mask_batch     = (uint64_t)batchCpuMask;
+    params.strict_cpu         = strictCpu;
+    params.max_candidates     = maxCandidates;
+    params.score_sequences    = scoreSequences;
+    params.job_workers        = jobWorkers;
+    params.job_queue          = jobQueue;
 
     std::string modelPath = jstring_to_std(env, jModelPath);
+    return reinterpret_cast<jlong>(dai_llm_model_load(modelPath, params));
+}
 
-    llama_model_params mparams = llama_model_default_params();
-    mparams.n_gpu_layers = useGpu ? 99 : 0;
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeEstimateMemory(
+    JNIEnv *env, jobject, jstring jModelPath,
+    jint maxThreads, jboolean useGpu, jint parallelSequences, jstring jDraftModelPath,
+    jint contextSize, jint batchSize, jint microBatchSize,
+    jint kvTypeK, jint kvTypeV, jint flashAttention,
+    jboolean useMmap, jint maxCandidates, jint scoreSequences, jint sessions
+) {
+    dai_llm_model_params params = model_params(
+        env, maxThreads, useGpu, parallelSequences, jDraftModelPath,
+        contextSize, batchSize, microBatchSize, kvTypeK, kvTypeV, flashAttention, useMmap);
+    params.max_candidates  = maxCandidates;
+    params.score_sequences = scoreSequences;
 
-    g_model = llama_model_load_from_file(modelPath.c_str(), mparams);
-    if (!g_model) {
-        LOGE("Failed to load model from %s", modelPath.c_str());
-        return JNI_FALSE;
-    }
+    dai_llm_memory_estimate est;
+    if (!dai_llm_estimate_memory(jstring_to_std(env, jModelPath), params, sessions, est)) return nullptr;
 
-    llama_context_params cparams = llama_context_default_params();
-    // n_ctx = 0 → llama.cpp uses the model's native context size from GGUF metadata
-    cparams.n_ctx     = 0;
-    cparams.n_threads = maxThreads;
-
-    g_ctx = llama_init_from_model(g_model, cparams);
-    if (!g_ctx) {
-        LOGE("Failed to create llama context");
-        llama_model_free(g_model);
-        g_model = nullptr;
-        return JNI_FALSE;
-    }
+    jlong values[5] = {
+        (jlong)est.n_ctx, (jlong)est.weights_bytes, (jlong)est.kv_bytes,
+        (jlong)est.compute_bytes, (jlong)est.total_bytes,
+    };
+    jlongArray out = env->NewLongArray(5);
+    if (out) env->SetLongArrayRegion(out, 0, 5, values);
+    return out;
+}
+
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeShutdown(JNIEnv *, jobject, jlong model) {
+    dai_llm_model_release(as_model(model));
+}
 
-    LOGI("LLM initialized: %s (ctx=%d, threads=%d, gpu=%d)",
-         modelPath.c_str(), llama_n_ctx(g_ctx), maxThreads, (bool)useGpu);
-    return JNI_TRUE;
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCreateSession(JNIEnv *, jobject, jlong model) {
+    return reinterpret_cast<jlong>(dai_llm_session_create(as_model(model)));
 }
 
 JNIEXPORT void JNICALL
-Java_dev_deviceai_llm_engine_LlmJniEngine_nativeShutdown(JNIEnv *, jobject) {
-    cleanup();
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCloseSession(JNIEnv *, jobject, jlong session) {
+    dai_llm_session_free(as_session(session));
+}
+
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeWarmPrefix(
+    JNIEnv *env, jobject, jlong session,
+    jobjectArray jRoles, jobjectArray jContents, jstring jCacheDir
+) {
+    auto *s = as_session(session);
+    std::string prefix = build_prompt(s, jRoles, jContents, env, /*add_assistant=*/false);
+    return dai_llm_session_warm(s, prefix, jstring_to_std(env, jCacheDir));
 }
 
 JNIEXPORT jstring JNICALL
 Java_dev_deviceai_llm_engine_LlmJniEngine_nativeGenerate(
-    JNIEnv *env, jobject,
-    jobjectArray jRoles, jobjectArray jContents,
-    jint maxTokens, jfloat temperature,
-    jfloat topP, jint topK, jfloat repeatPenalty
+    JNIEnv *env, jobject, jlong session,
+    jobjectArray jRoles, jobjectArray jContents, jobject jParams,
+    jobject jProgress, jdoubleArray jMetrics
 ) {
-    g_cancel = false;
-    std::string full = build_prompt(jRoles, jContents, env);
+    auto *s = as_session(session);
+    auto params = gen_params(env, s, jParams);
+    std::string full = build_prompt(s, jRoles, jContents, env, true,
+                                     params.context_shift && params.n_keep < 0 ? &params.keep_prefix : nullptr);
 
-    std::string result = do_generate(
-        full, maxTokens, temperature, topP, topK, repeatPenalty,
-        [](const std::string &) { return true; }
+    dai_llm_gen_metrics metrics;
+    std::string result = dai_llm_generate(
+        s, full, params,
+        [](const std::string &) { return true; },
+        progress_cb(env, s, jProgress),
+        &metrics
     );
+    write_metrics(env, jMetrics, metrics);
+    if (env->ExceptionCheck()) return nullptr;
 
     return env->NewStringUTF(result.c_str());
 }
 
 JNIEXPORT void JNICALL
 Java_dev_deviceai_llm_engine_LlmJniEngine_nativeGenerateStream(
-    JNIEnv *env, jobject,
-    jobjectArray jRoles, jobjectArray jContents,
-    jint maxTokens, jfloat temperature,
-    jfloat topP, jint topK, jfloat repeatPenalty,
-    jobject jCallback
+    JNIEnv *env, jobject, jlong session,
+    jobjectArray jRoles, jobjectArray jContents, jobject jParams,
+    jobject jProgress, jobject jBuffer, jint batchTokens, jint batchMillis,
+    jobject jCallback, jdoubleArray jMetrics
 ) {
-    g_cancel = false;
-    std::string full = build_prompt(jRoles, jContents, env);
+    auto *s = as_session(session);
+    auto params = gen_params(env, s, jParams);
+    std::string full = build_prompt(s, jRoles, jContents, env, true,
+                                     params.context_shift && params.n_keep < 0 ? &params.keep_prefix : nullptr);
 
-    // Resolve LlmStreamInternal callback methods (onToken + onError only)
+    // Resolve LlmStreamInternal callback methods (onText + onError only)
     jclass cbClass      = env->GetObjectClass(jCallback);
-    jmethodID onToken   = env->GetMethodID(cbClass, "onToken", "(Ljava/lang/String;)V");
+    jmethodID onText    = env->GetMethodID(cbClass, "onText", "(II)V");
     jmethodID onError   = env->GetMethodID(cbClass, "onError", "(Ljava/lang/String;)V");
+    env->DeleteLocalRef(cbClass);
 
-    if (!onToken || !onError) {
+    if (!onText || !onError) {
         LOGE("Failed to find LlmStreamInternal methods");
         return;
     }
 
-    jobject globalCb = env->NewGlobalRef(jCallback);
-    JavaVM *jvm;
-    env->GetJavaVM(&jvm);
+    ring_writer ring;
+    ring.env     = env;
+    ring.cb      = jCallback;
+    ring.on_text = onText;
+    ring.data    = static_cast<uint8_t *>(env->GetDirectBufferAddress(jBuffer));
+    ring.cap     = ring.data ? (size_t)env->GetDirectBufferCapacity(jBuffer) : 0;
+    if (ring.cap == 0) {
+        jstring msg = env->NewStringUTF("Stream buffer must be a non-empty direct ByteBuffer");
+        env->CallVoidMethod(jCallback, onError, msg);
+        env->DeleteLocalRef(msg);
+        return;
+    }
+
+    dai_llm_stream_batcher batcher;
+    batcher.max_tokens = batchTokens;
+    batcher.max_ms     = batchMillis;
+    batcher.on_text    = [&](const std::string &text) { return ring_write(ring, text); };
 
-    do_generate(
-        full, maxTokens, temperature, topP, topK, repeatPenalty,
+    // Token callbacks run on this thread (the scheduler hands pieces back to
+    // the waiting caller), so env and the local callback ref stay valid.
+    dai_llm_gen_metrics metrics;
+    dai_llm_generate(
+        s, full, params,
         [&](const std::string &piece) -> bool {
-            JNIEnv *e;
-            jvm->AttachCurrentThread(&e, nullptr);
-            jstring jPiece = e->NewStringUTF(piece.c_str());
-            e->CallVoidMethod(globalCb, onToken, jPiece);
-            e->DeleteLocalRef(jPiece);
-            return !g_cancel.load();
-        }
+            return dai_llm_stream_push(batcher, piece) && !s->cancel.load();
+        },
+        progress_cb(env, s, jProgress),
+        &metrics
     );
+    if (!ring.failed) dai_llm_stream_finish(batcher);
+    write_metrics(env, jMetrics, metrics);
+    if (metrics.failed && !env->ExceptionCheck()) {
+        jstring msg = env->NewStringUTF("Generation failed");
+        env->CallVoidMethod(jCallback, onError, msg);
+        env->DeleteLocalRef(msg);
+    }
 
     // Flow completes naturally when nativeGenerateStream returns — no onComplete JNI call needed.
-    env->DeleteGlobalRef(globalCb);
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeGenerateN(
+    JNIEnv *env, jobject, jlong session,
+    jobjectArray jRoles, jobjectArray jContents, jint count, jobject jParams,
+    jobject jProgress, jdoubleArray jMetrics
+) {
+    auto *s = as_session(session);
+    auto params = gen_params(env, s, jParams);
+    params.context_shift = false;   // candidates share sequence 0's prompt cells
+    std::string full = build_prompt(s, jRoles, jContents, env, true);
+
+    dai_llm_gen_metrics metrics;
+    std::vector<std::string> results = dai_llm_generate_n(
+        s, full, params, count,
+        [](int, const std::string &) { return true; },
+        progress_cb(env, s, jProgress),
+        &metrics
+    );
+    write_metrics(env, jMetrics, metrics);
+    if (env->ExceptionCheck()) return nullptr;
+
+    jclass bytesClass = env->FindClass("[B");
+    jobjectArray out = env->NewObjectArray((jsize)results.size(), bytesClass, nullptr);
+    env->DeleteLocalRef(bytesClass);
+    if (!out) return nullptr;
+    for (size_t i = 0; i < results.size(); i++) {
+        jbyteArray text = utf8_bytes(env, results[i]);
+        env->SetObjectArrayElement(out, (jsize)i, text);
+        env->DeleteLocalRef(text);
+    }
+    return out;
+}
+
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeGenerateNStream(
+    JNIEnv *env, jobject, jlong session,
+    jobjectArray jRoles, jobjectArray jContents, jint count, jobject jParams,
+    jobject jProgress, jobject jBuffer, jint batchTokens, jint batchMillis,
+    jobject jCallback, jdoubleArray jMetrics
+) {
+    auto *s = as_session(session);
+    auto params = gen_params(env, s, jParams);
+    params.context_shift = false;   // candidates share sequence 0's prompt cells
+    std::string full = build_prompt(s, jRoles, jContents, env, true);
+
+    // Resolve LlmCandidateStreamInternal callback methods
+    jclass cbClass      = env->GetObjectClass(jCallback);
+    jmethodID onText    = env->GetMethodID(cbClass, "onText", "(III)V");
+    jmethodID onError   = env->GetMethodID(cbClass, "onError", "(Ljava/lang/String;)V");
+    env->DeleteLocalRef(cbClass);
+
+    if (!onText || !onError) {
+        LOGE("Failed to find LlmCandidateStreamInternal methods");
+        return;
+    }
+
+    ring_writer ring;
+    ring.env     = env;
+    ring.cb      = jCallback;
+    ring.on_text = onText;
+    ring.data    = static_cast<uint8_t *>(env->GetDirectBufferAddress(jBuffer));
+    ring.cap     = ring.data ? (size_t)env->GetDirectBufferCapacity(jBuffer) : 0;
+    if (ring.cap == 0) {
+        jstring msg = env->NewStringUTF("Stream buffer must be a non-empty direct ByteBuffer");
+        env->CallVoidMethod(jCallback, onError, msg);
+        env->DeleteLocalRef(msg);
+        return;
+    }
+
+    // One batcher per candidate: each holds back its own split characters.
+    std::vector<dai_llm_stream_batcher> batchers(std::max(0, (int)count));
+    for (size_t i = 0; i < batchers.size(); i++) {
+        batchers[i].max_tokens = batchTokens;
+        batchers[i].max_ms     = batchMillis;
+        batchers[i].on_text    = [&ring, i](const std::string &text) { return ring_write(ring, text, (int)i); };
+    }
+
+    dai_llm_gen_metrics metrics;
+    std::vector<std::string> results = dai_llm_generate_n(
+        s, full, params, count,
+        [&](int index, const std::string &piece) -> bool {
+            if (!dai_llm_stream_push(batchers[index], piece)) s->cancel = true;   // Kotlin threw
+            return !s->cancel.load();
+        },
+        progress_cb(env, s, jProgress),
+        &metrics
+    );
+    for (size_t i = 0; i < results.size() && !ring.failed; i++) dai_llm_stream_finish(batchers[i]);
+    write_metrics(env, jMetrics, metrics);
+    if (metrics.failed && !env->ExceptionCheck()) {
+        jstring msg = env->NewStringUTF("Generation failed");
+        env->CallVoidMethod(jCallback, onError, msg);
+        env->DeleteLocalRef(msg);
+    }
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeScoreContinuations(
+    JNIEnv *env, jobject, jlong session,
+    jobjectArray jRoles, jobjectArray jContents, jobjectArray jContinuations, jintArray jTokenCounts
+) {
+    auto *s = as_session(session);
+    std::string full = build_prompt(s, jRoles, jContents, env, true);
+
+    std::vector<dai_llm_continuation_score> scores;
+    if (!dai_llm_score_continuations(s, full, string_array(env, jContinuations), scores)) return nullptr;
+
+    std::vector<jint>   counts;
+    std::vector<jfloat> logprobs;
+    for (const dai_llm_continuation_score &score : scores) {
+        counts.push_back((jint)score.token_logprobs.size());
+        logprobs.insert(logprobs.end(), score.token_logprobs.begin(), score.token_logprobs.end());
+    }
+    const jsize n_counts = std::min((jsize)counts.size(), env->GetArrayLength(jTokenCounts));
+    env->SetIntArrayRegion(jTokenCounts, 0, n_counts, counts.data());
+
+    jfloatArray out = env->NewFloatArray((jsize)logprobs.size());
+    if (out) env->SetFloatArrayRegion(out, 0, (jsize)logprobs.size(), logprobs.data());
+    return out;
+}
+
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCancel(JNIEnv *, jobject, jlong session) {
+    dai_llm_cancel(as_session(session));
+}
+
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeSubmitGenerate(
+    JNIEnv *env, jobject, jlong session,
+    jobjectArray jRoles, jobjectArray jContents, jobject jParams, jint priority
+) {
+    auto *s = as_session(session);
+    if (!s) return -1;
+    auto params = gen_params(env, s, jParams);
+    std::string full = build_prompt(s, jRoles, jContents, env, true,
+                                     params.context_shift && params.n_keep < 0 ? &params.keep_prefix : nullptr);
+    return dai_llm_job_submit(s, std::move(full), std::move(params), priority);
+}
+
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativePollJob(JNIEnv *, jobject, jlong job) {
+    return dai_llm_job_poll(job);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCancelJob(JNIEnv *, jobject, jlong job, jboolean discard) {
+    return dai_llm_job_cancel(job, discard);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeAwaitJobs(JNIEnv *env, jobject, jint timeoutMs) {
+    std::vector<int64_t> ids;
+    if (!dai_llm_jobs_wait(ids, timeoutMs)) return nullptr;
+    std::vector<jlong> values(ids.begin(), ids.end());
+    jlongArray out = env->NewLongArray((jsize)values.size());
+    if (out) env->SetLongArrayRegion(out, 0, (jsize)values.size(), values.data());
+    return out;
+}
+
+JNIEXPORT jbyteArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeTakeJob(JNIEnv *env, jobject, jlong job, jdoubleArray jMetrics) {
+    dai_llm_job_result result;
+    if (!dai_llm_job_take(job, result)) return nullptr;
+    write_metrics(env, jMetrics, result.metrics);
+    return utf8_bytes(env, result.text);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeSpeculativeStats(JNIEnv *env, jobject, jlong session) {
+    dai_llm_spec_stats st = dai_llm_speculative_stats(as_session(session));
+    jlong values[3] = { (jlong)st.n_drafted, (jlong)st.n_accepted, (jlong)st.n_rounds };
+    jlongArray out = env->NewLongArray(3);
+    if (out) env->SetLongArrayRegion(out, 0, 3, values);
+    return out;
+}
+
+JNIEXPORT jintArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCountTokens(JNIEnv *env, jobject, jlong model, jobjectArray jTexts) {
+    dai_llm_model *m = as_model(model);
+    std::vector<int> counts = dai_llm_count_tokens(m ? llama_model_get_vocab(m->model) : nullptr,
+                                                   string_array(env, jTexts));
+    jintArray out = env->NewIntArray((jsize)counts.size());
+    if (out) env->SetIntArrayRegion(out, 0, (jsize)counts.size(), reinterpret_cast<const jint *>(counts.data()));
+    return out;
+}
+
+JNIEXPORT jintArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativePackContext(
+    JNIEnv *env, jobject, jlong model, jobjectArray jChunks, jint maxTokens, jintArray jChunkTokens
+) {
+    dai_llm_model *m = as_model(model);
+    dai_llm_packed_context packed = dai_llm_pack_context(m ? llama_model_get_vocab(m->model) : nullptr,
+                                                         string_array(env, jChunks), maxTokens);
+
+    const jsize n_chunks = std::min((jsize)packed.chunk_tokens.size(), env->GetArrayLength(jChunkTokens));
+    env->SetIntArrayRegion(jChunkTokens, 0, n_chunks, reinterpret_cast<const jint *>(packed.chunk_tokens.data()));
+
+    jintArray out = env->NewIntArray((jsize)packed.tokens.size());
+    if (out) {
+        static_assert(sizeof(jint) == sizeof(llama_token), "jint must match llama_token");
+        env->SetIntArrayRegion(out, 0, (jsize)packed.tokens.size(), reinterpret_cast<const jint *>(packed.tokens.data()));
+    }
+    return out;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativePrefixCacheStats(JNIEnv *env, jobject, jlong model) {
+    dai_llm_model *m = as_model(model);
+    dai_llm_prefix_stats st = dai_llm_prefix_cache_stats(m ? m->prefix_cache : nullptr);
+    jlong values[8] = {
+        (jlong)st.lookups, (jlong)st.hits, (jlong)st.tokens_reused, (jlong)st.insertions,
+        (jlong)st.evictions, (jlong)st.entries, (jlong)st.bytes_used, (jlong)st.budget_bytes,
+    };
+    jlongArray out = env->NewLongArray(8);
+    if (out) env->SetLongArrayRegion(out, 0, 8, values);
+    return out;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeMetricsHistogram(JNIEnv *env, jobject, jlong model, jboolean reset) {
+    dai_llm_model *m = as_model(model);
+    dai_llm_metrics_histogram h = dai_llm_metrics_snapshot(m ? m->metrics : nullptr, reset);
+
+    const int B = DAI_LLM_METRICS_BUCKETS;
+    jlong values[4 + 4 * B] = {
+        (jlong)h.requests, (jlong)h.prompt_tokens, (jlong)h.cached_tokens, (jlong)h.generated_tokens,
+    };
+    for (int i = 0; i < B; i++) {
+        values[4 + i]         = (jlong)h.ttft_ms[i];
+        values[4 + B + i]     = (jlong)h.prefill_tps[i];
+        values[4 + 2 * B + i] = (jlong)h.decode_tps[i];
+        values[4 + 3 * B + i] = (jlong)h.cancel_ms[i];
+    }
+    jlongArray out = env->NewLongArray(4 + 4 * B);
+    if (out) env->SetLongArrayRegion(out, 0, 4 + 4 * B, values);
+    return out;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Threads
+// ═══════════════════════════════════════════════════════════════
+
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeSetThreads(
+    JNIEnv *, jobject, jlong model,
+    jint threads, jint batchThreads, jlong cpuMask, jlong batchCpuMask, jboolean strictCpu
+) {
+    dai_llm_threads t;
+    t.n_threads       = threads;
+    t.n_threads_batch = batchThreads;
+    t.cpu_mask        = (uint64_t)cpuMask;
+    t.cpu_mask_batch  = (uint64_t)batchCpuMask;
+    t.strict_cpu      = strictCpu;
+    dai_llm_set_threads(as_model(model), t);
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeGetThreads(JNIEnv *env, jobject, jlong model) {
+    dai_llm_threads t = dai_llm_get_threads(as_model(model));
+    jlong values[5] = {
+        (jlong)t.n_threads, (jlong)t.n_threads_batch, (jlong)t.cpu_mask, (jlong)t.cpu_mask_batch,
+        (jlong)t.strict_cpu,
+    };
+    jlongArray out = env->NewLongArray(5);
+    if (out) env->SetLongArrayRegion(out, 0, 5, values);
+    return out;
+}
+
+JNIEXPORT jdoubleArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeAutotuneThreads(JNIEnv *env, jobject, jlong model, jstring jCachePath) {
+    dai_llm_thread_tuning r = dai_llm_threads_autotune(as_model(model), jstring_to_std(env, jCachePath));
+    if (r.n_threads <= 0) return nullptr;
+
+    jdouble values[5] = {
+        (jdouble)r.n_threads, (jdouble)r.n_threads_batch, r.decode_tps, r.prefill_tps, r.cached ? 1.0 : 0.0,
+    };
+    jdoubleArray out = env->NewDoubleArray(5);
+    if (out) env->SetDoubleArrayRegion(out, 0, 5, values);
+    return out;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                      RAG: BM25 index
+// ═══════════════════════════════════════════════════════════════
+
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Create(JNIEnv *, jobject, jfloat k1, jfloat b) {
+    return reinterpret_cast<jlong>(dai_llm_bm25_create(k1, b));
+}
+
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Load(JNIEnv *env, jobject, jstring jPath) {
+    return reinterpret_cast<jlong>(dai_llm_bm25_load(jstring_to_std(env, jPath)));
+}
+
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Free(JNIEnv *, jobject, jlong index) {
+    dai_llm_bm25_free(as_bm25(index));
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Add(
+    JNIEnv *env, jobject, jlong index, jobjectArray jTexts, jobjectArray jSources
+) {
+    const int count = env->GetArrayLength(jTexts);
+    const int n_sources = jSources ? env->GetArrayLength(jSources) : 0;
+
+    std::vector<dai_llm_bm25_doc> docs(count);
+    for (int i = 0; i < count; i++) {
+        auto jText = (jstring)env->GetObjectArrayElement(jTexts, i);
+        docs[i].text = jstring_to_std(env, jText);
+        env->DeleteLocalRef(jText);
+
+        auto jSource = i < n_sources ? (jstring)env->GetObjectArrayElement(jSources, i) : nullptr;
+        if (jSource) {
+            docs[i].source     = jstring_to_std(env, jSource);
+            docs[i].has_source = true;
+            env->DeleteLocalRef(jSource);
+        }
+    }
+
+    std::vector<int64_t> ids = dai_llm_bm25_add(as_bm25(index), docs);
+    jlongArray out = env->NewLongArray((jsize)ids.size());
+    if (out) {
+        static_assert(sizeof(jlong) == sizeof(int64_t), "jlong must be 64-bit");
+        env->SetLongArrayRegion(out, 0, (jsize)ids.size(), reinterpret_cast<const jlong *>(ids.data()));
+    }
+    return out;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Remove(JNIEnv *, jobject, jlong index, jlong id) {
+    return dai_llm_bm25_remove(as_bm25(index), id);
+}
+
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Size(JNIEnv *, jobject, jlong index) {
+    return (jint)dai_llm_bm25_size(as_bm25(index));
+}
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Save(JNIEnv *env, jobject, jlong index, jstring jPath) {
+    return dai_llm_bm25_save(as_bm25(index), jstring_to_std(env, jPath));
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Search(
+    JNIEnv *env, jobject, jlong index, jstring jQuery, jint topK, jfloatArray jScores
+) {
+    const int top_k = std::min((int)topK, (int)env->GetArrayLength(jScores));
+    return hits_array(env, dai_llm_bm25_search(as_bm25(index), jstring_to_std(env, jQuery), top_k), jScores);
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                      RAG: embeddings
+// ═══════════════════════════════════════════════════════════════
+
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeEmbedLoad(
+    JNIEnv *env, jobject, jstring jPath, jint nThreads, jboolean useGpu,
+    jint batchTokens, jint batchTexts, jint pooling, jboolean normalize, jint contexts
+) {
+    dai_llm_embed_params params;
+    params.n_threads  = nThreads;
+    params.use_gpu    = useGpu;
+    params.n_batch    = batchTokens;
+    params.n_seq_max  = batchTexts;
+    params.pooling    = (dai_llm_pooling)pooling;
+    params.normalize  = normalize;
+    params.n_contexts = contexts;
+    return reinterpret_cast<jlong>(dai_llm_embedder_load(jstring_to_std(env, jPath), params));
 }
 
 JNIEXPORT void JNICALL
-Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCancel(JNIEnv *, jobject) {
-    g_cancel = true;
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeEmbedFree(JNIEnv *, jobject, jlong embedder) {
+    dai_llm_embedder_free(as_embedder(embedder));
+}
+
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeEmbedDim(JNIEnv *, jobject, jlong embedder) {
+    return dai_llm_embedder_dim(as_embedder(embedder));
+}
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeEmbed(
+    JNIEnv *env, jobject, jlong embedder, jobjectArray jTexts, jobject jOut
+) {
+    auto *e = as_embedder(embedder);
+    const int count = env->GetArrayLength(jTexts);
+
+    // The vectors are written in place: no float[] per text, no copy back.
+    auto *out = static_cast<float *>(env->GetDirectBufferAddress(jOut));
+    if (!out || env->GetDirectBufferCapacity(jOut) < (jlong)count * dai_llm_embedder_dim(e)) {
+        LOGE("nativeEmbed: output must be a direct FloatBuffer of at least %d floats",
+             count * dai_llm_embedder_dim(e));
+        return false;
+    }
+
+    std::vector<std::string> texts(count);
+    for (int i = 0; i < count; i++) {
+        auto jText = (jstring)env->GetObjectArrayElement(jTexts, i);
+        texts[i] = jstring_to_std(env, jText);
+        env->DeleteLocalRef(jText);
+    }
+    return dai_llm_embed(e, texts, out);
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                      RAG: HNSW index
+// ═══════════════════════════════════════════════════════════════
+
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswCreate(
+    JNIEnv *, jobject, jint dim, jint m, jint efConstruction, jint efSearch, jboolean quantize, jint nThreads
+) {
+    dai_llm_hnsw_params params;
+    params.dim             = dim;
+    params.m               = m;
+    params.ef_construction = efConstruction;
+    params.ef_search       = efSearch;
+    params.quantize        = quantize;
+    params.n_threads       = nThreads;
+    return reinterpret_cast<jlong>(dai_llm_hnsw_create(params));
+}
+
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswLoad(JNIEnv *env, jobject, jstring jPath) {
+    return reinterpret_cast<jlong>(dai_llm_hnsw_load(jstring_to_std(env, jPath)));
+}
+
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswFree(JNIEnv *, jobject, jlong index) {
+    dai_llm_hnsw_free(as_hnsw(index));
+}
+
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswDim(JNIEnv *, jobject, jlong index) {
+    return dai_llm_hnsw_dim(as_hnsw(index));
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswAdd(
+    JNIEnv *env, jobject, jlong index, jfloatArray jVectors, jobjectArray jTexts, jobjectArray jSources
+) {
+    const int count = env->GetArrayLength(jTexts);
+    const int n_sources = jSources ? env->GetArrayLength(jSources) : 0;
+
+    std::vector<dai_llm_hnsw_doc> docs(count);
+    for (int i = 0; i < count; i++) {
+        auto jText = (jstring)env->GetObjectArrayElement(jTexts, i);
+        docs[i].text = jstring_to_std(env, jText);
+        env->DeleteLocalRef(jText);
+
+        auto jSource = i < n_sources ? (jstring)env->GetObjectArrayElement(jSources, i) : nullptr;
+        if (jSource) {
+            docs[i].source     = jstring_to_std(env, jSource);
+            docs[i].has_source = true;
+            env->DeleteLocalRef(jSource);
+        }
+    }
+
+    std::vector<int64_t> ids;
+    if ((jlong)env->GetArrayLength(jVectors) >= (jlong)count * dai_llm_hnsw_dim(as_hnsw(index))) {
+        jfloat *vectors = env->GetFloatArrayElements(jVectors, nullptr);
+        ids = dai_llm_hnsw_add(as_hnsw(index), vectors, docs);
+        env->ReleaseFloatArrayElements(jVectors, vectors, JNI_ABORT);
+    }
+
+    jlongArray out = env->NewLongArray((jsize)ids.size());
+    if (out) {
+        static_assert(sizeof(jlong) == sizeof(int64_t), "jlong must be 64-bit");
+        env->SetLongArrayRegion(out, 0, (jsize)ids.size(), reinterpret_cast<const jlong *>(ids.data()));
+    }
+    return out;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswRemove(JNIEnv *, jobject, jlong index, jlong id) {
+    return dai_llm_hnsw_remove(as_hnsw(index), id);
+}
+
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswSize(JNIEnv *, jobject, jlong index) {
+    return (jint)dai_llm_hnsw_size(as_hnsw(index));
+}
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswSave(JNIEnv *env, jobject, jlong index, jstring jPath) {
+    return dai_llm_hnsw_save(as_hnsw(index), jstring_to_std(env, jPath));
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswSearch(
+    JNIEnv *env, jobject, jlong index, jfloatArray jQuery, jint topK, jint ef, jfloatArray jScores
+) {
+    if (env->GetArrayLength(jQuery) < dai_llm_hnsw_dim(as_hnsw(index))) return nullptr;
+    const int top_k = std::min((int)topK, (int)env->GetArrayLength(jScores));
+
+    std::vector<float> query(env->GetArrayLength(jQuery));
+    env->GetFloatArrayRegion(jQuery, 0, (jsize)query.size(), query.data());
+    return hits_array(env, dai_llm_hnsw_search(as_hnsw(index), query.data(), top_k, ef), jScores);
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                      RAG: INGESTION
+// ═══════════════════════════════════════════════════════════════
+
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeIngest(
+    JNIEnv *env, jobject,
+    jobjectArray jPaths, jlong bm25, jlong embedder, jlong hnsw, jstring jTokenizerPath,
+    jint chunkTokens, jint overlapTokens, jint nThreads, jlong maxBufferedBytes,
+    jobjectArray jExtensions, jstring jBm25Path, jstring jHnswPath, jobject jProgress
+) {
+    dai_llm_ingest_params params;
+    params.chunk_tokens       = chunkTokens;
+    params.overlap_tokens     = overlapTokens;
+    params.n_threads          = nThreads;
+    params.max_buffered_bytes = (size_t)std::max<jlong>(0, maxBufferedBytes);
+    params.tokenizer_path     = jstring_to_std(env, jTokenizerPath);
+    params.extensions         = string_array(env, jExtensions);
+    params.bm25_path          = jstring_to_std(env, jBm25Path);
+    params.hnsw_path          = jstring_to_std(env, jHnswPath);
+
+    // Progress runs on this thread (the reader), so env stays valid. If Kotlin
+    // throws, the ingest stops and the exception surfaces on return.
+    dai_llm_ingest_progress_cb on_progress;
+    if (jProgress) {
+        jclass cls = env->GetObjectClass(jProgress);
+        jmethodID onProgress = env->GetMethodID(cls, "onProgress", "(JJ)Z");
+        env->DeleteLocalRef(cls);
+        if (onProgress) {
+            on_progress = [env, jProgress, onProgress](uint64_t done, uint64_t total) {
+                if (env->ExceptionCheck()) return false;
+                const jboolean more = env->CallBooleanMethod(jProgress, onProgress, (jlong)done, (jlong)total);
+                return more == JNI_TRUE && !env->ExceptionCheck();
+            };
+        } else {
+            LOGE("Failed to find RagIngestProgressInternal.onProgress");
+            env->ExceptionClear();
+        }
+    }
+
+    dai_llm_ingest_stats stats;
+    if (!dai_llm_ingest(string_array(env, jPaths), as_bm25(bm25), as_embedder(embedder), as_hnsw(hnsw),
+                        params, stats, on_progress) || env->ExceptionCheck()) {
+        return nullptr;
+    }
+
+    const jlong values[] = {
+        (jlong)stats.files, (jlong)stats.failed_files, (jlong)stats.bytes,
+        (jlong)stats.chunks, (jlong)stats.tokens, stats.cancelled ? 1 : 0,
+    };
+    jlongArray out = env->NewLongArray(6);
+    if (out) env->SetLongArrayRegion(out, 0, 6, values);
+    return out;
 }
 
 } // extern "C"
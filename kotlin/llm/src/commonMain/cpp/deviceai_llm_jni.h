@@ -11,51 +11,531 @@ extern "C" {
 //                        LIFECYCLE
 // ═══════════════════════════════════════════════════════════════
 
-JNIEXPORT jboolean JNICALL
+/**
+ * Returns a model handle (0 on failure). Loading the same file twice shares weights.
+ * parallelSequences > 1 decodes all sessions on the model in one batched context.
+ * draftModelPath (nullable) enables speculative decoding with a smaller model.
+ * contextSize / batchSize / microBatchSize of 0 keep llama.cpp's defaults.
+ * kvTypeK / kvTypeV are dai_llm_kv_type codes; flashAttention is -1 auto, 0 off, 1 on.
+ * batchThreads of 0 uses maxThreads for prefill; cpuMask / batchCpuMask of 0 leave threads unpinned.
+ * maxCandidates caps nativeGenerateN on own-context sessions; scoreSequences is how many
+ * continuations nativeScoreContinuations decodes side by side (1 = one at a time).
+ * jobWorkers (0 = parallelSequences) and jobQueue size the model's executor for nativeSubmitGenerate.
+ */
+JNIEXPORT jlong JNICALL
 Java_dev_deviceai_llm_engine_LlmJniEngine_nativeInit(
     JNIEnv *env, jobject obj,
     jstring modelPath,
     jint maxThreads,
-    jboolean useGpu
+    jboolean useGpu,
+    jint parallelSequences,
+    jstring draftModelPath,
+    jlong prefixCacheBytes,
+    jint contextSize,
+    jint batchSize,
+    jint microBatchSize,
+    jint kvTypeK,
+    jint kvTypeV,
+    jint flashAttention,
+    jboolean useMmap,
+    jboolean useMlock,
+    jint batchThreads,
+    jlong cpuMask,
+    jlong batchCpuMask,
+    jboolean strictCpu,
+    jint maxCandidates,
+    jint scoreSequences,
+    jint jobWorkers,
+    jint jobQueue
+);
+
+/**
+ * Estimate memory for nativeInit with the same arguments plus the number of
+ * sessions, from GGUF metadata only. Returns [nCtx, weightsBytes, kvBytes,
+ * computeBytes, totalBytes], or null if the metadata cannot be read.
+ */
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeEstimateMemory(
+    JNIEnv *env, jobject obj,
+    jstring modelPath,
+    jint maxThreads,
+    jboolean useGpu,
+    jint parallelSequences,
+    jstring draftModelPath,
+    jint contextSize,
+    jint batchSize,
+    jint microBatchSize,
+    jint kvTypeK,
+    jint kvTypeV,
+    jint flashAttention,
+    jboolean useMmap,
+    jint maxCandidates,
+    jint scoreSequences,
+    jint sessions
 );
 
 JNIEXPORT void JNICALL
 Java_dev_deviceai_llm_engine_LlmJniEngine_nativeShutdown(
-    JNIEnv *env, jobject obj
+    JNIEnv *env, jobject obj,
+    jlong model
+);
+
+// ═══════════════════════════════════════════════════════════════
+//                        SESSIONS
+// ═══════════════════════════════════════════════════════════════
+
+/** Returns a session handle (0 on failure) with its own context and KV cache. */
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCreateSession(
+    JNIEnv *env, jobject obj,
+    jlong model
+);
+
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCloseSession(
+    JNIEnv *env, jobject obj,
+    jlong session
+);
+
+/**
+ * Restore the KV state of a conversation prefix (typically the system prompt)
+ * from cacheDir, or decode it and write a snapshot there. Returns a
+ * dai_llm_snapshot_status (0 failed, 1 restored, 2 rebuilt).
+ */
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeWarmPrefix(
+    JNIEnv *env, jobject obj,
+    jlong session,
+    jobjectArray roles,
+    jobjectArray contents,
+    jstring cacheDir
 );
 
 // ═══════════════════════════════════════════════════════════════
 //                        GENERATION
+// params: nullable LlmGenParamsInternal with the request's settings, read by
+//         field name:
+//   seed: sampling seed (-1 = random).
+//   prefillChunk: prompt tokens per decode call (0 = n_batch).
+//   draftTokens: speculative proposals per step (0 = off; needs a draft model
+//                or promptLookup).
+//   promptLookup: propose tokens by matching the latest n-gram against the
+//                 prompt and output instead of running a draft model.
+//   contextShift: evict old messages and shift the KV cache when the context
+//                 fills; keepTokens pins that many tokens (< 0 = system messages).
+//   stop: stop strings; generation ends before the first one in the output,
+//         which is neither streamed nor returned.
+//   repeatStopTokens: end once that many trailing tokens are a short cycle
+//                     repeated (0 = off).
+//   grammar: nullable GBNF the output must match (root rule "root"); nothing
+//            is generated when it does not parse.
+//   contextChunks: nullable RAG chunks, best first, packed into contextTokens
+//                  tokens and spliced in as tokens where contextMarker appears.
+// progress: nullable LlmProgressInternal, called between prefill chunks.
+// metrics: nullable DoubleArray(13) receiving the request's metrics as
+//          [promptTokens, cachedTokens, generatedTokens, ttftMs, prefillMs,
+//           decodeMs, sampleMs, prefillTps, decodeTps, kvPeak, nCtx,
+//           cancelMs (-1 = not cancelled), stopReason (dai_llm_stop_reason)].
 // ═══════════════════════════════════════════════════════════════
 
 JNIEXPORT jstring JNICALL
 Java_dev_deviceai_llm_engine_LlmJniEngine_nativeGenerate(
     JNIEnv *env, jobject obj,
+    jlong session,
     jobjectArray roles,
     jobjectArray contents,
-    jint maxTokens,
-    jfloat temperature,
-    jfloat topP,
-    jint topK,
-    jfloat repeatPenalty
+    jobject params,
+    jobject progress,
+    jdoubleArray metrics
 );
 
 JNIEXPORT void JNICALL
 Java_dev_deviceai_llm_engine_LlmJniEngine_nativeGenerateStream(
     JNIEnv *env, jobject obj,
+    jlong session,
+    jobjectArray roles,
+    jobjectArray contents,
+    jobject params,
+    jobject progress,
+    jobject buffer,
+    jint batchTokens,
+    jint batchMillis,
+    jobject callback,
+    jdoubleArray metrics
+);
+
+/**
+ * Up to count completions of one prompt as UTF-8 byte[]s, prefilled once and
+ * decoded side by side (deviceai_llm_nbest.h). Candidate i samples with
+ * params.seed + i; contextShift is ignored. Other parameters as for nativeGenerate; metrics
+ * cover all candidates.
+ */
+JNIEXPORT jobjectArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeGenerateN(
+    JNIEnv *env, jobject obj,
+    jlong session,
+    jobjectArray roles,
+    jobjectArray contents,
+    jint count,
+    jobject params,
+    jobject progress,
+    jdoubleArray metrics
+);
+
+/**
+ * nativeGenerateN streamed through the ring buffer: each batch is announced
+ * with LlmCandidateStreamInternal.onText(index, offset, length), candidates
+ * interleaved.
+ */
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeGenerateNStream(
+    JNIEnv *env, jobject obj,
+    jlong session,
+    jobjectArray roles,
+    jobjectArray contents,
+    jint count,
+    jobject params,
+    jobject progress,
+    jobject buffer,
+    jint batchTokens,
+    jint batchMillis,
+    jobject callback,
+    jdoubleArray metrics
+);
+
+/**
+ * Log-probability of each continuation after the chat prompt
+ * (deviceai_llm_score.h). Returns every continuation's per-token
+ * log-probabilities back to back; tokenCounts (continuations.length long)
+ * receives how many belong to each. null when the session cannot score.
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeScoreContinuations(
+    JNIEnv *env, jobject obj,
+    jlong session,
     jobjectArray roles,
     jobjectArray contents,
+    jobjectArray continuations,
+    jintArray tokenCounts
+);
+
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCancel(
+    JNIEnv *env, jobject obj,
+    jlong session
+);
+
+/** Speculative-decoding counters as [drafted, accepted, rounds]. */
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeSpeculativeStats(
+    JNIEnv *env, jobject obj,
+    jlong session
+);
+
+/** Token count of each text, as plain text without BOS/EOS. */
+JNIEXPORT jintArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCountTokens(
+    JNIEnv *env, jobject obj,
+    jlong model,
+    jobjectArray texts
+);
+
+/**
+ * Pack chunks, best first, into at most maxTokens tokens. Returns the token
+ * ids; chunkTokens (chunks.length long) receives the tokens packed per chunk.
+ */
+JNIEXPORT jintArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativePackContext(
+    JNIEnv *env, jobject obj,
+    jlong model,
+    jobjectArray chunks,
     jint maxTokens,
-    jfloat temperature,
-    jfloat topP,
+    jintArray chunkTokens
+);
+
+/**
+ * Prefix cache counters as [lookups, hits, tokensReused, insertions,
+ * evictions, entries, bytesUsed, budgetBytes].
+ */
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativePrefixCacheStats(
+    JNIEnv *env, jobject obj,
+    jlong model
+);
+
+/**
+ * Aggregated request metrics as [requests, promptTokens, cachedTokens,
+ * generatedTokens] followed by the ttftMs, prefillTps, decodeTps and cancelMs
+ * histograms (DAI_LLM_METRICS_BUCKETS each). reset clears them afterwards.
+ */
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeMetricsHistogram(
+    JNIEnv *env, jobject obj,
+    jlong model,
+    jboolean reset
+);
+
+// ═══════════════════════════════════════════════════════════════
+//                        JOBS
+// ═══════════════════════════════════════════════════════════════
+
+/**
+ * nativeGenerate as an asynchronous job on the model's executor; returns at
+ * once with the job id, 0 when the queue is full, -1 on failure. Higher
+ * priorities run first. The job reports no progress.
+ */
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeSubmitGenerate(
+    JNIEnv *env, jobject obj,
+    jlong session,
+    jobjectArray roles,
+    jobjectArray contents,
+    jobject params,
+    jint priority
+);
+
+/** dai_llm_job_state of a job. */
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativePollJob(
+    JNIEnv *env, jobject obj,
+    jlong job
+);
+
+/** Cancel a job; discard drops its result and completion. False if unknown. */
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCancelJob(
+    JNIEnv *env, jobject obj,
+    jlong job,
+    jboolean discard
+);
+
+/**
+ * The completion channel: ids of jobs finished since the last call, across
+ * all models, or null after timeoutMs without one.
+ */
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeAwaitJobs(
+    JNIEnv *env, jobject obj,
+    jint timeoutMs
+);
+
+/**
+ * UTF-8 text of a finished job, which is then forgotten; metrics receives its
+ * DoubleArray(13) like nativeGenerate's. Null if the job is not finished.
+ */
+JNIEXPORT jbyteArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeTakeJob(
+    JNIEnv *env, jobject obj,
+    jlong job,
+    jdoubleArray metrics
+);
+
+// ═══════════════════════════════════════════════════════════════
+//                          THREADS
+// ═══════════════════════════════════════════════════════════════
+
+/** Change the model's thread counts and CPU masks; every session applies them before its next decode. */
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeSetThreads(
+    JNIEnv *env, jobject obj,
+    jlong model,
+    jint threads,
+    jint batchThreads,
+    jlong cpuMask,
+    jlong batchCpuMask,
+    jboolean strictCpu
+);
+
+/** Current thread configuration as [threads, batchThreads, cpuMask, batchCpuMask, strictCpu]. */
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeGetThreads(
+    JNIEnv *env, jobject obj,
+    jlong model
+);
+
+/**
+ * Measure (or read from cachePath, nullable) and apply the fastest thread counts.
+ * Returns [threads, batchThreads, decodeTps, prefillTps, cached], or null on failure.
+ */
+JNIEXPORT jdoubleArray JNICALL
+Java_dev_deviceai_llm_engine_LlmJniEngine_nativeAutotuneThreads(
+    JNIEnv *env, jobject obj,
+    jlong model,
+    jstring cachePath
+);
+
+// ═══════════════════════════════════════════════════════════════
+//                      RAG: BM25 INDEX
+// Handles are dai_llm_bm25 pointers (0 on failure).
+// ═══════════════════════════════════════════════════════════════
+
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Create(JNIEnv *env, jobject obj, jfloat k1, jfloat b);
+
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Load(JNIEnv *env, jobject obj, jstring path);
+
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Free(JNIEnv *env, jobject obj, jlong index);
+
+/** sources may be null, as may its elements. Returns the documents' ids. */
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Add(
+    JNIEnv *env, jobject obj,
+    jlong index,
+    jobjectArray texts,
+    jobjectArray sources
+);
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Remove(JNIEnv *env, jobject obj, jlong index, jlong id);
+
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Size(JNIEnv *env, jobject obj, jlong index);
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Save(JNIEnv *env, jobject obj, jlong index, jstring path);
+
+/**
+ * Returns [text0, source0, text1, source1, ...] (sources may be null), best
+ * first. scores (at least topK long) receives their scores.
+ */
+JNIEXPORT jobjectArray JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeBm25Search(
+    JNIEnv *env, jobject obj,
+    jlong index,
+    jstring query,
     jint topK,
-    jfloat repeatPenalty,
-    jobject callback
+    jfloatArray scores
+);
+
+// ═══════════════════════════════════════════════════════════════
+//                      RAG: EMBEDDINGS
+// Handles are dai_llm_embedder pointers (0 on failure).
+// ═══════════════════════════════════════════════════════════════
+
+/** pooling: EmbeddingPooling ordinal (dai_llm_pooling). */
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeEmbedLoad(
+    JNIEnv *env, jobject obj,
+    jstring path,
+    jint nThreads,
+    jboolean useGpu,
+    jint batchTokens,
+    jint batchTexts,
+    jint pooling,
+    jboolean normalize,
+    jint contexts
 );
 
 JNIEXPORT void JNICALL
-Java_dev_deviceai_llm_engine_LlmJniEngine_nativeCancel(
-    JNIEnv *env, jobject obj
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeEmbedFree(JNIEnv *env, jobject obj, jlong embedder);
+
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeEmbedDim(JNIEnv *env, jobject obj, jlong embedder);
+
+/**
+ * Embed texts straight into out, a direct FloatBuffer in native byte order
+ * with room for texts.length * dim floats, row-major from its start.
+ */
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeEmbed(
+    JNIEnv *env, jobject obj,
+    jlong embedder,
+    jobjectArray texts,
+    jobject out
+);
+
+// ═══════════════════════════════════════════════════════════════
+//                      RAG: HNSW INDEX
+// Handles are dai_llm_hnsw pointers (0 on failure).
+// ═══════════════════════════════════════════════════════════════
+
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswCreate(
+    JNIEnv *env, jobject obj,
+    jint dim,
+    jint m,
+    jint efConstruction,
+    jint efSearch,
+    jboolean quantize,
+    jint nThreads
+);
+
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswLoad(JNIEnv *env, jobject obj, jstring path);
+
+JNIEXPORT void JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswFree(JNIEnv *env, jobject obj, jlong index);
+
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswDim(JNIEnv *env, jobject obj, jlong index);
+
+/**
+ * vectors: texts.length * dim floats, row-major. sources may be null, as may
+ * its elements. Returns the vectors' ids (empty if vectors is too short).
+ */
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswAdd(
+    JNIEnv *env, jobject obj,
+    jlong index,
+    jfloatArray vectors,
+    jobjectArray texts,
+    jobjectArray sources
+);
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswRemove(JNIEnv *env, jobject obj, jlong index, jlong id);
+
+JNIEXPORT jint JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswSize(JNIEnv *env, jobject obj, jlong index);
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswSave(JNIEnv *env, jobject obj, jlong index, jstring path);
+
+/**
+ * Returns [text0, source0, text1, source1, ...] (sources may be null), most
+ * similar first. scores (at least topK long) receives their cosine similarities.
+ */
+JNIEXPORT jobjectArray JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeHnswSearch(
+    JNIEnv *env, jobject obj,
+    jlong index,
+    jfloatArray query,
+    jint topK,
+    jint ef,
+    jfloatArray scores
+);
+
+// ═══════════════════════════════════════════════════════════════
+//                      RAG: INGESTION
+// ═══════════════════════════════════════════════════════════════
+
+/**
+ * Chunk and index files and directories into bm25 and/or hnsw (handles, 0 to
+ * skip). embedder is needed for hnsw; tokenizerPath (nullable) defaults to
+ * its model. bm25Path/hnswPath (nullable) are written after a complete run.
+ * progress: nullable RagIngestProgressInternal, called on this thread.
+ *
+ * Returns [files, failedFiles, bytes, chunks, tokens, cancelled (0/1)], or
+ * null if ingestion failed.
+ */
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_llm_engine_RagJniEngine_nativeIngest(
+    JNIEnv *env, jobject obj,
+    jobjectArray paths,
+    jlong bm25,
+    jlong embedder,
+    jlong hnsw,
+    jstring tokenizerPath,
+    jint chunkTokens,
+    jint overlapTokens,
+    jint nThreads,
+    jlong maxBufferedBytes,
+    jobjectArray extensions,
+    jstring bm25Path,
+    jstring hnswPath,
+    jobject progress
 );
 
 #ifdef __cplusplus
@@ -0,0 +1,293 @@
+/**
+ * deviceai_llm_jobs.cpp - Asynchronous generation jobs
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_jobs.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmJobs"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+namespace {
+
+struct job {
+    int64_t  id       = 0;
+    int      priority = 0;
+    uint64_t seq      = 0;   // submission order, for FIFO among equal priorities
+
+    dai_llm_jobs       *owner   = nullptr;
+    dai_llm_session    *session = nullptr;
+    std::string         prompt;
+    dai_llm_gen_params  params;
+
+    // Read by the token callback of the running generate, which may have
+    // started after dai_llm_job_cancel and cleared session->cancel.
+    std::atomic<bool> cancel{false};
+
+    // Guarded by g_mutex.
+    bool               discard = false;
+    dai_llm_job_result result;
+};
+
+using job_ptr = std::shared_ptr<job>;
+
+} // namespace
+
+struct dai_llm_jobs {
+    dai_llm_model *model      = nullptr;
+    int            max_queued = 16;
+
+    std::vector<std::thread> workers;
+
+    // Guarded by g_mutex.
+    std::condition_variable cv;        // a job was queued or finished, or stop
+    std::vector<job_ptr>    queue;
+    std::vector<job_ptr>    running;
+    bool                    stop = false;
+};
+
+// ═══════════════════════════════════════════════════════════════
+//                        Job registry
+// Every job of every model, by id, until its result is taken. One mutex
+// covers the registry, the completion channel and all queues: each is only
+// held for a few pointer moves.
+// ═══════════════════════════════════════════════════════════════
+
+static std::mutex                           g_mutex;
+static std::condition_variable              g_done_cv;
+static std::unordered_map<int64_t, job_ptr> g_jobs;
+static std::vector<int64_t>                 g_completed;   // finished since the last wait
+static int64_t                              g_next_id  = 1;
+static uint64_t                             g_next_seq = 0;
+
+// Publish a finished job on the completion channel, or forget it when its
+// caller asked for the result to be discarded. Caller holds g_mutex.
+static void finish(const job_ptr &j, dai_llm_job_state state) {
+    j->result.state = state;
+    if (j->discard) {
+        g_jobs.erase(j->id);
+        return;
+    }
+    g_completed.push_back(j->id);
+    g_done_cv.notify_all();
+}
+
+static void remove_job(std::vector<job_ptr> &jobs, const job_ptr &j) {
+    jobs.erase(std::remove(jobs.begin(), jobs.end(), j), jobs.end());
+}
+
+static bool session_busy(const dai_llm_jobs *jobs, const dai_llm_session *s) {
+    return std::any_of(jobs->running.begin(), jobs->running.end(),
+                       [s](const job_ptr &r) { return r->session == s; });
+}
+
+// Highest-priority, oldest queued job whose session is idle, taken off the
+// queue. Caller holds g_mutex.
+static job_ptr next_job(dai_llm_jobs *jobs) {
+    auto best = jobs->queue.end();
+    for (auto it = jobs->queue.begin(); it != jobs->queue.end(); ++it) {
+        if (session_busy(jobs, (*it)->session)) continue;
+        if (best == jobs->queue.end() || (*it)->priority > (*best)->priority ||
+            ((*it)->priority == (*best)->priority && (*it)->seq < (*best)->seq)) {
+            best = it;
+        }
+    }
+    if (best == jobs->queue.end()) return nullptr;
+    job_ptr j = *best;
+    jobs->queue.erase(best);
+    return j;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                           Workers
+// ═══════════════════════════════════════════════════════════════
+
+static void worker_loop(dai_llm_jobs *jobs) {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    for (;;) {
+        job_ptr j;
+        jobs->cv.wait(lock, [&] { return jobs->stop || (j = next_job(jobs)) != nullptr; });
+        if (!j) return;
+
+        j->result.state = DAI_LLM_JOB_RUNNING;
+        jobs->running.push_back(j);
+        lock.unlock();
+
+        dai_llm_gen_metrics metrics;
+        std::string text = dai_llm_generate(
+            j->session, j->prompt, j->params,
+            [&j](const std::string &) { return !j->cancel.load(); },
+            nullptr, &metrics
+        );
+
+        lock.lock();
+        remove_job(jobs->running, j);
+        j->result.text    = std::move(text);
+        j->result.metrics = metrics;
+        finish(j, j->cancel.load() ? DAI_LLM_JOB_CANCELLED
+                : metrics.failed   ? DAI_LLM_JOB_FAILED
+                :                    DAI_LLM_JOB_DONE);
+
+        // The session is free again: its next job may be runnable, and
+        // dai_llm_jobs_drop_session may be waiting for it.
+        jobs->cv.notify_all();
+    }
+}
+
+// The model's executor, started on first use.
+static dai_llm_jobs *model_jobs(dai_llm_model *model) {
+    std::call_once(model->jobs_once, [model] {
+        auto *jobs = new dai_llm_jobs();
+        jobs->model      = model;
+        jobs->max_queued = std::max(1, model->job_queue);
+
+        const int n_workers = model->job_workers > 0 ? model->job_workers : model->n_parallel;
+        for (int i = 0; i < n_workers; i++) jobs->workers.emplace_back(worker_loop, jobs);
+        model->jobs = jobs;
+
+        LOGI("LLM job executor started (workers=%d, queue=%d)", n_workers, jobs->max_queued);
+    });
+    return model->jobs.load();
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                            API
+// ═══════════════════════════════════════════════════════════════
+
+int64_t dai_llm_job_submit(dai_llm_session *session, std::string prompt, dai_llm_gen_params params,
+                           int priority) {
+    if (!session) return -1;
+    dai_llm_jobs *jobs = model_jobs(session->model);
+
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if (jobs->stop) return -1;
+    if ((int)jobs->queue.size() >= jobs->max_queued) return 0;
+
+    auto j = std::make_shared<job>();
+    j->id           = g_next_id++;
+    j->priority     = priority;
+    j->seq          = g_next_seq++;
+    j->owner        = jobs;
+    j->session      = session;
+    j->prompt       = std::move(prompt);
+    j->params       = std::move(params);
+    j->result.state = DAI_LLM_JOB_QUEUED;
+
+    g_jobs[j->id] = j;
+    jobs->queue.push_back(j);
+    jobs->cv.notify_all();   // shared with dai_llm_jobs_drop_session's wait
+    return j->id;
+}
+
+dai_llm_job_state dai_llm_job_poll(int64_t id) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_jobs.find(id);
+    return it == g_jobs.end() ? DAI_LLM_JOB_UNKNOWN : it->second->result.state;
+}
+
+bool dai_llm_job_cancel(int64_t id, bool discard) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_jobs.find(id);
+    if (it == g_jobs.end()) return false;
+    job_ptr j = it->second;
+
+    switch (j->result.state) {
+        case DAI_LLM_JOB_QUEUED:
+            j->discard = discard;
+            remove_job(j->owner->queue, j);
+            finish(j, DAI_LLM_JOB_CANCELLED);
+            break;
+        case DAI_LLM_JOB_RUNNING:
+            j->discard = discard;
+            j->cancel  = true;
+            dai_llm_cancel(j->session);
+            break;
+        default:
+            // Finished and waiting to be taken.
+            if (discard) {
+                g_jobs.erase(it);
+                g_completed.erase(std::remove(g_completed.begin(), g_completed.end(), id), g_completed.end());
+            }
+            break;
+    }
+    return true;
+}
+
+bool dai_llm_jobs_wait(std::vector<int64_t> &ids, int timeout_ms) {
+    ids.clear();
+    std::unique_lock<std::mutex> lock(g_mutex);
+    auto ready = [] { return !g_completed.empty(); };
+    if (timeout_ms < 0) g_done_cv.wait(lock, ready);
+    else if (!g_done_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready)) return false;
+    ids.swap(g_completed);
+    return true;
+}
+
+bool dai_llm_job_take(int64_t id, dai_llm_job_result &out) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_jobs.find(id);
+    if (it == g_jobs.end()) return false;
+
+    const dai_llm_job_state state = it->second->result.state;
+    if (state != DAI_LLM_JOB_DONE && state != DAI_LLM_JOB_CANCELLED && state != DAI_LLM_JOB_FAILED) return false;
+    out = std::move(it->second->result);
+    g_jobs.erase(it);
+    return true;
+}
+
+void dai_llm_jobs_drop_session(dai_llm_jobs *jobs, dai_llm_session *session) {
+    if (!jobs || !session) return;
+    std::unique_lock<std::mutex> lock(g_mutex);
+
+    for (const job_ptr &j : std::vector<job_ptr>(jobs->queue)) {
+        if (j->session != session) continue;
+        remove_job(jobs->queue, j);
+        finish(j, DAI_LLM_JOB_CANCELLED);
+    }
+    for (const job_ptr &j : jobs->running) {
+        if (j->session != session) continue;
+        j->cancel = true;
+        dai_llm_cancel(session);
+    }
+    jobs->cv.wait(lock, [&] { return !session_busy(jobs, session); });
+}
+
+void dai_llm_jobs_free(dai_llm_jobs *jobs) {
+    if (!jobs) return;
+    {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        jobs->stop = true;
+        for (const job_ptr &j : jobs->queue) finish(j, DAI_LLM_JOB_CANCELLED);
+        jobs->queue.clear();
+        // Running jobs would otherwise hold the join until max_tokens.
+        for (const job_ptr &j : jobs->running) {
+            j->cancel = true;
+            dai_llm_cancel(j->session);
+        }
+        jobs->cv.notify_all();
+    }
+    for (auto &t : jobs->workers) t.join();
+
+    // Results nobody took; waiters see their jobs as unknown.
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (auto it = g_jobs.begin(); it != g_jobs.end();) {
+        if (it->second->owner == jobs) it = g_jobs.erase(it);
+        else ++it;
+    }
+    delete jobs;
+}
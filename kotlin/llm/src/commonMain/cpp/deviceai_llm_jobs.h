@@ -0,0 +1,86 @@
+#ifndef DEVICEAI_LLM_JOBS_H
+#define DEVICEAI_LLM_JOBS_H
+
+/**
+ * deviceai_llm_jobs.h - Asynchronous generation jobs
+ *
+ * dai_llm_generate holds its caller for the whole request. Bridges whose
+ * callers should not block (coroutine dispatchers, UI run loops) submit a
+ * job instead and collect the result once it completes:
+ *
+ *   submit   queue a request on the session's model and return its id at
+ *            once; 0 when the model's queue is full (backpressure: retry
+ *            after a completion)
+ *   poll     state of a job
+ *   wait     the completion channel: ids of jobs finished since the last
+ *            wait, for every model; blocks until there is one or timeout
+ *   take     result of a finished job, which is then forgotten
+ *   cancel   drop a queued job or stop a running one
+ *
+ * Each model gets its own executor on first submit: job_workers threads
+ * serving a queue bounded by job_queue. Higher priorities run first, FIFO
+ * among equals. Jobs on the same session run one at a time, in submission
+ * order within a priority; jobs on different sessions run side by side, so
+ * on a batching model they share the scheduler's forward passes.
+ *
+ * Jobs run without token or progress callbacks. Job ids are unique for the
+ * process; a result nobody takes is kept until its model is freed.
+ */
+
+#include "deviceai_llm_engine.h"
+#include "deviceai_llm_metrics.h"
+
+struct dai_llm_jobs;
+
+enum dai_llm_job_state {
+    DAI_LLM_JOB_UNKNOWN   = 0,   // never submitted, already taken, or discarded
+    DAI_LLM_JOB_QUEUED    = 1,
+    DAI_LLM_JOB_RUNNING   = 2,
+    DAI_LLM_JOB_DONE      = 3,
+    DAI_LLM_JOB_CANCELLED = 4,   // text holds what was generated before the cancel
+    DAI_LLM_JOB_FAILED    = 5,   // the request could not run or a decode failed (metrics.failed)
+};
+
+struct dai_llm_job_result {
+    dai_llm_job_state   state = DAI_LLM_JOB_UNKNOWN;
+    std::string         text;
+    dai_llm_gen_metrics metrics;
+};
+
+/**
+ * Queue dai_llm_generate(session, prompt, params) on the session's model.
+ * Returns the job id (> 0), 0 when the queue is full, -1 without a session.
+ */
+int64_t dai_llm_job_submit(dai_llm_session *session, std::string prompt, dai_llm_gen_params params,
+                           int priority = 0);
+
+dai_llm_job_state dai_llm_job_poll(int64_t id);
+
+/**
+ * Cancel a job: a queued one never runs, a running one stops like
+ * dai_llm_cancel. Either way it completes as DAI_LLM_JOB_CANCELLED. With
+ * discard, its result is dropped instead and it is left off the completion
+ * channel, for callers that stopped waiting. False if the job is unknown.
+ */
+bool dai_llm_job_cancel(int64_t id, bool discard = false);
+
+/**
+ * Move the ids of jobs finished since the last call into ids (cleared first),
+ * waiting up to timeout_ms for the first one (< 0 waits indefinitely).
+ * Returns false on timeout.
+ */
+bool dai_llm_jobs_wait(std::vector<int64_t> &ids, int timeout_ms);
+
+/** Remove a finished (done, cancelled or failed) job and hand over its result. */
+bool dai_llm_job_take(int64_t id, dai_llm_job_result &out);
+
+/**
+ * Cancel every job on session and wait for the running one to return, so
+ * the session can be freed. Called by dai_llm_session_free.
+ */
+void dai_llm_jobs_drop_session(dai_llm_jobs *jobs, dai_llm_session *session);
+
+/** Stop the model's workers; queued and running jobs complete as cancelled. */
+void dai_llm_jobs_free(dai_llm_jobs *jobs);
+
+#endif // DEVICEAI_LLM_JOBS_H
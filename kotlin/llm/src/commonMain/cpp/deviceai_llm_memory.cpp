@@ -0,0 +1,110 @@
+/**
+ * deviceai_llm_memory.cpp - Memory footprint estimate before loading a model
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_memory.h"
+
+#include <algorithm>
+#include <fstream>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmMemory"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+// Bytes per block of 32 elements.
+static uint64_t kv_block_bytes(ggml_type type) {
+    switch (type) {
+        case GGML_TYPE_Q8_0: return 34;   // 32 × int8 + f16 scale
+        case GGML_TYPE_Q4_0: return 18;   // 32 × 4 bit + f16 scale
+        default:             return 64;   // 32 × f16
+    }
+}
+
+static uint64_t file_size(const std::string &path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    return in ? (uint64_t)in.tellg() : 0;
+}
+
+struct model_shape {
+    uint64_t n_layer, n_embd, n_head, n_head_kv, n_vocab;
+    int      n_ctx_train;
+};
+
+// Hyperparameters from the GGUF header, without reading any tensor data.
+static bool read_shape(const std::string &path, const dai_llm_model_params &params, model_shape &out) {
+    llama_model_params mparams = dai_llm_model_load_params(params);
+    mparams.vocab_only = true;
+
+    llama_model *model = llama_model_load_from_file(path.c_str(), mparams);
+    if (!model) return false;
+
+    out.n_layer     = (uint64_t)std::max(0, llama_model_n_layer(model));
+    out.n_embd      = (uint64_t)std::max(0, llama_model_n_embd(model));
+    out.n_head      = (uint64_t)std::max(1, llama_model_n_head(model));
+    out.n_head_kv   = (uint64_t)std::max(1, llama_model_n_head_kv(model));
+    out.n_vocab     = (uint64_t)std::max(0, llama_vocab_n_tokens(llama_model_get_vocab(model)));
+    out.n_ctx_train = llama_model_n_ctx_train(model);
+    llama_model_free(model);
+    return true;
+}
+
+static uint64_t kv_bytes(const model_shape &m, const llama_context_params &cparams, uint64_t n_ctx) {
+    const uint64_t n_embd_kv = m.n_embd / m.n_head * m.n_head_kv;   // per layer, per token
+    const uint64_t elems     = m.n_layer * n_ctx * n_embd_kv;
+    return elems * (kv_block_bytes(cparams.type_k) + kv_block_bytes(cparams.type_v)) / 32;
+}
+
+static uint64_t compute_bytes(const model_shape &m, const llama_context_params &cparams, uint64_t n_ctx) {
+    const uint64_t n_ubatch = std::min(cparams.n_ubatch, cparams.n_batch);
+    // Logits plus a handful of n_embd-wide activations, all f32.
+    uint64_t bytes = 4 * n_ubatch * (m.n_vocab + 8 * m.n_embd);
+    // Without flash attention the full KQ score matrix is materialised;
+    // "auto" may resolve either way, so count it.
+    if (cparams.flash_attn_type != LLAMA_FLASH_ATTN_TYPE_ENABLED) bytes += 4 * n_ubatch * n_ctx * m.n_head;
+    return bytes;
+}
+
+bool dai_llm_estimate_memory(
+    const std::string &path,
+    const dai_llm_model_params &params,
+    int n_sessions,
+    dai_llm_memory_estimate &out
+) {
+    model_shape target;
+    if (!read_shape(path, params, target)) {
+        LOGE("Cannot read model metadata from %s", path.c_str());
+        return false;
+    }
+
+    const llama_context_params cparams = dai_llm_context_params(params);
+    const uint64_t n_ctx = cparams.n_ctx > 0 ? cparams.n_ctx : (uint64_t)std::max(0, target.n_ctx_train);
+
+    // Direct sessions each own a context; a scheduler owns one for everyone.
+    const bool     batched    = params.n_parallel > 1;
+    const uint64_t n_contexts = batched ? 1 : (uint64_t)std::max(1, n_sessions);
+
+    out = {};
+    out.n_ctx         = (int)n_ctx;
+    out.weights_bytes = file_size(path);
+    out.kv_bytes      = n_contexts * kv_bytes(target, cparams, n_ctx);
+    out.compute_bytes = n_contexts * compute_bytes(target, cparams, n_ctx);
+
+    model_shape draft;
+    if (!batched && !params.draft_path.empty() && read_shape(params.draft_path, params, draft)) {
+        out.weights_bytes += file_size(params.draft_path);
+        out.kv_bytes      += n_contexts * kv_bytes(draft, cparams, n_ctx);
+        out.compute_bytes += n_contexts * compute_bytes(draft, cparams, n_ctx);
+    }
+
+    out.total_bytes = out.weights_bytes + out.kv_bytes + out.compute_bytes;
+    return true;
+}
@@ -0,0 +1,44 @@
+#ifndef DEVICEAI_LLM_MEMORY_H
+#define DEVICEAI_LLM_MEMORY_H
+
+/**
+ * deviceai_llm_memory.h - Memory footprint estimate before loading a model
+ *
+ * Reads only the GGUF metadata (llama.cpp vocab-only load, no tensor data)
+ * and sizes the parts that dominate resident memory for a given
+ * dai_llm_model_params:
+ *
+ *   weights  ≈ GGUF file size (mmap'd pages are reclaimable by the OS, but
+ *              count against the app on iOS and low-memory Android kills)
+ *   KV cache = n_layer · n_ctx · n_embd_head · n_head_kv · (bytes_k + bytes_v)
+ *   compute  ≈ logits + activations for one n_ubatch, plus the attention
+ *              score matrix (n_ubatch · n_ctx · n_head floats) when flash
+ *              attention is off
+ *
+ * Sliding-window and recurrent layers are sized as full attention, so the
+ * estimate errs high for those architectures.
+ */
+
+#include "deviceai_llm_engine.h"
+
+struct dai_llm_memory_estimate {
+    int      n_ctx         = 0;   // effective context length per context
+    uint64_t weights_bytes = 0;   // target + draft model files
+    uint64_t kv_bytes      = 0;   // all contexts
+    uint64_t compute_bytes = 0;   // all contexts
+    uint64_t total_bytes   = 0;
+};
+
+/**
+ * Estimate memory for loading `path` with `params` and creating n_sessions
+ * sessions (each direct session has its own context; with n_parallel > 1
+ * all sessions share one). Returns false if the metadata cannot be read.
+ */
+bool dai_llm_estimate_memory(
+    const std::string &path,
+    const dai_llm_model_params &params,
+    int n_sessions,
+    dai_llm_memory_estimate &out
+);
+
+#endif // DEVICEAI_LLM_MEMORY_H
@@ -0,0 +1,80 @@
+/**
+ * deviceai_llm_metrics.cpp - Per-request generation metrics and histograms
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_metrics.h"
+
+#include <cmath>
+
+struct dai_llm_metrics {
+    std::mutex                mutex;
+    dai_llm_metrics_histogram hist;
+};
+
+static double ms_between(dai_llm_metrics_recorder::clock::time_point a,
+                         dai_llm_metrics_recorder::clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+static double per_second(int n, double ms) {
+    return ms > 0 ? n * 1000.0 / ms : 0;
+}
+
+static int bucket(double value) {
+    if (!(value >= 1)) return 0;   // also NaN
+    const int b = 1 + (int)std::floor(std::log2(value));
+    return std::min(b, DAI_LLM_METRICS_BUCKETS - 1);
+}
+
+dai_llm_metrics *dai_llm_metrics_create() {
+    return new dai_llm_metrics();
+}
+
+void dai_llm_metrics_free(dai_llm_metrics *metrics) {
+    delete metrics;
+}
+
+dai_llm_gen_metrics dai_llm_metrics_finish(dai_llm_metrics_recorder &rec, dai_llm_metrics *metrics) {
+    const auto end = dai_llm_metrics_recorder::clock::now();
+    const bool started = rec.prefill_start != dai_llm_metrics_recorder::clock::time_point{};
+    rec.end_prefill();
+
+    dai_llm_gen_metrics &m = rec.m;
+    if (started) {
+        m.prefill_ms  = ms_between(rec.prefill_start, rec.prefill_end);
+        m.decode_ms   = ms_between(rec.prefill_end, end);
+        m.prefill_tps = per_second(m.prompt_tokens - m.cached_tokens, m.prefill_ms);
+        m.decode_tps  = per_second(m.generated_tokens, m.decode_ms);
+    }
+    if (rec.cancel_at_ns) {
+        const auto at = dai_llm_metrics_recorder::clock::time_point(
+            std::chrono::duration_cast<dai_llm_metrics_recorder::clock::duration>(
+                std::chrono::nanoseconds(rec.cancel_at_ns)));
+        m.cancel_ms = std::max(0.0, ms_between(at, end));
+    }
+    // Requests that never got to prefill (failed tokenization, cancelled in
+    // the queue) say nothing about performance.
+    if (!metrics || !started) return m;
+
+    std::lock_guard<std::mutex> lock(metrics->mutex);
+    auto &h = metrics->hist;
+    h.requests++;
+    h.prompt_tokens    += m.prompt_tokens;
+    h.cached_tokens    += m.cached_tokens;
+    h.generated_tokens += m.generated_tokens;
+    if (m.generated_tokens > 0) h.ttft_ms[bucket(m.ttft_ms)]++;
+    if (m.prompt_tokens > m.cached_tokens) h.prefill_tps[bucket(m.prefill_tps)]++;
+    if (m.generated_tokens > 0) h.decode_tps[bucket(m.decode_tps)]++;
+    if (m.cancel_ms >= 0) h.cancel_ms[bucket(m.cancel_ms)]++;
+    return m;
+}
+
+dai_llm_metrics_histogram dai_llm_metrics_snapshot(dai_llm_metrics *metrics, bool reset) {
+    if (!metrics) return {};
+    std::lock_guard<std::mutex> lock(metrics->mutex);
+    dai_llm_metrics_histogram out = metrics->hist;
+    if (reset) metrics->hist = {};
+    return out;
+}
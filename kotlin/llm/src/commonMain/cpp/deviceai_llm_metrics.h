@@ -0,0 +1,121 @@
+#ifndef DEVICEAI_LLM_METRICS_H
+#define DEVICEAI_LLM_METRICS_H
+
+/**
+ * deviceai_llm_metrics.h - Per-request generation metrics and histograms
+ *
+ * llama.cpp's own perf counters are per context: a scheduler context mixes
+ * every session's requests, and speculative verification passes count as
+ * prompt evaluation. The engine therefore times its own phases:
+ *
+ *   ttft      call start → first token sampled (queueing, tokenization and
+ *             prefill included)
+ *   prefill   decoding the prompt tokens not already in the KV cache
+ *   decode    end of prefill → last token, sampling included
+ *   sample    time inside the sampler chain
+ *   cancel    dai_llm_cancel → the call returning, for cancelled requests;
+ *             bounded by one graph compute on own-context sessions
+ *
+ * Every finished request is also added to its model's aggregate: token
+ * totals plus histograms of ttft, throughput and cancel latency in
+ * power-of-two buckets, cheap to keep and to poll for dashboards.
+ */
+
+#include "deviceai_llm_engine.h"
+
+#include <algorithm>
+#include <chrono>
+
+struct dai_llm_gen_metrics {
+    int    prompt_tokens    = 0;   // after context fitting
+    int    cached_tokens    = 0;   // prompt tokens reused from the KV cache, not prefilled
+    int    generated_tokens = 0;
+    double ttft_ms          = 0;
+    double prefill_ms       = 0;
+    double decode_ms        = 0;
+    double sample_ms        = 0;
+    double prefill_tps      = 0;   // prefilled tokens per second
+    double decode_tps       = 0;   // generated tokens per second
+    int    kv_peak          = 0;   // most KV cells the request's sequence held
+    int    n_ctx            = 0;   // cells available to the sequence
+    double cancel_ms        = -1;  // cancel → return; -1 when not cancelled
+    int    stop_reason      = 0;   // dai_llm_stop_reason: a stop string or repetition ended it
+    bool   failed           = false;   // the request could not run, or a decode failed part way
+};
+
+// Bucket i counts values below 2^i (bucket 0: below 1); the last bucket
+// counts everything larger.
+#define DAI_LLM_METRICS_BUCKETS 20
+
+struct dai_llm_metrics_histogram {
+    int64_t requests         = 0;
+    int64_t prompt_tokens    = 0;
+    int64_t cached_tokens    = 0;
+    int64_t generated_tokens = 0;
+    int64_t ttft_ms    [DAI_LLM_METRICS_BUCKETS] = {};
+    int64_t prefill_tps[DAI_LLM_METRICS_BUCKETS] = {};
+    int64_t decode_tps [DAI_LLM_METRICS_BUCKETS] = {};
+    int64_t cancel_ms  [DAI_LLM_METRICS_BUCKETS] = {};   // cancelled requests only
+};
+
+struct dai_llm_metrics;
+
+// Timestamps of one running request, filled in by the generation loops
+// (engine-internal).
+struct dai_llm_metrics_recorder {
+    using clock = std::chrono::steady_clock;
+
+    clock::time_point start = clock::now();
+    clock::time_point prefill_start;
+    clock::time_point prefill_end;
+    bool              prefilled    = false;
+    bool              first_token  = false;
+    int64_t           cancel_at_ns = 0;   // session's cancel_at_ns, copied before finishing
+    dai_llm_gen_metrics m;
+
+    void begin_prefill(size_t n_prompt, size_t n_cached) {
+        prefill_start   = clock::now();
+        m.prompt_tokens = (int)n_prompt;
+        m.cached_tokens = (int)n_cached;
+    }
+    void end_prefill() {
+        if (prefilled) return;
+        prefill_end = clock::now();
+        prefilled   = true;
+    }
+    // Call after each sampler run with the time it began.
+    void sampled(clock::time_point t0) {
+        const auto now = clock::now();
+        m.sample_ms += std::chrono::duration<double, std::milli>(now - t0).count();
+        if (!first_token) {
+            first_token = true;
+            end_prefill();
+            m.ttft_ms = std::chrono::duration<double, std::milli>(now - start).count();
+        }
+    }
+    // A sampled token handed to the caller.
+    void emitted() { m.generated_tokens++; }
+    void kv(size_t n_cells) { m.kv_peak = std::max(m.kv_peak, (int)n_cells); }
+};
+
+/** steady_clock now in nanoseconds, the unit of dai_llm_session::cancel_at_ns. */
+inline int64_t dai_llm_metrics_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        dai_llm_metrics_recorder::clock::now().time_since_epoch()).count();
+}
+
+/** Aggregate for one model; freed with it. */
+dai_llm_metrics *dai_llm_metrics_create();
+
+void dai_llm_metrics_free(dai_llm_metrics *metrics);
+
+/**
+ * Close the recorder's timings into its metrics, add them to the model's
+ * aggregate (may be null) and return them.
+ */
+dai_llm_gen_metrics dai_llm_metrics_finish(dai_llm_metrics_recorder &rec, dai_llm_metrics *metrics);
+
+/** Copy the aggregate; reset clears it after copying, for interval polling. */
+dai_llm_metrics_histogram dai_llm_metrics_snapshot(dai_llm_metrics *metrics, bool reset);
+
+#endif // DEVICEAI_LLM_METRICS_H
@@ -0,0 +1,35 @@
+/**
+ * deviceai_llm_mmap.cpp - Read-only file mapping for the on-disk RAG indexes
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_mmap.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const uint8_t *dai_llm_map_file(const std::string &path, size_t min_size, bool random_access, size_t &size) {
+    size = 0;
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < min_size || st.st_size == 0) {
+        close(fd);
+        return nullptr;
+    }
+    void *addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) return nullptr;
+
+    if (random_access) madvise(addr, (size_t)st.st_size, MADV_RANDOM);
+    size = (size_t)st.st_size;
+    return static_cast<const uint8_t *>(addr);
+}
+
+void dai_llm_unmap_file(const uint8_t *data, size_t size) {
+    if (data) munmap(const_cast<uint8_t *>(data), size);
+}
@@ -0,0 +1,25 @@
+#ifndef DEVICEAI_LLM_MMAP_H
+#define DEVICEAI_LLM_MMAP_H
+
+/**
+ * deviceai_llm_mmap.h - Read-only file mapping for the on-disk RAG indexes
+ *
+ * A mapped index is queried in place: pages are read on first touch and can
+ * be dropped again by the OS under memory pressure, so opening even a large
+ * index costs next to nothing.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Map path read-only. random_access disables read-ahead, for files probed
+ * at scattered offsets (graph indexes). Returns nullptr if the file cannot
+ * be opened or mapped, or is shorter than min_size.
+ */
+const uint8_t *dai_llm_map_file(const std::string &path, size_t min_size, bool random_access, size_t &size);
+
+void dai_llm_unmap_file(const uint8_t *data, size_t size);
+
+#endif // DEVICEAI_LLM_MMAP_H
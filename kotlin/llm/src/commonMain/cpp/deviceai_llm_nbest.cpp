@@ -0,0 +1,228 @@
+/**
+ * deviceai_llm_nbest.cpp - Parallel n-best completions of one prompt
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_nbest.h"
+#include "deviceai_llm_scheduler.h"
+#include "deviceai_llm_grammar.h"
+#include "deviceai_llm_metrics.h"
+#include "deviceai_llm_threads.h"
+#include "deviceai_llm_stop.h"
+
+#include <algorithm>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmNBest"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+// ═══════════════════════════════════════════════════════════════
+//                           State
+// ═══════════════════════════════════════════════════════════════
+
+namespace {
+
+// One candidate; decodes into sequence `index` of the session's context.
+struct candidate {
+    llama_sampler *sampler     = nullptr;
+    std::string    text;
+    int            n_generated = 0;
+    int            i_batch     = -1;     // batch index holding its logits (-1 = last output)
+    bool           running     = true;
+};
+
+} // namespace
+
+static void batch_add(llama_batch &batch, llama_token token, llama_pos pos, llama_seq_id seq) {
+    const int i = batch.n_tokens;
+    batch.token   [i]    = token;
+    batch.pos     [i]    = pos;
+    batch.n_seq_id[i]    = 1;
+    batch.seq_id  [i][0] = seq;
+    batch.logits  [i]    = true;
+    batch.n_tokens++;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                     Own-context decode loop
+// ═══════════════════════════════════════════════════════════════
+
+static std::vector<std::string> generate_n_locked(
+    dai_llm_session *s,
+    const std::string &prompt,
+    const dai_llm_gen_params &params,
+    int n,
+    const dai_llm_nbest_cb &on_token,
+    const dai_llm_progress_cb &on_progress,
+    dai_llm_metrics_recorder &rec
+) {
+    s->cancel       = false;
+    s->cancel_at_ns = 0;
+
+    const llama_vocab *vocab = llama_model_get_vocab(s->model->model);
+
+    if (s->scheduler) {
+        auto tokens = dai_llm_tokenize_prompt(vocab, prompt, params, dai_llm_scheduler_n_ctx_seq(s->scheduler));
+        if (tokens.empty()) {
+            LOGE("Tokenization failed");
+            rec.m.failed = true;
+            return {};
+        }
+        return dai_llm_scheduler_generate_n(s->scheduler, s, tokens, params, n, on_token, on_progress, &rec);
+    }
+    if (!s->ctx) {
+        rec.m.failed = true;
+        return {};
+    }
+
+    n = std::min(n, s->model->max_candidates);
+    if (n < 1) return {};
+
+    // Samplers first: a grammar that does not parse fails the call before prefill.
+    std::vector<candidate> cands(n);
+    auto free_samplers = [&cands] {
+        for (candidate &c : cands) {
+            if (c.sampler) llama_sampler_free(c.sampler);
+        }
+    };
+    for (int i = 0; i < n; i++) {
+        dai_llm_gen_params p = params;
+        if (params.seed != LLAMA_DEFAULT_SEED) p.seed = params.seed + (uint32_t)i;
+        cands[i].sampler = dai_llm_build_sampler(p, s->model);
+        if (!cands[i].sampler) {
+            free_samplers();
+            rec.m.failed = true;
+            return {};
+        }
+    }
+
+    dai_llm_threads_apply(s->model, s->threads, s->ctx, s->draft_ctx);
+    if (!dai_llm_prepare_prompt(s, prompt, params, on_progress, rec)) {
+        free_samplers();
+        rec.m.failed = !s->cancel;
+        return {};
+    }
+
+    // Fork: every other candidate's sequence shares sequence 0's prompt cells.
+    llama_memory_t mem      = llama_get_memory(s->ctx);
+    const size_t   n_prompt = s->kv_tokens.size();
+    for (int i = 1; i < n; i++) {
+        llama_memory_seq_rm(mem, i, -1, -1);
+        llama_memory_seq_cp(mem, 0, i, -1, -1);
+    }
+
+    // The prompt and every candidate's tokens share the context: cap the
+    // length so n_prompt + n * max_tokens cells fit.
+    const size_t n_ctx      = llama_n_ctx(s->ctx);
+    const size_t room       = n_ctx > n_prompt ? n_ctx - n_prompt : 0;
+    const int    max_tokens = std::min(params.max_tokens, (int)(room / n));
+
+    // The first tokens are all sampled from the prompt's last logits; after
+    // that, each step decodes one token per running candidate in one batch.
+    llama_batch batch   = llama_batch_init(n, 0, 1);
+    size_t      n_cells = n_prompt;
+    char piece_buf[256];
+
+    for (;;) {
+        batch.n_tokens = 0;
+        for (int i = 0; i < n; i++) {
+            candidate &c = cands[i];
+            if (!c.running) continue;
+            if (c.n_generated >= max_tokens || s->cancel.load()) { c.running = false; continue; }
+
+            const auto t_sample = dai_llm_metrics_recorder::clock::now();
+            llama_token token = dai_llm_sample(c.sampler, s->ctx, c.i_batch);
+            if (token == LLAMA_TOKEN_NULL) { c.running = false; continue; }   // grammar dead end
+            llama_sampler_accept(c.sampler, token);
+            rec.sampled(t_sample);
+
+            int len = llama_vocab_is_eog(vocab, token)
+                ? -1 : llama_token_to_piece(vocab, token, piece_buf, sizeof(piece_buf), 0, true);
+            if (len < 0) { c.running = false; continue; }
+
+            std::string piece(piece_buf, len);
+            c.text += piece;
+            c.n_generated++;
+            rec.emitted();
+
+            if (!on_token(i, piece) || c.n_generated >= max_tokens) { c.running = false; continue; }
+
+            c.i_batch = batch.n_tokens;
+            batch_add(batch, token, (llama_pos)(n_prompt + c.n_generated - 1), i);
+        }
+        if (batch.n_tokens == 0) break;
+
+        const int rc = llama_decode(s->ctx, batch);
+        if (rc == DAI_LLM_DECODE_ABORTED) break;   // cleanup below drops the batch's cells
+        if (rc) {   // cleanup below drops the candidates' cells, keeping the prompt
+            LOGE("llama_decode failed for %d candidates at %zu cells", batch.n_tokens, n_cells);
+            rec.m.failed = true;
+            break;
+        }
+        n_cells += batch.n_tokens;
+        rec.kv(n_cells);
+    }
+    llama_batch_free(batch);
+
+    std::vector<std::string> results(n);
+    for (int i = 0; i < n; i++) results[i] = std::move(cands[i].text);
+    free_samplers();
+
+    // Keep only the prompt (sequence 0), so the next turn reuses it whichever
+    // candidate the caller picks.
+    if (!s->kv_tokens.empty()) {
+        for (int i = 1; i < n; i++) llama_memory_seq_rm(mem, i, -1, -1);
+        llama_memory_seq_rm(mem, 0, (llama_pos)n_prompt, -1);
+    }
+    dai_llm_store_prefix(s, rec.m.cached_tokens);
+    return results;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Public API
+// ═══════════════════════════════════════════════════════════════
+
+std::vector<std::string> dai_llm_generate_n(
+    dai_llm_session *s,
+    const std::string &prompt,
+    const dai_llm_gen_params &params,
+    int n,
+    const dai_llm_nbest_cb &on_token,
+    const dai_llm_progress_cb &on_progress,
+    dai_llm_gen_metrics *metrics
+) {
+    if (!s || n < 1) return {};
+    dai_llm_metrics_recorder rec;   // started before the lock: waiting counts toward ttft
+
+    // One stop filter per candidate: a candidate that stops leaves the others running.
+    std::vector<dai_llm_stop_filter> stops(n);
+    dai_llm_nbest_cb cb = on_token;
+    bool filtered = false;
+    for (int i = 0; i < n; i++) {
+        filtered = dai_llm_stop_init(stops[i], params, [&on_token, i](const std::string &piece) {
+            return on_token(i, piece);
+        });
+    }
+    if (filtered) {
+        cb = [&stops](int i, const std::string &piece) { return dai_llm_stop_feed(stops[i], piece); };
+    }
+
+    std::vector<std::string> results;
+    {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        results = generate_n_locked(s, prompt, params, n, cb, on_progress, rec);
+        for (size_t i = 0; i < results.size(); i++) dai_llm_stop_finish(stops[i], results[i]);
+    }
+    rec.cancel_at_ns = s->cancel_at_ns.load();
+    dai_llm_gen_metrics m = dai_llm_metrics_finish(rec, s->model->metrics);
+    if (metrics) *metrics = m;
+    return results;
+}
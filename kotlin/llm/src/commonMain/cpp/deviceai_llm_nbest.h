@@ -0,0 +1,48 @@
+#ifndef DEVICEAI_LLM_NBEST_H
+#define DEVICEAI_LLM_NBEST_H
+
+/**
+ * deviceai_llm_nbest.h - Parallel n-best completions of one prompt
+ *
+ * Suggested replies need several candidates for the same prompt. Generating
+ * them one after another prefills the prompt each time and decodes one token
+ * per forward pass. Here the prompt is prefilled once into sequence 0, the
+ * other candidates' sequences are forked from it (llama_memory_seq_cp on a
+ * unified KV cache shares the cells, no tensor data is copied), and every
+ * step decodes one token of each running candidate in a single batch. Each
+ * candidate has its own sampler; with a fixed params.seed candidate i uses
+ * seed + i, so results are reproducible but not identical.
+ *
+ * Sessions with their own context decode up to the model's max_candidates
+ * sequences. On a scheduler model the candidates run as requests on
+ * separate slots: the first one prefills, the rest start once its prompt is
+ * in the KV cache and take its cells through the scheduler's cross-slot
+ * prefix sharing, so they too only decode their own tokens.
+ */
+
+#include "deviceai_llm_engine.h"
+
+// Called for each generated piece of candidate `index` (0-based); return
+// false to stop that candidate. The others keep going.
+using dai_llm_nbest_cb = std::function<bool(int index, const std::string &piece)>;
+
+/**
+ * Generate up to n completions of prompt side by side. n is clamped to the
+ * sequences available (max_candidates, or the scheduler's slots), so the
+ * result may hold fewer strings; it is empty on failure.
+ *
+ * Pieces of different candidates arrive interleaved, always on the calling
+ * thread. session->cancel stops all candidates. metrics, when not null,
+ * covers the whole call; generated_tokens counts every candidate's tokens.
+ */
+std::vector<std::string> dai_llm_generate_n(
+    dai_llm_session *session,
+    const std::string &prompt,
+    const dai_llm_gen_params &params,
+    int n,
+    const dai_llm_nbest_cb &on_token,
+    const dai_llm_progress_cb &on_progress = nullptr,
+    dai_llm_gen_metrics *metrics = nullptr
+);
+
+#endif // DEVICEAI_LLM_NBEST_H
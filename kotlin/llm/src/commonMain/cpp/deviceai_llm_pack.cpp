@@ -0,0 +1,65 @@
+/**
+ * deviceai_llm_pack.cpp - Token counting and token-budgeted RAG context
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_pack.h"
+
+#include <algorithm>
+
+// Chunks are document text: "<|im_start|>" inside one is literal text, not
+// a control token.
+static std::vector<llama_token> tokenize_text(const llama_vocab *vocab, const std::string &text) {
+    std::vector<llama_token> tokens(text.size() + 1);
+    int n = llama_tokenize(vocab, text.data(), (int32_t)text.size(), tokens.data(), (int32_t)tokens.size(), false, false);
+    if (n < 0) {
+        tokens.resize((size_t)-n);
+        n = llama_tokenize(vocab, text.data(), (int32_t)text.size(), tokens.data(), (int32_t)tokens.size(), false, false);
+    }
+    tokens.resize((size_t)std::max(0, n));
+    return tokens;
+}
+
+std::vector<int> dai_llm_count_tokens(const llama_vocab *vocab, const std::vector<std::string> &texts) {
+    std::vector<int> counts(texts.size(), 0);
+    if (!vocab) return counts;
+    for (size_t i = 0; i < texts.size(); i++) {
+        // With no room for output, llama_tokenize returns minus the count.
+        const int n = llama_tokenize(vocab, texts[i].data(), (int32_t)texts[i].size(), nullptr, 0, false, false);
+        counts[i] = n < 0 ? -n : n;
+    }
+    return counts;
+}
+
+dai_llm_packed_context dai_llm_pack_context(
+    const llama_vocab *vocab,
+    const std::vector<std::string> &chunks,
+    int max_tokens,
+    const std::string &separator,
+    int min_cut_tokens
+) {
+    dai_llm_packed_context packed;
+    packed.chunk_tokens.assign(chunks.size(), 0);
+    if (!vocab || max_tokens <= 0) return packed;
+
+    const std::vector<llama_token> sep = tokenize_text(vocab, separator);
+    const size_t budget = (size_t)max_tokens;
+    const size_t min_cut = (size_t)std::max(1, min_cut_tokens);
+
+    for (size_t i = 0; i < chunks.size() && packed.tokens.size() < budget; i++) {
+        std::vector<llama_token> tokens = tokenize_text(vocab, chunks[i]);
+        if (tokens.empty()) continue;
+
+        const size_t gap  = packed.tokens.empty() ? 0 : sep.size();
+        const size_t room = budget - packed.tokens.size();
+        if (gap + tokens.size() > room) {
+            if (room < gap + min_cut) continue;
+            tokens.resize(room - gap);
+        }
+        packed.tokens.insert(packed.tokens.end(), sep.begin(), sep.begin() + (long)gap);
+        packed.tokens.insert(packed.tokens.end(), tokens.begin(), tokens.end());
+        packed.chunk_tokens[i] = (int)tokens.size();
+    }
+    return packed;
+}
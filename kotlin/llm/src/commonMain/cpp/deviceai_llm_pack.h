@@ -0,0 +1,50 @@
+#ifndef DEVICEAI_LLM_PACK_H
+#define DEVICEAI_LLM_PACK_H
+
+/**
+ * deviceai_llm_pack.h - Token counting and token-budgeted RAG context
+ *
+ * Joining the top-k retrieved chunks as text ignores their size in tokens:
+ * long chunks overflow the context window, short ones waste it.
+ * dai_llm_pack_context fills a token budget instead. Chunks are taken in
+ * priority order while they fit. The first one that does not fit is cut at
+ * a token boundary if enough budget is left, and skipped otherwise; later
+ * chunks can still fill what remains.
+ *
+ * The result is token ids, not text. dai_llm_generate splices them into
+ * the prompt through dai_llm_gen_params::splice_tokens, so the context is
+ * tokenized once and decoded exactly as it was counted.
+ */
+
+#include "deviceai_llm_engine.h"
+
+// Matches the separator RagAugmentor joins chunks with.
+#define DAI_LLM_PACK_SEPARATOR "\n\n---\n\n"
+
+struct dai_llm_packed_context {
+    std::vector<llama_token> tokens;
+
+    // Per input chunk, the tokens packed: 0 = skipped, fewer than the
+    // chunk's own count = cut to fit.
+    std::vector<int> chunk_tokens;
+};
+
+/**
+ * Token count of each text as plain text (no BOS/EOS, special-token
+ * syntax not parsed), without running the model.
+ */
+std::vector<int> dai_llm_count_tokens(const llama_vocab *vocab, const std::vector<std::string> &texts);
+
+/**
+ * Pack chunks, best first, into at most max_tokens tokens, separated by
+ * separator. A chunk is cut only if at least min_cut_tokens of it fit.
+ */
+dai_llm_packed_context dai_llm_pack_context(
+    const llama_vocab *vocab,
+    const std::vector<std::string> &chunks,
+    int max_tokens,
+    const std::string &separator = DAI_LLM_PACK_SEPARATOR,
+    int min_cut_tokens = 32
+);
+
+#endif // DEVICEAI_LLM_PACK_H
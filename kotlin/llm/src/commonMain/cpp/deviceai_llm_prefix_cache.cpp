@@ -0,0 +1,284 @@
+/**
+ * deviceai_llm_prefix_cache.cpp - Cross-session prompt prefix cache
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_prefix_cache.h"
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <memory>
+
+// Restoring copies the whole stored state into the context, so it must save
+// a meaningful amount of prefill to be worth it.
+static const size_t MIN_REUSE_GAIN   = 32;
+// Requests that decoded fewer fresh prompt tokens than this are not stored.
+static const size_t MIN_STORE_TOKENS = 64;
+
+// ═══════════════════════════════════════════════════════════════
+//                           State
+// ═══════════════════════════════════════════════════════════════
+
+namespace {
+
+struct cache_entry;
+
+// Radix tree over token sequences. Each edge carries a run of tokens; a node
+// with an entry marks the end of a cached sequence. Leaves always hold an
+// entry (empty leaves are pruned), so every subtree contains at least one.
+struct radix_node {
+    std::vector<llama_token> edge;                                   // tokens from parent to here
+    radix_node              *parent = nullptr;
+    std::map<llama_token, std::unique_ptr<radix_node>> children;     // keyed by child->edge[0]
+    cache_entry             *entry  = nullptr;
+    size_t                   depth  = 0;                             // tokens from the root to here
+};
+
+using state_ptr = std::shared_ptr<const std::vector<uint8_t>>;
+
+struct cache_entry {
+    radix_node                      *node = nullptr;
+    state_ptr                        state;
+    std::list<cache_entry>::iterator self;
+};
+
+} // namespace
+
+struct dai_llm_prefix_cache {
+    std::mutex             mutex;
+    size_t                 budget = 0;
+    size_t                 bytes  = 0;
+    radix_node             root;
+    std::list<cache_entry> lru;      // front = most recently used
+    dai_llm_prefix_stats   stats;
+};
+
+// ═══════════════════════════════════════════════════════════════
+//                         Radix tree
+// ═══════════════════════════════════════════════════════════════
+
+// Deepest point reached by `tokens`. Returns the node whose subtree shares
+// the matched length with tokens (the match may end inside its edge).
+static radix_node *match(radix_node *root, const std::vector<llama_token> &tokens, size_t &n_matched) {
+    radix_node *node = root;
+    size_t i = 0;
+    for (;;) {
+        if (i == tokens.size()) break;
+        auto it = node->children.find(tokens[i]);
+        if (it == node->children.end()) break;
+
+        radix_node *child = it->second.get();
+        size_t k = 0;
+        while (k < child->edge.size() && i + k < tokens.size() && child->edge[k] == tokens[i + k]) k++;
+        i += k;
+        node = child;
+        if (k < child->edge.size()) break;
+    }
+    n_matched = i;
+    return node;
+}
+
+// Shortest cached sequence under node: the cheapest state to restore.
+static cache_entry *shallowest_entry(radix_node *node) {
+    if (node->entry) return node->entry;
+    cache_entry *best = nullptr;
+    for (auto &kv : node->children) {
+        cache_entry *e = shallowest_entry(kv.second.get());
+        if (e && (!best || e->node->depth < best->node->depth)) best = e;
+    }
+    return best;
+}
+
+// Node at the end of `tokens`, splitting edges and adding nodes as needed.
+static radix_node *insert_path(radix_node *root, const std::vector<llama_token> &tokens) {
+    radix_node *node = root;
+    size_t i = 0;
+    while (i < tokens.size()) {
+        auto it = node->children.find(tokens[i]);
+        if (it == node->children.end()) {
+            auto leaf = std::make_unique<radix_node>();
+            leaf->edge.assign(tokens.begin() + i, tokens.end());
+            leaf->parent = node;
+            leaf->depth  = tokens.size();
+            radix_node *raw = leaf.get();
+            node->children[tokens[i]] = std::move(leaf);
+            return raw;
+        }
+
+        radix_node *child = it->second.get();
+        size_t k = 0;
+        while (k < child->edge.size() && i + k < tokens.size() && child->edge[k] == tokens[i + k]) k++;
+
+        if (k < child->edge.size()) {
+            // Split the edge: node → mid (edge[:k]) → child (edge[k:])
+            auto mid = std::make_unique<radix_node>();
+            mid->edge.assign(child->edge.begin(), child->edge.begin() + k);
+            mid->parent = node;
+            mid->depth  = node->depth + k;
+
+            std::unique_ptr<radix_node> old = std::move(it->second);
+            old->edge.erase(old->edge.begin(), old->edge.begin() + k);
+            old->parent = mid.get();
+            mid->children[old->edge[0]] = std::move(old);
+
+            child = mid.get();
+            it->second = std::move(mid);
+        }
+        i += k;
+        node = child;
+    }
+    return node;
+}
+
+// Drop empty leaves and fold pass-through nodes back into one edge.
+static void prune(radix_node *root, radix_node *node) {
+    while (node != root && !node->entry && node->children.empty()) {
+        radix_node *parent = node->parent;
+        parent->children.erase(node->edge[0]);
+        node = parent;
+    }
+    if (node != root && !node->entry && node->children.size() == 1) {
+        std::unique_ptr<radix_node> only = std::move(node->children.begin()->second);
+        node->children.clear();
+        node->edge.insert(node->edge.end(), only->edge.begin(), only->edge.end());
+        node->depth    = only->depth;
+        node->entry    = only->entry;
+        node->children = std::move(only->children);
+        if (node->entry) node->entry->node = node;
+        for (auto &kv : node->children) kv.second->parent = node;
+    }
+}
+
+static void evict(dai_llm_prefix_cache *c, cache_entry &e) {
+    radix_node *node = e.node;
+    node->entry = nullptr;
+    c->bytes -= e.state->size();
+    c->lru.erase(e.self);
+    c->stats.evictions++;
+    prune(&c->root, node);
+}
+
+static void touch(dai_llm_prefix_cache *c, cache_entry *e) {
+    c->lru.splice(c->lru.begin(), c->lru, e->self);
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Public API
+// ═══════════════════════════════════════════════════════════════
+
+dai_llm_prefix_cache *dai_llm_prefix_cache_create(size_t budget_bytes) {
+    auto *c = new dai_llm_prefix_cache();
+    c->budget = budget_bytes;
+    return c;
+}
+
+void dai_llm_prefix_cache_free(dai_llm_prefix_cache *cache) {
+    delete cache;
+}
+
+size_t dai_llm_prefix_cache_restore(
+    dai_llm_prefix_cache *c,
+    llama_context *ctx,
+    llama_seq_id seq,
+    const std::vector<llama_token> &tokens,
+    size_t n_have
+) {
+    if (!c) return n_have;
+
+    state_ptr state;
+    size_t    n_shared = 0;
+    {
+        std::lock_guard<std::mutex> lock(c->mutex);
+        c->stats.lookups++;
+
+        radix_node *node = match(&c->root, tokens, n_shared);
+        if (n_shared < n_have + MIN_REUSE_GAIN) return n_have;
+
+        cache_entry *e = shallowest_entry(node);
+        if (!e) return n_have;
+        touch(c, e);
+        state = e->state;   // keeps the bytes alive if evicted meanwhile
+    }
+
+    // Replaces the sequence with the stored one, then cut it back to the
+    // part shared with this prompt.
+    llama_memory_t mem = llama_get_memory(ctx);
+    if (!llama_state_seq_set_data(ctx, state->data(), state->size(), seq)) {
+        llama_memory_seq_rm(mem, seq, -1, -1);
+        return 0;
+    }
+    llama_memory_seq_rm(mem, seq, (llama_pos)n_shared, -1);
+
+    std::lock_guard<std::mutex> lock(c->mutex);
+    c->stats.hits++;
+    c->stats.tokens_reused += (int64_t)(n_shared - n_have);
+    return n_shared;
+}
+
+void dai_llm_prefix_cache_store(
+    dai_llm_prefix_cache *c,
+    llama_context *ctx,
+    llama_seq_id seq,
+    const std::vector<llama_token> &tokens,
+    size_t n_prefilled
+) {
+    if (!c || c->budget == 0 || n_prefilled < MIN_STORE_TOKENS) return;
+
+    {
+        // Already cached: just mark it as used.
+        std::lock_guard<std::mutex> lock(c->mutex);
+        size_t n_matched = 0;
+        radix_node *node = match(&c->root, tokens, n_matched);
+        if (n_matched == tokens.size() && node->depth == tokens.size() && node->entry) {
+            touch(c, node->entry);
+            return;
+        }
+    }
+
+    const size_t size = llama_state_seq_get_size(ctx, seq);
+    if (size == 0 || size > c->budget) return;
+
+    auto buf = std::make_shared<std::vector<uint8_t>>(size);
+    if (llama_state_seq_get_data(ctx, buf->data(), size, seq) != size) return;
+
+    std::lock_guard<std::mutex> lock(c->mutex);
+    radix_node *node = insert_path(&c->root, tokens);
+    if (node->entry) {
+        c->bytes -= node->entry->state->size();
+        node->entry->state = buf;
+        touch(c, node->entry);
+    } else {
+        c->lru.emplace_front();
+        cache_entry &e = c->lru.front();
+        e.node  = node;
+        e.state = buf;
+        e.self  = c->lru.begin();
+        node->entry = &e;
+        c->stats.insertions++;
+    }
+    c->bytes += size;
+
+    while (c->bytes > c->budget && !c->lru.empty()) evict(c, c->lru.back());
+}
+
+void dai_llm_prefix_cache_record(dai_llm_prefix_cache *c, size_t n_reused) {
+    if (!c) return;
+    std::lock_guard<std::mutex> lock(c->mutex);
+    c->stats.lookups++;
+    if (n_reused > 0) {
+        c->stats.hits++;
+        c->stats.tokens_reused += (int64_t)n_reused;
+    }
+}
+
+dai_llm_prefix_stats dai_llm_prefix_cache_stats(dai_llm_prefix_cache *c) {
+    if (!c) return {};
+    std::lock_guard<std::mutex> lock(c->mutex);
+    dai_llm_prefix_stats st = c->stats;
+    st.entries      = (int64_t)c->lru.size();
+    st.bytes_used   = (int64_t)c->bytes;
+    st.budget_bytes = (int64_t)c->budget;
+    return st;
+}
@@ -0,0 +1,77 @@
+#ifndef DEVICEAI_LLM_PREFIX_CACHE_H
+#define DEVICEAI_LLM_PREFIX_CACHE_H
+
+/**
+ * deviceai_llm_prefix_cache.h - Cross-session prompt prefix cache
+ *
+ * Per-session KV reuse only helps consecutive turns of one conversation.
+ * Unrelated sessions and requests on the same model usually begin with the
+ * same system prompt, RAG preamble or few-shot block, and prefilled it again
+ * each time.
+ *
+ * The cache keeps serialized sequence states (llama_state_seq_get_data) of
+ * recently finished requests, prompt and reply, keyed by their tokens in a
+ * radix tree. A state is copied once its request is done, never between
+ * prefill and the first token. For a new prompt it finds the longest cached
+ * prefix; any stored sequence that continues that prefix can serve it, so
+ * the state is loaded into the session's sequence and truncated to the
+ * shared length. Entries are evicted least-recently-used under a byte budget.
+ *
+ * Sessions on a batching scheduler share one context, so the scheduler
+ * copies KV cells between its sequences instead (llama_memory_seq_cp) and
+ * only reports hits here.
+ */
+
+#include "deviceai_llm_engine.h"
+
+struct dai_llm_prefix_cache;
+
+struct dai_llm_prefix_stats {
+    int64_t lookups       = 0;   // prompts checked against the cache
+    int64_t hits          = 0;   // prompts that reused cached prefix tokens
+    int64_t tokens_reused = 0;   // prompt tokens not prefilled thanks to hits
+    int64_t insertions    = 0;
+    int64_t evictions     = 0;
+    int64_t entries       = 0;
+    int64_t bytes_used    = 0;
+    int64_t budget_bytes  = 0;
+};
+
+/** Create a cache holding at most budget_bytes of sequence state (0 = store nothing). */
+dai_llm_prefix_cache *dai_llm_prefix_cache_create(size_t budget_bytes);
+
+void dai_llm_prefix_cache_free(dai_llm_prefix_cache *cache);
+
+/**
+ * Load the longest cached prefix of `tokens` into sequence `seq` of ctx when
+ * it covers more than the n_have tokens already resident there. Returns the
+ * number of prompt tokens resident afterwards: n_have when nothing was
+ * restored, 0 when a restore failed (the sequence is then empty).
+ */
+size_t dai_llm_prefix_cache_restore(
+    dai_llm_prefix_cache *cache,
+    llama_context *ctx,
+    llama_seq_id seq,
+    const std::vector<llama_token> &tokens,
+    size_t n_have
+);
+
+/**
+ * Offer the state of sequence `seq`, which holds exactly `tokens`, to the
+ * cache. n_prefilled is how many of them were just decoded; short fresh
+ * suffixes are not worth a snapshot and are skipped.
+ */
+void dai_llm_prefix_cache_store(
+    dai_llm_prefix_cache *cache,
+    llama_context *ctx,
+    llama_seq_id seq,
+    const std::vector<llama_token> &tokens,
+    size_t n_prefilled
+);
+
+/** Count a lookup served elsewhere (scheduler seq_cp); n_reused = 0 is a miss. */
+void dai_llm_prefix_cache_record(dai_llm_prefix_cache *cache, size_t n_reused);
+
+dai_llm_prefix_stats dai_llm_prefix_cache_stats(dai_llm_prefix_cache *cache);
+
+#endif // DEVICEAI_LLM_PREFIX_CACHE_H
@@ -0,0 +1,603 @@
+/**
+ * deviceai_llm_scheduler.cpp - Continuous-batching scheduler
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_scheduler.h"
+#include "deviceai_llm_prefix_cache.h"
+#include "deviceai_llm_grammar.h"
+#include "deviceai_llm_threads.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmScheduler"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+// ═══════════════════════════════════════════════════════════════
+//                           State
+// ═══════════════════════════════════════════════════════════════
+
+namespace {
+
+// The calling thread waiting for one or more requests (an n-best call
+// waits for all its candidates at once).
+struct sched_waiter {
+    std::mutex              mutex;
+    std::condition_variable cv;
+};
+
+// One queued or running generate call. Lives on the caller's stack; the
+// scheduler thread stops touching it once `done` is set.
+struct sched_request {
+    dai_llm_session          *session = nullptr;
+    std::vector<llama_token>  prompt;
+    dai_llm_gen_params        params;
+    dai_llm_metrics_recorder *rec = nullptr;     // written by the scheduler thread until done
+    llama_sampler            *sampler = nullptr; // built by the caller, taken over by admit()
+
+    std::atomic<bool>         stopped{false};   // caller's on_token returned false
+
+    // Guarded by waiter->mutex
+    sched_waiter             *waiter = nullptr;
+    std::vector<std::string>  pieces;           // produced, not yet delivered
+    int                       n_prefilled = -1; // prompt tokens in KV, not yet reported
+    bool                      done = false;
+
+    ~sched_request() { if (sampler) llama_sampler_free(sampler); }
+};
+
+enum class slot_state { IDLE, PREFILL, GENERATE };
+
+struct sched_slot {
+    llama_seq_id             seq_id = 0;
+    slot_state               state  = slot_state::IDLE;
+    std::vector<llama_token> kv_tokens;         // tokens resident in this sequence
+    sched_request           *req     = nullptr;
+    llama_sampler           *sampler = nullptr;
+
+    size_t      n_prompt_done = 0;               // prompt tokens submitted so far
+    int         n_generated   = 0;
+    llama_token pending       = LLAMA_TOKEN_NULL; // sampled, not yet decoded
+
+    // Per-step bookkeeping
+    int    i_batch    = -1;   // batch index whose logits this slot samples from
+    int    i_first    = -1;   // batch index of this slot's first token (they are contiguous)
+    size_t n_in_batch = 0;    // tokens this slot contributed to the current batch
+};
+
+} // namespace
+
+struct dai_llm_scheduler {
+    dai_llm_model *model   = nullptr;
+    llama_context *ctx     = nullptr;
+    llama_batch    batch   = {};
+    int            n_batch = 0;
+    int            n_ctx_seq = 0;
+    dai_llm_ctx_threads threads;     // touched only by the scheduler thread
+
+    std::vector<sched_slot> slots;   // touched only by the scheduler thread
+
+    std::thread                 thread;
+    std::mutex                  mutex;
+    std::condition_variable     cv;
+    std::deque<sched_request *> queue;
+    bool                        stop = false;
+};
+
+// ═══════════════════════════════════════════════════════════════
+//                         Helpers
+// ═══════════════════════════════════════════════════════════════
+
+static void batch_add(llama_batch &batch, llama_token token, llama_pos pos, llama_seq_id seq, bool logits) {
+    const int i = batch.n_tokens;
+    batch.token   [i]    = token;
+    batch.pos     [i]    = pos;
+    batch.n_seq_id[i]    = 1;
+    batch.seq_id  [i][0] = seq;
+    batch.logits  [i]    = logits;
+    batch.n_tokens++;
+}
+
+// Entries [first, first + n) of b, sharing its arrays.
+static llama_batch batch_view(const llama_batch &b, int first, int n) {
+    llama_batch view = {};
+    view.n_tokens = n;
+    view.token    = b.token    + first;
+    view.pos      = b.pos      + first;
+    view.n_seq_id = b.n_seq_id + first;
+    view.seq_id   = b.seq_id   + first;
+    view.logits   = b.logits   + first;
+    return view;
+}
+
+static void deliver(sched_request *r, std::string piece) {
+    {
+        std::lock_guard<std::mutex> lock(r->waiter->mutex);
+        r->pieces.push_back(std::move(piece));
+    }
+    r->waiter->cv.notify_one();
+}
+
+static void report_progress(sched_request *r, size_t n_prefilled) {
+    {
+        std::lock_guard<std::mutex> lock(r->waiter->mutex);
+        r->n_prefilled = (int)n_prefilled;
+    }
+    r->waiter->cv.notify_one();
+}
+
+static void complete(sched_request *r) {
+    // Notify while holding the lock: once `done` is visible the caller may
+    // return and destroy the request, condition variable included.
+    std::lock_guard<std::mutex> lock(r->waiter->mutex);
+    r->done = true;
+    r->waiter->cv.notify_one();
+}
+
+static bool is_cancelled(const sched_request *r) {
+    return r->stopped.load() || r->session->cancel.load();
+}
+
+// Hand the result back to the caller and return the slot to the idle pool.
+// The slot keeps its KV cells for prefix reuse by the next request.
+static void finish(sched_slot &slot) {
+    if (slot.sampler) { llama_sampler_free(slot.sampler); slot.sampler = nullptr; }
+    if (slot.req)     { complete(slot.req); slot.req = nullptr; }
+    slot.state   = slot_state::IDLE;
+    slot.pending = LLAMA_TOKEN_NULL;
+}
+
+// Idle slot whose cached tokens share the longest prefix with the prompt.
+static sched_slot *pick_slot(dai_llm_scheduler *sc, const std::vector<llama_token> &prompt) {
+    sched_slot *best   = nullptr;
+    size_t      best_n = 0;
+    for (auto &slot : sc->slots) {
+        if (slot.state != slot_state::IDLE) continue;
+        size_t n = dai_llm_common_prefix(slot.kv_tokens, prompt);
+        if (!best || n > best_n) { best = &slot; best_n = n; }
+    }
+    return best;
+}
+
+// Any other sequence (busy or idle) holding a longer prefix of the prompt
+// than `n_have` tokens; n_shared receives that length.
+static const sched_slot *donor_slot(const dai_llm_scheduler *sc, const sched_slot &self,
+                                    const std::vector<llama_token> &prompt, size_t n_have, size_t &n_shared) {
+    const sched_slot *best = nullptr;
+    n_shared = n_have;
+    for (const auto &slot : sc->slots) {
+        if (&slot == &self) continue;
+        size_t n = dai_llm_common_prefix(slot.kv_tokens, prompt);
+        if (n > n_shared) { best = &slot; n_shared = n; }
+    }
+    return best;
+}
+
+static void admit(dai_llm_scheduler *sc, sched_slot &slot, sched_request *r) {
+    llama_memory_t mem = llama_get_memory(sc->ctx);
+
+    // Keep the shared prefix, re-decode at least the last prompt token.
+    size_t n_keep = std::min(dai_llm_common_prefix(slot.kv_tokens, r->prompt), r->prompt.size() - 1);
+    size_t n_copied = 0;
+    if (!llama_memory_seq_rm(mem, slot.seq_id, (llama_pos)n_keep, -1)) {
+        llama_memory_seq_rm(mem, slot.seq_id, -1, -1);
+        n_keep = 0;
+    } else {
+        // Share the cells of a longer prefix decoded by another sequence
+        // (the KV cache is unified, so this copies no tensor data).
+        size_t n_shared = 0;
+        const sched_slot *donor = donor_slot(sc, slot, r->prompt, n_keep, n_shared);
+        n_shared = std::min(n_shared, r->prompt.size() - 1);
+        if (donor && n_shared > n_keep) {
+            llama_memory_seq_cp(mem, donor->seq_id, slot.seq_id, (llama_pos)n_keep, (llama_pos)n_shared);
+            n_copied = n_shared - n_keep;
+            n_keep   = n_shared;
+        }
+    }
+    slot.kv_tokens.assign(r->prompt.begin(), r->prompt.begin() + n_keep);
+    dai_llm_prefix_cache_record(sc->model->prefix_cache, n_copied);
+
+    slot.req           = r;
+    slot.sampler       = r->sampler;
+    r->sampler         = nullptr;
+    slot.n_prompt_done = n_keep;
+    slot.n_generated   = 0;
+    slot.pending       = LLAMA_TOKEN_NULL;
+    slot.state         = slot_state::PREFILL;
+
+    if (r->rec) {
+        r->rec->m.n_ctx = sc->n_ctx_seq;
+        r->rec->begin_prefill(r->prompt.size(), n_keep);
+    }
+    report_progress(r, n_keep);
+}
+
+// Record the tokens the slot's part of the last decode put in the KV cache.
+static void commit_step(sched_slot &slot) {
+    if (slot.state == slot_state::GENERATE) {
+        slot.kv_tokens.push_back(slot.pending);
+    } else {
+        const auto &prompt = slot.req->prompt;
+        slot.kv_tokens.insert(slot.kv_tokens.end(),
+                              prompt.begin() + (slot.n_prompt_done - slot.n_in_batch),
+                              prompt.begin() + slot.n_prompt_done);
+        report_progress(slot.req, slot.n_prompt_done);
+        if (slot.req->rec && slot.n_prompt_done == prompt.size()) slot.req->rec->end_prefill();
+    }
+    if (slot.req->rec) slot.req->rec->kv(slot.kv_tokens.size());
+}
+
+// Sample the slot's next token from output idx of the last decode and hand
+// it to the caller; the slot finishes on EOG, max_tokens or a full sequence.
+static void sample_step(dai_llm_scheduler *sc, sched_slot &slot, int32_t idx) {
+    const llama_vocab *vocab = llama_model_get_vocab(sc->model->model);
+    char piece_buf[256];
+
+    if (slot.n_generated >= slot.req->params.max_tokens) { finish(slot); return; }
+
+    const auto t_sample = dai_llm_metrics_recorder::clock::now();
+    llama_token token = dai_llm_sample(slot.sampler, sc->ctx, idx);
+    if (token == LLAMA_TOKEN_NULL) { finish(slot); return; }   // grammar dead end
+    llama_sampler_accept(slot.sampler, token);
+    if (slot.req->rec) slot.req->rec->sampled(t_sample);
+
+    if (llama_vocab_is_eog(vocab, token)) { finish(slot); return; }
+
+    int n = llama_token_to_piece(vocab, token, piece_buf, sizeof(piece_buf), 0, true);
+    if (n < 0) { finish(slot); return; }
+
+    deliver(slot.req, std::string(piece_buf, n));
+    slot.n_generated++;
+    if (slot.req->rec) slot.req->rec->emitted();
+
+    if (slot.n_generated >= slot.req->params.max_tokens) { finish(slot); return; }
+
+    // The cache is shared by all slots; a sequence stops at its share of it
+    // rather than taking cells the others were promised.
+    if (slot.kv_tokens.size() >= (size_t)sc->n_ctx_seq) { finish(slot); return; }
+
+    slot.pending = token;
+    slot.state   = slot_state::GENERATE;
+}
+
+static bool has_work(const dai_llm_scheduler *sc) {
+    for (const auto &slot : sc->slots) {
+        if (slot.state != slot_state::IDLE) return true;
+    }
+    return !sc->queue.empty();
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                      Scheduler thread
+// ═══════════════════════════════════════════════════════════════
+
+static void run(dai_llm_scheduler *sc) {
+    llama_memory_t mem = llama_get_memory(sc->ctx);
+
+    for (;;) {
+        // ── Admit queued requests onto idle slots ──────────────────
+        {
+            std::unique_lock<std::mutex> lock(sc->mutex);
+            sc->cv.wait(lock, [&] { return sc->stop || has_work(sc); });
+            if (sc->stop) break;
+
+            // Requests cancelled while still queued never reach a slot.
+            for (auto it = sc->queue.begin(); it != sc->queue.end();) {
+                if (is_cancelled(*it)) { complete(*it); it = sc->queue.erase(it); }
+                else ++it;
+            }
+
+            while (!sc->queue.empty()) {
+                sched_slot *slot = pick_slot(sc, sc->queue.front()->prompt);
+                if (!slot) break;
+                admit(sc, *slot, sc->queue.front());
+                sc->queue.pop_front();
+            }
+        }
+
+        dai_llm_threads_apply(sc->model, sc->threads, sc->ctx);
+
+        // ── Build one batch: decode tokens first, then prompt chunks ──
+        sc->batch.n_tokens = 0;
+        for (auto &slot : sc->slots) { slot.i_batch = -1; slot.i_first = -1; slot.n_in_batch = 0; }
+
+        for (auto &slot : sc->slots) {
+            if (slot.state != slot_state::GENERATE) continue;
+            if (is_cancelled(slot.req)) { finish(slot); continue; }
+            if (sc->batch.n_tokens >= sc->n_batch) break;
+
+            slot.i_batch    = sc->batch.n_tokens;
+            slot.i_first    = sc->batch.n_tokens;
+            slot.n_in_batch = 1;
+            batch_add(sc->batch, slot.pending, (llama_pos)slot.kv_tokens.size(), slot.seq_id, true);
+        }
+
+        // A request's prefill_chunk caps how much of its prompt enters one step,
+        // so long prompts leave room for other slots and cancel between steps.
+        for (auto &slot : sc->slots) {
+            if (slot.state != slot_state::PREFILL) continue;
+            if (is_cancelled(slot.req)) { finish(slot); continue; }
+
+            const auto  &prompt = slot.req->prompt;
+            const size_t chunk  = (size_t)dai_llm_prefill_chunk(slot.req->params, sc->n_batch);
+            slot.i_first = sc->batch.n_tokens;
+            while (slot.n_prompt_done < prompt.size() && sc->batch.n_tokens < sc->n_batch &&
+                   slot.n_in_batch < chunk) {
+                const bool last = slot.n_prompt_done == prompt.size() - 1;
+                if (last) slot.i_batch = sc->batch.n_tokens;
+                batch_add(sc->batch, prompt[slot.n_prompt_done], (llama_pos)slot.n_prompt_done, slot.seq_id, last);
+                slot.n_prompt_done++;
+                slot.n_in_batch++;
+            }
+        }
+
+        if (sc->batch.n_tokens == 0) continue;
+
+        const int rc = llama_decode(sc->ctx, sc->batch);
+        if (rc == 0) {
+            for (auto &slot : sc->slots) {
+                if (slot.n_in_batch == 0) continue;
+                commit_step(slot);
+                if (slot.i_batch >= 0) sample_step(sc, slot, slot.i_batch);
+            }
+            continue;
+        }
+
+        // One request can sink the whole batch (its chunk does not fit in the
+        // cache, say). Drop whatever the failed call left in the cache, then
+        // decode each slot's share on its own: only the slots that fail again
+        // are finished, the others carry on.
+        LOGE("llama_decode failed (%d) for a batch of %d tokens, retrying per request", rc, sc->batch.n_tokens);
+        for (auto &slot : sc->slots) {
+            if (slot.n_in_batch > 0) llama_memory_seq_rm(mem, slot.seq_id, (llama_pos)slot.kv_tokens.size(), -1);
+        }
+        for (auto &slot : sc->slots) {
+            if (slot.n_in_batch == 0) continue;
+            if (llama_decode(sc->ctx, batch_view(sc->batch, slot.i_first, (int)slot.n_in_batch))) {
+                LOGE("llama_decode failed for %zu tokens of sequence %d", slot.n_in_batch, slot.seq_id);
+                llama_memory_seq_rm(mem, slot.seq_id, (llama_pos)slot.kv_tokens.size(), -1);
+                if (slot.req->rec) slot.req->rec->m.failed = true;
+                finish(slot);
+                continue;
+            }
+            commit_step(slot);
+            if (slot.i_batch >= 0) sample_step(sc, slot, slot.i_batch - slot.i_first);
+        }
+    }
+
+    // ── Shutdown: release everyone still waiting ───────────────────
+    for (auto &slot : sc->slots) finish(slot);
+    std::lock_guard<std::mutex> lock(sc->mutex);
+    for (auto *r : sc->queue) complete(r);
+    sc->queue.clear();
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Public API
+// ═══════════════════════════════════════════════════════════════
+
+dai_llm_scheduler *dai_llm_scheduler_create(dai_llm_model *model, int n_slots) {
+    if (!model || !model->model || n_slots < 1) return nullptr;
+
+    // n_ctx (0 → model's native context) is split evenly across the sequences
+    llama_context_params cparams = model->cparams;
+    cparams.n_seq_max = n_slots;
+    // One cell pool for all sequences, so a shared prefix can be copied
+    // between them (prefix cache) instead of decoded again.
+    cparams.kv_unified = true;
+
+    llama_context *ctx = llama_init_from_model(model->model, cparams);
+    if (!ctx) {
+        LOGE("Failed to create scheduler context");
+        return nullptr;
+    }
+
+    auto *sc = new dai_llm_scheduler();
+    sc->model     = model;
+    sc->ctx       = ctx;
+    sc->n_batch   = (int)llama_n_batch(ctx);
+    sc->n_ctx_seq = (int)(llama_n_ctx(ctx) / n_slots);
+    sc->batch     = llama_batch_init(sc->n_batch, 0, 1);
+
+    sc->slots.resize(n_slots);
+    for (int i = 0; i < n_slots; i++) sc->slots[i].seq_id = i;
+
+    sc->thread = std::thread(run, sc);
+
+    LOGI("LLM scheduler started (slots=%d, ctx/seq=%d, batch=%d)", n_slots, sc->n_ctx_seq, sc->n_batch);
+    return sc;
+}
+
+void dai_llm_scheduler_free(dai_llm_scheduler *sc) {
+    if (!sc) return;
+    {
+        std::lock_guard<std::mutex> lock(sc->mutex);
+        sc->stop = true;
+    }
+    sc->cv.notify_all();
+    if (sc->thread.joinable()) sc->thread.join();
+
+    llama_batch_free(sc->batch);
+    llama_free(sc->ctx);
+    dai_llm_threads_release(sc->threads);
+    delete sc;
+}
+
+int dai_llm_scheduler_n_ctx_seq(const dai_llm_scheduler *sc) {
+    return sc ? sc->n_ctx_seq : 0;
+}
+
+std::string dai_llm_scheduler_generate(
+    dai_llm_scheduler *sc,
+    dai_llm_session *session,
+    const std::vector<llama_token> &prompt,
+    const dai_llm_gen_params &params,
+    const dai_llm_token_cb &on_token,
+    const dai_llm_progress_cb &on_progress,
+    dai_llm_metrics_recorder *rec
+) {
+    if (!sc || prompt.empty()) return "";
+
+    sched_waiter  waiter;
+    sched_request r;
+    r.session = session;
+    r.prompt  = prompt;
+    r.params  = params;
+    r.rec     = rec;
+    r.waiter  = &waiter;
+    r.sampler = dai_llm_build_sampler(params, sc->model);
+    if (!r.sampler) {
+        if (rec) rec->m.failed = true;
+        return "";
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sc->mutex);
+        if (sc->stop) return "";
+        sc->queue.push_back(&r);
+    }
+    sc->cv.notify_one();
+
+    // Deliver progress and pieces on the calling thread so platform callbacks
+    // (JNI, Kotlin channels) never run on the scheduler thread.
+    std::string result;
+    for (;;) {
+        std::vector<std::string> pieces;
+        int  n_prefilled;
+        bool done;
+        {
+            std::unique_lock<std::mutex> lock(waiter.mutex);
+            waiter.cv.wait(lock, [&] { return r.done || !r.pieces.empty() || r.n_prefilled >= 0; });
+            pieces.swap(r.pieces);
+            n_prefilled   = r.n_prefilled;
+            r.n_prefilled = -1;
+            done = r.done;
+        }
+        if (n_prefilled >= 0 && on_progress) on_progress(n_prefilled, (int)prompt.size());
+        for (auto &piece : pieces) {
+            if (r.stopped.load()) break;
+            result += piece;
+            if (!on_token(piece)) r.stopped = true;
+        }
+        if (done) break;
+    }
+    return result;
+}
+
+std::vector<std::string> dai_llm_scheduler_generate_n(
+    dai_llm_scheduler *sc,
+    dai_llm_session *session,
+    const std::vector<llama_token> &prompt,
+    const dai_llm_gen_params &params,
+    int n,
+    const dai_llm_nbest_cb &on_token,
+    const dai_llm_progress_cb &on_progress,
+    dai_llm_metrics_recorder *rec
+) {
+    if (!sc || prompt.empty()) return {};
+    n = std::min(n, (int)sc->slots.size());
+    if (n < 1) return {};
+
+    sched_waiter waiter;
+    std::unique_ptr<sched_request[]>      reqs(new sched_request[n]);
+    std::vector<dai_llm_metrics_recorder> recs(n);
+    for (int i = 0; i < n; i++) {
+        sched_request &r = reqs[i];
+        r.session = session;
+        r.prompt  = prompt;
+        r.params  = params;
+        if (params.seed != LLAMA_DEFAULT_SEED) r.params.seed = params.seed + (uint32_t)i;
+        r.rec     = i == 0 && rec ? rec : &recs[i];
+        r.waiter  = &waiter;
+        r.sampler = dai_llm_build_sampler(r.params, sc->model);
+        if (!r.sampler) {
+            if (rec) rec->m.failed = true;
+            return {};
+        }
+    }
+
+    // Candidate 0 prefills the prompt; the others are queued once its cells
+    // exist, so admit() shares them instead of decoding the prompt n times.
+    int n_submitted = 0;
+    auto submit = [&](int count) {
+        {
+            std::lock_guard<std::mutex> lock(sc->mutex);
+            if (sc->stop) return false;
+            for (int i = 0; i < count; i++) sc->queue.push_back(&reqs[n_submitted + i]);
+        }
+        n_submitted += count;
+        sc->cv.notify_one();
+        return true;
+    };
+    if (!submit(1)) return {};
+
+    std::vector<std::string> results(n);
+    bool prefilled = false;
+    for (;;) {
+        const int n_seen = n_submitted;
+        std::vector<std::vector<std::string>> pieces(n_seen);
+        int  n_prefilled;
+        int  n_done = 0;
+        {
+            std::unique_lock<std::mutex> lock(waiter.mutex);
+            waiter.cv.wait(lock, [&] {
+                if (reqs[0].n_prefilled >= 0) return true;
+                for (int i = 0; i < n_seen; i++) {
+                    if (reqs[i].done || !reqs[i].pieces.empty()) return true;
+                }
+                return false;
+            });
+            for (int i = 0; i < n_seen; i++) {
+                pieces[i].swap(reqs[i].pieces);
+                n_done += reqs[i].done;
+            }
+            n_prefilled = reqs[0].n_prefilled;
+            reqs[0].n_prefilled = -1;
+        }
+        if (n_prefilled >= 0 && on_progress) on_progress(n_prefilled, (int)prompt.size());
+
+        for (int i = 0; i < n_seen; i++) {
+            for (auto &piece : pieces[i]) {
+                if (reqs[i].stopped.load()) break;
+                results[i] += piece;
+                if (!on_token(i, piece)) reqs[i].stopped = true;
+            }
+        }
+
+        if (!prefilled && (n_prefilled == (int)prompt.size() || !pieces[0].empty())) {
+            prefilled = true;
+            if (n > 1 && !submit(n - 1)) n = n_submitted;
+        }
+        if (n_done == n_submitted) {
+            // Candidate 0 ended before its prompt was decoded (cancel, decode
+            // failure): the others are never queued.
+            n = n_submitted;
+            break;
+        }
+    }
+
+    // The other candidates' tokens count toward the call's metrics.
+    if (rec) {
+        for (int i = 1; i < n; i++) {
+            rec->m.generated_tokens += recs[i].m.generated_tokens;
+            rec->m.sample_ms        += recs[i].m.sample_ms;
+            rec->m.kv_peak           = std::max(rec->m.kv_peak, recs[i].m.kv_peak);
+            rec->m.failed            = rec->m.failed || recs[i].m.failed;
+        }
+    }
+    results.resize(n);
+    return results;
+}
@@ -0,0 +1,66 @@
+#ifndef DEVICEAI_LLM_SCHEDULER_H
+#define DEVICEAI_LLM_SCHEDULER_H
+
+/**
+ * deviceai_llm_scheduler.h - Continuous-batching scheduler
+ *
+ * One llama_context with n_slots sequences, driven by a dedicated thread.
+ * Every step the thread builds a single llama_batch containing one decode
+ * token for each running sequence plus prompt chunks of newly admitted
+ * requests, so concurrent requests share each forward pass.
+ *
+ * Slots keep their KV cells after a request finishes. A new request is placed
+ * on the idle slot whose cached tokens share the longest prefix with its
+ * prompt, so multi-turn sessions keep most of their prefix reuse.
+ */
+
+#include "deviceai_llm_engine.h"
+#include "deviceai_llm_metrics.h"
+#include "deviceai_llm_nbest.h"
+
+/**
+ * Start a scheduler on a loaded model with n_slots parallel sequences.
+ * The model's context window is split evenly between the slots; a request
+ * whose sequence fills its share ends as if it had reached max_tokens.
+ */
+dai_llm_scheduler *dai_llm_scheduler_create(dai_llm_model *model, int n_slots);
+
+/** Stop the scheduler thread, fail queued requests and free the context. */
+void dai_llm_scheduler_free(dai_llm_scheduler *sched);
+
+/** Context window available to one sequence. */
+int dai_llm_scheduler_n_ctx_seq(const dai_llm_scheduler *sched);
+
+/**
+ * Queue a tokenized prompt and block until it completes. on_token and
+ * on_progress run on the calling thread; session->cancel or a false return
+ * stops the request. rec (may be null) is filled in by the scheduler thread.
+ */
+std::string dai_llm_scheduler_generate(
+    dai_llm_scheduler *sched,
+    dai_llm_session *session,
+    const std::vector<llama_token> &prompt,
+    const dai_llm_gen_params &params,
+    const dai_llm_token_cb &on_token,
+    const dai_llm_progress_cb &on_progress = nullptr,
+    dai_llm_metrics_recorder *rec = nullptr
+);
+
+/**
+ * dai_llm_scheduler_generate for n candidates on separate slots
+ * (deviceai_llm_nbest.h). Candidate 0 prefills; the rest are queued once its
+ * prompt is in the KV cache and share those cells. n is clamped to the slot
+ * count. rec receives candidate 0's timings and every candidate's tokens.
+ */
+std::vector<std::string> dai_llm_scheduler_generate_n(
+    dai_llm_scheduler *sched,
+    dai_llm_session *session,
+    const std::vector<llama_token> &prompt,
+    const dai_llm_gen_params &params,
+    int n,
+    const dai_llm_nbest_cb &on_token,
+    const dai_llm_progress_cb &on_progress = nullptr,
+    dai_llm_metrics_recorder *rec = nullptr
+);
+
+#endif // DEVICEAI_LLM_SCHEDULER_H
@@ -0,0 +1,187 @@
+/**
+ * deviceai_llm_score.cpp - Log-likelihood of candidate continuations
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_score.h"
+#include "deviceai_llm_metrics.h"
+#include "deviceai_llm_threads.h"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmScore"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+// ═══════════════════════════════════════════════════════════════
+//                        Teacher forcing
+// ═══════════════════════════════════════════════════════════════
+
+// log Σ exp(logits): subtracted from a logit it gives that token's log-probability.
+static double log_normalizer(const float *logits, int n_vocab) {
+    const float max = *std::max_element(logits, logits + n_vocab);
+    double sum = 0;
+    for (int i = 0; i < n_vocab; i++) sum += std::exp((double)(logits[i] - max));
+    return max + std::log(sum);
+}
+
+static float token_logprob(const float *logits, int n_vocab, llama_token token) {
+    return (float)(logits[token] - log_normalizer(logits, n_vocab));
+}
+
+// Plain text: no BOS/EOS and no special tokens, the same count dai_llm_count_tokens gives.
+static std::vector<llama_token> tokenize_plain(const llama_vocab *vocab, const std::string &text) {
+    const int n = -llama_tokenize(vocab, text.data(), (int32_t)text.size(), nullptr, 0, false, false);
+    std::vector<llama_token> tokens(std::max(n, 0));
+    if (n > 0) llama_tokenize(vocab, text.data(), (int32_t)text.size(), tokens.data(), n, false, false);
+    return tokens;
+}
+
+static void batch_add(llama_batch &batch, llama_token token, llama_pos pos, llama_seq_id seq, bool logits) {
+    const int i = batch.n_tokens;
+    batch.token   [i]    = token;
+    batch.pos     [i]    = pos;
+    batch.n_seq_id[i]    = 1;
+    batch.seq_id  [i][0] = seq;
+    batch.logits  [i]    = logits;
+    batch.n_tokens++;
+}
+
+// Decode every token but the last of each continuation in `group`, candidate
+// g in sequence g, and append the log-probabilities of the tokens after them.
+// The batch holds no prompt tokens, and its last tokens are left out, so each
+// output row scores exactly one continuation token. Returns false on cancel
+// or decode failure.
+static bool score_group(
+    dai_llm_session *s,
+    llama_batch &batch,
+    const std::vector<size_t> &group,
+    const std::vector<std::vector<llama_token>> &tokens,
+    std::vector<dai_llm_continuation_score> &out
+) {
+    llama_memory_t mem      = llama_get_memory(s->ctx);
+    const size_t   n_prompt = s->kv_tokens.size();
+    const int      n_vocab  = llama_vocab_n_tokens(llama_model_get_vocab(s->model->model));
+
+    batch.n_tokens = 0;
+    std::vector<int> first(group.size());
+    for (size_t g = 0; g < group.size(); g++) {
+        const llama_seq_id seq = (llama_seq_id)g;
+        if (seq > 0) {
+            llama_memory_seq_rm(mem, seq, -1, -1);
+            llama_memory_seq_cp(mem, 0, seq, -1, -1);
+        }
+        const std::vector<llama_token> &t = tokens[group[g]];
+        first[g] = batch.n_tokens;
+        for (size_t j = 0; j + 1 < t.size(); j++) {
+            batch_add(batch, t[j], (llama_pos)(n_prompt + j), seq, /*logits=*/true);   // predicts t[j + 1]
+        }
+    }
+
+    const int rc = llama_decode(s->ctx, batch);
+    if (rc == 0) {
+        for (size_t g = 0; g < group.size(); g++) {
+            const std::vector<llama_token> &t = tokens[group[g]];
+            for (size_t j = 0; j + 1 < t.size(); j++) {
+                const float *logits = llama_get_logits_ith(s->ctx, first[g] + (int)j);
+                out[group[g]].token_logprobs.push_back(token_logprob(logits, n_vocab, t[j + 1]));
+            }
+        }
+    } else if (rc != DAI_LLM_DECODE_ABORTED) {
+        LOGE("llama_decode failed scoring %zu continuations (%d tokens)", group.size(), batch.n_tokens);
+    }
+
+    // Back to just the prompt, also after an aborted or failed batch.
+    for (size_t g = 0; g < group.size(); g++) {
+        const llama_seq_id seq = (llama_seq_id)g;
+        llama_memory_seq_rm(mem, seq, seq == 0 ? (llama_pos)n_prompt : -1, -1);
+    }
+    return rc == 0;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                           Scoring
+// ═══════════════════════════════════════════════════════════════
+
+bool dai_llm_score_continuations(
+    dai_llm_session *s,
+    const std::string &prompt,
+    const std::vector<std::string> &continuations,
+    std::vector<dai_llm_continuation_score> &out,
+    const dai_llm_progress_cb &on_progress
+) {
+    out.clear();
+    if (!s) return false;
+
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (!s->ctx) {
+        LOGE("Scoring needs a session with its own context");
+        return false;
+    }
+    s->cancel       = false;
+    s->cancel_at_ns = 0;
+
+    const llama_vocab *vocab   = llama_model_get_vocab(s->model->model);
+    const int          n_vocab = llama_vocab_n_tokens(vocab);
+
+    std::vector<std::vector<llama_token>> tokens;
+    tokens.reserve(continuations.size());
+    for (const std::string &text : continuations) tokens.push_back(tokenize_plain(vocab, text));
+
+    dai_llm_threads_apply(s->model, s->threads, s->ctx, s->draft_ctx);
+    dai_llm_metrics_recorder rec;
+    if (!dai_llm_prepare_prompt(s, prompt, dai_llm_gen_params(), on_progress, rec)) return false;
+
+    // The prompt's logits score every first token; read them before a batch
+    // replaces them.
+    std::vector<dai_llm_continuation_score> scores(continuations.size());
+    const float *last = llama_get_logits_ith(s->ctx, -1);
+    const double norm = log_normalizer(last, n_vocab);
+    for (size_t i = 0; i < tokens.size(); i++) {
+        if (!tokens[i].empty()) scores[i].token_logprobs.push_back((float)(last[tokens[i][0]] - norm));
+    }
+
+    // Passes of up to n_seq continuations (the larger of score_sequences and
+    // max_candidates) whose tokens fit one batch and the context.
+    const size_t n_seq   = llama_n_seq_max(s->ctx);
+    const size_t n_batch = llama_n_batch(s->ctx);
+    const size_t n_limit = std::min(n_batch, (size_t)llama_n_ctx(s->ctx) - s->kv_tokens.size());
+    llama_batch  batch   = llama_batch_init((int32_t)n_batch, 0, 1);
+    bool         ok      = true;
+
+    size_t next = 0;
+    while (ok && next < tokens.size()) {
+        std::vector<size_t> group;
+        size_t n_tokens = 0;
+        for (; next < tokens.size() && group.size() < n_seq; next++) {
+            const size_t n = tokens[next].size() > 1 ? tokens[next].size() - 1 : 0;
+            if (n == 0) continue;   // scored by the prompt's logits alone
+            if (n > n_limit) {
+                LOGE("Continuation %zu has %zu tokens, more than one pass can score (%zu)", next, n + 1, n_limit);
+                ok = false;
+                break;
+            }
+            if (n_tokens + n > n_limit) break;
+            group.push_back(next);
+            n_tokens += n;
+        }
+        if (!ok || group.empty()) break;
+        ok = !s->cancel.load() && score_group(s, batch, group, tokens, scores);
+    }
+    llama_batch_free(batch);
+    dai_llm_store_prefix(s, rec.m.cached_tokens);
+    if (!ok) return false;
+
+    for (dai_llm_continuation_score &score : scores) {
+        for (float lp : score.token_logprobs) score.logprob += lp;
+    }
+    out = std::move(scores);
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef DEVICEAI_LLM_SCORE_H
+#define DEVICEAI_LLM_SCORE_H
+
+/**
+ * deviceai_llm_score.h - Log-likelihood of candidate continuations
+ *
+ * Intent classification and reply reranking only need to know which of K
+ * fixed continuations the model finds most likely, not new text. Sampling an
+ * answer and parsing it costs a decode step per token; here every candidate
+ * is scored by teacher forcing in one forward pass.
+ *
+ * The prompt is prefilled once into sequence 0 (reusing the KV cache and the
+ * prefix cache like any request), and its last logits score every
+ * candidate's first token. The candidates' other tokens are then decoded
+ * together in one batch, candidate i in sequence i forked from the prompt,
+ * each token's logits scoring the next one; only those positions produce
+ * logits. A pass holds up to the context's sequences, the larger of the
+ * model's score_sequences and max_candidates (dai_llm_model_params);
+ * larger candidate sets, or ones that overflow a batch, are scored in
+ * several passes.
+ * Afterwards the cache again holds just the prompt.
+ *
+ * Sessions with their own context only.
+ */
+
+#include "deviceai_llm_engine.h"
+
+struct dai_llm_continuation_score {
+    double             logprob = 0;       // sum of token_logprobs: log P(continuation | prompt)
+    std::vector<float> token_logprobs;    // log P(token | prompt, earlier tokens), one per token
+};
+
+/**
+ * Score each continuation of prompt. Continuations are tokenized on their
+ * own as plain text, without BOS/EOS or special tokens; an empty one scores 0. Returns false, with out
+ * empty, when the session cannot score (scheduler session, failed prefill,
+ * a continuation longer than a batch) or is cancelled.
+ */
+bool dai_llm_score_continuations(
+    dai_llm_session *session,
+    const std::string &prompt,
+    const std::vector<std::string> &continuations,
+    std::vector<dai_llm_continuation_score> &out,
+    const dai_llm_progress_cb &on_progress = nullptr
+);
+
+#endif // DEVICEAI_LLM_SCORE_H
@@ -0,0 +1,159 @@
+/**
+ * deviceai_llm_snapshot.cpp - On-disk KV snapshots of a prompt prefix
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_snapshot.h"
+#include "deviceai_llm_threads.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmSnapshot"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+static const size_t FP_HEAD_BYTES  = 64 * 1024;   // GGUF header + metadata
+static const size_t FP_BLOCK_BYTES = 4 * 1024;
+static const int    FP_BLOCKS      = 16;          // sampled across the weights
+
+// ═══════════════════════════════════════════════════════════════
+//                         Hashing
+// ═══════════════════════════════════════════════════════════════
+
+static const uint64_t FNV_OFFSET = 1469598103934665603ull;
+static const uint64_t FNV_PRIME  = 1099511628211ull;
+
+static uint64_t fnv1a(uint64_t h, const void *data, size_t n) {
+    const auto *p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < n; i++) h = (h ^ p[i]) * FNV_PRIME;
+    return h;
+}
+
+static uint64_t hash_tokens(const std::vector<llama_token> &tokens) {
+    return fnv1a(FNV_OFFSET, tokens.data(), tokens.size() * sizeof(llama_token));
+}
+
+static uint64_t compute_fingerprint(const dai_llm_model *m) {
+    uint64_t h = FNV_OFFSET;
+
+    const uint64_t n_params = llama_model_n_params(m->model);
+    const uint64_t size     = llama_model_size(m->model);
+    h = fnv1a(h, &n_params, sizeof(n_params));
+    h = fnv1a(h, &size,     sizeof(size));
+
+    std::ifstream in(m->path, std::ios::binary | std::ios::ate);
+    if (!in) return h;
+
+    const std::streamoff file_size = in.tellg();
+    h = fnv1a(h, &file_size, sizeof(file_size));
+
+    std::vector<char> buf(FP_HEAD_BYTES);
+    auto read_at = [&](std::streamoff off, size_t n) {
+        in.clear();
+        in.seekg(off);
+        in.read(buf.data(), (std::streamsize)n);
+        h = fnv1a(h, buf.data(), (size_t)in.gcount());
+    };
+
+    read_at(0, FP_HEAD_BYTES);
+    if (file_size > (std::streamoff)(FP_HEAD_BYTES + FP_BLOCK_BYTES)) {
+        const std::streamoff span = file_size - (std::streamoff)(FP_HEAD_BYTES + FP_BLOCK_BYTES);
+        for (int i = 1; i <= FP_BLOCKS; i++) {
+            read_at((std::streamoff)FP_HEAD_BYTES + span * i / FP_BLOCKS, FP_BLOCK_BYTES);
+        }
+    }
+    return h;
+}
+
+uint64_t dai_llm_model_fingerprint(dai_llm_model *m) {
+    if (!m) return 0;
+    std::call_once(m->fingerprint_once, [m] { m->fingerprint = compute_fingerprint(m); });
+    return m->fingerprint;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                       Restore / rebuild
+// ═══════════════════════════════════════════════════════════════
+
+static bool restore(dai_llm_session *s, const std::string &path, const std::vector<llama_token> &prefix) {
+    std::vector<llama_token> stored(prefix.size());
+    size_t n_stored = 0;
+
+    if (!llama_state_seq_load_file(s->ctx, path.c_str(), 0, stored.data(), stored.size(), &n_stored)) {
+        return false;
+    }
+    stored.resize(n_stored);
+    if (stored != prefix) {
+        LOGI("KV snapshot %s holds a different prefix", path.c_str());
+        return false;
+    }
+    s->kv_tokens = prefix;
+    return true;
+}
+
+static void save(dai_llm_session *s, const std::string &path) {
+    // Write next to the target and rename, so a crash mid-write never leaves
+    // a truncated snapshot under the final name.
+    const std::string tmp = path + ".tmp";
+    if (!llama_state_seq_save_file(s->ctx, tmp.c_str(), 0, s->kv_tokens.data(), s->kv_tokens.size()) ||
+        std::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to write KV snapshot %s", path.c_str());
+        std::remove(tmp.c_str());
+    }
+}
+
+dai_llm_snapshot_status dai_llm_session_warm(
+    dai_llm_session *s,
+    const std::string &prefix,
+    const std::string &cache_dir
+) {
+    if (!s || prefix.empty() || cache_dir.empty()) return DAI_LLM_SNAPSHOT_FAILED;
+    std::lock_guard<std::mutex> lock(s->mutex);
+    if (!s->ctx) return DAI_LLM_SNAPSHOT_FAILED;   // scheduler sessions share one context
+    dai_llm_threads_apply(s->model, s->threads, s->ctx, s->draft_ctx);
+
+    const llama_vocab *vocab = llama_model_get_vocab(s->model->model);
+    auto tokens = dai_llm_tokenize(vocab, prefix, llama_n_ctx(s->ctx));
+    if (tokens.empty()) return DAI_LLM_SNAPSHOT_FAILED;
+
+    // Already resident (e.g. warmed twice): nothing to do.
+    if (dai_llm_common_prefix(s->kv_tokens, tokens) == tokens.size()) return DAI_LLM_SNAPSHOT_RESTORED;
+
+    char name[64];
+    snprintf(name, sizeof(name), "%016" PRIx64 "-%016" PRIx64 ".kvstate",
+             dai_llm_model_fingerprint(s->model), hash_tokens(tokens));
+    std::string path = cache_dir;
+    if (path.back() != '/') path += '/';
+    path += name;
+
+    llama_memory_t mem = llama_get_memory(s->ctx);
+    llama_memory_clear(mem, /*data=*/false);
+    s->kv_tokens.clear();
+
+    if (restore(s, path, tokens)) {
+        LOGI("KV snapshot restored: %zu tokens from %s", tokens.size(), path.c_str());
+        return DAI_LLM_SNAPSHOT_RESTORED;
+    }
+
+    // Missing or stale: a failed load may have left partial cells behind.
+    llama_memory_clear(mem, /*data=*/false);
+    s->kv_tokens.clear();
+    s->cancel       = false;
+    s->cancel_at_ns = 0;
+
+    if (!dai_llm_prefill(s, tokens, (int)llama_n_batch(s->ctx), nullptr)) return DAI_LLM_SNAPSHOT_FAILED;
+    save(s, path);
+
+    LOGI("KV snapshot rebuilt: %zu tokens to %s", tokens.size(), path.c_str());
+    return DAI_LLM_SNAPSHOT_REBUILT;
+}
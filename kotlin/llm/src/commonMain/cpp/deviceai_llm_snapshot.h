@@ -0,0 +1,46 @@
+#ifndef DEVICEAI_LLM_SNAPSHOT_H
+#define DEVICEAI_LLM_SNAPSHOT_H
+
+/**
+ * deviceai_llm_snapshot.h - On-disk KV snapshots of a prompt prefix
+ *
+ * Prefilling a long system prompt dominates time-to-first-token on a cold
+ * start. A snapshot stores the session's sequence state (KV cells + tokens,
+ * via llama_state_seq_save_file) right after that prefix was decoded, in
+ *
+ *     <cache_dir>/<model fingerprint>-<prefix token hash>.kvstate
+ *
+ * Warming a session loads the file instead of decoding the prefix. The
+ * loaded token list must equal the freshly tokenized prefix; a missing,
+ * unreadable or mismatched file (other llama.cpp version, other KV layout,
+ * hash collision) is treated as stale and rebuilt in place.
+ *
+ * The model fingerprint covers the file size and sampled blocks of the GGUF
+ * (header + spread across the weights), so a re-quantised or fine-tuned file
+ * at the same path gets new snapshots without hashing gigabytes.
+ */
+
+#include "deviceai_llm_engine.h"
+
+enum dai_llm_snapshot_status {
+    DAI_LLM_SNAPSHOT_FAILED   = 0,   // nothing restored or built
+    DAI_LLM_SNAPSHOT_RESTORED = 1,   // prefix loaded from disk (or already resident)
+    DAI_LLM_SNAPSHOT_REBUILT  = 2,   // prefix decoded and snapshot (re)written
+};
+
+/**
+ * Make the session's KV cache start with `prefix`, restoring it from
+ * cache_dir when a valid snapshot exists and writing one otherwise.
+ * cache_dir must exist. Only sessions with their own context are supported;
+ * scheduler sessions return DAI_LLM_SNAPSHOT_FAILED.
+ */
+dai_llm_snapshot_status dai_llm_session_warm(
+    dai_llm_session *session,
+    const std::string &prefix,
+    const std::string &cache_dir
+);
+
+/** Fingerprint of a model's weights file (cached on the model). */
+uint64_t dai_llm_model_fingerprint(dai_llm_model *model);
+
+#endif // DEVICEAI_LLM_SNAPSHOT_H
@@ -0,0 +1,257 @@
+/**
+ * deviceai_llm_speculative.cpp - Speculative decoding (draft model, prompt lookup)
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_speculative.h"
+#include "deviceai_llm_context.h"
+#include "deviceai_llm_grammar.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmSpeculative"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+// Same tolerance as llama.cpp's speculative example: families often pad the
+// vocabulary of their larger members with a few unused tokens.
+static const int MAX_VOCAB_SIZE_DIFF = 128;
+
+// ═══════════════════════════════════════════════════════════════
+//                         Helpers
+// ═══════════════════════════════════════════════════════════════
+
+bool dai_llm_draft_compatible(const llama_model *target, const llama_model *draft) {
+    const llama_vocab *vt = llama_model_get_vocab(target);
+    const llama_vocab *vd = llama_model_get_vocab(draft);
+
+    if (llama_vocab_type(vt) != llama_vocab_type(vd)) return false;
+    if (llama_vocab_bos(vt) != llama_vocab_bos(vd))   return false;
+    if (llama_vocab_eos(vt) != llama_vocab_eos(vd))   return false;
+    return std::abs(llama_vocab_n_tokens(vt) - llama_vocab_n_tokens(vd)) <= MAX_VOCAB_SIZE_DIFF;
+}
+
+static void batch_add(llama_batch &batch, llama_token token, llama_pos pos) {
+    const int i = batch.n_tokens;
+    batch.token   [i]    = token;
+    batch.pos     [i]    = pos;
+    batch.n_seq_id[i]    = 1;
+    batch.seq_id  [i][0] = 0;
+    batch.logits  [i]    = true;
+    batch.n_tokens++;
+}
+
+static void reset_draft(dai_llm_session *s) {
+    llama_memory_clear(llama_get_memory(s->draft_ctx), /*data=*/false);
+    s->draft_tokens.clear();
+}
+
+// After a failed draft decode: a cancel only drops the aborted batch's cells.
+static void draft_decode_failed(dai_llm_session *s, int rc) {
+    if (rc != DAI_LLM_DECODE_ABORTED ||
+        !llama_memory_seq_rm(llama_get_memory(s->draft_ctx), 0, (llama_pos)s->draft_tokens.size(), -1)) {
+        reset_draft(s);
+    }
+}
+
+// Bring the draft KV cache in line with the target's (kv_tokens), reusing the
+// longest shared prefix. Returns false if the draft context fails to decode.
+static bool sync_draft(dai_llm_session *s) {
+    const auto &target = s->kv_tokens;
+
+    size_t n_keep = dai_llm_common_prefix(s->draft_tokens, target);
+    if (!llama_memory_seq_rm(llama_get_memory(s->draft_ctx), 0, (llama_pos)n_keep, -1)) {
+        reset_draft(s);
+        n_keep = 0;
+    }
+    s->draft_tokens.resize(n_keep);
+
+    const size_t n_batch = llama_n_batch(s->draft_ctx);
+    for (size_t i = n_keep; i < target.size(); i += n_batch) {
+        const int n = (int)std::min(n_batch, target.size() - i);
+        llama_batch batch = llama_batch_get_one(const_cast<llama_token *>(target.data()) + i, n);
+        if (const int rc = llama_decode(s->draft_ctx, batch)) {
+            draft_decode_failed(s, rc);
+            return false;
+        }
+        s->draft_tokens.insert(s->draft_tokens.end(), target.begin() + i, target.begin() + i + n);
+    }
+    return true;
+}
+
+// Greedy proposals from the draft model following `last` (sampled, not yet
+// decoded anywhere). Never more than n_draft; fewer if the draft fails.
+static std::vector<llama_token> propose_draft(dai_llm_session *s, llama_token last, int n_draft, int n_vocab) {
+    std::vector<llama_token> drafts;
+    if (n_draft <= 0 || !sync_draft(s)) return drafts;
+
+    const int n_vocab_draft = llama_vocab_n_tokens(llama_model_get_vocab(s->model->draft));
+    llama_token cur = last;
+    for (int i = 0; i < n_draft; i++) {
+        llama_batch batch = llama_batch_get_one(&cur, 1);
+        if (const int rc = llama_decode(s->draft_ctx, batch)) {
+            draft_decode_failed(s, rc);
+            break;
+        }
+        s->draft_tokens.push_back(cur);
+
+        const float *logits = llama_get_logits_ith(s->draft_ctx, -1);
+        cur = (llama_token)(std::max_element(logits, logits + n_vocab_draft) - logits);
+        if (cur >= n_vocab) break;   // padding token the target cannot verify
+        drafts.push_back(cur);
+    }
+    return drafts;
+}
+
+std::vector<llama_token> dai_llm_prompt_lookup(const std::vector<llama_token> &history, llama_token last,
+                                               int max_ngram, int n_draft) {
+    // h = history + [last], without copying the history.
+    const size_t len = history.size() + 1;
+    auto h = [&](size_t i) { return i < history.size() ? history[i] : last; };
+
+    std::vector<llama_token> drafts;
+    if (n_draft <= 0) return drafts;
+    for (size_t n = std::min((size_t)std::max(max_ngram, 1), len - 1); n >= 1; n--) {
+        // Latest match first: recent text is the likeliest to be continued.
+        for (size_t start = len - n; start-- > 0;) {
+            size_t k = 0;
+            while (k < n && h(start + k) == h(len - n + k)) k++;
+            if (k < n) continue;
+
+            const size_t end = std::min(start + n + (size_t)n_draft, len);
+            for (size_t i = start + n; i < end; i++) drafts.push_back(h(i));
+            return drafts;
+        }
+    }
+    return drafts;
+}
+
+// Proposals for one round: prompt lookup if enabled, else (or when nothing
+// recurs) the draft model if the session has one.
+static std::vector<llama_token> propose(dai_llm_session *s, const dai_llm_gen_params &params, llama_token last,
+                                        int n_draft, int n_vocab) {
+    std::vector<llama_token> drafts;
+    if (params.prompt_lookup) drafts = dai_llm_prompt_lookup(s->kv_tokens, last, params.lookup_ngram, n_draft);
+    if (drafts.empty() && s->draft_ctx) drafts = propose_draft(s, last, n_draft, n_vocab);
+    return drafts;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                     Speculative loop
+// ═══════════════════════════════════════════════════════════════
+
+std::string dai_llm_speculative_loop(
+    dai_llm_session *s,
+    llama_sampler *sampler,
+    const dai_llm_gen_params &params,
+    const dai_llm_token_cb &on_token,
+    dai_llm_metrics_recorder &rec
+) {
+    const llama_vocab *vocab   = llama_model_get_vocab(s->model->model);
+    const int          n_vocab = llama_vocab_n_tokens(vocab);
+    const int          n_ctx   = (int)llama_n_ctx(s->ctx);
+    llama_memory_t     mem     = llama_get_memory(s->ctx);
+
+    llama_batch batch = llama_batch_init(params.n_draft + 1, 0, 1);
+
+    std::string result;
+    char piece_buf[256];
+    int n_generated = 0;
+
+    // Hand one sampled token to the caller. False when generation should end;
+    // the token is then left out of kv_tokens.
+    auto emit = [&](llama_token token) -> bool {
+        if (token == LLAMA_TOKEN_NULL || llama_vocab_is_eog(vocab, token)) return false;
+
+        int n = llama_token_to_piece(vocab, token, piece_buf, sizeof(piece_buf), 0, true);
+        if (n < 0) return false;
+
+        std::string piece(piece_buf, n);
+        result += piece;
+        n_generated++;
+        rec.emitted();
+
+        if (!on_token(piece)) return false;
+        return n_generated < params.max_tokens && !s->cancel.load();
+    };
+
+    if (params.max_tokens <= 0 || s->cancel.load()) {
+        llama_batch_free(batch);
+        return result;
+    }
+
+    auto t_sample = dai_llm_metrics_recorder::clock::now();
+    llama_token id = dai_llm_sample(sampler, s->ctx, -1);
+    if (id != LLAMA_TOKEN_NULL) llama_sampler_accept(sampler, id);   // else a grammar dead end
+    rec.sampled(t_sample);
+
+    while (emit(id)) {
+        if (!dai_llm_context_make_room(s, params, 1)) break;
+
+        // Leave room in the context for the sampled token and every proposal.
+        const int room    = n_ctx - (int)s->kv_tokens.size() - 1;
+        const int n_draft = std::min(params.n_draft, std::max(0, room));
+        std::vector<llama_token> drafts = propose(s, params, id, n_draft, n_vocab);
+
+        // Verify: the sampled token plus all proposals in one target pass.
+        const llama_pos pos0 = (llama_pos)s->kv_tokens.size();
+        batch.n_tokens = 0;
+        batch_add(batch, id, pos0);
+        for (size_t i = 0; i < drafts.size(); i++) batch_add(batch, drafts[i], pos0 + 1 + (llama_pos)i);
+        rec.kv((size_t)pos0 + batch.n_tokens);
+
+        if (const int rc = llama_decode(s->ctx, batch)) {
+            if (rc == DAI_LLM_DECODE_ABORTED) {
+                dai_llm_kv_rollback(s);
+            } else {
+                llama_memory_clear(mem, /*data=*/false);
+                s->kv_tokens.clear();
+                rec.m.failed = true;
+            }
+            break;
+        }
+        s->kv_tokens.push_back(id);
+
+        // Accept proposals while the target samples the same token.
+        size_t n_accepted = 0;
+        bool   stop       = false;
+        llama_token next  = LLAMA_TOKEN_NULL;
+        for (size_t i = 0; i <= drafts.size(); i++) {
+            t_sample = dai_llm_metrics_recorder::clock::now();
+            next = dai_llm_sample(sampler, s->ctx, (int32_t)i);
+            if (next == LLAMA_TOKEN_NULL) { stop = true; break; }   // grammar dead end
+            llama_sampler_accept(sampler, next);
+            rec.sampled(t_sample);
+            if (i == drafts.size() || next != drafts[i]) break;
+
+            n_accepted++;
+            if (!emit(next)) { stop = true; break; }
+            s->kv_tokens.push_back(next);
+        }
+
+        // Drop the KV cells of rejected (or unreported) proposals.
+        llama_memory_seq_rm(mem, 0, (llama_pos)s->kv_tokens.size(), -1);
+
+        {
+            std::lock_guard<std::mutex> lock(s->stats_mutex);
+            s->spec.n_drafted  += (int64_t)drafts.size();
+            s->spec.n_accepted += (int64_t)n_accepted;
+            s->spec.n_rounds++;
+        }
+
+        if (stop) break;
+        id = next;
+    }
+
+    llama_batch_free(batch);
+    return result;
+}
@@ -0,0 +1,53 @@
+#ifndef DEVICEAI_LLM_SPECULATIVE_H
+#define DEVICEAI_LLM_SPECULATIVE_H
+
+/**
+ * deviceai_llm_speculative.h - Speculative decoding (draft model, prompt lookup)
+ *
+ * Each round up to n_draft tokens are proposed after the last sampled token:
+ * greedily by a draft model or, with prompt lookup, by copying what followed
+ * the latest earlier occurrence of the context's last n-gram (quoted RAG
+ * chunks, rewritten user text). The target model then decodes the sampled
+ * token plus all proposals in one batch and samples every position with the
+ * request's own sampler. Proposals are accepted while they match what the
+ * target sampled; the first mismatch becomes the next sampled token. The
+ * target therefore samples exactly the tokens it would have sampled one at a
+ * time, in the same order (same sampler draws for a fixed seed), so the
+ * output is unchanged — only the number of sequential forward passes drops.
+ *
+ * Rejected tokens are removed from the KV caches; the draft cache is
+ * resynchronised against the session's kv_tokens by longest common prefix.
+ */
+
+#include "deviceai_llm_engine.h"
+#include "deviceai_llm_metrics.h"
+
+/**
+ * Whether draft can speculate for target: same tokenizer type, same special
+ * tokens and (nearly) the same vocabulary size.
+ */
+bool dai_llm_draft_compatible(const llama_model *target, const llama_model *draft);
+
+/**
+ * Up to n_draft tokens that followed the latest earlier occurrence of the last
+ * n tokens of history + [last], trying n = max_ngram down to 1. Empty if no
+ * n-gram recurs.
+ */
+std::vector<llama_token> dai_llm_prompt_lookup(const std::vector<llama_token> &history, llama_token last,
+                                               int max_ngram, int n_draft);
+
+/**
+ * Sampling loop with speculation: prompt lookup when params.prompt_lookup,
+ * the session's draft model otherwise or when lookup finds nothing. Expects
+ * the prompt to be decoded in session->ctx with logits for its last token,
+ * exactly like the plain loop in dai_llm_generate. Returns the generated string.
+ */
+std::string dai_llm_speculative_loop(
+    dai_llm_session *session,
+    llama_sampler *sampler,
+    const dai_llm_gen_params &params,
+    const dai_llm_token_cb &on_token,
+    dai_llm_metrics_recorder &rec
+);
+
+#endif // DEVICEAI_LLM_SPECULATIVE_H
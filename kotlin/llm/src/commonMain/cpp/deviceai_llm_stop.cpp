@@ -0,0 +1,154 @@
+/**
+ * deviceai_llm_stop.cpp - Stop strings and repetition-loop detection
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_stop.h"
+
+#include <algorithm>
+#include <functional>
+
+// ═══════════════════════════════════════════════════════════════
+//                       Automaton build
+// ═══════════════════════════════════════════════════════════════
+
+static int32_t add_state(dai_llm_stop_filter &f, int32_t depth) {
+    const int32_t s = (int32_t)f.match.size();
+    f.next.resize(f.next.size() + 256, -1);
+    f.match.push_back(0);
+    f.depth.push_back(depth);
+    return s;
+}
+
+// Trie of the stop strings, then failure links folded into a full DFA
+// breadth-first: a missing edge takes its failure state's edge, and a state
+// matches whatever its failure state matches.
+static void build_automaton(dai_llm_stop_filter &f, const std::vector<std::string> &stop) {
+    add_state(f, 0);
+    for (const std::string &s : stop) {
+        int32_t state = 0;
+        for (unsigned char c : s) {
+            int32_t &edge = f.next[state * 256 + c];
+            if (edge < 0) {
+                const int32_t child = add_state(f, f.depth[state] + 1);
+                f.next[state * 256 + c] = child;   // add_state may have moved f.next
+                state = child;
+            } else {
+                state = edge;
+            }
+        }
+        f.match[state] = std::max(f.match[state], (int32_t)s.size());
+    }
+
+    std::vector<int32_t> fail(f.match.size(), 0);
+    std::vector<int32_t> queue;
+    for (int c = 0; c < 256; c++) {
+        int32_t &edge = f.next[c];
+        if (edge < 0) edge = 0;
+        else          queue.push_back(edge);
+    }
+    for (size_t i = 0; i < queue.size(); i++) {
+        const int32_t s = queue[i];
+        f.match[s] = std::max(f.match[s], f.match[fail[s]]);
+        for (int c = 0; c < 256; c++) {
+            int32_t &edge = f.next[s * 256 + c];
+            const int32_t via_fail = f.next[fail[s] * 256 + c];
+            if (edge < 0) {
+                edge = via_fail;
+            } else {
+                fail[edge] = via_fail;
+                queue.push_back(edge);
+            }
+        }
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                            Filter
+// ═══════════════════════════════════════════════════════════════
+
+bool dai_llm_stop_init(dai_llm_stop_filter &f, const dai_llm_gen_params &params, dai_llm_token_cb out) {
+    std::vector<std::string> stop;
+    for (const std::string &s : params.stop) {
+        if (!s.empty()) stop.push_back(s);
+    }
+    f.window = params.repeat_stop_tokens >= 2 ? params.repeat_stop_tokens : 0;
+    if (stop.empty() && f.window == 0) return false;
+
+    f.out = std::move(out);
+    if (!stop.empty()) build_automaton(f, stop);
+    if (f.window > 0) {
+        f.recent.assign(f.window, 0);
+        f.runs.assign(f.window / 2 + 1, 0);
+    }
+    return true;
+}
+
+// Hand the first n pending bytes to the caller.
+static bool emit(dai_llm_stop_filter &f, size_t n) {
+    if (n == 0) return true;
+    std::string text = f.pending.substr(0, n);
+    f.pending.erase(0, n);
+    if (!f.out || f.out(text)) return true;
+    // The caller stopped: it keeps what it was given.
+    f.cut_at = (int64_t)(f.fed - f.pending.size());
+    return false;
+}
+
+// True once the last `window` pieces are a cycle of p <= window / 2 pieces
+// repeated: each of the last window - p pieces equals the one p before it.
+static bool repeating(dai_llm_stop_filter &f, const std::string &piece) {
+    const size_t   w = (size_t)f.window;
+    const uint64_t h = std::hash<std::string>()(piece);
+    const size_t   i = f.n_pieces++;
+
+    bool loop = false;
+    for (size_t p = 1; p < f.runs.size(); p++) {
+        const bool same = i >= p && f.recent[(i - p) % w] == h;
+        f.runs[p] = same ? f.runs[p] + 1 : 0;
+        if ((size_t)f.runs[p] >= w - p) loop = true;
+    }
+    f.recent[i % w] = h;
+    return loop;
+}
+
+bool dai_llm_stop_feed(dai_llm_stop_filter &f, const std::string &piece) {
+    if (!f.match.empty()) {
+        for (size_t k = 0; k < piece.size(); k++) {
+            f.state = f.next[f.state * 256 + (unsigned char)piece[k]];
+            const int32_t len = f.match[f.state];
+            if (len == 0) continue;
+
+            // Every byte of the match is still pending: it extended a prefix
+            // of a stop string all along, so none of it was safe to emit.
+            f.pending.append(piece, 0, k + 1);
+            f.fed += k + 1;
+            f.reason = DAI_LLM_STOP_SEQUENCE;
+            emit(f, f.pending.size() - (size_t)len);
+            f.cut_at = (int64_t)(f.fed - (size_t)len);
+            return false;
+        }
+    }
+
+    f.pending += piece;
+    f.fed     += piece.size();
+
+    if (f.window > 0 && repeating(f, piece)) {
+        f.reason = DAI_LLM_STOP_REPETITION;
+        return false;
+    }
+    // Hold back the longest tail that may still become a stop string.
+    const size_t held = f.match.empty() ? 0 : (size_t)f.depth[f.state];
+    return emit(f, f.pending.size() - std::min(held, f.pending.size()));
+}
+
+void dai_llm_stop_finish(dai_llm_stop_filter &f, std::string &result) {
+    if (f.cut_at >= 0) {
+        if ((size_t)f.cut_at < result.size()) result.resize((size_t)f.cut_at);
+        return;
+    }
+    // Generation ended another way; the held-back text was no stop string.
+    if (!f.pending.empty() && f.out) f.out(f.pending);
+    f.pending.clear();
+}
@@ -0,0 +1,77 @@
+#ifndef DEVICEAI_LLM_STOP_H
+#define DEVICEAI_LLM_STOP_H
+
+/**
+ * deviceai_llm_stop.h - Stop strings and repetition-loop detection
+ *
+ * Sits between a decode loop and the caller's token callback, so every loop
+ * (plain, speculative, scheduler, n-best) ends early the same way:
+ *
+ *   stop strings  params.stop is compiled into an Aho-Corasick automaton over
+ *                 bytes: one table lookup per generated byte, whichever token
+ *                 pieces a stop string is split across. Text that could be
+ *                 the start of a stop string is held back from the callback
+ *                 until it cannot; the stop string and anything after it are
+ *                 neither streamed nor returned.
+ *
+ *   repetition    with params.repeat_stop_tokens = W, generation ends once
+ *                 the last W pieces are one cycle of at most W / 2 pieces
+ *                 repeated back to back, the shape of a degenerate loop. A
+ *                 run length per cycle length keeps each piece O(W / 2).
+ *
+ * When both are off the filter is not installed and costs nothing.
+ */
+
+#include "deviceai_llm_engine.h"
+
+#include <cstdint>
+
+enum dai_llm_stop_reason {
+    DAI_LLM_STOP_NONE       = 0,   // EOG, max_tokens, cancel or the caller's callback
+    DAI_LLM_STOP_SEQUENCE   = 1,
+    DAI_LLM_STOP_REPETITION = 2,
+};
+
+// One request's filter state (engine-internal).
+struct dai_llm_stop_filter {
+    dai_llm_token_cb out;   // the caller's callback
+
+    // Aho-Corasick DFA over bytes: next[state * 256 + byte]. match[state] is
+    // the length of the longest stop string ending there (0: none), depth the
+    // length of the stop-string prefix the state stands for.
+    std::vector<int32_t> next;
+    std::vector<int32_t> match;
+    std::vector<int32_t> depth;
+    int32_t              state = 0;
+
+    std::string pending;        // fed but not yet passed to out
+    size_t      fed    = 0;     // bytes fed so far
+    int64_t     cut_at = -1;    // result length to keep once stopped; -1 keeps all
+
+    // Repetition: hashes of the last `window` pieces (a ring) and, per cycle
+    // length p, how many pieces in a row equalled the one p before them.
+    int                   window = 0;
+    std::vector<uint64_t> recent;
+    std::vector<int>      runs;
+    size_t                n_pieces = 0;
+
+    dai_llm_stop_reason reason = DAI_LLM_STOP_NONE;
+};
+
+/**
+ * Set up f for a request. Returns false, leaving out to be called directly,
+ * when params enable neither stop strings nor repetition detection.
+ */
+bool dai_llm_stop_init(dai_llm_stop_filter &f, const dai_llm_gen_params &params, dai_llm_token_cb out);
+
+/** Pass a generated piece through the filter; false ends generation. */
+bool dai_llm_stop_feed(dai_llm_stop_filter &f, const std::string &piece);
+
+/**
+ * After the loop: cut result (the loop's concatenated pieces) back to what
+ * the caller was given, or hand over the text still held back when
+ * generation ended some other way.
+ */
+void dai_llm_stop_finish(dai_llm_stop_filter &f, std::string &result);
+
+#endif // DEVICEAI_LLM_STOP_H
@@ -0,0 +1,57 @@
+/**
+ * deviceai_llm_stream.cpp - Coalesced, UTF-8-safe token streaming
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_stream.h"
+
+#include <algorithm>
+
+static const char REPLACEMENT_CHAR[] = "\xEF\xBF\xBD";   // U+FFFD
+
+size_t dai_llm_utf8_complete(const std::string &s) {
+    const size_t n = s.size();
+    for (size_t i = 1; i <= std::min<size_t>(4, n); i++) {
+        const auto c = (unsigned char)s[n - i];
+        if ((c & 0xC0) == 0x80) continue;   // continuation byte
+
+        const size_t len = c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC0 ? 2 : 1;
+        return len > i ? n - i : n;
+    }
+    // Only continuation bytes: malformed, pass through for the decoder to replace.
+    return n;
+}
+
+static bool flush(dai_llm_stream_batcher &b) {
+    b.n_pending = 0;
+    b.since     = std::chrono::steady_clock::now();
+    if (b.text.empty()) return true;
+
+    bool keep_going = b.on_text(b.text);
+    b.text.clear();
+    return keep_going;
+}
+
+bool dai_llm_stream_push(dai_llm_stream_batcher &b, const std::string &piece) {
+    b.carry += piece;
+    const size_t n = dai_llm_utf8_complete(b.carry);
+    b.text.append(b.carry, 0, n);
+    b.carry.erase(0, n);
+    b.n_pending++;
+
+    if (b.n_pending >= b.max_tokens) return flush(b);
+    if (b.max_ms > 0) {
+        auto elapsed = std::chrono::steady_clock::now() - b.since;
+        if (elapsed >= std::chrono::milliseconds(b.max_ms)) return flush(b);
+    }
+    return true;
+}
+
+bool dai_llm_stream_finish(dai_llm_stream_batcher &b) {
+    if (!b.carry.empty()) {
+        b.text += REPLACEMENT_CHAR;
+        b.carry.clear();
+    }
+    return flush(b);
+}
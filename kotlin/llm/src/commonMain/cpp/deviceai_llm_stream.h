@@ -0,0 +1,46 @@
+#ifndef DEVICEAI_LLM_STREAM_H
+#define DEVICEAI_LLM_STREAM_H
+
+/**
+ * deviceai_llm_stream.h - Coalesced, UTF-8-safe token streaming
+ *
+ * Token pieces are arbitrary byte runs: a multi-byte character can be split
+ * across two tokens, and handing such a piece to the platform as a string
+ * produces garbage. Delivering every piece separately also costs one
+ * platform upcall (JNI / Kotlin-Native bridge) and one string per token.
+ *
+ * A batcher collects pieces, holds back an incomplete trailing character
+ * until the next piece completes it, and hands out text in batches: after
+ * max_tokens pieces or max_ms since the last batch, whichever comes first
+ * (checked whenever a piece arrives). finish() flushes the rest; a character
+ * left incomplete at the end becomes U+FFFD.
+ */
+
+#include "deviceai_llm_engine.h"
+
+#include <chrono>
+
+struct dai_llm_stream_batcher {
+    int max_tokens = 1;   // pieces per batch (<= 1 → every piece)
+    int max_ms     = 0;   // max delay of a batch (<= 0 → no time limit)
+
+    // Receives each batch of complete UTF-8 text. Return false to stop.
+    std::function<bool(const std::string &)> on_text;
+
+    // State
+    std::string carry;      // bytes of an incomplete trailing character
+    std::string text;       // complete text not yet delivered
+    int         n_pending = 0;
+    std::chrono::steady_clock::time_point since = std::chrono::steady_clock::now();
+};
+
+/** Length of the longest prefix of s that does not end inside a UTF-8 character. */
+size_t dai_llm_utf8_complete(const std::string &s);
+
+/** Add one token piece. Returns false once on_text asked to stop. */
+bool dai_llm_stream_push(dai_llm_stream_batcher &batcher, const std::string &piece);
+
+/** Deliver everything still held. Returns false if on_text asked to stop. */
+bool dai_llm_stream_finish(dai_llm_stream_batcher &batcher);
+
+#endif // DEVICEAI_LLM_STREAM_H
@@ -0,0 +1,326 @@
+/**
+ * deviceai_llm_threads.cpp - Runtime thread configuration and auto-tuning
+ *
+ * Shared between the JNI bridge (Android, Desktop) and the iOS C API.
+ */
+
+#include "deviceai_llm_threads.h"
+#include "deviceai_llm_snapshot.h"
+
+#include "ggml-cpu.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef ANDROID
+#include <android/log.h>
+#define LOG_TAG "LlmThreads"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#define LOGI(...) fprintf(stdout, __VA_ARGS__)
+#define LOGE(...) fprintf(stderr, __VA_ARGS__)
+#endif
+
+// ═══════════════════════════════════════════════════════════════
+//                       Configuration
+// ═══════════════════════════════════════════════════════════════
+
+dai_llm_threads dai_llm_threads_from_params(const dai_llm_model_params &params) {
+    dai_llm_threads t;
+    t.n_threads       = std::max(1, params.n_threads);
+    t.n_threads_batch = params.n_threads_batch > 0 ? params.n_threads_batch : t.n_threads;
+    t.cpu_mask        = params.cpu_mask;
+    t.cpu_mask_batch  = params.cpu_mask_batch;
+    t.strict_cpu      = params.strict_cpu;
+    return t;
+}
+
+void dai_llm_set_threads(dai_llm_model *model, const dai_llm_threads &threads) {
+    if (!model) return;
+    dai_llm_threads t = threads;
+    t.n_threads       = std::max(1, t.n_threads);
+    t.n_threads_batch = t.n_threads_batch > 0 ? t.n_threads_batch : t.n_threads;
+
+    std::lock_guard<std::mutex> lock(model->threads_mutex);
+    if (model->threads == t) return;
+    model->threads = t;
+    model->threads_version++;
+    LOGI("LLM threads set: decode=%d batch=%d mask=%" PRIx64 "/%" PRIx64 "%s",
+         t.n_threads, t.n_threads_batch, t.cpu_mask, t.cpu_mask_batch, t.strict_cpu ? " strict" : "");
+}
+
+dai_llm_threads dai_llm_get_threads(dai_llm_model *model) {
+    if (!model) return {};
+    std::lock_guard<std::mutex> lock(model->threads_mutex);
+    return model->threads;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                        Thread pools
+// ═══════════════════════════════════════════════════════════════
+
+static ggml_threadpool_t make_pool(int n_threads, uint64_t mask, bool strict, bool paused) {
+    ggml_threadpool_params tpp = ggml_threadpool_params_default(n_threads);
+    for (int cpu = 0; cpu < 64 && cpu < GGML_MAX_N_THREADS; cpu++) {
+        tpp.cpumask[cpu] = (mask >> cpu) & 1;
+    }
+    tpp.strict_cpu = strict;
+    tpp.paused     = paused;
+    ggml_threadpool_t pool = ggml_threadpool_new(&tpp);
+    if (!pool) LOGE("Failed to create a %d-thread pool for CPU mask %" PRIx64, n_threads, mask);
+    return pool;
+}
+
+void dai_llm_threads_release(dai_llm_ctx_threads &state) {
+    if (state.pool)       ggml_threadpool_free(state.pool);
+    if (state.pool_batch) ggml_threadpool_free(state.pool_batch);
+    state.pool       = nullptr;
+    state.pool_batch = nullptr;
+}
+
+// Pools for t, or none without masks. The decode pool starts paused when a
+// batch pool exists, so the two never spin on the same cores at once.
+static void create_pools(const dai_llm_threads &t, dai_llm_ctx_threads &state) {
+    const uint64_t mask_batch = t.cpu_mask_batch ? t.cpu_mask_batch : t.cpu_mask;
+    if (mask_batch)  state.pool_batch = make_pool(t.n_threads_batch, mask_batch, t.strict_cpu, false);
+    if (t.cpu_mask)  state.pool       = make_pool(t.n_threads, t.cpu_mask, t.strict_cpu, state.pool_batch != nullptr);
+}
+
+static void bind(llama_context *ctx, const dai_llm_threads &t, const dai_llm_ctx_threads &state) {
+    if (!ctx) return;
+    llama_detach_threadpool(ctx);
+    llama_set_n_threads(ctx, t.n_threads, t.n_threads_batch);
+    if (state.pool || state.pool_batch) llama_attach_threadpool(ctx, state.pool, state.pool_batch);
+}
+
+void dai_llm_threads_apply(dai_llm_model *model, dai_llm_ctx_threads &state,
+                           llama_context *ctx, llama_context *draft_ctx) {
+    if (!model || state.version == model->threads_version.load()) return;
+
+    dai_llm_threads t;
+    uint32_t version;
+    {
+        std::lock_guard<std::mutex> lock(model->threads_mutex);
+        t       = model->threads;
+        version = model->threads_version.load();
+    }
+
+    // Detach before freeing: a context must never point at a freed pool.
+    if (ctx)       llama_detach_threadpool(ctx);
+    if (draft_ctx) llama_detach_threadpool(draft_ctx);
+    dai_llm_threads_release(state);
+    create_pools(t, state);
+
+    // Target and draft never decode at the same time, so they share the pools.
+    bind(ctx, t, state);
+    bind(draft_ctx, t, state);
+    state.version = version;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Auto-tune
+// ═══════════════════════════════════════════════════════════════
+
+namespace {
+
+constexpr int TUNE_PROMPT = 128;   // tokens per prefill measurement
+constexpr int TUNE_DECODE = 16;    // single-token steps per decode measurement
+constexpr int TUNE_ROUNDS = 2;     // best of, against scheduling noise
+
+using clock_type = std::chrono::steady_clock;
+
+struct tuner {
+    llama_context           *ctx = nullptr;
+    std::vector<llama_token> tokens;
+    dai_llm_threads          base;
+};
+
+} // namespace
+
+static int popcount(uint64_t v) {
+    int n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+}
+
+// 1-4, then even counts up to 8, then multiples of 4: enough resolution
+// where cluster sizes differ without trying every count on big desktops.
+static std::vector<int> candidates(int max_threads) {
+    std::vector<int> out;
+    for (int n = 1; n <= max_threads; n++) {
+        if (n <= 4 || (n <= 8 && n % 2 == 0) || n % 4 == 0) out.push_back(n);
+    }
+    if (out.back() != max_threads) out.push_back(max_threads);
+    return out;
+}
+
+// Tokens/s of one configuration: a TUNE_PROMPT-token prefill, or (decode)
+// TUNE_DECODE single-token steps after a short prompt.
+static double measure(tuner &tu, int n_threads, bool decode) {
+    dai_llm_threads t = tu.base;
+    if (decode) t.n_threads = n_threads;
+    else        t.n_threads_batch = n_threads;
+
+    dai_llm_ctx_threads state;
+    create_pools(t, state);
+    bind(tu.ctx, t, state);
+
+    llama_memory_t mem = llama_get_memory(tu.ctx);
+    const int n_prompt = decode ? 8 : TUNE_PROMPT;
+    double best = 0;
+    bool   ok   = true;
+    for (int round = 0; round < TUNE_ROUNDS && ok; round++) {
+        llama_memory_clear(mem, /*data=*/false);
+        auto t0 = clock_type::now();
+        ok = llama_decode(tu.ctx, llama_batch_get_one(tu.tokens.data(), n_prompt)) == 0;
+        if (decode) {
+            llama_synchronize(tu.ctx);
+            t0 = clock_type::now();
+            for (int i = 0; ok && i < TUNE_DECODE; i++) {
+                llama_token token = tu.tokens[n_prompt + i];
+                ok = llama_decode(tu.ctx, llama_batch_get_one(&token, 1)) == 0;
+            }
+        }
+        llama_synchronize(tu.ctx);
+        const double s = std::chrono::duration<double>(clock_type::now() - t0).count();
+        if (ok) best = std::max(best, (decode ? TUNE_DECODE : n_prompt) / std::max(s, 1e-9));
+    }
+
+    llama_detach_threadpool(tu.ctx);
+    dai_llm_threads_release(state);
+    return ok ? best : 0;
+}
+
+// Walk the candidates upwards; stop once throughput falls well below the
+// best so far (extra threads landed on slow cores or the memory bus is saturated).
+static int fastest(tuner &tu, int max_threads, bool decode, double &best_tps) {
+    int best_n = 0;
+    best_tps = 0;
+    for (int n : candidates(max_threads)) {
+        const double tps = measure(tu, n, decode);
+        if (tps > best_tps) { best_tps = tps; best_n = n; }
+        else if (tps < best_tps * 0.8) break;
+    }
+    return best_n;
+}
+
+static std::string cache_key(dai_llm_model *model, const dai_llm_threads &t, int hw) {
+    char key[128];
+    snprintf(key, sizeof(key), "%016" PRIx64 "-g%d-c%d-m%" PRIx64 "-b%" PRIx64 "-s%d",
+             dai_llm_model_fingerprint(model), model->n_gpu_layers, hw, t.cpu_mask, t.cpu_mask_batch,
+             t.strict_cpu ? 1 : 0);
+    return key;
+}
+
+// Cache lines: "<key> <n_threads> <n_threads_batch> <decode_tps> <prefill_tps>".
+static bool read_cached(const std::string &path, const std::string &key, dai_llm_thread_tuning &out) {
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string k;
+        dai_llm_thread_tuning r;
+        if (fields >> k >> r.n_threads >> r.n_threads_batch >> r.decode_tps >> r.prefill_tps &&
+            k == key && r.n_threads > 0 && r.n_threads_batch > 0) {
+            out = r;
+            out.cached = true;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void write_cached(const std::string &path, const std::string &key, const dai_llm_thread_tuning &r) {
+    std::string kept;
+    {
+        std::ifstream in(path);
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty() && line.compare(0, key.size() + 1, key + " ") != 0) kept += line + "\n";
+        }
+    }
+    // Write next to the target and rename, as for KV snapshots.
+    const std::string tmp = path + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "w");
+    if (!f) {
+        LOGE("Failed to write thread tuning cache %s", path.c_str());
+        return;
+    }
+    fprintf(f, "%s%s %d %d %.2f %.2f\n", kept.c_str(), key.c_str(), r.n_threads, r.n_threads_batch,
+            r.decode_tps, r.prefill_tps);
+    if (fclose(f) != 0 || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        LOGE("Failed to write thread tuning cache %s", path.c_str());
+        std::remove(tmp.c_str());
+    }
+}
+
+dai_llm_thread_tuning dai_llm_threads_autotune(dai_llm_model *model, const std::string &cache_path) {
+    dai_llm_thread_tuning result;
+    if (!model || !model->model) return result;
+
+    dai_llm_threads t = dai_llm_get_threads(model);
+    const int hw  = (int)std::max(1u, std::thread::hardware_concurrency());
+    const std::string key = cache_key(model, t, hw);
+
+    if (!cache_path.empty() && read_cached(cache_path, key, result)) {
+        t.n_threads       = result.n_threads;
+        t.n_threads_batch = result.n_threads_batch;
+        dai_llm_set_threads(model, t);
+        return result;
+    }
+
+    // A scratch context, so live sessions keep their KV caches.
+    llama_context_params cparams = model->cparams;
+    cparams.n_ctx     = 2 * TUNE_PROMPT;
+    cparams.n_batch   = TUNE_PROMPT;
+    cparams.n_ubatch  = TUNE_PROMPT;
+    cparams.n_seq_max = 1;
+
+    tuner tu;
+    tu.base = t;
+    tu.ctx  = llama_init_from_model(model->model, cparams);
+    if (!tu.ctx) {
+        LOGE("Failed to create thread tuning context");
+        return result;
+    }
+
+    // Ordinary text, repeated to length; content does not affect speed.
+    const llama_vocab *vocab = llama_model_get_vocab(model->model);
+    const auto text = dai_llm_tokenize(vocab, "The quick brown fox jumps over the lazy dog. ", 0, false);
+    for (size_t i = 0; !text.empty() && tu.tokens.size() < (size_t)TUNE_PROMPT; i++) {
+        tu.tokens.push_back(text[i % text.size()]);
+    }
+
+    if (tu.tokens.size() == (size_t)TUNE_PROMPT) {
+        measure(tu, t.n_threads, true);   // warm-up: first-use allocations and page faults
+
+        const int max_decode = t.cpu_mask ? std::min(hw, popcount(t.cpu_mask)) : hw;
+        const uint64_t mask_batch = t.cpu_mask_batch ? t.cpu_mask_batch : t.cpu_mask;
+        const int max_batch  = mask_batch ? std::min(hw, popcount(mask_batch)) : hw;
+
+        result.n_threads       = fastest(tu, max_decode, true,  result.decode_tps);
+        tu.base.n_threads      = result.n_threads > 0 ? result.n_threads : t.n_threads;
+        result.n_threads_batch = fastest(tu, max_batch,  false, result.prefill_tps);
+    }
+    llama_free(tu.ctx);
+
+    if (result.n_threads <= 0 || result.n_threads_batch <= 0) {
+        LOGE("Thread tuning failed");
+        return {};
+    }
+
+    LOGI("LLM threads tuned: decode=%d (%.1f tok/s) batch=%d (%.1f tok/s)",
+         result.n_threads, result.decode_tps, result.n_threads_batch, result.prefill_tps);
+    if (!cache_path.empty()) write_cached(cache_path, key, result);
+
+    t.n_threads       = result.n_threads;
+    t.n_threads_batch = result.n_threads_batch;
+    dai_llm_set_threads(model, t);
+    return result;
+}
@@ -0,0 +1,59 @@
+#ifndef DEVICEAI_LLM_THREADS_H
+#define DEVICEAI_LLM_THREADS_H
+
+/**
+ * deviceai_llm_threads.h - Runtime thread configuration and auto-tuning
+ *
+ * A model's thread counts and CPU masks (dai_llm_threads) can change while
+ * it is loaded. dai_llm_set_threads only records the new configuration; every
+ * context picks it up before its next decode, under the lock that already
+ * serialises its decodes (session mutex, scheduler thread), so nothing is
+ * reconfigured mid-graph.
+ *
+ * With a CPU mask, the context gets its own ggml threadpools whose workers
+ * are pinned to the masked CPUs, e.g. the performance cluster of a
+ * big.LITTLE phone. Without one, llama.cpp's default threads float freely.
+ *
+ * dai_llm_threads_autotune measures decode and prefill throughput over a
+ * range of thread counts on a small scratch context and applies the fastest
+ * of each. The result is cached in a text file keyed by model fingerprint,
+ * GPU offload, core count and masks, so only the first run on a device pays
+ * for the measurement.
+ */
+
+#include "deviceai_llm_engine.h"
+
+struct dai_llm_thread_tuning {
+    int    n_threads       = 0;       // 0 = tuning failed
+    int    n_threads_batch = 0;
+    double decode_tps      = 0;       // throughput measured at the chosen counts
+    double prefill_tps     = 0;
+    bool   cached          = false;   // read from the cache file, nothing measured
+};
+
+/** Model params → the model's initial thread configuration. */
+dai_llm_threads dai_llm_threads_from_params(const dai_llm_model_params &params);
+
+/** Replace the model's thread configuration; contexts apply it before their next decode. */
+void dai_llm_set_threads(dai_llm_model *model, const dai_llm_threads &threads);
+
+dai_llm_threads dai_llm_get_threads(dai_llm_model *model);
+
+/**
+ * Bring a context (and its draft, may be null) up to the model's current
+ * configuration if it changed. Caller holds whatever serialises decodes on them.
+ */
+void dai_llm_threads_apply(dai_llm_model *model, dai_llm_ctx_threads &state,
+                           llama_context *ctx, llama_context *draft_ctx = nullptr);
+
+/** Free the pools of state. Call after the contexts using them are freed. */
+void dai_llm_threads_release(dai_llm_ctx_threads &state);
+
+/**
+ * Pick and apply the fastest decode and prefill thread counts, reading
+ * them from cache_path when a matching entry exists and adding one
+ * otherwise (empty path = always measure, never cache). Keeps the masks.
+ */
+dai_llm_thread_tuning dai_llm_threads_autotune(dai_llm_model *model, const std::string &cache_path);
+
+#endif // DEVICEAI_LLM_THREADS_H
@@ -0,0 +1,148 @@
+/**
+ * test_bm25.cpp - MaxScore search against exhaustive BM25 scoring
+ *
+ * A random corpus with a small vocabulary gives long posting lists (several
+ * skip intervals) and many near ties. Every query's top-k must match scoring
+ * every live document, before and after removals and after a save/load.
+ */
+
+#include "deviceai_llm_bm25.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+struct reference_doc {
+    std::map<std::string, int> tf;
+    int  length = 0;
+    bool live   = true;
+};
+
+// Okapi BM25 as documented in deviceai_llm_bm25.h, over every live document.
+static std::vector<float> reference_top(const std::vector<reference_doc> &docs, const std::vector<std::string> &query,
+                                        int top_k, float k1, float b) {
+    float n = 0, total = 0;
+    for (const auto &d : docs) {
+        if (!d.live) continue;
+        n++;
+        total += (float)d.length;
+    }
+    const float avgdl = total / n;
+
+    std::map<std::string, int> qtf;
+    for (const auto &t : query) qtf[t]++;
+    std::map<std::string, float> idf;
+    for (const auto &q : qtf) {
+        float df = 0;
+        for (const auto &d : docs) df += (d.live && d.tf.count(q.first)) ? 1.0f : 0.0f;
+        idf[q.first] = std::log((n - df + 0.5f) / (df + 0.5f) + 1.0f);
+    }
+
+    std::vector<float> scores;
+    for (const auto &d : docs) {
+        if (!d.live) continue;
+        float score = 0;
+        for (const auto &q : qtf) {
+            auto it = d.tf.find(q.first);
+            if (it == d.tf.end()) continue;
+            const float tf = (float)it->second;
+            score += (float)q.second * idf[q.first] * tf * (k1 + 1.0f) /
+                     (tf + k1 * (1.0f - b + b * (float)d.length / avgdl));
+        }
+        if (score > 0) scores.push_back(score);
+    }
+    std::sort(scores.rbegin(), scores.rend());
+    if ((int)scores.size() > top_k) scores.resize(top_k);
+    return scores;
+}
+
+static void check_queries(dai_llm_bm25 *index, const std::vector<reference_doc> &docs,
+                          const std::vector<std::string> &vocab, std::mt19937 &rng) {
+    std::uniform_int_distribution<size_t> word(0, vocab.size() - 1);
+    for (int q = 0; q < 60; q++) {
+        std::vector<std::string> query;
+        std::string text;
+        const int n_words = 1 + q % 5;
+        for (int i = 0; i < n_words; i++) {
+            query.push_back(vocab[word(rng)]);
+            text += query.back() + " ";
+        }
+        const int top_k = 1 + q % 12;
+
+        auto hits     = dai_llm_bm25_search(index, text, top_k);
+        auto expected = reference_top(docs, query, top_k, 1.5f, 0.75f);
+        CHECK(hits.size() == expected.size());
+        for (size_t i = 0; i < hits.size(); i++) {
+            CHECK(std::fabs(hits[i].score - expected[i]) <= 1e-4f * std::max(1.0f, expected[i]));
+            CHECK(i == 0 || hits[i - 1].score >= hits[i].score);
+        }
+    }
+}
+
+int main() {
+    std::mt19937 rng(42);
+
+    // Zipf-like word frequencies: a few terms in most documents, a long tail in few.
+    std::vector<std::string> vocab;
+    for (int i = 0; i < 200; i++) vocab.push_back("w" + std::to_string(100 + i));
+    std::vector<double> weights;
+    for (int i = 0; i < 200; i++) weights.push_back(1.0 / (i + 1));
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+    std::uniform_int_distribution<int> length(3, 60);
+
+    dai_llm_bm25 *index = dai_llm_bm25_create(1.5f, 0.75f);
+    std::vector<reference_doc> docs;
+    std::vector<dai_llm_bm25_doc> batch;
+    for (int d = 0; d < 3000; d++) {
+        reference_doc ref;
+        dai_llm_bm25_doc doc;
+        const int n = length(rng);
+        for (int i = 0; i < n; i++) {
+            const std::string &w = vocab[pick(rng)];
+            doc.text += w + (i % 7 == 6 ? ". " : " ");
+            ref.tf[w]++;
+        }
+        doc.text += "ab x";   // too short to be terms
+        ref.length = n;
+        docs.push_back(ref);
+        batch.push_back(doc);
+    }
+    std::vector<int64_t> ids = dai_llm_bm25_add(index, batch);
+    CHECK(ids.size() == docs.size());
+    CHECK(dai_llm_bm25_size(index) == docs.size());
+    check_queries(index, docs, vocab, rng);
+
+    // Removals change df, avgdl and the live set.
+    for (size_t d = 0; d < docs.size(); d += 3) {
+        CHECK(dai_llm_bm25_remove(index, ids[d]));
+        docs[d].live = false;
+    }
+    CHECK(!dai_llm_bm25_remove(index, ids[0]));
+    check_queries(index, docs, vocab, rng);
+
+    // A saved index answers the same from its memory map.
+    const std::string path = "test_bm25.idx";
+    CHECK(dai_llm_bm25_save(index, path));
+    dai_llm_bm25 *loaded = dai_llm_bm25_load(path);
+    CHECK(loaded);
+    CHECK(dai_llm_bm25_size(loaded) == dai_llm_bm25_size(index));
+    check_queries(loaded, docs, vocab, rng);
+
+    // Text and sources come back byte for byte, including 4-byte UTF-8.
+    const std::string text = "emoji \xF0\x9F\x98\x80 w100";
+    std::vector<int64_t> added = dai_llm_bm25_add(loaded, {{text, "src", true}});
+    auto hits = dai_llm_bm25_search(loaded, "w100", 5000);
+    auto it = std::find_if(hits.begin(), hits.end(), [&](const dai_llm_bm25_hit &h) { return h.id == added[0]; });
+    CHECK(it != hits.end() && it->text == text && it->has_source && it->source == "src");
+
+    dai_llm_bm25_free(loaded);
+    dai_llm_bm25_free(index);
+    std::remove(path.c_str());
+    puts("test_bm25: OK");
+    return 0;
+}
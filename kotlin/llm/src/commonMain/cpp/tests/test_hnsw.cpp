@@ -0,0 +1,161 @@
+/**
+ * test_hnsw.cpp - HNSW insert/search round trip
+ *
+ * Random unit vectors are inserted in parallel, then every query's top-k is
+ * compared with exhaustive cosine search: each stored vector must find
+ * itself, and recall@10 must stay high, for float and int8 storage, after
+ * removals and after a save/load.
+ */
+
+#include "deviceai_llm_hnsw.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+static const int DIM = 48;
+static const int N   = 3000;
+static const int K   = 10;
+
+static float dot(const float *a, const float *b) {
+    float s = 0;
+    for (int i = 0; i < DIM; i++) s += a[i] * b[i];
+    return s;
+}
+
+static std::vector<int64_t> exact_top(const std::vector<float> &vectors, const std::vector<int64_t> &ids,
+                                      const std::vector<bool> &live, const float *query, int k) {
+    std::vector<std::pair<float, int64_t>> scored;
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (live[i]) scored.push_back({dot(&vectors[i * DIM], query), ids[i]});
+    }
+    std::partial_sort(scored.begin(), scored.begin() + k, scored.end(),
+                      [](const auto &a, const auto &b) { return a.first > b.first; });
+    std::vector<int64_t> out;
+    for (int i = 0; i < k; i++) out.push_back(scored[i].second);
+    return out;
+}
+
+// Self hits and recall@K over a sample of stored vectors and fresh queries.
+static void check_search(dai_llm_hnsw *index, const std::vector<float> &vectors, const std::vector<int64_t> &ids,
+                         const std::vector<bool> &live, bool quantized, std::mt19937 &rng) {
+    std::normal_distribution<float> gauss;
+    size_t found = 0, total = 0, self = 0, n_self = 0;
+    for (int q = 0; q < 200; q++) {
+        std::vector<float> query(DIM);
+        if (q % 2 == 0) {
+            const size_t i = (size_t)q * 7 % ids.size();
+            std::copy(&vectors[i * DIM], &vectors[i * DIM] + DIM, query.begin());
+            if (live[i]) {
+                auto hits = dai_llm_hnsw_search(index, query.data(), 1, 100);
+                n_self++;
+                if (!hits.empty() && hits[0].id == ids[i]) {
+                    self++;
+                    CHECK(std::fabs(hits[0].score - 1.0f) < (quantized ? 2e-2f : 1e-4f));
+                }
+            }
+        } else {
+            float norm = 0;
+            for (float &x : query) {
+                x = gauss(rng);
+                norm += x * x;
+            }
+            for (float &x : query) x /= std::sqrt(norm);
+        }
+
+        auto hits = dai_llm_hnsw_search(index, query.data(), K, 100);
+        CHECK(hits.size() == (size_t)K);
+        std::set<int64_t> expected;
+        for (int64_t id : exact_top(vectors, ids, live, query.data(), K)) expected.insert(id);
+        for (size_t i = 0; i < hits.size(); i++) {
+            CHECK(i == 0 || hits[i - 1].score >= hits[i].score);
+            const size_t pos = std::find(ids.begin(), ids.end(), hits[i].id) - ids.begin();
+            CHECK(pos < ids.size() && live[pos]);
+            CHECK(hits[i].text == "doc " + std::to_string(pos));
+            found += expected.count(hits[i].id);
+        }
+        total += K;
+    }
+    const double recall = (double)found / total;
+    printf("recall@%d %.3f, self %zu/%zu%s\n", K, recall, self, n_self, quantized ? " (int8)" : "");
+    CHECK(recall >= (quantized ? 0.9 : 0.95));
+    CHECK(self >= n_self * 98 / 100);
+}
+
+static void run(bool quantize) {
+    std::mt19937 rng(7);
+    std::normal_distribution<float> gauss;
+
+    // Unnormalised on purpose: insert normalises, and the reference uses the normalised copies.
+    std::vector<float> raw((size_t)N * DIM), vectors((size_t)N * DIM);
+    for (int i = 0; i < N; i++) {
+        float norm = 0;
+        for (int j = 0; j < DIM; j++) {
+            raw[i * DIM + j] = gauss(rng) * 3.0f;
+            norm += raw[i * DIM + j] * raw[i * DIM + j];
+        }
+        for (int j = 0; j < DIM; j++) vectors[i * DIM + j] = raw[i * DIM + j] / std::sqrt(norm);
+    }
+    std::vector<dai_llm_hnsw_doc> docs(N);
+    for (int i = 0; i < N; i++) {
+        docs[i].text = "doc " + std::to_string(i);
+        if (i % 2) docs[i] = {docs[i].text, "src \xF0\x9F\x98\x80", true};
+    }
+
+    dai_llm_hnsw_params params;
+    params.dim       = DIM;
+    params.quantize  = quantize;
+    params.n_threads = 4;
+    dai_llm_hnsw *index = dai_llm_hnsw_create(params);
+    CHECK(index && dai_llm_hnsw_dim(index) == DIM);
+
+    // Two batches, so the second inserts into an existing graph.
+    std::vector<int64_t> ids = dai_llm_hnsw_add(index, raw.data(), {docs.begin(), docs.begin() + N / 3});
+    std::vector<int64_t> more = dai_llm_hnsw_add(index, raw.data() + (size_t)(N / 3) * DIM, {docs.begin() + N / 3, docs.end()});
+    ids.insert(ids.end(), more.begin(), more.end());
+    CHECK(ids.size() == (size_t)N && std::set<int64_t>(ids.begin(), ids.end()).size() == (size_t)N);
+    CHECK(dai_llm_hnsw_size(index) == (size_t)N);
+
+    std::vector<bool> live(N, true);
+    check_search(index, vectors, ids, live, quantize, rng);
+
+    auto hit = dai_llm_hnsw_search(index, &vectors[1 * DIM], 1, 100);
+    CHECK(hit.size() == 1 && hit[0].id == ids[1] && hit[0].has_source && hit[0].source == docs[1].source);
+
+    // Removed vectors stay in the graph for routing but never come back.
+    for (int i = 0; i < N; i += 4) {
+        CHECK(dai_llm_hnsw_remove(index, ids[i]));
+        live[i] = false;
+    }
+    CHECK(!dai_llm_hnsw_remove(index, ids[0]));
+    CHECK(dai_llm_hnsw_size(index) == (size_t)(N - (N + 3) / 4));
+    check_search(index, vectors, ids, live, quantize, rng);
+
+    const std::string path = quantize ? "test_hnsw_q8.idx" : "test_hnsw.idx";
+    CHECK(dai_llm_hnsw_save(index, path));
+    dai_llm_hnsw *loaded = dai_llm_hnsw_load(path);
+    CHECK(loaded && dai_llm_hnsw_size(loaded) == dai_llm_hnsw_size(index));
+    for (int i = 0; i < 50; i++) {
+        auto a = dai_llm_hnsw_search(index, &vectors[i * 11 * DIM], K, 100);
+        auto b = dai_llm_hnsw_search(loaded, &vectors[i * 11 * DIM], K, 100);
+        CHECK(a.size() == b.size());
+        for (size_t j = 0; j < a.size(); j++) CHECK(a[j].id == b[j].id && a[j].text == b[j].text);
+    }
+    check_search(loaded, vectors, ids, live, quantize, rng);
+
+    dai_llm_hnsw_free(loaded);
+    dai_llm_hnsw_free(index);
+    std::remove(path.c_str());
+}
+
+int main() {
+    run(false);
+    run(true);
+    puts("test_hnsw: OK");
+    return 0;
+}
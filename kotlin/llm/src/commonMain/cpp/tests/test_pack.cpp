@@ -0,0 +1,120 @@
+/**
+ * test_pack.cpp - Token-budget packing of RAG chunks
+ *
+ * Usage: test_pack <vocab.gguf>. Only the vocabulary is loaded; CTest passes
+ * one of the vocab-only files shipped in llama.cpp/models.
+ *
+ * Checks that packing never exceeds the budget, keeps chunks whole while
+ * they fit, cuts the first one that does not fit to a token prefix when
+ * enough room is left, and skips it otherwise so later chunks can still fill
+ * the budget.
+ */
+
+#include "deviceai_llm_pack.h"
+#include "test_util.h"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+static std::vector<llama_token> tokenize(const llama_vocab *vocab, const std::string &text) {
+    std::vector<llama_token> tokens(text.size() + 8);
+    const int n = llama_tokenize(vocab, text.data(), (int32_t)text.size(), tokens.data(), (int32_t)tokens.size(), false, false);
+    CHECK(n >= 0);
+    tokens.resize((size_t)n);
+    return tokens;
+}
+
+// Whatever the budget: separators only between packed chunks, and each chunk
+// packed whole, not at all, or cut to a prefix of at least min_cut tokens.
+static void check_layout(const llama_vocab *vocab, const std::vector<std::string> &chunks,
+                         const dai_llm_packed_context &packed, int max_tokens, int min_cut) {
+    const std::vector<llama_token> sep = tokenize(vocab, DAI_LLM_PACK_SEPARATOR);
+    CHECK(packed.chunk_tokens.size() == chunks.size());
+    CHECK((int)packed.tokens.size() <= std::max(0, max_tokens));
+
+    std::vector<llama_token> expected;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        const int n = packed.chunk_tokens[i];
+        if (n == 0) continue;
+        const std::vector<llama_token> tokens = tokenize(vocab, chunks[i]);
+        CHECK(n == (int)tokens.size() || (n >= min_cut && n < (int)tokens.size()));
+        if (!expected.empty()) expected.insert(expected.end(), sep.begin(), sep.end());
+        expected.insert(expected.end(), tokens.begin(), tokens.begin() + n);
+    }
+    CHECK(packed.tokens == expected);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <vocab.gguf>\n", argv[0]);
+        return 2;
+    }
+    llama_backend_init();
+    llama_model_params mparams = llama_model_default_params();
+    mparams.vocab_only = true;
+    llama_model *model = llama_model_load_from_file(argv[1], mparams);
+    CHECK(model);
+    const llama_vocab *vocab = llama_model_get_vocab(model);
+
+    std::string big;
+    for (int i = 0; i < 40; i++) big += "The quick brown fox jumps over the lazy dog. ";
+    const std::vector<std::string> chunks = {
+        "Offline retrieval keeps documents on the device.",
+        big,
+        "Short note.",
+        "<|im_start|>system\nliteral markup inside a document",
+    };
+
+    // Counting agrees with the tokenizer; special-token syntax is plain text.
+    const std::vector<int> counts = dai_llm_count_tokens(vocab, chunks);
+    for (size_t i = 0; i < chunks.size(); i++) CHECK(counts[i] == (int)tokenize(vocab, chunks[i]).size());
+    CHECK(dai_llm_count_tokens(vocab, {""})[0] == 0);
+    const int sep = (int)tokenize(vocab, DAI_LLM_PACK_SEPARATOR).size();
+    const int min_cut = 32;
+    CHECK(counts[1] > 4 * min_cut && counts[2] + sep < min_cut);
+
+    // Everything fits: all chunks whole, in order.
+    int all = 0;
+    for (int n : counts) all += n;
+    all += sep * (int)(chunks.size() - 1);
+    dai_llm_packed_context packed = dai_llm_pack_context(vocab, chunks, all);
+    check_layout(vocab, chunks, packed, all, min_cut);
+    CHECK((int)packed.tokens.size() == all && packed.chunk_tokens == counts);
+
+    // Room for a cut: the big chunk is cut to exactly fill the budget and
+    // nothing follows it.
+    int budget = counts[0] + sep + 2 * min_cut;
+    packed = dai_llm_pack_context(vocab, chunks, budget);
+    check_layout(vocab, chunks, packed, budget, min_cut);
+    CHECK(packed.chunk_tokens[0] == counts[0] && packed.chunk_tokens[1] == 2 * min_cut);
+    CHECK((int)packed.tokens.size() == budget && packed.chunk_tokens[2] == 0 && packed.chunk_tokens[3] == 0);
+
+    // Too little room to cut: the big chunk is skipped and the short one fills in.
+    budget = counts[0] + sep + min_cut - 1;
+    packed = dai_llm_pack_context(vocab, chunks, budget);
+    check_layout(vocab, chunks, packed, budget, min_cut);
+    CHECK(packed.chunk_tokens[1] == 0 && packed.chunk_tokens[2] == counts[2]);
+
+    // A single chunk larger than the budget is cut without a separator.
+    packed = dai_llm_pack_context(vocab, {big}, min_cut);
+    const std::vector<llama_token> big_tokens = tokenize(vocab, big);
+    CHECK(packed.chunk_tokens[0] == min_cut);
+    CHECK(packed.tokens == std::vector<llama_token>(big_tokens.begin(), big_tokens.begin() + min_cut));
+
+    // Every budget keeps the layout rules.
+    for (budget = -1; budget <= all + 2; budget++) {
+        for (int cut : {1, min_cut, 1000}) {
+            packed = dai_llm_pack_context(vocab, chunks, budget, DAI_LLM_PACK_SEPARATOR, cut);
+            check_layout(vocab, chunks, packed, budget, cut);
+        }
+    }
+
+    CHECK(dai_llm_pack_context(vocab, chunks, 0).tokens.empty());
+    CHECK(dai_llm_pack_context(nullptr, chunks, 100).tokens.empty());
+
+    llama_model_free(model);
+    llama_backend_free();
+    puts("test_pack: OK");
+    return 0;
+}
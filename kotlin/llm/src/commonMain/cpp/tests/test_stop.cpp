@@ -0,0 +1,192 @@
+/**
+ * test_stop.cpp - Stop strings and repetition-loop detection
+ *
+ * Feeds random texts over a small alphabet, split into random pieces, through
+ * the filter and compares against a naive scan: generation must end at the
+ * first stop string, even when it is split across pieces, and the caller must
+ * only ever see the text before it. Also checks that a caller which stops
+ * keeps what it was given, and that the repetition window ends a short cycle
+ * of pieces but not a longer one.
+ */
+
+#include "deviceai_llm_stop.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+// Length of text kept by the reference: up to the stop string that ends
+// first (the longest one of those ending at the same byte), or all of it.
+static size_t naive_cut(const std::string &text, const std::vector<std::string> &stop) {
+    for (size_t end = 1; end <= text.size(); end++) {
+        size_t len = 0;
+        for (const std::string &s : stop) {
+            if (!s.empty() && s.size() <= end && text.compare(end - s.size(), s.size(), s) == 0) {
+                len = std::max(len, s.size());
+            }
+        }
+        if (len > 0) return end - len;
+    }
+    return text.size();
+}
+
+struct run_result {
+    std::string streamed;   // what the caller's callback received
+    std::string result;     // the loop's result after dai_llm_stop_finish
+    bool        stopped = false;
+    dai_llm_stop_reason reason = DAI_LLM_STOP_NONE;
+};
+
+// Drive the filter the way a decode loop does: feed until it says stop,
+// then finish with the concatenation of every piece fed.
+static run_result run(const dai_llm_gen_params &params, const std::vector<std::string> &pieces,
+                      size_t caller_limit = SIZE_MAX) {
+    run_result r;
+    dai_llm_stop_filter f;
+    const bool installed = dai_llm_stop_init(f, params, [&r, caller_limit](const std::string &text) {
+        r.streamed += text;
+        return r.streamed.size() < caller_limit;
+    });
+    CHECK(installed);
+
+    for (const std::string &piece : pieces) {
+        r.result += piece;
+        if (!dai_llm_stop_feed(f, piece)) {
+            r.stopped = true;
+            break;
+        }
+    }
+    dai_llm_stop_finish(f, r.result);
+    r.reason = f.reason;
+    return r;
+}
+
+static std::vector<std::string> split(std::mt19937 &rng, const std::string &text) {
+    std::vector<std::string> pieces;
+    std::uniform_int_distribution<size_t> len(1, 4);
+    for (size_t i = 0; i < text.size();) {
+        const size_t n = std::min(len(rng), text.size() - i);
+        pieces.push_back(text.substr(i, n));
+        i += n;
+    }
+    return pieces;
+}
+
+static std::string random_text(std::mt19937 &rng, size_t n) {
+    std::uniform_int_distribution<int> c(0, 2);
+    std::string text;
+    for (size_t i = 0; i < n; i++) text += (char)('a' + c(rng));
+    return text;
+}
+
+static void test_not_installed() {
+    dai_llm_gen_params params;
+    dai_llm_stop_filter f;
+    CHECK(!dai_llm_stop_init(f, params, nullptr));
+
+    params.stop = {""};
+    params.repeat_stop_tokens = 1;
+    CHECK(!dai_llm_stop_init(f, params, nullptr));
+}
+
+static void test_split_stop_string() {
+    dai_llm_gen_params params;
+    params.stop = {"</answer>"};
+
+    const run_result r = run(params, {"The answer is 4", "2.</", "ans", "wer> and then", " more"});
+    CHECK(r.stopped);
+    CHECK(r.reason == DAI_LLM_STOP_SEQUENCE);
+    CHECK(r.streamed == "The answer is 42.");
+    CHECK(r.result == "The answer is 42.");
+
+    // A partial match that falls apart is handed over once it cannot match.
+    const run_result partial = run(params, {"a </ans", "x> b"});
+    CHECK(!partial.stopped);
+    CHECK(partial.reason == DAI_LLM_STOP_NONE);
+    CHECK(partial.streamed == "a </ansx> b");
+    CHECK(partial.result == "a </ansx> b");
+
+    // Held back at the end of generation: not a stop string, so it is released.
+    const run_result tail = run(params, {"ends with </ans"});
+    CHECK(!tail.stopped);
+    CHECK(tail.streamed == "ends with </ans");
+}
+
+static void test_against_naive() {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<size_t> n_stop(1, 4), stop_len(1, 5), text_len(0, 60);
+
+    for (int iter = 0; iter < 20000; iter++) {
+        dai_llm_gen_params params;
+        const size_t k = n_stop(rng);
+        for (size_t i = 0; i < k; i++) params.stop.push_back(random_text(rng, stop_len(rng)));
+
+        const std::string text = random_text(rng, text_len(rng));
+        const size_t      cut  = naive_cut(text, params.stop);
+
+        const run_result r = run(params, split(rng, text));
+        CHECK(r.streamed == text.substr(0, cut));
+        CHECK(r.result == r.streamed);
+        CHECK(r.stopped == (cut < text.size()));
+        CHECK((r.reason == DAI_LLM_STOP_SEQUENCE) == r.stopped);
+    }
+}
+
+static void test_caller_stops() {
+    dai_llm_gen_params params;
+    params.stop = {"zz"};
+
+    // The caller declines after 5 bytes: the result keeps what it was given.
+    const run_result r = run(params, {"abc", "defg", "hij"}, 5);
+    CHECK(r.stopped);
+    CHECK(r.reason == DAI_LLM_STOP_NONE);
+    CHECK(r.streamed == "abcdefg");
+    CHECK(r.result == "abcdefg");
+
+    // Text held back for a possible stop string was never given, nor kept.
+    const run_result held = run(params, {"abc", "dez", "z"}, 4);
+    CHECK(held.stopped);
+    CHECK(held.streamed == "abcde");
+    CHECK(held.result == "abcde");
+}
+
+static void test_repetition() {
+    dai_llm_gen_params params;
+    params.repeat_stop_tokens = 8;
+
+    // A two-piece cycle ends once it fills the window.
+    std::vector<std::string> loop = {"Intro", "."};
+    for (int i = 0; i < 20; i++) loop.push_back(i % 2 ? " yes" : " no");
+    const run_result r = run(params, loop);
+    CHECK(r.stopped);
+    CHECK(r.reason == DAI_LLM_STOP_REPETITION);
+    CHECK(r.result == "Intro. no yes no yes no yes no yes");
+    CHECK(r.streamed == r.result);
+
+    // A cycle longer than half the window is not a loop.
+    std::vector<std::string> words = {" a", " b", " c", " d", " e"};
+    std::vector<std::string> varied;
+    for (int i = 0; i < 40; i++) varied.push_back(words[i % words.size()]);
+    const run_result free_text = run(params, varied);
+    CHECK(!free_text.stopped);
+    CHECK(free_text.reason == DAI_LLM_STOP_NONE);
+
+    // A single piece repeated is a cycle of length 1.
+    const run_result same = run(params, std::vector<std::string>(12, "ha"));
+    CHECK(same.stopped);
+    CHECK(same.result == "hahahahahahahaha");
+}
+
+int main() {
+    test_not_installed();
+    test_split_stop_string();
+    test_against_naive();
+    test_caller_stops();
+    test_repetition();
+    printf("test_stop: OK\n");
+    return 0;
+}
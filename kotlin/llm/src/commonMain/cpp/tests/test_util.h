@@ -0,0 +1,22 @@
+#ifndef DEVICEAI_LLM_TEST_UTIL_H
+#define DEVICEAI_LLM_TEST_UTIL_H
+
+/**
+ * test_util.h - Checks for the native unit tests
+ *
+ * A failed CHECK prints the condition and exits non-zero, whatever NDEBUG is,
+ * so the tests also run against the -O3 release build of the core.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+
+#define CHECK(cond)                                                                   \
+    do {                                                                              \
+        if (!(cond)) {                                                                \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond);  \
+            exit(1);                                                                  \
+        }                                                                             \
+    } while (0)
+
+#endif // DEVICEAI_LLM_TEST_UTIL_H
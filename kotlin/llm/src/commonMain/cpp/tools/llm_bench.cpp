@@ -0,0 +1,509 @@
+/**
+ * llm_bench.cpp - Throughput benchmark for the LLM generation core
+ *
+ * Drives the same dai_llm_* engine as the JNI bridge and the iOS C API, so
+ * builds and GGUF quantizations can be compared on a plain Linux box without
+ * an app around them:
+ *
+ *   llm-bench -m q4_k_m.gguf -m q8_0.gguf -p 128,1024 -n 128 -t 4,8 -kv f16,q8_0 -s 1,4
+ *
+ * Every combination of the list-valued options is one configuration, run
+ * `--repetitions` times after `--warmup` discarded runs. The model is loaded
+ * again for each configuration, since threads, batch sizes and KV types are
+ * fixed at load time.
+ *
+ * Prompts are random vocabulary tokens spliced in as tokens, so their length
+ * is exact and every run prefills from scratch; end-of-generation tokens are
+ * never sampled, so every run generates exactly the requested tokens. With
+ * several sessions, each runs on its own thread and context, or on the
+ * model's continuous-batching scheduler with --scheduler.
+ *
+ * Results (TTFT, prefill and decode tok/s per request, aggregate tok/s per
+ * run, peak RSS per configuration) go to stdout or -o as JSON; progress and
+ * engine logs go to stderr.
+ */
+
+#include "deviceai_llm_engine.h"
+#include "deviceai_llm_metrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+// ═══════════════════════════════════════════════════════════════
+//                          Options
+// ═══════════════════════════════════════════════════════════════
+
+struct bench_options {
+    std::vector<std::string>     models;
+    std::vector<int>             n_prompt      = {512};
+    std::vector<int>             n_gen         = {128};
+    std::vector<int>             threads       = {(int)std::max(1u, std::thread::hardware_concurrency())};
+    std::vector<int>             threads_batch = {0};   // 0 = same as threads
+    std::vector<int>             n_batch       = {512};
+    std::vector<int>             n_ubatch      = {512};
+    std::vector<dai_llm_kv_type> kv_types      = {DAI_LLM_KV_F16};
+    std::vector<int>             flash_attn    = {-1};
+    std::vector<int>             sessions      = {1};
+
+    bool        scheduler   = false;
+    bool        use_gpu     = true;
+    int         n_ctx       = 0;     // 0 = just enough for the workload
+    int         repetitions = 5;
+    int         warmup      = 1;
+    uint32_t    seed        = 42;
+    std::string output;              // empty = stdout
+    bool        verbose     = false;
+};
+
+// One point of the workload matrix.
+struct bench_config {
+    std::string     model;
+    int             n_prompt      = 0;
+    int             n_gen         = 0;
+    int             threads       = 0;
+    int             threads_batch = 0;
+    int             n_batch       = 0;
+    int             n_ubatch      = 0;
+    dai_llm_kv_type kv_type       = DAI_LLM_KV_F16;
+    int             flash_attn    = -1;
+    int             sessions      = 1;
+};
+
+static const char *kv_name(dai_llm_kv_type t) {
+    switch (t) {
+        case DAI_LLM_KV_Q8_0: return "q8_0";
+        case DAI_LLM_KV_Q4_0: return "q4_0";
+        default:              return "f16";
+    }
+}
+
+static bool parse_kv(const std::string &s, dai_llm_kv_type &out) {
+    if (s == "f16")  { out = DAI_LLM_KV_F16;  return true; }
+    if (s == "q8_0") { out = DAI_LLM_KV_Q8_0; return true; }
+    if (s == "q4_0") { out = DAI_LLM_KV_Q4_0; return true; }
+    return false;
+}
+
+static std::vector<std::string> split(const std::string &s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+static bool parse_ints(const std::string &s, std::vector<int> &out, int min_value) {
+    out.clear();
+    for (const auto &item : split(s)) {
+        char *end = nullptr;
+        long v = strtol(item.c_str(), &end, 10);
+        if (*end != '\0' || v < min_value) return false;
+        out.push_back((int)v);
+    }
+    return !out.empty();
+}
+
+static void usage(const char *argv0) {
+    fprintf(stderr,
+        "usage: %s -m MODEL [-m MODEL ...] [options]\n"
+        "\n"
+        "List options take comma-separated values; every combination is benchmarked.\n"
+        "  -p,  --prompt-tokens LIST   prompt lengths in tokens (default 512)\n"
+        "  -n,  --gen-tokens LIST      generated tokens per request (default 128)\n"
+        "  -t,  --threads LIST         CPU threads (default: all cores)\n"
+        "  -tb, --threads-batch LIST   prefill threads, 0 = same as -t (default 0)\n"
+        "  -b,  --batch LIST           tokens per llama_decode call (default 512)\n"
+        "  -ub, --ubatch LIST          physical batch size (default 512)\n"
+        "  -kv, --kv-type LIST         KV cache type: f16, q8_0, q4_0 (default f16)\n"
+        "  -fa, --flash-attn LIST      -1 auto, 0 off, 1 on (default -1)\n"
+        "  -s,  --sessions LIST        concurrent sessions (default 1)\n"
+        "\n"
+        "  --scheduler                 run sessions on one continuous-batching context\n"
+        "  -c,  --ctx N                context size (default: what the workload needs)\n"
+        "  -r,  --repetitions N        measured runs per configuration (default 5)\n"
+        "  -w,  --warmup N             discarded runs per configuration (default 1)\n"
+        "  --no-gpu                    CPU only\n"
+        "  --seed N                    seed of the random prompts (default 42)\n"
+        "  -o,  --output FILE          write JSON to FILE instead of stdout\n"
+        "  -v,  --verbose              keep llama.cpp's log output\n",
+        argv0);
+}
+
+static bool parse_args(int argc, char **argv, bench_options &o) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        auto value = [&](const char *&out) {
+            if (i + 1 >= argc) return false;
+            out = argv[++i];
+            return true;
+        };
+        const char *v = nullptr;
+        bool ok = true;
+
+        if      (arg == "-m"  || arg == "--model")         { ok = value(v); if (ok) o.models.push_back(v); }
+        else if (arg == "-p"  || arg == "--prompt-tokens") { ok = value(v) && parse_ints(v, o.n_prompt, 1); }
+        else if (arg == "-n"  || arg == "--gen-tokens")    { ok = value(v) && parse_ints(v, o.n_gen, 1); }
+        else if (arg == "-t"  || arg == "--threads")       { ok = value(v) && parse_ints(v, o.threads, 1); }
+        else if (arg == "-tb" || arg == "--threads-batch") { ok = value(v) && parse_ints(v, o.threads_batch, 0); }
+        else if (arg == "-b"  || arg == "--batch")         { ok = value(v) && parse_ints(v, o.n_batch, 1); }
+        else if (arg == "-ub" || arg == "--ubatch")        { ok = value(v) && parse_ints(v, o.n_ubatch, 1); }
+        else if (arg == "-fa" || arg == "--flash-attn")    { ok = value(v) && parse_ints(v, o.flash_attn, -1); }
+        else if (arg == "-s"  || arg == "--sessions")      { ok = value(v) && parse_ints(v, o.sessions, 1); }
+        else if (arg == "-kv" || arg == "--kv-type") {
+            ok = value(v);
+            if (ok) {
+                o.kv_types.clear();
+                for (const auto &item : split(v)) {
+                    dai_llm_kv_type t;
+                    if (!parse_kv(item, t)) { ok = false; break; }
+                    o.kv_types.push_back(t);
+                }
+                ok = ok && !o.kv_types.empty();
+            }
+        }
+        else if (arg == "-c"  || arg == "--ctx")         { ok = value(v); if (ok) o.n_ctx = atoi(v); }
+        else if (arg == "-r"  || arg == "--repetitions") { ok = value(v); if (ok) o.repetitions = std::max(1, atoi(v)); }
+        else if (arg == "-w"  || arg == "--warmup")      { ok = value(v); if (ok) o.warmup = std::max(0, atoi(v)); }
+        else if (arg == "--seed")                        { ok = value(v); if (ok) o.seed = (uint32_t)strtoul(v, nullptr, 10); }
+        else if (arg == "-o"  || arg == "--output")      { ok = value(v); if (ok) o.output = v; }
+        else if (arg == "--scheduler")                   { o.scheduler = true; }
+        else if (arg == "--no-gpu")                      { o.use_gpu = false; }
+        else if (arg == "-v"  || arg == "--verbose")     { o.verbose = true; }
+        else if (arg == "-h"  || arg == "--help")        { return false; }
+        else {
+            fprintf(stderr, "unknown argument: %s\n", arg.c_str());
+            return false;
+        }
+        if (!ok) {
+            fprintf(stderr, "invalid value for %s\n", arg.c_str());
+            return false;
+        }
+    }
+    if (o.models.empty()) {
+        fprintf(stderr, "no model given (-m)\n");
+        return false;
+    }
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Helpers
+// ═══════════════════════════════════════════════════════════════
+
+// Peak resident set size since the last reset_peak_rss, in bytes.
+// Linux resets the high-water mark through clear_refs; elsewhere the peak
+// covers the whole process.
+static void reset_peak_rss() {
+    if (FILE *f = fopen("/proc/self/clear_refs", "w")) {
+        fputs("5", f);
+        fclose(f);
+    }
+}
+
+static int64_t peak_rss_bytes() {
+    if (FILE *f = fopen("/proc/self/status", "r")) {
+        char line[256];
+        int64_t kb = -1;
+        while (fgets(line, sizeof(line), f)) {
+            if (sscanf(line, "VmHWM: %lld kB", (long long *)&kb) == 1) break;
+        }
+        fclose(f);
+        if (kb >= 0) return kb * 1024;
+    }
+    struct rusage ru = {};
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    return (int64_t)ru.ru_maxrss;          // bytes
+#else
+    return (int64_t)ru.ru_maxrss * 1024;   // kilobytes
+#endif
+}
+
+// Ordinary vocabulary tokens to draw random prompts from.
+static std::vector<llama_token> prompt_pool(const llama_vocab *vocab) {
+    std::vector<llama_token> pool;
+    const int n_vocab = llama_vocab_n_tokens(vocab);
+    for (llama_token t = 0; t < n_vocab; t++) {
+        if (!llama_vocab_is_control(vocab, t) && !llama_vocab_is_eog(vocab, t)) pool.push_back(t);
+    }
+    return pool;
+}
+
+struct summary {
+    double mean = 0, stddev = 0, min = 0, p50 = 0, p90 = 0, p99 = 0, max = 0;
+};
+
+static summary summarize(std::vector<double> v) {
+    summary s;
+    if (v.empty()) return s;
+    std::sort(v.begin(), v.end());
+    auto rank = [&](double p) { return v[(size_t)std::ceil(p * v.size()) - 1]; };   // nearest rank
+    double sum = 0;
+    for (double x : v) sum += x;
+    s.mean = sum / v.size();
+    double var = 0;
+    for (double x : v) var += (x - s.mean) * (x - s.mean);
+    s.stddev = v.size() > 1 ? std::sqrt(var / (v.size() - 1)) : 0;
+    s.min = v.front();
+    s.p50 = rank(0.50);
+    s.p90 = rank(0.90);
+    s.p99 = rank(0.99);
+    s.max = v.back();
+    return s;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                        JSON output
+// ═══════════════════════════════════════════════════════════════
+
+static std::string json_string(const std::string &s) {
+    std::string out = "\"";
+    for (unsigned char c : s) {
+        switch (c) {
+            case '"':  out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n";  break;
+            case '\t': out += "\\t";  break;
+            default:
+                if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += (char)c;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+static std::string json_summary(const summary &s) {
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+             "{\"mean\": %.3f, \"stddev\": %.3f, \"min\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+             s.mean, s.stddev, s.min, s.p50, s.p90, s.p99, s.max);
+    return buf;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Runner
+// ═══════════════════════════════════════════════════════════════
+
+struct bench_result {
+    bool                ok = false;
+    std::string         model_desc;
+    uint64_t            model_bytes  = 0;
+    uint64_t            model_params = 0;
+    int                 n_ctx        = 0;
+    double              load_ms      = 0;
+    int64_t             peak_rss     = 0;
+    std::vector<double> ttft_ms, prefill_tps, decode_tps, aggregate_tps;
+};
+
+static bench_result run_config(const bench_options &o, const bench_config &c) {
+    bench_result res;
+    const int per_session = c.n_prompt + c.n_gen + 8;   // BOS and some slack
+
+    dai_llm_model_params mp;
+    mp.n_threads       = c.threads;
+    mp.n_threads_batch = c.threads_batch;
+    mp.use_gpu         = o.use_gpu;
+    mp.n_batch         = c.n_batch;
+    mp.n_ubatch        = std::min(c.n_ubatch, c.n_batch);
+    mp.type_k          = c.kv_type;
+    mp.type_v          = c.kv_type;
+    mp.flash_attn      = c.flash_attn;
+    mp.n_parallel      = o.scheduler ? c.sessions : 1;
+    mp.n_ctx           = o.n_ctx > 0 ? o.n_ctx : per_session * (o.scheduler ? c.sessions : 1);
+
+    reset_peak_rss();
+    const auto t_load = std::chrono::steady_clock::now();
+    dai_llm_model *model = dai_llm_model_load(c.model, mp);
+    if (!model) return res;
+    res.load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_load).count();
+
+    char desc[256] = {};
+    llama_model_desc(model->model, desc, sizeof(desc));
+    res.model_desc   = desc;
+    res.model_bytes  = llama_model_size(model->model);
+    res.model_params = llama_model_n_params(model->model);
+    res.n_ctx        = mp.n_ctx;
+
+    std::vector<dai_llm_session *> sessions;
+    for (int i = 0; i < c.sessions; i++) {
+        dai_llm_session *s = dai_llm_session_create(model);
+        if (!s) break;
+        sessions.push_back(s);
+    }
+
+    const std::vector<llama_token> pool = prompt_pool(llama_model_get_vocab(model->model));
+    bool failed = sessions.size() != (size_t)c.sessions || pool.empty();
+
+    for (int run = 0; run < o.warmup + o.repetitions && !failed; run++) {
+        std::vector<dai_llm_gen_metrics> metrics(sessions.size());
+        std::vector<int>                 produced(sessions.size(), 0);
+
+        auto request = [&](size_t i) {
+            // Fresh tokens per run and session: nothing is reused from the KV cache.
+            std::mt19937 rng(o.seed ^ (uint32_t)(run * 7919 + i * 104729));
+            std::uniform_int_distribution<size_t> pick(0, pool.size() - 1);
+
+            dai_llm_gen_params gp;
+            gp.max_tokens    = c.n_gen;
+            gp.ignore_eos    = true;
+            gp.n_draft       = 0;
+            gp.splice_marker = "<prompt>";
+            gp.splice_tokens.resize(c.n_prompt);
+            for (auto &t : gp.splice_tokens) t = pool[pick(rng)];
+
+            dai_llm_generate(sessions[i], gp.splice_marker, gp,
+                             [&](const std::string &) { produced[i]++; return true; },
+                             nullptr, &metrics[i]);
+        };
+
+        const auto t_run = std::chrono::steady_clock::now();
+        if (sessions.size() == 1) {
+            request(0);
+        } else {
+            std::vector<std::thread> workers;
+            for (size_t i = 0; i < sessions.size(); i++) workers.emplace_back(request, i);
+            for (auto &w : workers) w.join();
+        }
+        const double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_run).count();
+
+        int64_t total = 0;
+        for (size_t i = 0; i < sessions.size(); i++) {
+            if (produced[i] != c.n_gen) failed = true;   // decode error or context too small
+            total += produced[i];
+        }
+        if (failed || run < o.warmup) continue;
+
+        for (const auto &m : metrics) {
+            res.ttft_ms.push_back(m.ttft_ms);
+            res.prefill_tps.push_back(m.prefill_tps);
+            res.decode_tps.push_back(m.decode_tps);
+        }
+        res.aggregate_tps.push_back(wall_s > 0 ? total / wall_s : 0);
+    }
+
+    for (auto *s : sessions) dai_llm_session_free(s);
+    dai_llm_model_release(model);
+    res.peak_rss = peak_rss_bytes();
+    res.ok = !failed;
+    return res;
+}
+
+static std::string json_result(const bench_options &o, const bench_config &c, const bench_result &r) {
+    std::ostringstream js;
+    js << "    {\n"
+       << "      \"model\": " << json_string(c.model) << ",\n"
+       << "      \"model_desc\": " << json_string(r.model_desc) << ",\n"
+       << "      \"model_bytes\": " << r.model_bytes << ",\n"
+       << "      \"model_params\": " << r.model_params << ",\n"
+       << "      \"prompt_tokens\": " << c.n_prompt << ",\n"
+       << "      \"gen_tokens\": " << c.n_gen << ",\n"
+       << "      \"threads\": " << c.threads << ",\n"
+       << "      \"threads_batch\": " << (c.threads_batch > 0 ? c.threads_batch : c.threads) << ",\n"
+       << "      \"n_batch\": " << c.n_batch << ",\n"
+       << "      \"n_ubatch\": " << std::min(c.n_ubatch, c.n_batch) << ",\n"
+       << "      \"kv_type\": \"" << kv_name(c.kv_type) << "\",\n"
+       << "      \"flash_attn\": " << c.flash_attn << ",\n"
+       << "      \"sessions\": " << c.sessions << ",\n"
+       << "      \"scheduler\": " << (o.scheduler ? "true" : "false") << ",\n"
+       << "      \"n_ctx\": " << r.n_ctx << ",\n"
+       << "      \"ok\": " << (r.ok ? "true" : "false") << ",\n"
+       << "      \"repetitions\": " << r.aggregate_tps.size() << ",\n"
+       << "      \"load_ms\": " << r.load_ms << ",\n"
+       << "      \"peak_rss_bytes\": " << r.peak_rss << ",\n"
+       << "      \"ttft_ms\": " << json_summary(summarize(r.ttft_ms)) << ",\n"
+       << "      \"prefill_tps\": " << json_summary(summarize(r.prefill_tps)) << ",\n"
+       << "      \"decode_tps\": " << json_summary(summarize(r.decode_tps)) << ",\n"
+       << "      \"aggregate_tps\": " << json_summary(summarize(r.aggregate_tps)) << "\n"
+       << "    }";
+    return js.str();
+}
+
+static void quiet_log(ggml_log_level level, const char *text, void *) {
+    if (level == GGML_LOG_LEVEL_ERROR) fputs(text, stderr);
+}
+
+int main(int argc, char **argv) {
+    bench_options o;
+    if (!parse_args(argc, argv, o)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    // The engine logs to stdout; keep stdout for the JSON only.
+    FILE *out = nullptr;
+    if (o.output.empty()) {
+        out = fdopen(dup(STDOUT_FILENO), "w");
+        dup2(STDERR_FILENO, STDOUT_FILENO);
+    } else {
+        out = fopen(o.output.c_str(), "w");
+    }
+    if (!out) {
+        fprintf(stderr, "cannot open output %s\n", o.output.empty() ? "stdout" : o.output.c_str());
+        return 1;
+    }
+    if (!o.verbose) llama_log_set(quiet_log, nullptr);
+
+    std::vector<bench_config> configs;
+    for (const auto &model : o.models)
+    for (int n_prompt : o.n_prompt)
+    for (int n_gen : o.n_gen)
+    for (int threads : o.threads)
+    for (int threads_batch : o.threads_batch)
+    for (int n_batch : o.n_batch)
+    for (int n_ubatch : o.n_ubatch)
+    for (dai_llm_kv_type kv : o.kv_types)
+    for (int fa : o.flash_attn)
+    for (int sessions : o.sessions) {
+        configs.push_back({ model, n_prompt, n_gen, threads, threads_batch, n_batch, n_ubatch, kv, fa, sessions });
+    }
+
+    char stamp[32];
+    const time_t now = time(nullptr);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    fprintf(out, "{\n  \"timestamp\": \"%s\",\n  \"system_info\": %s,\n  \"results\": [\n",
+            stamp, json_string(llama_print_system_info()).c_str());
+
+    int n_failed = 0;
+    for (size_t i = 0; i < configs.size(); i++) {
+        const bench_config &c = configs[i];
+        fprintf(stderr, "[%zu/%zu] %s pp=%d tg=%d t=%d/%d b=%d ub=%d kv=%s fa=%d s=%d ... ",
+                i + 1, configs.size(), c.model.c_str(), c.n_prompt, c.n_gen, c.threads, c.threads_batch,
+                c.n_batch, c.n_ubatch, kv_name(c.kv_type), c.flash_attn, c.sessions);
+
+        bench_result r = run_config(o, c);
+        if (r.ok) {
+            fprintf(stderr, "ttft p50 %.1f ms, decode p50 %.1f tok/s\n",
+                    summarize(r.ttft_ms).p50, summarize(r.decode_tps).p50);
+        } else {
+            fprintf(stderr, "FAILED\n");
+            n_failed++;
+        }
+        fprintf(out, "%s%s\n", json_result(o, c, r).c_str(), i + 1 < configs.size() ? "," : "");
+        fflush(out);
+    }
+
+    fprintf(out, "  ]\n}\n");
+    fclose(out);
+    return n_failed ? 1 : 0;
+}
@@ -0,0 +1,13 @@
+package dev.deviceai.llm
+
+/**
+ * Streamed text of one candidate of [LlmEngine.generateNStream]. Emissions of
+ * different candidates are interleaved; each ends on a complete character.
+ *
+ * @param index Candidate the text belongs to, 0-based
+ * @param text  Text of one or more tokens
+ */
+data class CandidateText(
+    val index: Int,
+    val text: String,
+)
@@ -55,32 +55,179 @@ class ChatConfig {
      */
     var repeatPenalty: Float = 1.1f
 
+    /**
+     * Prompt tokens evaluated per native decode call. Lower values make
+     * [ChatSession.cancel] respond faster during long (e.g. RAG) prompts.
+     * Default: 0 (the context's batch size).
+     */
+    var prefillChunkSize: Int = 0
+
+    /**
+     * Keep long conversations going inside [contextSize]: once the history no
+     * longer fits, the oldest turns are evicted and the KV cache is shifted in
+     * place, while the system prompt stays pinned. The model forgets the evicted
+     * turns. Default: false (an oversized history fails).
+     */
+    var contextShift: Boolean = false
+
+    /**
+     * Tokens pinned at the start of the context when [contextShift] evicts.
+     * Default: -1 (the system prompt).
+     */
+    var contextKeepTokens: Int = -1
+
+    /**
+     * Tokens coalesced into one [ChatSession.send] emission. Raise (e.g. 4–8)
+     * to cut per-token overhead when rendering fast output. Default: 1.
+     */
+    var streamBatchTokens: Int = 1
+
+    /**
+     * Longest a streamed batch is held back, in milliseconds. Default: 0 (no limit).
+     */
+    var streamBatchMillis: Int = 0
+
     // ── Engine (init-time) ────────────────────────────────────────────────────
 
     /**
-     * Number of CPU threads for inference.
+     * Number of CPU threads for inference (decode only when [batchThreads] is set).
      * Default: 4.
      */
     var threads: Int = 4
 
+    /**
+     * CPU threads for prompt prefill, which is compute-bound and usually scales
+     * to more cores than decoding. Default: 0 (same as [threads]).
+     */
+    var batchThreads: Int = 0
+
+    /**
+     * CPUs the inference threads are pinned to, bit i = CPU i — e.g. the
+     * performance cores of a big.LITTLE phone. Default: 0 (not pinned).
+     */
+    var cpuMask: Long = 0
+
+    /**
+     * File caching auto-tuned thread counts. When set, the first session on a
+     * model and device measures which [threads] and [batchThreads] are fastest
+     * (a few seconds) and stores them; later sessions reuse the result. See
+     * [ChatSession.threadTuning]. Default: null (use [threads] as given).
+     */
+    var threadTuningCache: String? = null
+
     /**
      * Whether to use GPU acceleration — Metal on iOS, Vulkan on Android.
      * Default: true.
      */
     var useGpu: Boolean = true
 
+    /**
+     * Context window in tokens. 0 uses the model's native length, which for
+     * modern models can need gigabytes of KV cache — set e.g. 4096 on phones.
+     * Default: 0.
+     */
+    var contextSize: Int = 0
+
+    /**
+     * Element type of the KV cache (K and V). [KvCacheType.Q8_0] roughly halves
+     * KV memory. Default: [KvCacheType.F16].
+     */
+    var kvCacheType: KvCacheType = KvCacheType.F16
+
+    /** Force flash attention on or off. Default: null (llama.cpp decides). */
+    var flashAttention: Boolean? = null
+
+    /** Pin the model weights in RAM. Default: false. */
+    var useMlock: Boolean = false
+
+    /**
+     * Requests decoded together in one batch across all sessions on this model.
+     * Raise on desktop/server deployments that serve several conversations at once.
+     * Default: 1 (each session has its own context).
+     */
+    var parallelSequences: Int = 1
+
+    /**
+     * Most alternative replies one [ChatSession.sendCandidates] call decodes side
+     * by side. The prompt is prefilled once and shared, but every candidate's
+     * tokens need room in [contextSize]. Default: 1.
+     */
+    var maxCandidates: Int = 1
+
+    /**
+     * Replies one [ChatSession.scoreReplies] call scores in the same forward
+     * pass; more need extra passes. Default: 1 (one pass per reply).
+     */
+    var scoreSequences: Int = 1
+
+    /**
+     * Optional path to a small .gguf of the same model family, used as a draft
+     * model for speculative decoding. Faster decode on CPU; identical output.
+     * Default: null (disabled).
+     */
+    var draftModelPath: String? = null
+
+    /**
+     * Tokens the draft model proposes per step. Check [ChatSession.speculativeStats]
+     * to tune: lower it when the acceptance rate is low. Default: 8.
+     */
+    var draftTokens: Int = 8
+
+    /**
+     * Speculate by copying tokens that follow the latest repeated n-gram in the
+     * prompt or reply, verified like draft-model proposals. No extra model; helps
+     * replies that quote their input (RAG, summaries, code). Default: false.
+     */
+    var promptLookup: Boolean = false
+
+    /**
+     * Directory for on-disk KV snapshots of the system prompt. When set, the
+     * session restores the prefilled system prompt from here at creation
+     * (or prefills and saves it on the first run), so the first reply after
+     * an app restart skips the system-prompt prefill. Must exist and be
+     * writable — e.g. the app's cache directory. Default: null (disabled).
+     */
+    var kvCacheDir: String? = null
+
+    /**
+     * Memory budget in bytes for prompt prefixes shared between sessions on
+     * this model — other [ChatSession]s with the same system prompt skip its
+     * prefill. Check [ChatSession.prefixCacheStats] for the hit rate.
+     * Default: 0 (disabled).
+     */
+    var prefixCacheBytes: Long = 0
+
     // ── Internal helpers ──────────────────────────────────────────────────────
 
     internal fun toInitConfig() = LlmInitConfig(
-        maxThreads = threads,
-        useGpu     = useGpu,
+        maxThreads        = threads,
+        batchThreads      = batchThreads,
+        cpuMask           = cpuMask,
+        useGpu            = useGpu,
+        parallelSequences = parallelSequences,
+        maxCandidates     = maxCandidates,
+        scoreSequences    = scoreSequences,
+        draftModelPath    = draftModelPath,
+        prefixCacheBytes  = prefixCacheBytes,
+        contextSize       = contextSize,
+        kvCacheTypeK      = kvCacheType,
+        kvCacheTypeV      = kvCacheType,
+        flashAttention    = flashAttention,
+        useMlock          = useMlock,
     )
 
     internal fun toGenConfig() = LlmGenConfig(
-        maxTokens     = maxTokens,
-        temperature   = temperature,
-        topP          = topP,
-        topK          = topK,
-        repeatPenalty = repeatPenalty,
+        maxTokens         = maxTokens,
+        temperature       = temperature,
+        topP              = topP,
+        topK              = topK,
+        repeatPenalty     = repeatPenalty,
+        prefillChunkSize  = prefillChunkSize,
+        draftTokens       = draftTokens,
+        promptLookup      = promptLookup,
+        contextShift      = contextShift,
+        contextKeepTokens = contextKeepTokens,
+        streamBatchTokens = streamBatchTokens,
+        streamBatchMillis = streamBatchMillis,
     )
 }
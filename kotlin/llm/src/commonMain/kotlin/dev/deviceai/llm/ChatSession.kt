@@ -31,19 +31,44 @@ import kotlinx.coroutines.flow.onEach
  * session.send("Give me an example.").collect { print(it) }  // remembers context
  * ```
  *
+ * ## Concurrent sessions
+ * Each session owns its own native context and KV cache, so several sessions
+ * can generate at the same time without disturbing each other. Sessions created
+ * on the same model file share one copy of the weights.
+ *
  * ## Lifecycle
  * ```kotlin
  * session.cancel()        // abort in-progress generation
  * session.clearHistory()  // start a fresh conversation, keep the model loaded
- * session.close()         // unload the model and free all resources
+ * session.close()         // free this session; the model unloads with its last session
  * ```
  */
 class ChatSession internal constructor(
     modelPath: String,
     private val config: ChatConfig,
 ) {
+    private val modelHandle: Long = LlmCppBridge.initLlm(modelPath, config.toInitConfig())
+    private val sessionHandle: Long = LlmCppBridge.createSession(modelHandle)
+
     /** `true` if the model loaded successfully and the session is ready for inference. */
-    val isReady: Boolean = LlmCppBridge.initLlm(modelPath, config.toInitConfig())
+    val isReady: Boolean = sessionHandle != 0L
+
+    /**
+     * Thread counts picked by auto-tuning when [ChatConfig.threadTuningCache]
+     * is set, measured on the first run and cached after. Null when tuning is
+     * disabled or failed.
+     */
+    val threadTuning: ThreadTuning? = config.threadTuningCache?.takeIf { isReady }?.let { path ->
+        LlmCppBridge.autotuneThreads(modelHandle, path)
+    }
+
+    /**
+     * How the system prompt's KV state was prepared when [ChatConfig.kvCacheDir]
+     * is set: restored from disk or rebuilt. Null when snapshots are disabled.
+     */
+    val warmStart: KvSnapshotStatus? = config.kvCacheDir?.takeIf { isReady }?.let { dir ->
+        LlmCppBridge.warmPrefix(sessionHandle, listOf(LlmMessage(LlmRole.SYSTEM, config.systemPrompt)), dir)
+    }
 
     private val _history = mutableListOf<LlmMessage>()
 
@@ -94,10 +119,10 @@ class ChatSession internal constructor(
             addAll(_history)
         }
 
-        val genConfig = (overrideConfig ?: config).toGenConfig()
+        val genConfig = (overrideConfig ?: config).toGenConfig().copy(onMetrics = { lastMetrics = it })
         val reply = StringBuilder()
 
-        return LlmCppBridge.generateStream(messages, genConfig)
+        return LlmCppBridge.generateStream(sessionHandle, messages, genConfig)
             .onEach { token -> reply.append(token) }
             .onCompletion { error ->
                 if (error == null) {
@@ -131,9 +156,9 @@ class ChatSession internal constructor(
             addAll(_history)
         }
 
-        val genConfig = (overrideConfig ?: config).toGenConfig()
+        val genConfig = (overrideConfig ?: config).toGenConfig().copy(onMetrics = { lastMetrics = it })
         return try {
-            val result = LlmCppBridge.generate(messages, genConfig)
+            val result = LlmCppBridge.generate(sessionHandle, messages, genConfig)
             _history.add(LlmMessage(LlmRole.ASSISTANT, result.text))
             result.text
         } catch (e: Exception) {
@@ -142,12 +167,172 @@ class ChatSession internal constructor(
         }
     }
 
+    /**
+     * Send a user message and suspend until the full response is available,
+     * without blocking a thread: the request runs on the model's native job
+     * executor. Many concurrent sessions can wait this way on a small dispatcher.
+     *
+     * @param text           The user's message.
+     * @param overrideConfig Per-request config override. Null = use session default.
+     * @param priority       Runs before waiting requests of lower priority on the same model.
+     * @return The complete assistant response; empty (and the user message rolled back)
+     *         if the request was cancelled or failed.
+     */
+    suspend fun sendAsync(text: String, overrideConfig: ChatConfig? = null, priority: Int = 0): String {
+        require(text.isNotBlank()) { "Message text must not be blank" }
+        _history.add(LlmMessage(LlmRole.USER, text))
+
+        val messages = buildList {
+            add(LlmMessage(LlmRole.SYSTEM, config.systemPrompt))
+            addAll(_history)
+        }
+
+        val genConfig = (overrideConfig ?: config).toGenConfig().copy(onMetrics = { lastMetrics = it })
+        val result = try {
+            LlmCppBridge.generateAsync(sessionHandle, messages, genConfig, priority)
+        } catch (e: Exception) {
+            _history.removeLastOrNull() // roll back user message for clean retry
+            throw e
+        }
+        if (result.finishReason != FinishReason.STOP || result.text.isEmpty()) {
+            _history.removeLastOrNull()
+            return ""
+        }
+        _history.add(LlmMessage(LlmRole.ASSISTANT, result.text))
+        return result.text
+    }
+
+    /**
+     * Send a user message and generate up to [count] alternative replies at about
+     * the cost of one, e.g. for suggested responses. The prompt is prefilled once
+     * and the candidates are decoded together; see [ChatConfig.maxCandidates].
+     *
+     * The first candidate is recorded as the assistant reply; pass the one the user
+     * picks to [selectReply].
+     *
+     * @param text           The user's message.
+     * @param count          Candidates wanted.
+     * @param overrideConfig Per-request config override. Null = use session default.
+     * @param seed           Sampling seed for reproducible candidates. Null = random.
+     * @return The candidates; empty (and the user message rolled back) on failure.
+     */
+    fun sendCandidates(
+        text: String, count: Int, overrideConfig: ChatConfig? = null, seed: Int? = null
+    ): List<String> {
+        require(text.isNotBlank()) { "Message text must not be blank" }
+        _history.add(LlmMessage(LlmRole.USER, text))
+
+        val messages = buildList {
+            add(LlmMessage(LlmRole.SYSTEM, config.systemPrompt))
+            addAll(_history)
+        }
+
+        val genConfig = (overrideConfig ?: config).toGenConfig().copy(onMetrics = { lastMetrics = it })
+        val candidates = try {
+            LlmCppBridge.generateN(sessionHandle, messages, count, genConfig, seed).candidates
+        } catch (e: Exception) {
+            _history.removeLastOrNull() // roll back user message for clean retry
+            throw e
+        }
+        if (candidates.isEmpty()) {
+            _history.removeLastOrNull()
+        } else {
+            _history.add(LlmMessage(LlmRole.ASSISTANT, candidates[0]))
+        }
+        return candidates
+    }
+
+    /**
+     * How likely the model finds each of [replies] as the answer to [text], without
+     * generating, e.g. to classify a message against fixed labels or rerank
+     * replies. The history is used but not changed. Up to [ChatConfig.scoreSequences]
+     * replies (or [ChatConfig.maxCandidates] when larger) share one forward pass.
+     *
+     * @return One score per reply, in order; empty on failure.
+     */
+    fun scoreReplies(text: String, replies: List<String>): List<ContinuationScore> {
+        require(text.isNotBlank()) { "Message text must not be blank" }
+        val messages = buildList {
+            add(LlmMessage(LlmRole.SYSTEM, config.systemPrompt))
+            addAll(_history)
+            add(LlmMessage(LlmRole.USER, text))
+        }
+        return LlmCppBridge.scoreContinuations(sessionHandle, messages, replies)
+    }
+
+    /** Replace the last assistant reply, e.g. with the candidate picked from [sendCandidates]. */
+    fun selectReply(reply: String) {
+        val last = _history.lastOrNull()
+        check(last?.role == LlmRole.ASSISTANT) { "No assistant reply to replace" }
+        _history[_history.lastIndex] = LlmMessage(LlmRole.ASSISTANT, reply)
+    }
+
+    /**
+     * Timings of the most recent [send] or [sendBlocking] call: prompt and
+     * generated tokens, time to first token, prefill and decode throughput,
+     * sampling time and peak KV usage. Null before the first request ends.
+     */
+    var lastMetrics: GenerationMetrics? = null
+        private set
+
+    /**
+     * Metrics of every request on the loaded model, shared by all sessions on it,
+     * as histograms for dashboards. Poll with [reset] = true to get one interval at a time.
+     */
+    fun metricsHistogram(reset: Boolean = false): MetricsHistogram =
+        LlmCppBridge.metricsHistogram(modelHandle, reset)
+
+    /**
+     * Speculative-decoding counters for this session (all zero unless
+     * [ChatConfig.draftModelPath] is set). Use [SpeculativeStats.acceptanceRate]
+     * to tune [ChatConfig.draftTokens].
+     */
+    val speculativeStats: SpeculativeStats
+        get() = LlmCppBridge.speculativeStats(sessionHandle)
+
+    /**
+     * Cross-session prefix cache counters of the loaded model, shared by every
+     * session on it (see [ChatConfig.prefixCacheBytes]).
+     */
+    val prefixCacheStats: PrefixCacheStats
+        get() = LlmCppBridge.prefixCacheStats(modelHandle)
+
+    /**
+     * CPU threads of the loaded model, shared by every session on it. Setting
+     * takes effect from the next decode step, without reloading the model —
+     * e.g. fewer threads while the app is in the background.
+     */
+    var threadConfig: ThreadConfig
+        get() = LlmCppBridge.threadConfig(modelHandle)
+        set(value) = LlmCppBridge.setThreads(modelHandle, value)
+
+    /**
+     * Token count of each text under this model's tokenizer, computed natively
+     * in one call without decoding. Use it to size prompts and RAG chunks.
+     */
+    fun countTokens(texts: List<String>): IntArray = LlmCppBridge.countTokens(modelHandle, texts)
+
+    /**
+     * Pack [chunks], best first, into at most [maxTokens] tokens: whole while
+     * they fit, then cut or skipped at a token boundary.
+     * [LlmGenConfig.ragContextTokens] does this automatically for retrieved chunks.
+     */
+    fun packContext(chunks: List<String>, maxTokens: Int): PackedContext =
+        LlmCppBridge.packContext(modelHandle, chunks, maxTokens)
+
     /** Abort any in-progress [send] or [sendBlocking] call. */
-    fun cancel() = LlmCppBridge.cancelGeneration()
+    fun cancel() = LlmCppBridge.cancelGeneration(sessionHandle)
 
     /** Clear conversation history. The model stays loaded and the session remains usable. */
     fun clearHistory() = _history.clear()
 
-    /** Unload the model and release all engine resources. Do not use the session after this. */
-    fun close() = LlmCppBridge.shutdown()
+    /**
+     * Free this session's native context and release its model reference.
+     * The weights are unloaded once no other session uses them.
+     * Do not use the session after this.
+     */
+    fun close() {
+        LlmCppBridge.closeSession(sessionHandle)
+        LlmCppBridge.shutdown(modelHandle)
+    }
 }
@@ -0,0 +1,25 @@
+package dev.deviceai.llm
+
+import kotlin.math.exp
+
+/**
+ * How likely the model finds one candidate continuation of a prompt, from
+ * [LlmEngine.scoreContinuations].
+ *
+ * @param logProbability         Natural-log probability of the whole continuation
+ *                               given the prompt; 0 for an empty continuation
+ * @param tokenLogProbabilities  Log-probability of each of its tokens given the
+ *                               prompt and the tokens before it
+ */
+data class ContinuationScore(
+    val logProbability: Double,
+    val tokenLogProbabilities: List<Float>,
+) {
+    /** [logProbability] per token, to compare continuations of different lengths. */
+    val meanLogProbability: Double
+        get() = if (tokenLogProbabilities.isEmpty()) 0.0 else logProbability / tokenLogProbabilities.size
+
+    /** exp(-[meanLogProbability]); lower is more likely. */
+    val perplexity: Double
+        get() = exp(-meanLogProbability)
+}
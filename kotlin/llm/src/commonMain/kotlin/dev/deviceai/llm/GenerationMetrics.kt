@@ -0,0 +1,76 @@
+package dev.deviceai.llm
+
+/**
+ * Timings and token counts of one generate or stream call, measured natively.
+ *
+ * Use them to tell where a slow request spent its time: a high [ttftMs] with a
+ * low [prefillTokensPerSecond] points at prefill, a low [decodeTokensPerSecond]
+ * at decoding, and a large [sampleMs] share of [decodeMs] at sampling.
+ *
+ * @param promptTokens           Prompt tokens after context fitting
+ * @param cachedTokens           Prompt tokens reused from the KV cache instead of prefilled
+ * @param generatedTokens        Tokens handed to the caller
+ * @param ttftMs                 Call start to first token, queueing and prefill included
+ * @param prefillMs              Time spent prefilling the uncached prompt tokens
+ * @param decodeMs               End of prefill to the last token, sampling included
+ * @param sampleMs               Time spent in the sampler
+ * @param prefillTokensPerSecond Prefilled tokens per second
+ * @param decodeTokensPerSecond  Generated tokens per second
+ * @param kvPeakCells            Most KV cache cells the request's sequence held
+ * @param contextSize            KV cache cells available to the sequence
+ * @param cancelLatencyMs        For cancelled requests, cancel call to the request returning.
+ *                               Cancel interrupts the running forward pass, so this stays
+ *                               small even in the middle of a long prefill. Null otherwise.
+ * @param stoppedBy              What ended generation early, if a stop sequence or the
+ *                               repetition guard of [LlmGenConfig] did. Null otherwise.
+ */
+data class GenerationMetrics(
+    val promptTokens: Int,
+    val cachedTokens: Int,
+    val generatedTokens: Int,
+    val ttftMs: Double,
+    val prefillMs: Double,
+    val decodeMs: Double,
+    val sampleMs: Double,
+    val prefillTokensPerSecond: Double,
+    val decodeTokensPerSecond: Double,
+    val kvPeakCells: Int,
+    val contextSize: Int,
+    val cancelLatencyMs: Double? = null,
+    val stoppedBy: EarlyStop? = null,
+) {
+    /** Peak share of the context the request used, 0..1. */
+    val kvPeakUsage: Double
+        get() = if (contextSize == 0) 0.0 else kvPeakCells.toDouble() / contextSize
+
+    internal companion object {
+        /** Size of the native metrics array (see deviceai_llm_jni.h). */
+        const val FIELDS = 13
+
+        fun fromArray(v: DoubleArray) = GenerationMetrics(
+            promptTokens = v[0].toInt(), cachedTokens = v[1].toInt(), generatedTokens = v[2].toInt(),
+            ttftMs = v[3], prefillMs = v[4], decodeMs = v[5], sampleMs = v[6],
+            prefillTokensPerSecond = v[7], decodeTokensPerSecond = v[8],
+            kvPeakCells = v[9].toInt(), contextSize = v[10].toInt(),
+            cancelLatencyMs = v[11].takeIf { it >= 0 },
+            stoppedBy = EarlyStop.fromNative(v[12].toInt())
+        )
+    }
+}
+
+/** Why generation ended before end-of-sequence or maxTokens; see [GenerationMetrics.stoppedBy]. */
+enum class EarlyStop {
+    /** The output reached one of [LlmGenConfig.stopSequences] */
+    STOP_SEQUENCE,
+    /** The output started repeating itself; see [LlmGenConfig.repetitionStopTokens] */
+    REPETITION;
+
+    internal companion object {
+        /** Native dai_llm_stop_reason; 0 (none) → null. */
+        fun fromNative(code: Int): EarlyStop? = when (code) {
+            1 -> STOP_SEQUENCE
+            2 -> REPETITION
+            else -> null
+        }
+    }
+}
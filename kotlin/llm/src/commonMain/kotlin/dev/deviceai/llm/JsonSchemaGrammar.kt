@@ -0,0 +1,224 @@
+package dev.deviceai.llm
+
+import kotlinx.serialization.SerializationException
+import kotlinx.serialization.json.Json
+import kotlinx.serialization.json.JsonArray
+import kotlinx.serialization.json.JsonElement
+import kotlinx.serialization.json.JsonObject
+import kotlinx.serialization.json.JsonPrimitive
+import kotlinx.serialization.json.booleanOrNull
+import kotlinx.serialization.json.intOrNull
+import kotlinx.serialization.json.jsonArray
+import kotlinx.serialization.json.jsonObject
+import kotlinx.serialization.json.jsonPrimitive
+
+/**
+ * Converts a JSON schema into the GBNF grammar behind [LlmGenConfig.jsonSchema].
+ *
+ * Covers what tool-call schemas use: `object` (`properties` in declared order,
+ * `required`), `array` (`items`, `minItems`, `maxItems`), `string`
+ * (`minLength`, `maxLength`), `number`, `integer`, `boolean`, `null`, `enum`,
+ * `const`, `anyOf` / `oneOf`, type lists and local `$ref`s. Objects with
+ * `properties` admit no other keys; other keywords are ignored, and an empty
+ * schema accepts any JSON value.
+ *
+ * The output depends only on the schema, so repeated requests hit the native
+ * compiled-grammar cache.
+ */
+internal class JsonSchemaGrammar private constructor(private val root: JsonElement) {
+
+    private val rules = LinkedHashMap<String, String>()   // name → body
+    private val byBody = HashMap<String, String>()       // body → name, to share identical rules
+    private val refs = HashMap<String, String>()         // $ref → name
+
+    private fun build(): String {
+        val top = visit(root, "root")
+        if (top != "root") rules["root"] = top
+        return buildString {
+            append("root ::= ").append(rules.getValue("root")).append('\n')
+            for ((name, body) in rules) if (name != "root") append(name).append(" ::= ").append(body).append('\n')
+        }
+    }
+
+    // ── Schemas ──────────────────────────────────────────────────────
+
+    /** A GBNF expression (usually a rule name) matching [schema]. */
+    private fun visit(schema: JsonElement, name: String): String {
+        if (schema is JsonPrimitive && schema.booleanOrNull == true) return primitive("value")
+        val s = schema as? JsonObject ?: unsupported("schema at $name is not an object")
+
+        s["\$ref"]?.let { return ref(it.jsonPrimitive.content) }
+        s["const"]?.let {
+            primitive("ws")
+            return rule(name, "${literal(it.toString())} ws")
+        }
+        s["enum"]?.let { values ->
+            primitive("ws")
+            return rule(name, "(${values.jsonArray.joinToString(" | ") { literal(it.toString()) }}) ws")
+        }
+        (s["anyOf"] ?: s["oneOf"])?.let { alternatives ->
+            return rule(name, alternatives.jsonArray.mapIndexed { i, alt -> visit(alt, "$name-$i") }.joinToString(" | "))
+        }
+
+        return when (val type = s["type"]) {
+            is JsonArray -> rule(name, type.joinToString(" | ") { typed(s, it.jsonPrimitive.content, "$name-${it.jsonPrimitive.content}") })
+            null -> when {
+                "properties" in s -> typed(s, "object", name)
+                "items" in s -> typed(s, "array", name)
+                else -> primitive("value")
+            }
+            else -> typed(s, type.jsonPrimitive.content, name)
+        }
+    }
+
+    private fun typed(s: JsonObject, type: String, name: String): String = when (type) {
+        "object" -> s["properties"]?.let { objectRule(s, it.jsonObject, name) } ?: primitive("object")
+        "array" -> arrayRule(s, name)
+        "string" -> {
+            val min = s["minLength"]?.jsonPrimitive?.intOrNull
+            val max = s["maxLength"]?.jsonPrimitive?.intOrNull
+            if (min == null && max == null) {
+                primitive("string")
+            } else {
+                primitive("char"); primitive("ws")
+                rule(name, """"\"" char{${min ?: 0},${max ?: ""}} "\"" ws""")
+            }
+        }
+        "number", "integer", "boolean", "null" -> primitive(type)
+        else -> unsupported("type \"$type\" at $name")
+    }
+
+    private fun objectRule(s: JsonObject, properties: JsonObject, name: String): String {
+        primitive("ws")
+        val required = s["required"]?.jsonArray?.map { it.jsonPrimitive.content }?.toSet() ?: emptySet()
+        val keys = properties.keys.toList()
+        val kv = keys.map { key ->
+            val value = visit(properties.getValue(key), "$name-$key")
+            rule("$name-$key-kv", "${literal(JsonPrimitive(key).toString())} ws \":\" ws $value")
+        }
+        val n = keys.size
+
+        // Properties in declared order, optional ones skippable: `after(i)`
+        // continues a non-empty object from property i, `first(i)` opens one.
+        fun after(i: Int): String = (i until n).joinToString(" ") { j ->
+            if (keys[j] in required) "\",\" ws ${kv[j]}" else "( \",\" ws ${kv[j]} )?"
+        }
+        fun first(i: Int): String = when {
+            i == n -> ""
+            keys[i] in required -> "${kv[i]} ${after(i + 1)}".trim()
+            else -> {
+                val rest = first(i + 1)
+                val take = "${kv[i]} ${after(i + 1)}".trim()
+                if (rest.isEmpty()) "( $take )?" else "( $take | $rest )"
+            }
+        }
+        val body = first(0)
+        return rule(name, if (body.isEmpty()) "\"{\" ws \"}\" ws" else "\"{\" ws $body \"}\" ws")
+    }
+
+    private fun arrayRule(s: JsonObject, name: String): String {
+        primitive("ws")
+        val item = s["items"]?.let { visit(it, "$name-item") } ?: primitive("value")
+        val min = s["minItems"]?.jsonPrimitive?.intOrNull ?: 0
+        val max = s["maxItems"]?.jsonPrimitive?.intOrNull
+        if (max == 0) return rule(name, "\"[\" ws \"]\" ws")
+
+        val more = if (max == null) {
+            if (min <= 1) "( \",\" ws $item )*" else "( \",\" ws $item ){${min - 1},}"
+        } else {
+            "( \",\" ws $item ){${maxOf(0, min - 1)},${max - 1}}"
+        }
+        val items = if (min == 0) "( $item $more )?" else "$item $more"
+        return rule(name, "\"[\" ws $items \"]\" ws")
+    }
+
+    private fun ref(ref: String): String {
+        refs[ref]?.let { return it }
+        if (!ref.startsWith("#/")) unsupported("\$ref \"$ref\" (only local references)")
+        var target: JsonElement = root
+        for (part in ref.removePrefix("#/").split('/')) {
+            target = (target as? JsonObject)?.get(part.replace("~1", "/").replace("~0", "~"))
+                ?: unsupported("\$ref \"$ref\" does not resolve")
+        }
+        // Named before visiting, so a recursive schema refers back to it.
+        // "root" stays free for the top-level schema.
+        val def = ref.substringAfterLast('/')
+        val name = uniqueName(if (def == "root") "root-ref" else def)
+        refs[ref] = name
+        rules[name] = ""
+        rules[name] = visit(target, "$name-body")
+        return name
+    }
+
+    // ── Rules ────────────────────────────────────────────────────────
+
+    private fun rule(name: String, body: String): String {
+        byBody[body]?.let { return it }
+        val unique = uniqueName(name)
+        rules[unique] = body
+        byBody[body] = unique
+        return unique
+    }
+
+    private fun uniqueName(name: String): String {
+        val base = name.replace(Regex("[^a-zA-Z0-9-]+"), "-")
+        var unique = base
+        var k = 1
+        while (unique in rules || unique in PRIMITIVES) unique = "$base${k++}"
+        return unique
+    }
+
+    /** Adds a built-in rule and the ones it uses; returns its name. */
+    private fun primitive(name: String): String {
+        if (name !in rules) {
+            val (body, deps) = PRIMITIVES.getValue(name)
+            rules[name] = body
+            deps.forEach { primitive(it) }
+        }
+        return name
+    }
+
+    companion object {
+        /** GBNF for [schema] (JSON text); throws [IllegalArgumentException] when it cannot be converted. */
+        fun toGbnf(schema: String): String {
+            val element = try {
+                Json.parseToJsonElement(schema)
+            } catch (e: SerializationException) {
+                throw IllegalArgumentException("jsonSchema is not valid JSON: ${e.message}", e)
+            }
+            return JsonSchemaGrammar(element).build()
+        }
+
+        private fun unsupported(what: String): Nothing =
+            throw IllegalArgumentException("Unsupported JSON schema: $what")
+
+        /** GBNF string literal for [text]. */
+        private fun literal(text: String) = buildString {
+            append('"')
+            for (c in text) when (c) {
+                '"' -> append("\\\"")
+                '\\' -> append("\\\\")
+                '\n' -> append("\\n")
+                '\r' -> append("\\r")
+                '\t' -> append("\\t")
+                else -> append(c)
+            }
+            append('"')
+        }
+
+        // Built-in rules: name → (body, rules it uses). Values end in `ws`.
+        private val PRIMITIVES: Map<String, Pair<String, List<String>>> = mapOf(
+            "ws" to ("""| " " | "\n" [ \t]{0,20}""" to emptyList()),
+            "char" to ("""[^"\\\x7F\x00-\x1F] | [\\] (["\\/bfnrt] | "u" [0-9a-fA-F]{4})""" to emptyList()),
+            "integral-part" to ("""[0] | [1-9] [0-9]{0,15}""" to emptyList()),
+            "string" to (""""\"" char* "\"" ws""" to listOf("char", "ws")),
+            "number" to ("""("-"? integral-part) ("." [0-9]+)? ([eE] [-+]? [0-9]+)? ws""" to listOf("integral-part", "ws")),
+            "integer" to ("""("-"? integral-part) ws""" to listOf("integral-part", "ws")),
+            "boolean" to ("""("true" | "false") ws""" to listOf("ws")),
+            "null" to (""""null" ws""" to listOf("ws")),
+            "object" to (""""{" ws ( string ":" ws value ( "," ws string ":" ws value )* )? "}" ws""" to listOf("string", "value", "ws")),
+            "array" to (""""[" ws ( value ( "," ws value )* )? "]" ws""" to listOf("value", "ws")),
+            "value" to ("""object | array | string | number | boolean | null""" to listOf("object", "array", "string", "number", "boolean", "null")),
+        )
+    }
+}
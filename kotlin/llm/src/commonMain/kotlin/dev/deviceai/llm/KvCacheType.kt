@@ -0,0 +1,14 @@
+package dev.deviceai.llm
+
+/**
+ * Element type of the KV cache (see [LlmInitConfig.kvCacheTypeK]).
+ * Ordinals match the native dai_llm_kv_type codes.
+ */
+enum class KvCacheType {
+    /** 16-bit floats — llama.cpp's default, full precision. */
+    F16,
+    /** 8-bit blocks, ~53% of F16 memory with negligible quality loss. */
+    Q8_0,
+    /** 4-bit blocks, ~28% of F16 memory; noticeable quality loss on small models. */
+    Q4_0,
+}
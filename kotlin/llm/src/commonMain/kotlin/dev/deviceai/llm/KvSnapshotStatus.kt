@@ -0,0 +1,18 @@
+package dev.deviceai.llm
+
+/**
+ * Outcome of warming a session from an on-disk KV snapshot
+ * (see [LlmEngine.warmPrefix]). Ordinals match the native status codes.
+ */
+enum class KvSnapshotStatus {
+    /** Nothing was restored or built (unsupported session, I/O or decode error). */
+    FAILED,
+    /** The prefix's KV state was loaded from disk — no prefill needed. */
+    RESTORED,
+    /** No valid snapshot existed: the prefix was decoded and a new snapshot written. */
+    REBUILT;
+
+    internal companion object {
+        fun fromNative(code: Int): KvSnapshotStatus = entries.getOrElse(code) { FAILED }
+    }
+}
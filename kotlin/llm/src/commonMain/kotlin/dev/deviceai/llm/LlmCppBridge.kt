@@ -10,18 +10,49 @@ expect object LlmCppBridge {
     // ══════════════════════════════════════════════════════════════
 
     /**
-     * Initialize the LLM engine with a GGUF model file.
+     * Load a GGUF model file, sharing the weights if it is already loaded.
      *
      * @param modelPath Absolute path to .gguf model file
      * @param config Engine initialization parameters
-     * @return true if initialization succeeded
+     * @return Model handle, or 0 if loading failed
      */
-    fun initLlm(modelPath: String, config: LlmInitConfig = LlmInitConfig()): Boolean
+    fun initLlm(modelPath: String, config: LlmInitConfig = LlmInitConfig()): Long
 
     /**
-     * Release all LLM resources and unload the model.
+     * Estimate the memory of [initLlm] plus [sessions] sessions from the model's
+     * GGUF metadata, without loading weights.
+     *
+     * @return The estimate, or null if the metadata could not be read
+     */
+    fun estimateMemory(modelPath: String, config: LlmInitConfig = LlmInitConfig(), sessions: Int = 1): MemoryEstimate?
+
+    /**
+     * Release one reference to the model. Weights are unloaded with the last one.
+     */
+    fun shutdown(model: Long)
+
+    // ══════════════════════════════════════════════════════════════
+    //                        SESSIONS
+    // ══════════════════════════════════════════════════════════════
+
+    /**
+     * Create a session with its own context, KV cache and cancel flag.
+     *
+     * @param model Handle returned by [initLlm]
+     * @return Session handle, or 0 on failure
+     */
+    fun createSession(model: Long): Long
+
+    /**
+     * Free a session. Does not release the model.
+     */
+    fun closeSession(session: Long)
+
+    /**
+     * Restore (or build and save) the KV state of a conversation prefix
+     * from a snapshot file in [cacheDir].
      */
-    fun shutdown()
+    fun warmPrefix(session: Long, messages: List<LlmMessage>, cacheDir: String): KvSnapshotStatus
 
     // ══════════════════════════════════════════════════════════════
     //                        GENERATION
@@ -30,24 +61,111 @@ expect object LlmCppBridge {
     /**
      * Generate a response for the given conversation (blocking).
      *
+     * @param session Session handle returned by [createSession]
      * @param messages Conversation history including the new user message
      * @param config Per-request generation parameters
      * @return [LlmResult] with generated text and metadata
      */
-    fun generate(messages: List<LlmMessage>, config: LlmGenConfig = LlmGenConfig()): LlmResult
+    fun generate(session: Long, messages: List<LlmMessage>, config: LlmGenConfig = LlmGenConfig()): LlmResult
+
+    /**
+     * [generate] as a job on the model's native executor; suspends instead of
+     * blocking the calling thread. See [LlmEngine.generateAsync].
+     */
+    suspend fun generateAsync(
+        session: Long, messages: List<LlmMessage>, config: LlmGenConfig = LlmGenConfig(), priority: Int = 0
+    ): LlmResult
 
     /**
-     * Stream a response token-by-token.
-     * Each emission is one llama token piece.
+     * Stream a response token-by-token, or in batches of tokens
+     * ([LlmGenConfig.streamBatchTokens]). Emissions always end on a complete character.
      *
+     * @param session Session handle returned by [createSession]
      * @param messages Conversation history including the new user message
      * @param config Per-request generation parameters
      * @return [Flow] of token strings in generation order
      */
-    fun generateStream(messages: List<LlmMessage>, config: LlmGenConfig = LlmGenConfig()): Flow<String>
+    fun generateStream(session: Long, messages: List<LlmMessage>, config: LlmGenConfig = LlmGenConfig()): Flow<String>
+
+    /**
+     * Generate up to [count] alternative responses from one prompt prefill,
+     * decoded together in one batch. Candidate i samples with [seed] + i.
+     */
+    fun generateN(
+        session: Long, messages: List<LlmMessage>, count: Int,
+        config: LlmGenConfig = LlmGenConfig(), seed: Int? = null
+    ): NBestResult
+
+    /**
+     * Stream [generateN]: text of all candidates, interleaved, tagged with its index.
+     */
+    fun generateNStream(
+        session: Long, messages: List<LlmMessage>, count: Int,
+        config: LlmGenConfig = LlmGenConfig(), seed: Int? = null
+    ): Flow<CandidateText>
+
+    /**
+     * Log-probability of each continuation after the conversation, teacher-forced
+     * in one batch after a single prefill. Empty on failure.
+     */
+    fun scoreContinuations(session: Long, messages: List<LlmMessage>, continuations: List<String>): List<ContinuationScore>
+
+    /**
+     * Cancel an in-progress generation on the given session. The running forward
+     * pass is interrupted, so this takes effect mid-prefill too; the request's
+     * [GenerationMetrics.cancelLatencyMs] shows how long it took.
+     */
+    fun cancelGeneration(session: Long)
+
+    /**
+     * Speculative-decoding counters accumulated by the session.
+     */
+    fun speculativeStats(session: Long): SpeculativeStats
+
+    /**
+     * Prefix cache counters of the model.
+     */
+    fun prefixCacheStats(model: Long): PrefixCacheStats
+
+    /**
+     * Metrics of the requests finished on the model since it was loaded, or
+     * since the last call with [reset] = true.
+     */
+    fun metricsHistogram(model: Long, reset: Boolean): MetricsHistogram
+
+    // ══════════════════════════════════════════════════════════════
+    //                        THREADS
+    // ══════════════════════════════════════════════════════════════
+
+    /**
+     * Change the model's thread counts and CPU masks without reloading it.
+     */
+    fun setThreads(model: Long, config: ThreadConfig)
+
+    /**
+     * Current thread configuration of the model.
+     */
+    fun threadConfig(model: Long): ThreadConfig
+
+    /**
+     * Pick and apply the fastest decode and prefill thread counts, cached in [cachePath].
+     */
+    fun autotuneThreads(model: Long, cachePath: String?): ThreadTuning?
+
+    // ══════════════════════════════════════════════════════════════
+    //                        TOKENIZER
+    // ══════════════════════════════════════════════════════════════
+
+    /**
+     * Count the tokens of each text with the model's tokenizer, without
+     * decoding anything. BOS/EOS are not counted.
+     */
+    fun countTokens(model: Long, texts: List<String>): IntArray
 
     /**
-     * Cancel an in-progress generation.
+     * Pack [chunks], best first, into [maxTokens] tokens: chunks that fit are
+     * taken whole, a chunk that does not is cut at a token boundary if enough
+     * room is left, otherwise skipped.
      */
-    fun cancelGeneration()
+    fun packContext(model: Long, chunks: List<String>, maxTokens: Int): PackedContext
 }
@@ -5,40 +5,177 @@ import kotlinx.coroutines.flow.Flow
 /**
  * Abstraction over the native LLM inference backend.
  * Callers depend on this interface rather than concrete implementations (DIP).
+ *
+ * The engine is handle-based: [init] returns a model handle shared by every
+ * session created on it, and each session owns its own context, KV cache and
+ * cancel flag. A handle value of `0` means the call failed.
  */
 interface LlmEngine {
 
     /**
-     * Initialize the LLM engine with a GGUF model file.
+     * Load a GGUF model file. Loading the same file again returns the already
+     * loaded weights with an extra reference instead of a second copy.
      *
      * @param modelPath Absolute path to .gguf model file
      * @param config Engine initialization parameters
-     * @return true if initialization succeeded
+     * @return Model handle, or 0 if loading failed
      */
-    fun init(modelPath: String, config: LlmInitConfig = LlmInitConfig()): Boolean
+    fun init(modelPath: String, config: LlmInitConfig = LlmInitConfig()): Long
 
-    /** Release all LLM resources and unload the model. */
-    fun shutdown()
+    /**
+     * Estimate the memory [init] with [config] plus [sessions] sessions would use,
+     * reading only the model's GGUF metadata. Use it to pick [LlmInitConfig.contextSize]
+     * and KV cache types per device class before loading.
+     *
+     * @return The estimate, or null if the model metadata could not be read
+     */
+    fun estimateMemory(modelPath: String, config: LlmInitConfig = LlmInitConfig(), sessions: Int = 1): MemoryEstimate?
+
+    /** Release one reference to [model]. Weights are unloaded with the last one. */
+    fun shutdown(model: Long)
+
+    /**
+     * Create an independent session on a loaded model.
+     *
+     * @param model Handle returned by [init]
+     * @return Session handle, or 0 if the context could not be created
+     */
+    fun createSession(model: Long): Long
+
+    /** Free a session's context and KV cache. Does not release the model. */
+    fun closeSession(session: Long)
+
+    /**
+     * Load the KV state of a conversation prefix (typically just the system
+     * message) from [cacheDir], or decode it and save a snapshot there. The
+     * next [generate] on [session] then only prefills what follows the prefix.
+     *
+     * Snapshots are keyed by model fingerprint and prefix tokens; stale or
+     * corrupt ones are rebuilt automatically.
+     *
+     * @param session Session handle returned by [createSession]
+     * @param messages Prefix messages, rendered without the assistant header
+     * @param cacheDir Existing, writable directory for snapshot files
+     */
+    fun warmPrefix(session: Long, messages: List<LlmMessage>, cacheDir: String): KvSnapshotStatus
 
     /**
      * Generate a response for the given conversation (blocking).
      *
+     * @param session Session handle returned by [createSession]
      * @param messages Conversation history including the new user message
      * @param config Per-request generation parameters
      * @return [LlmResult] with generated text and metadata
      */
-    fun generate(messages: List<LlmMessage>, config: LlmGenConfig = LlmGenConfig()): LlmResult
+    fun generate(session: Long, messages: List<LlmMessage>, config: LlmGenConfig = LlmGenConfig()): LlmResult
+
+    /**
+     * [generate] without blocking a thread: the request is queued on the model's
+     * native executor and the caller suspends until it finishes. Higher [priority]
+     * jobs run first; when [LlmInitConfig.jobQueueDepth] jobs are already waiting,
+     * the call suspends until one finishes. Cancelling the coroutine cancels the
+     * job. [LlmGenConfig.onPrefillProgress] is not called.
+     *
+     * @return [LlmResult]; [FinishReason.CANCELLED] if the job was cancelled natively
+     *         (e.g. by [cancelGeneration]), [FinishReason.ERROR] if it could not run
+     */
+    suspend fun generateAsync(
+        session: Long, messages: List<LlmMessage>, config: LlmGenConfig = LlmGenConfig(), priority: Int = 0
+    ): LlmResult
 
     /**
      * Stream a response token-by-token.
-     * Each emission is one llama token piece. Collect with [kotlinx.coroutines.flow.onEach].
+     * Each emission is the text of one token — or of several, coalesced per
+     * [LlmGenConfig.streamBatchTokens] / [LlmGenConfig.streamBatchMillis] — and always
+     * ends on a complete UTF-8 character. Collect with [kotlinx.coroutines.flow.onEach].
      *
+     * @param session Session handle returned by [createSession]
      * @param messages Conversation history including the new user message
      * @param config Per-request generation parameters
      * @return [Flow] of token strings in generation order
      */
-    fun generateStream(messages: List<LlmMessage>, config: LlmGenConfig = LlmGenConfig()): Flow<String>
+    fun generateStream(session: Long, messages: List<LlmMessage>, config: LlmGenConfig = LlmGenConfig()): Flow<String>
+
+    /**
+     * Generate up to [count] alternative responses (e.g. suggested replies) at
+     * about the cost of one: the prompt is prefilled once and all candidates
+     * are decoded together in one batch, each with its own sampler.
+     *
+     * @param session Session handle returned by [createSession]
+     * @param messages Conversation history including the new user message
+     * @param count Candidates wanted; capped by [LlmInitConfig.maxCandidates]
+     *        (or [LlmInitConfig.parallelSequences] on a batching model)
+     * @param config Per-request generation parameters; speculation and context
+     *        shifting do not apply
+     * @param seed Sampling seed; candidate i uses seed + i. Null falls back to
+     *        [LlmGenConfig.seed], then to random seeds.
+     */
+    fun generateN(
+        session: Long, messages: List<LlmMessage>, count: Int,
+        config: LlmGenConfig = LlmGenConfig(), seed: Int? = null
+    ): NBestResult
 
-    /** Cancel an in-progress generation. */
-    fun cancelGeneration()
+    /**
+     * [generateN] streamed: emissions of all candidates interleaved as they are
+     * decoded, coalesced per candidate like [generateStream].
+     */
+    fun generateNStream(
+        session: Long, messages: List<LlmMessage>, count: Int,
+        config: LlmGenConfig = LlmGenConfig(), seed: Int? = null
+    ): Flow<CandidateText>
+
+    /**
+     * Score fixed [continuations] of the conversation instead of generating,
+     * e.g. to pick an intent label or rerank replies: the prompt is prefilled
+     * once and every continuation is teacher-forced in the same batch, up to
+     * [LlmInitConfig.scoreSequences] (or [LlmInitConfig.maxCandidates] when
+     * larger) at a time. Continuations are tokenized as plain text.
+     *
+     * @param session Session handle returned by [createSession]; a session on
+     *        a batching model ([LlmInitConfig.parallelSequences] > 1) cannot score
+     * @param messages Conversation history; the continuations follow the
+     *        assistant turn it opens
+     * @return One score per continuation, in order; empty on failure or cancel
+     */
+    fun scoreContinuations(session: Long, messages: List<LlmMessage>, continuations: List<String>): List<ContinuationScore>
+
+    /** Cancel an in-progress generation on [session]. */
+    fun cancelGeneration(session: Long)
+
+    /** Speculative-decoding counters for [session]. Safe to call during generation. */
+    fun speculativeStats(session: Long): SpeculativeStats
+
+    /** Cross-session prefix cache counters for [model]. Safe to call during generation. */
+    fun prefixCacheStats(model: Long): PrefixCacheStats
+
+    /** Aggregated request metrics of [model]; [reset] clears them after reading. */
+    fun metricsHistogram(model: Long, reset: Boolean): MetricsHistogram
+
+    /**
+     * Change [model]'s thread counts and CPU masks without reloading. Every
+     * session on it applies them before its next decode step.
+     */
+    fun setThreads(model: Long, config: ThreadConfig)
+
+    /** Current thread configuration of [model]. */
+    fun threadConfig(model: Long): ThreadConfig
+
+    /**
+     * Measure decode and prefill throughput over a range of thread counts and
+     * apply the fastest of each, keeping the CPU masks. Takes a few seconds,
+     * so results are cached in [cachePath] per model, device and masks; later
+     * calls with a cached result only apply it. Null [cachePath] always measures.
+     *
+     * @return The chosen counts, or null if the measurement failed
+     */
+    fun autotuneThreads(model: Long, cachePath: String?): ThreadTuning?
+
+    /** Token count of each text under [model]'s tokenizer, without BOS/EOS. */
+    fun countTokens(model: Long, texts: List<String>): IntArray
+
+    /**
+     * Pack [chunks], best first, into [maxTokens] tokens of [model]'s tokenizer:
+     * whole while they fit, then cut or skipped at a token boundary.
+     */
+    fun packContext(model: Long, chunks: List<String>, maxTokens: Int): PackedContext
 }
@@ -11,6 +11,57 @@ import dev.deviceai.llm.rag.RagRetriever
  * @param topP               Nucleus sampling probability threshold (default 0.9)
  * @param topK               Top-K sampling limit (default 40)
  * @param repeatPenalty      Penalty for repeating tokens (default 1.1)
+ * @param seed               Sampling seed, for repeatable output at a given prompt and
+ *                           config; null draws a random one. Candidate i of an n-best
+ *                           call samples with seed + i (default null).
+ * @param prefillChunkSize   Prompt tokens evaluated per native decode call. Smaller
+ *                           chunks let [LlmEngine.cancelGeneration] and progress updates
+ *                           land sooner on long prompts at some throughput cost.
+ *                           0 uses the context's batch size (default 0).
+ * @param onPrefillProgress  Called between prefill chunks with prompt tokens processed
+ *                           so far (including cached prefix tokens) and the prompt total.
+ *                           Runs on the generating thread. Default null.
+ * @param draftTokens        Tokens the draft model proposes per verification pass when the
+ *                           model was loaded with [LlmInitConfig.draftModelPath], or the
+ *                           most [promptLookup] copies. Tune with [SpeculativeStats];
+ *                           0 disables speculation (default 8).
+ * @param promptLookup       Speculate without a draft model: the last few tokens are looked
+ *                           up earlier in the prompt and output, and the tokens that followed
+ *                           them are verified in one pass. Pays off when replies quote their
+ *                           input — RAG answers, summaries, code edits. Output is unchanged;
+ *                           a draft model, if loaded, covers steps with no match (default false).
+ * @param contextShift       Keep the conversation going once it outgrows the context:
+ *                           the oldest tokens after the pinned ones are evicted and the
+ *                           KV cache is shifted in place, so only new messages are
+ *                           prefilled. Without it, an oversized history fails (default false).
+ * @param contextKeepTokens  Tokens pinned at the start of the context when shifting;
+ *                           -1 pins the leading system messages (default -1).
+ * @param stopSequences      Strings that end generation, e.g. a template's turn marker or
+ *                           `</answer>`. Matched natively as tokens are generated, even
+ *                           when split across tokens; the stop string and anything after
+ *                           it are neither streamed nor returned. Streamed text that could
+ *                           be the start of one is held back until it is not (default none).
+ * @param repetitionStopTokens End generation once this many trailing tokens are a short
+ *                           cycle repeated back to back — a degenerate loop — instead of
+ *                           running to [maxTokens]. 32 suits most chat; 0 disables (default 0).
+ * @param grammar            GBNF grammar (root rule `root`) the output must match, e.g. for
+ *                           tool calls. Enforced while sampling, so the output is valid by
+ *                           construction rather than checked and retried. Compiled grammars
+ *                           are cached natively, so repeating one costs no parse. A grammar
+ *                           that does not parse yields no output (default null).
+ * @param jsonSchema         JSON schema (as JSON text) the output must satisfy; converted to a
+ *                           [grammar] covering the common keywords — properties, required,
+ *                           items, enum, const, anyOf and local refs. Throws
+ *                           [IllegalArgumentException] on a schema it cannot convert.
+ *                           Set at most one of [grammar] and [jsonSchema] (default null).
+ * @param streamBatchTokens  Tokens coalesced into one streamed emission. Fewer emissions
+ *                           mean less native-bridge and Flow overhead at high token rates
+ *                           (default 1: every token).
+ * @param streamBatchMillis  Longest a streamed batch is held back, so slow generation
+ *                           still updates the UI promptly; 0 = no time limit (default 0).
+ * @param onMetrics          Called once per request with its [GenerationMetrics], when
+ *                           generation ends. Streams have no result object, so this is
+ *                           how they report metrics; [LlmResult.metrics] has the same data.
  * @param ragStore           Optional retriever for offline RAG. When set, the SDK
  *                           retrieves relevant chunks and injects them into the system
  *                           prompt before every generation call. Default null (disabled).
@@ -18,6 +69,11 @@ import dev.deviceai.llm.rag.RagRetriever
  * @param ragPromptTemplate  System prompt template for injected context. Must contain
  *                           the placeholder `{context}` which is replaced with the
  *                           retrieved chunks separated by `---`. (default: see below)
+ * @param ragContextTokens   Token budget for the injected chunks; 0 = no budget (default).
+ *                           When set, the best-scoring chunks are packed natively with the
+ *                           model's tokenizer: whole while they fit, then cut or skipped at
+ *                           a token boundary. The packed tokens are decoded as they are,
+ *                           so the context is never tokenized twice.
  */
 data class LlmGenConfig(
     val maxTokens: Int = 512,
@@ -25,15 +81,52 @@ data class LlmGenConfig(
     val topP: Float = 0.9f,
     val topK: Int = 40,
     val repeatPenalty: Float = 1.1f,
+    val seed: Int? = null,
+
+    // ── Prefill ──────────────────────────────────────────────────────
+    val prefillChunkSize: Int = 0,
+    val onPrefillProgress: ((processed: Int, total: Int) -> Unit)? = null,
+
+    // ── Speculative decoding ─────────────────────────────────────────
+    val draftTokens: Int = 8,
+    val promptLookup: Boolean = false,
+
+    // ── Context ──────────────────────────────────────────────────────
+    val contextShift: Boolean = false,
+    val contextKeepTokens: Int = -1,
+
+    // ── Early stops ──────────────────────────────────────────────────
+    val stopSequences: List<String> = emptyList(),
+    val repetitionStopTokens: Int = 0,
+
+    // ── Structured output ────────────────────────────────────────────
+    val grammar: String? = null,
+    val jsonSchema: String? = null,
+
+    // ── Streaming ────────────────────────────────────────────────────
+    val streamBatchTokens: Int = 1,
+    val streamBatchMillis: Int = 0,
+
+    // ── Metrics ──────────────────────────────────────────────────────
+    val onMetrics: ((GenerationMetrics) -> Unit)? = null,
 
     // ── RAG ──────────────────────────────────────────────────────────
     val ragStore: RagRetriever? = null,
     val ragTopK: Int = 3,
     val ragPromptTemplate: String = DEFAULT_RAG_TEMPLATE,
+    val ragContextTokens: Int = 0,
 ) {
+    init {
+        require(grammar == null || jsonSchema == null) { "Set grammar or jsonSchema, not both" }
+    }
+
     companion object {
         const val DEFAULT_RAG_TEMPLATE = """Use the following context to answer the question:
 
 {context}"""
     }
 }
+
+/** The GBNF the native sampler enforces: [LlmGenConfig.grammar], or the converted schema. */
+internal fun LlmGenConfig.nativeGrammar(): String? =
+    grammar ?: jsonSchema?.let { JsonSchemaGrammar.toGbnf(it) }
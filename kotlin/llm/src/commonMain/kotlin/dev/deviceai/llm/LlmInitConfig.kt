@@ -3,13 +3,83 @@ package dev.deviceai.llm
 /**
  * Configuration for LLM engine initialization.
  *
- * Context window size is intentionally omitted — llama.cpp reads it directly
- * from the model's GGUF metadata and uses the model's native context length.
+ * The defaults keep llama.cpp's behaviour: the model's native context length
+ * from its GGUF metadata and an F16 KV cache. For models with 32k-128k native
+ * contexts that is gigabytes of KV memory; on phones set [contextSize] and a
+ * quantized KV cache, sized with [LlmEngine.estimateMemory].
  *
- * @param maxThreads CPU threads for inference (default 4)
+ * @param maxThreads CPU threads for inference; with [batchThreads] set, for decode only (default 4)
  * @param useGpu Use GPU acceleration — Metal on iOS, Vulkan on Android (default true)
+ * @param parallelSequences Number of requests decoded together in one batch (default 1).
+ *        With 1, every session gets its own context. With N > 1, a native
+ *        continuous-batching scheduler shares one context between all sessions on
+ *        the model, so up to N concurrent requests run in the same forward pass.
+ *        The context window is split evenly between the N sequences. Only the first
+ *        load of a model file decides this value.
+ * @param draftModelPath Optional path to a small .gguf from the same model family
+ *        (e.g. the 0.5B sibling) used for speculative decoding. The draft proposes
+ *        [LlmGenConfig.draftTokens] tokens that the main model verifies in a single
+ *        forward pass; output is identical to normal decoding. Requires
+ *        [parallelSequences] = 1 and a compatible tokenizer. Default null (off).
+ * @param prefixCacheBytes Memory budget for prompt prefixes (system prompt, RAG
+ *        preamble, few-shot examples) shared between sessions on this model.
+ *        A new prompt starting with a cached prefix skips prefilling it; the least
+ *        recently used prefixes are dropped beyond the budget. With
+ *        [parallelSequences] > 1, sessions already share one KV cache and reuse
+ *        each other's prefixes without this budget. Default 0 (off).
+ * @param contextSize Context window in tokens. 0 uses the model's native length (default).
+ *        With [parallelSequences] > 1 it is shared by all sequences.
+ * @param batchSize Max prompt tokens per decode call; 0 keeps llama.cpp's default (2048).
+ * @param microBatchSize Physical batch size, which bounds the compute buffer;
+ *        0 keeps llama.cpp's default (512).
+ * @param kvCacheTypeK Element type of the K cache (default [KvCacheType.F16]).
+ * @param kvCacheTypeV Element type of the V cache (default [KvCacheType.F16]).
+ *        Quantized types require flash attention; with [flashAttention] = false
+ *        the V cache stays F16.
+ * @param flashAttention Force flash attention on or off; null lets llama.cpp
+ *        decide per backend (default).
+ * @param useMmap Map the weights file instead of reading it into memory (default true).
+ * @param useMlock Pin the weights in RAM so they are never paged out (default false).
+ * @param batchThreads CPU threads for prompt prefill; 0 uses [maxThreads] (default).
+ * @param cpuMask CPUs the decode threads are pinned to, bit i = CPU i; 0 leaves them
+ *        unpinned (default). See [ThreadConfig]; change at runtime with [LlmEngine.setThreads].
+ * @param batchCpuMask CPUs for the prefill threads; 0 uses [cpuMask] (default).
+ * @param strictCpu Pin each thread to its own CPU of the mask (default false).
+ * @param maxCandidates Most completions one [LlmEngine.generateN] call decodes side by
+ *        side on a session with its own context (default 1). The KV cache of such
+ *        sessions is unified so the candidates share the prompt's cells; size
+ *        [contextSize] for the prompt plus every candidate's tokens. With [parallelSequences] > 1 the
+ *        scheduler's sequences are used instead.
+ * @param scoreSequences Continuations one [LlmEngine.scoreContinuations] pass decodes
+ *        side by side on a session with its own context; 1 scores them one decode
+ *        each (default). Above 1 the KV cache is unified like for [maxCandidates];
+ *        the larger of the two applies to both.
+ * @param jobWorkers Native threads running [LlmEngine.generateAsync] jobs on this model;
+ *        0 uses one per [parallelSequences] (default), so batched models keep every
+ *        sequence busy. Jobs on the same session always run one at a time.
+ * @param jobQueueDepth Most async jobs waiting to run on this model (default 16). Further
+ *        submits suspend until a job finishes.
  */
 data class LlmInitConfig(
     val maxThreads: Int = 4,
     val useGpu: Boolean = true,
+    val parallelSequences: Int = 1,
+    val draftModelPath: String? = null,
+    val prefixCacheBytes: Long = 0,
+    val contextSize: Int = 0,
+    val batchSize: Int = 0,
+    val microBatchSize: Int = 0,
+    val kvCacheTypeK: KvCacheType = KvCacheType.F16,
+    val kvCacheTypeV: KvCacheType = KvCacheType.F16,
+    val flashAttention: Boolean? = null,
+    val useMmap: Boolean = true,
+    val useMlock: Boolean = false,
+    val batchThreads: Int = 0,
+    val cpuMask: Long = 0,
+    val batchCpuMask: Long = 0,
+    val strictCpu: Boolean = false,
+    val maxCandidates: Int = 1,
+    val scoreSequences: Int = 1,
+    val jobWorkers: Int = 0,
+    val jobQueueDepth: Int = 16,
 )
@@ -8,13 +8,15 @@ package dev.deviceai.llm
  * @param promptTokenCount Number of tokens in the input prompt
  * @param finishReason Why generation stopped
  * @param generationTimeMs Wall-clock time for generation in milliseconds
+ * @param metrics Native timings of the request (prefill, decode, sampling, KV usage)
  */
 data class LlmResult(
     val text: String,
     val tokenCount: Int,
     val promptTokenCount: Int,
     val finishReason: FinishReason,
-    val generationTimeMs: Long
+    val generationTimeMs: Long,
+    val metrics: GenerationMetrics? = null,
 )
 
 enum class FinishReason {
@@ -0,0 +1,19 @@
+package dev.deviceai.llm
+
+/**
+ * Estimated memory for loading a model with a given [LlmInitConfig]
+ * (see [LlmEngine.estimateMemory]). Sizes are in bytes.
+ *
+ * @param contextSize   Effective context window per context, in tokens
+ * @param weightsBytes  Model files (plus the draft model, if any)
+ * @param kvCacheBytes  KV caches of all contexts
+ * @param computeBytes  Scratch buffers of all contexts
+ * @param totalBytes    Sum of the above
+ */
+data class MemoryEstimate(
+    val contextSize: Int,
+    val weightsBytes: Long,
+    val kvCacheBytes: Long,
+    val computeBytes: Long,
+    val totalBytes: Long,
+)
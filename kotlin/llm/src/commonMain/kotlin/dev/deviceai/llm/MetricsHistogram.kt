@@ -0,0 +1,67 @@
+package dev.deviceai.llm
+
+/**
+ * Metrics of every request finished on a model, aggregated for dashboards.
+ *
+ * Each histogram has [BUCKETS] buckets: bucket `i` counts requests whose value
+ * was below `2^i` (bucket 0: below 1), the last one everything larger.
+ * Requests that produced no token are left out of [ttftMs] and [decodeTokensPerSecond];
+ * fully cached prompts are left out of [prefillTokensPerSecond]. [cancelLatencyMs]
+ * counts cancelled requests only.
+ *
+ * @param requests              Requests that reached prefill
+ * @param promptTokens          Prompt tokens over all requests
+ * @param cachedTokens          Prompt tokens reused from the KV cache
+ * @param generatedTokens       Tokens generated over all requests
+ * @param ttftMs                Time to first token, in milliseconds
+ * @param prefillTokensPerSecond Prefill throughput
+ * @param decodeTokensPerSecond  Decode throughput
+ * @param cancelLatencyMs       Cancel call to the request returning, in milliseconds
+ */
+class MetricsHistogram(
+    val requests: Long,
+    val promptTokens: Long,
+    val cachedTokens: Long,
+    val generatedTokens: Long,
+    val ttftMs: LongArray,
+    val prefillTokensPerSecond: LongArray,
+    val decodeTokensPerSecond: LongArray,
+    val cancelLatencyMs: LongArray,
+) {
+    companion object {
+        const val BUCKETS = 20
+
+        /** Exclusive upper bound of [bucket]; infinite for the last one. */
+        fun upperBound(bucket: Int): Double =
+            if (bucket >= BUCKETS - 1) Double.POSITIVE_INFINITY else (1L shl bucket).toDouble()
+
+        /**
+         * Upper bound of the bucket holding the [p]-th percentile (0..1) of
+         * [histogram], e.g. `percentile(h.ttftMs, 0.95)`. 0 when empty.
+         */
+        fun percentile(histogram: LongArray, p: Double): Double {
+            val total = histogram.sum()
+            if (total == 0L) return 0.0
+            val rank = (p.coerceIn(0.0, 1.0) * total).toLong().coerceAtLeast(1)
+            var seen = 0L
+            histogram.forEachIndexed { i, n ->
+                seen += n
+                if (seen >= rank) return upperBound(i)
+            }
+            return upperBound(BUCKETS - 1)
+        }
+
+        internal val EMPTY = MetricsHistogram(
+            0, 0, 0, 0, LongArray(BUCKETS), LongArray(BUCKETS), LongArray(BUCKETS), LongArray(BUCKETS)
+        )
+
+        /** Parse the native layout (see deviceai_llm_jni.h). */
+        internal fun fromArray(v: LongArray) = MetricsHistogram(
+            requests = v[0], promptTokens = v[1], cachedTokens = v[2], generatedTokens = v[3],
+            ttftMs = v.copyOfRange(4, 4 + BUCKETS),
+            prefillTokensPerSecond = v.copyOfRange(4 + BUCKETS, 4 + 2 * BUCKETS),
+            decodeTokensPerSecond = v.copyOfRange(4 + 2 * BUCKETS, 4 + 3 * BUCKETS),
+            cancelLatencyMs = v.copyOfRange(4 + 3 * BUCKETS, 4 + 4 * BUCKETS),
+        )
+    }
+}
@@ -0,0 +1,18 @@
+package dev.deviceai.llm
+
+/**
+ * Completions of one prompt from [LlmEngine.generateN], prefilled once and
+ * decoded side by side.
+ *
+ * @param candidates       Generated texts, candidate 0 first. May hold fewer than
+ *                         requested when the model has fewer sequences (see
+ *                         [LlmInitConfig.maxCandidates]); empty on failure.
+ * @param generationTimeMs Wall-clock time of the whole call in milliseconds
+ * @param metrics          Native timings of the call; [GenerationMetrics.generatedTokens]
+ *                         counts the tokens of every candidate
+ */
+data class NBestResult(
+    val candidates: List<String>,
+    val generationTimeMs: Long,
+    val metrics: GenerationMetrics,
+)
@@ -0,0 +1,13 @@
+package dev.deviceai.llm
+
+/**
+ * Chunks packed into a token budget by [ChatSession.packContext].
+ *
+ * @param tokens      Token ids of the packed context, chunks joined by a `---` separator
+ * @param chunkTokens Tokens each input chunk contributed, in input order:
+ *                    its full count, fewer if it was cut, 0 if it was skipped
+ */
+class PackedContext(
+    val tokens: IntArray,
+    val chunkTokens: IntArray,
+)
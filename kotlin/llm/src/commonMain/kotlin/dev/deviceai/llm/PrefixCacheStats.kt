@@ -0,0 +1,37 @@
+package dev.deviceai.llm
+
+/**
+ * Counters of a model's cross-session prefix cache, accumulated since the model was loaded.
+ * See [LlmInitConfig.prefixCacheBytes].
+ *
+ * @param lookups      Prompts checked against the cache
+ * @param hits         Prompts that reused a prefix prefilled by another session
+ * @param tokensReused Prompt tokens not prefilled thanks to hits
+ * @param insertions   Prefixes stored
+ * @param evictions    Prefixes dropped to stay within the budget
+ * @param entries      Prefixes currently stored
+ * @param bytesUsed    Memory held by stored prefixes
+ * @param budgetBytes  Configured memory budget
+ */
+data class PrefixCacheStats(
+    val lookups: Long,
+    val hits: Long,
+    val tokensReused: Long,
+    val insertions: Long,
+    val evictions: Long,
+    val entries: Long,
+    val bytesUsed: Long,
+    val budgetBytes: Long,
+) {
+    /** Fraction of lookups that reused a cached prefix. */
+    val hitRate: Double
+        get() = if (lookups == 0L) 0.0 else hits.toDouble() / lookups
+
+    /** Fraction of lookups that had to prefill from their own KV state. */
+    val missRate: Double
+        get() = if (lookups == 0L) 0.0 else 1.0 - hitRate
+
+    internal companion object {
+        val EMPTY = PrefixCacheStats(0, 0, 0, 0, 0, 0, 0, 0)
+    }
+}
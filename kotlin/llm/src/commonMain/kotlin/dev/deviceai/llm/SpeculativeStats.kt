@@ -0,0 +1,24 @@
+package dev.deviceai.llm
+
+/**
+ * Speculative-decoding counters for one session, accumulated since it was created.
+ * All zero unless the model was loaded with [LlmInitConfig.draftModelPath] or
+ * requests enable [LlmGenConfig.promptLookup].
+ *
+ * @param draftedTokens  Tokens proposed by the draft model or prompt lookup
+ * @param acceptedTokens Proposed tokens the main model agreed with
+ * @param rounds         Verification passes of the main model
+ */
+data class SpeculativeStats(
+    val draftedTokens: Long,
+    val acceptedTokens: Long,
+    val rounds: Long,
+) {
+    /** Fraction of proposals accepted. Low values mean [LlmGenConfig.draftTokens] is too high. */
+    val acceptanceRate: Double
+        get() = if (draftedTokens == 0L) 0.0 else acceptedTokens.toDouble() / draftedTokens
+
+    /** Tokens produced per main-model pass (accepted proposals + one sampled token). */
+    val tokensPerRound: Double
+        get() = if (rounds == 0L) 0.0 else (acceptedTokens + rounds).toDouble() / rounds
+}
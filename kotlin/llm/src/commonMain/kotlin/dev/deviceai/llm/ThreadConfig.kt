@@ -0,0 +1,26 @@
+package dev.deviceai.llm
+
+/**
+ * CPU threads of a loaded model, changeable at runtime with
+ * [LlmEngine.setThreads] — no reload; sessions pick the change up before
+ * their next decode step.
+ *
+ * Decoding one token at a time is memory-bound and often fastest on a few
+ * performance cores; prompt prefill is compute-bound and scales further.
+ * On big.LITTLE phones and hybrid desktops, pin threads to the fast cores
+ * with [cpuMask] so none lands on an efficiency core and slows every step.
+ *
+ * @param threads      Threads for single-token decode steps
+ * @param batchThreads Threads for prompt prefill and batches; 0 = [threads]
+ * @param cpuMask      CPUs the decode threads run on, bit i = CPU i; 0 = not pinned
+ * @param batchCpuMask Same for the batch threads; 0 = [cpuMask]
+ * @param strictCpu    Pin each thread to its own CPU of the mask, in order,
+ *                     instead of letting it float within the mask
+ */
+data class ThreadConfig(
+    val threads: Int,
+    val batchThreads: Int = 0,
+    val cpuMask: Long = 0,
+    val batchCpuMask: Long = 0,
+    val strictCpu: Boolean = false,
+)
@@ -0,0 +1,19 @@
+package dev.deviceai.llm
+
+/**
+ * Thread counts chosen by [LlmEngine.autotuneThreads] and the throughput
+ * measured with them.
+ *
+ * @param threads      Fastest decode thread count
+ * @param batchThreads Fastest prefill thread count
+ * @param decodeTps    Decode tokens per second at [threads]
+ * @param prefillTps   Prefill tokens per second at [batchThreads]
+ * @param fromCache    Read from the tuning cache; nothing was measured
+ */
+data class ThreadTuning(
+    val threads: Int,
+    val batchThreads: Int,
+    val decodeTps: Double,
+    val prefillTps: Double,
+    val fromCache: Boolean,
+)
@@ -0,0 +1,79 @@
+package dev.deviceai.llm.rag
+
+/**
+ * Native BM25 keyword index that can be updated and saved to disk.
+ *
+ * Queries use an inverted index with MaxScore pruning, so they touch only the
+ * documents that contain the query terms. This stays fast on corpora of
+ * hundreds of thousands of chunks. Documents and their text live in native
+ * memory, not on the Kotlin heap.
+ *
+ * ```kotlin
+ * val index = BM25Index.load(path) ?: BM25Index.create().apply {
+ *     addAll(chunks, sources)
+ *     save(path)
+ * }
+ * val config = LlmGenConfig(ragStore = index)
+ * ```
+ *
+ * A saved index is memory-mapped by [load] and can be queried right away, with no
+ * rebuild. The first [add] or [remove] on it copies it into memory.
+ *
+ * Terms and scores match [BM25RagStore]: lowercase ASCII words of three or more
+ * letters and digits, Okapi BM25. All methods are thread-safe. Call [close] when
+ * done; the index must not be used afterwards. An index that is never closed is
+ * freed after it is garbage-collected.
+ */
+class BM25Index private constructor(handle: Long) : RagRetriever, AutoCloseable {
+
+    private val native = NativeHandle(handle, RagCppBridge::bm25Free)
+
+    internal val handle: Long get() = native.pointer
+
+    /** Number of indexed documents. */
+    val size: Int get() = native.withPointer(RagCppBridge::bm25Size)
+
+    /** Index one chunk. Returns its id, stable across [save] and [load]. */
+    fun add(text: String, source: String? = null): Long = addAll(listOf(text), listOf(source))[0]
+
+    /**
+     * Index chunks in one native call.
+     *
+     * @param sources Optional source identifiers, parallel to [texts]
+     * @return The chunks' ids, in order
+     */
+    fun addAll(texts: List<String>, sources: List<String?> = emptyList()): LongArray =
+        native.withPointer { RagCppBridge.bm25Add(it, texts, sources) }
+
+    /** Remove a chunk by the id [add] returned. False if it is not in the index. */
+    fun remove(id: Long): Boolean = native.withPointer { RagCppBridge.bm25Remove(it, id) }
+
+    /** Write the index to [path], replacing the file atomically. False on I/O error. */
+    fun save(path: String): Boolean = native.withPointer { RagCppBridge.bm25Save(it, path) }
+
+    override fun retrieve(query: String, topK: Int): List<RagChunk> =
+        native.withPointer { RagCppBridge.bm25Search(it, query, topK) }
+
+    /** Free the native index. Later calls do nothing. */
+    override fun close() = native.close()
+
+    companion object {
+        /**
+         * Create an empty index.
+         *
+         * @param k1 Term-frequency saturation (default 1.5)
+         * @param b  Document-length normalization strength (default 0.75)
+         */
+        fun create(k1: Float = 1.5f, b: Float = 0.75f): BM25Index =
+            BM25Index(RagCppBridge.bm25Create(k1, b))
+
+        /** Memory-map an index written by [save]. Null if the file is missing or invalid. */
+        fun load(path: String): BM25Index? =
+            RagCppBridge.bm25Load(path).takeIf { it != 0L }?.let(::BM25Index)
+
+        fun fromTexts(
+            texts: List<String>,
+            sources: List<String?> = emptyList(),
+        ): BM25Index = create().apply { addAll(texts, sources) }
+    }
+}
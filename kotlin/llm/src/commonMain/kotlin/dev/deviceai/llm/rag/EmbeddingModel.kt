@@ -0,0 +1,89 @@
+package dev.deviceai.llm.rag
+
+/**
+ * How an [EmbeddingModel] pools a text's token embeddings into one vector.
+ * Ordinals match the native dai_llm_pooling codes.
+ */
+enum class EmbeddingPooling {
+    /** The model's own pooling from its GGUF metadata; mean if it declares none. */
+    MODEL,
+    /** Average of all token embeddings. */
+    MEAN,
+    /** First token ([CLS]), as used by most BERT-style models. */
+    CLS,
+    /** Last token, as used by decoder embedding models (e.g. Qwen3-Embedding). */
+    LAST,
+}
+
+/**
+ * Configuration for loading an [EmbeddingModel].
+ *
+ * @param maxThreads CPU threads for inference (default 4)
+ * @param useGpu Use GPU acceleration — Metal on iOS, Vulkan on Android (default true)
+ * @param batchTokens Tokens decoded per native call (default 2048). This is also the
+ *        per-text limit; longer texts are truncated.
+ * @param batchTexts Texts decoded together per native call, each on its own
+ *        sequence (default 32)
+ * @param contexts Native contexts, and so calls that run at once (default 1).
+ *        Each has its own compute buffers; give [RagIngestor] one per worker
+ *        thread to embed in parallel.
+ * @param pooling Pooling method (default [EmbeddingPooling.MODEL])
+ * @param normalize L2-normalize vectors, so the dot product is the cosine
+ *        similarity (default true)
+ */
+data class EmbeddingConfig(
+    val maxThreads: Int = 4,
+    val useGpu: Boolean = true,
+    val batchTokens: Int = 2048,
+    val batchTexts: Int = 32,
+    val contexts: Int = 1,
+    val pooling: EmbeddingPooling = EmbeddingPooling.MODEL,
+    val normalize: Boolean = true,
+)
+
+/**
+ * A GGUF embedding model that turns text into dense vectors for semantic RAG retrieval.
+ *
+ * [embedAll] packs many texts into each native decode call, each on its own
+ * sequence, instead of decoding them one by one. For document ingestion this is
+ * many times faster than calling [embed] in a loop.
+ *
+ * ```kotlin
+ * val model = EmbeddingModel.load("/path/to/bge-small.gguf") ?: error("load failed")
+ * val vectors = model.embedAll(chunks)          // chunks.size * model.dimension floats
+ * val first = vectors.copyOfRange(0, model.dimension)
+ * model.close()
+ * ```
+ *
+ * Up to [EmbeddingConfig.contexts] calls on one model run at once; further calls
+ * wait. Call [close] when done; the model must not
+ * be used afterwards.
+ */
+class EmbeddingModel private constructor(internal val handle: Long) {
+
+    /** Length of each vector. */
+    val dimension: Int = RagCppBridge.embedDim(handle)
+
+    /** Embed one text. */
+    fun embed(text: String): FloatArray = embedAll(listOf(text))
+
+    /**
+     * Embed [texts] in batches.
+     *
+     * @return Row-major vectors: text `i` is at `[i * dimension, (i + 1) * dimension)`
+     * @throws IllegalStateException if native decoding fails
+     */
+    fun embedAll(texts: List<String>): FloatArray {
+        if (texts.isEmpty()) return FloatArray(0)
+        return checkNotNull(RagCppBridge.embed(handle, texts)) { "Embedding failed" }
+    }
+
+    /** Free the native model and context. */
+    fun close() = RagCppBridge.embedFree(handle)
+
+    companion object {
+        /** Load a GGUF embedding model. Null on failure or for reranker models. */
+        fun load(modelPath: String, config: EmbeddingConfig = EmbeddingConfig()): EmbeddingModel? =
+            RagCppBridge.embedLoad(modelPath, config).takeIf { it != 0L }?.let(::EmbeddingModel)
+    }
+}
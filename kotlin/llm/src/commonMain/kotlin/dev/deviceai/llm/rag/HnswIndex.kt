@@ -0,0 +1,122 @@
+package dev.deviceai.llm.rag
+
+/**
+ * Build and search settings for an [HnswIndex].
+ *
+ * @param m Links per vector per graph level (default 16). Higher values improve
+ *        recall on large corpora but use more memory and build time.
+ * @param efConstruction Search width while inserting (default 200). Higher
+ *        values give a better graph and a slower build.
+ * @param efSearch Default search width per query (default 64). Raise it for
+ *        better recall, lower it for faster queries.
+ * @param quantize Store vectors as int8 instead of float (default false). Uses
+ *        a quarter of the memory, at a small cost in recall.
+ * @param buildThreads Threads used to insert vectors; 0 = all cores (default).
+ */
+data class HnswConfig(
+    val m: Int = 16,
+    val efConstruction: Int = 200,
+    val efSearch: Int = 64,
+    val quantize: Boolean = false,
+    val buildThreads: Int = 0,
+)
+
+/**
+ * Native approximate nearest-neighbour index (HNSW) for semantic RAG retrieval.
+ *
+ * A brute-force scan compares a query against every stored vector. This index
+ * walks a proximity graph instead and touches only a few thousand vectors per
+ * query, so top-10 queries take around a millisecond even on a million chunks.
+ * Vectors, graph and chunk text live in native memory, not on the Kotlin heap.
+ *
+ * ```kotlin
+ * val embedder = EmbeddingModel.load(embeddingModelPath) ?: error("load failed")
+ * val index = HnswIndex.load(indexPath, embedder) ?: HnswIndex.create(embedder).apply {
+ *     addAll(chunks, sources)
+ *     save(indexPath)
+ * }
+ * val config = LlmGenConfig(ragStore = index)
+ * ```
+ *
+ * Queries passed to [retrieve] and texts passed to [add] are embedded with [embedder].
+ * Scores are cosine similarities. A saved index is memory-mapped by [load] and can
+ * be queried right away; the first [add] on it copies it into memory.
+ *
+ * All methods are thread-safe. Call [close] when done; the index must not be used
+ * afterwards. It does not close [embedder].
+ */
+class HnswIndex private constructor(
+    internal val handle: Long,
+    val embedder: EmbeddingModel,
+) : RagRetriever {
+
+    /** Number of indexed vectors. */
+    val size: Int get() = RagCppBridge.hnswSize(handle)
+
+    /** Embed and index one chunk. Returns its id, stable across [save] and [load]. */
+    fun add(text: String, source: String? = null): Long = addAll(listOf(text), listOf(source))[0]
+
+    /**
+     * Embed chunks in batches and index them.
+     *
+     * @param sources Optional source identifiers, parallel to [texts]
+     * @return The chunks' ids, in order
+     */
+    fun addAll(texts: List<String>, sources: List<String?> = emptyList()): LongArray {
+        if (texts.isEmpty()) return LongArray(0)
+        return addVectors(embedder.embedAll(texts), texts, sources)
+    }
+
+    /**
+     * Index chunks whose vectors are already computed.
+     *
+     * @param vectors Row-major, `texts.size * embedder.dimension` floats
+     * @return The chunks' ids, in order
+     */
+    fun addVectors(vectors: FloatArray, texts: List<String>, sources: List<String?> = emptyList()): LongArray {
+        require(vectors.size == texts.size * embedder.dimension) {
+            "Expected ${texts.size * embedder.dimension} floats, got ${vectors.size}"
+        }
+        return RagCppBridge.hnswAdd(handle, vectors, texts, sources)
+    }
+
+    /** Remove a chunk by the id [add] returned. False if it is not in the index. */
+    fun remove(id: Long): Boolean = RagCppBridge.hnswRemove(handle, id)
+
+    /** Write the index to [path], replacing the file atomically. False on I/O error. */
+    fun save(path: String): Boolean = RagCppBridge.hnswSave(handle, path)
+
+    override fun retrieve(query: String, topK: Int): List<RagChunk> =
+        search(embedder.embed(query), topK)
+
+    /**
+     * Chunks nearest to a precomputed query [vector].
+     *
+     * @param ef Search width; 0 uses [HnswConfig.efSearch]
+     */
+    fun search(vector: FloatArray, topK: Int, ef: Int = 0): List<RagChunk> =
+        RagCppBridge.hnswSearch(handle, vector, topK, ef)
+
+    /** Free the native index. */
+    fun close() = RagCppBridge.hnswFree(handle)
+
+    companion object {
+        /** Create an empty index for [embedder]'s vectors. */
+        fun create(embedder: EmbeddingModel, config: HnswConfig = HnswConfig()): HnswIndex =
+            HnswIndex(RagCppBridge.hnswCreate(embedder.dimension, config), embedder)
+
+        /**
+         * Memory-map an index written by [save]. Null if the file is missing or
+         * invalid, or was built for vectors of another dimension than [embedder]'s.
+         */
+        fun load(path: String, embedder: EmbeddingModel): HnswIndex? {
+            val handle = RagCppBridge.hnswLoad(path)
+            if (handle == 0L) return null
+            if (RagCppBridge.hnswDim(handle) != embedder.dimension) {
+                RagCppBridge.hnswFree(handle)
+                return null
+            }
+            return HnswIndex(handle, embedder)
+        }
+    }
+}
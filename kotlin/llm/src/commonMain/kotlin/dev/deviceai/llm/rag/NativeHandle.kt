@@ -0,0 +1,18 @@
+package dev.deviceai.llm.rag
+
+/**
+ * A native pointer freed exactly once: by [close], or by a cleaner after the
+ * handle becomes unreachable without being closed. [free] runs on the cleaner's
+ * thread in the second case.
+ */
+@Suppress("EXPECT_ACTUAL_CLASSIFIERS_ARE_IN_BETA_WARNING")
+internal expect class NativeHandle(pointer: Long, free: (Long) -> Unit) {
+
+    /** The pointer, for calls that keep the owner reachable themselves. */
+    val pointer: Long
+
+    /** Run [block] with the pointer; the handle is not cleaned up before it returns. */
+    fun <R> withPointer(block: (Long) -> R): R
+
+    fun close()
+}
@@ -4,34 +4,51 @@ import dev.deviceai.llm.LlmGenConfig
 import dev.deviceai.llm.LlmMessage
 import dev.deviceai.llm.LlmRole
 
+/**
+ * Chunks left for the native engine to pack into [maxTokens] at
+ * [RagAugmentor.CONTEXT_MARKER], best first.
+ */
+internal class RagContext(val chunks: List<String>, val maxTokens: Int)
+
+/** Messages with RAG context injected, plus chunks still to be packed natively. */
+internal class AugmentedPrompt(val messages: List<LlmMessage>, val context: RagContext? = null)
+
 /**
  * Injects retrieved RAG context into the message list before it reaches the LLM engine.
  *
  * Called by each LlmCppBridge actual inside [generate] and [generateStream].
  * Returns the original list unchanged when [LlmGenConfig.ragStore] is null.
+ *
+ * With [LlmGenConfig.ragContextTokens] set, the chunks are not joined here:
+ * the template gets [CONTEXT_MARKER] in place of `{context}` and the engine
+ * packs the chunks into the budget with the model's tokenizer at that spot.
  */
 internal object RagAugmentor {
 
-    fun augment(messages: List<LlmMessage>, config: LlmGenConfig): List<LlmMessage> {
-        val store = config.ragStore ?: return messages
+    /** Stands in for the packed context. Private-use characters, so never in real text. */
+    const val CONTEXT_MARKER = "\uE000rag-context\uE000"
+
+    fun augment(messages: List<LlmMessage>, config: LlmGenConfig): AugmentedPrompt {
+        val store = config.ragStore ?: return AugmentedPrompt(messages)
 
         // Use the last user message as the retrieval query
         val query = messages.lastOrNull { it.role == LlmRole.USER }?.content
-            ?: return messages
+            ?: return AugmentedPrompt(messages)
 
         val chunks = store.retrieve(query, config.ragTopK)
-        if (chunks.isEmpty()) return messages
+        if (chunks.isEmpty()) return AugmentedPrompt(messages)
 
         require("{context}" in config.ragPromptTemplate) {
             "ragPromptTemplate must contain the placeholder \"{context}\""
         }
 
-        val context  = chunks.joinToString("\n\n---\n\n") { it.text }
+        val packed = config.ragContextTokens > 0
+        val context = if (packed) CONTEXT_MARKER else chunks.joinToString("\n\n---\n\n") { it.text }
         val injected = config.ragPromptTemplate.replace("{context}", context)
 
         // Prepend to existing system message, or insert a new one at position 0
         val systemIdx = messages.indexOfFirst { it.role == LlmRole.SYSTEM }
-        return if (systemIdx >= 0) {
+        val augmented = if (systemIdx >= 0) {
             messages.toMutableList().also {
                 it[systemIdx] = it[systemIdx].copy(
                     content = injected + "\n\n" + it[systemIdx].content
@@ -40,5 +57,9 @@ internal object RagAugmentor {
         } else {
             listOf(LlmMessage(LlmRole.SYSTEM, injected)) + messages
         }
+
+        if (!packed) return AugmentedPrompt(augmented)
+        val ranked = chunks.sortedByDescending { it.score }.map { it.text }
+        return AugmentedPrompt(augmented, RagContext(ranked, config.ragContextTokens))
     }
 }
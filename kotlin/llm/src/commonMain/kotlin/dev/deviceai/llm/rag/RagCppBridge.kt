@@ -0,0 +1,71 @@
+package dev.deviceai.llm.rag
+
+/**
+ * Native RAG indexes, embedding models and ingestion (deviceai_llm_bm25,
+ * deviceai_llm_hnsw, deviceai_llm_embed, deviceai_llm_ingest).
+ * Handles are native pointers as [Long]; `0` means the call failed.
+ */
+@Suppress("EXPECT_ACTUAL_CLASSIFIERS_ARE_IN_BETA_WARNING")
+internal expect object RagCppBridge {
+
+    /** Create an empty BM25 index. */
+    fun bm25Create(k1: Float, b: Float): Long
+
+    /** Memory-map an index saved by [bm25Save]; 0 if missing or invalid. */
+    fun bm25Load(path: String): Long
+
+    fun bm25Free(index: Long)
+
+    /** Index [texts] with parallel, optional [sources]. Returns their ids. */
+    fun bm25Add(index: Long, texts: List<String>, sources: List<String?>): LongArray
+
+    fun bm25Remove(index: Long, id: Long): Boolean
+
+    fun bm25Size(index: Long): Int
+
+    fun bm25Save(index: Long, path: String): Boolean
+
+    /** Best [topK] chunks for [query], by descending score. */
+    fun bm25Search(index: Long, query: String, topK: Int): List<RagChunk>
+
+    /** Load an embedding model; 0 on failure. */
+    fun embedLoad(path: String, config: EmbeddingConfig): Long
+
+    fun embedFree(embedder: Long)
+
+    fun embedDim(embedder: Long): Int
+
+    /** Row-major `texts.size * dim` vectors; null if decoding failed. */
+    fun embed(embedder: Long, texts: List<String>): FloatArray?
+
+    /** Create an empty HNSW index for vectors of length [dim]. */
+    fun hnswCreate(dim: Int, config: HnswConfig): Long
+
+    /** Memory-map an index saved by [hnswSave]; 0 if missing or invalid. */
+    fun hnswLoad(path: String): Long
+
+    fun hnswFree(index: Long)
+
+    fun hnswDim(index: Long): Int
+
+    /** Index row-major [vectors] with parallel [texts] and optional [sources]. Returns their ids. */
+    fun hnswAdd(index: Long, vectors: FloatArray, texts: List<String>, sources: List<String?>): LongArray
+
+    fun hnswRemove(index: Long, id: Long): Boolean
+
+    fun hnswSize(index: Long): Int
+
+    fun hnswSave(index: Long, path: String): Boolean
+
+    /** Best [topK] chunks for [query], by descending cosine similarity. */
+    fun hnswSearch(index: Long, query: FloatArray, topK: Int, ef: Int): List<RagChunk>
+
+    /**
+     * Chunk and index [paths] into the given handles (0 to skip). [embedder] is
+     * needed with [hnsw]. Null if ingestion failed.
+     */
+    fun ingest(
+        paths: List<String>, bm25: Long, embedder: Long, hnsw: Long, config: IngestConfig,
+        bm25Path: String?, hnswPath: String?, onProgress: ((Long, Long) -> Boolean)?,
+    ): IngestStats?
+}
@@ -0,0 +1,112 @@
+package dev.deviceai.llm.rag
+
+/**
+ * Settings for [RagIngestor.ingest].
+ *
+ * @param chunkTokens Tokens per chunk (default 256). Chunks are cut from the
+ *        model's own tokens, so a chunk always fits an embedding model with at
+ *        least this context.
+ * @param overlapTokens Tokens shared by consecutive chunks of a file (default 32);
+ *        must be less than [chunkTokens]
+ * @param threads Worker threads for tokenizing, indexing and embedding; 0 = all
+ *        cores (default). At most [EmbeddingConfig.contexts] of them embed at
+ *        once.
+ * @param maxBufferedBytes Text read ahead of the workers (default 64 MiB). Memory
+ *        use is bounded by this plus the indexes, whatever the corpus size.
+ * @param extensions Extensions of the files taken from directories, case-insensitive
+ *        (default txt, md, markdown). Empty takes every file. Files passed directly
+ *        are always read.
+ * @param tokenizerModelPath GGUF model whose tokenizer sizes the chunks; only its
+ *        vocabulary is loaded. Null uses the HNSW index's embedding model, so set
+ *        it when ingesting into a [BM25Index] alone.
+ */
+data class IngestConfig(
+    val chunkTokens: Int = 256,
+    val overlapTokens: Int = 32,
+    val threads: Int = 0,
+    val maxBufferedBytes: Long = 64L shl 20,
+    val extensions: List<String> = listOf("txt", "md", "markdown"),
+    val tokenizerModelPath: String? = null,
+)
+
+/**
+ * Result of [RagIngestor.ingest].
+ *
+ * @param files Files read
+ * @param failedFiles Paths that were missing or unreadable; they are skipped
+ * @param bytes Text read
+ * @param chunks Chunks added to each index
+ * @param tokens Tokens in the text read
+ * @param cancelled The progress callback stopped the run; the index files were not written
+ */
+data class IngestStats(
+    val files: Long,
+    val failedFiles: Long,
+    val bytes: Long,
+    val chunks: Long,
+    val tokens: Long,
+    val cancelled: Boolean,
+)
+
+/**
+ * Builds RAG indexes straight from files on disk.
+ *
+ * The native pipeline streams each file in pieces through a bounded buffer,
+ * cuts it into overlapping chunks of model tokens, and indexes and embeds the
+ * chunks on a pool of worker threads. Nothing passes through Kotlin lists, so
+ * re-indexing a multi-gigabyte knowledge base uses every core and bounded memory.
+ *
+ * ```kotlin
+ * val embedder = EmbeddingModel.load(embeddingModelPath) ?: error("load failed")
+ * val bm25 = BM25Index.create()
+ * val hnsw = HnswIndex.create(embedder)
+ * val stats = RagIngestor.ingest(
+ *     listOf(docsDir), bm25 = bm25, hnsw = hnsw,
+ *     bm25Path = "$indexDir/docs.bm25", hnswPath = "$indexDir/docs.hnsw",
+ * ) { done, total -> updateProgress(done, total); true }
+ * ```
+ *
+ * Each chunk's source is its file's path. Chunks are added in the order they
+ * finish, not in file order.
+ */
+object RagIngestor {
+
+    /**
+     * Chunk and index every file in [paths]; directories are walked recursively,
+     * skipping hidden entries. Blocks until done; run it off the main thread.
+     *
+     * @param bm25 Keyword index to add the chunks to, or null
+     * @param hnsw Vector index to embed and add the chunks to, or null; uses its
+     *        [HnswIndex.embedder]
+     * @param bm25Path Where to save [bm25] after a complete run, or null
+     * @param hnswPath Where to save [hnsw] after a complete run, or null
+     * @param onProgress Called with bytes indexed so far and the corpus size;
+     *        return false to stop. Chunks indexed before stopping stay indexed.
+     * @return The run's statistics, or null if the tokenizer could not be loaded,
+     *         embedding failed or an index file could not be written
+     */
+    fun ingest(
+        paths: List<String>,
+        bm25: BM25Index? = null,
+        hnsw: HnswIndex? = null,
+        config: IngestConfig = IngestConfig(),
+        bm25Path: String? = null,
+        hnswPath: String? = null,
+        onProgress: ((done: Long, total: Long) -> Boolean)? = null,
+    ): IngestStats? {
+        require(bm25 != null || hnsw != null) { "Nothing to ingest into: pass bm25 and/or hnsw" }
+        require(hnsw != null || config.tokenizerModelPath != null) {
+            "A BM25-only ingest needs IngestConfig.tokenizerModelPath"
+        }
+        require(config.overlapTokens in 0 until config.chunkTokens) {
+            "overlapTokens must be in 0 until chunkTokens"
+        }
+        return RagCppBridge.ingest(
+            paths,
+            bm25?.handle ?: 0L,
+            hnsw?.embedder?.handle ?: 0L,
+            hnsw?.handle ?: 0L,
+            config, bm25Path, hnswPath, onProgress
+        )
+    }
+}
@@ -5,7 +5,8 @@ package dev.deviceai.llm.rag
  *
  * Implement this interface to plug in any retrieval backend:
  * - [BM25RagStore] — built-in keyword search, no extra model needed
- * - Semantic embedding store — embed query + cosine similarity
+ * - [BM25Index] — the same, updatable and persisted to disk
+ * - [HnswIndex] — semantic search over [EmbeddingModel] vectors
  * - SQLite FTS5 — persistent full-text search
  * - Remote vector DB — for server-side retrieval
  */
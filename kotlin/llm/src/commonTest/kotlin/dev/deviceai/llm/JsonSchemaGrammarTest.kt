@@ -0,0 +1,134 @@
+package dev.deviceai.llm
+
+import kotlin.test.Test
+import kotlin.test.assertEquals
+import kotlin.test.assertFailsWith
+import kotlin.test.assertFalse
+import kotlin.test.assertTrue
+
+class JsonSchemaGrammarTest {
+
+    /** Rules of [schema]'s grammar, name → body, after checking every rule used is defined. */
+    private fun rules(schema: String): Map<String, String> {
+        val gbnf = JsonSchemaGrammar.toGbnf(schema)
+        val rules = gbnf.lines().filter { it.isNotEmpty() }.associate { line ->
+            val (name, body) = line.split(" ::= ", limit = 2)
+            name to body
+        }
+        assertTrue(gbnf.startsWith("root ::= "), gbnf)
+        for ((name, body) in rules) {
+            for (used in ruleNames(body)) assertTrue(used in rules, "$name uses undefined rule $used in\n$gbnf")
+        }
+        return rules
+    }
+
+    /** Rule names referenced by a GBNF expression, outside literals and character classes. */
+    private fun ruleNames(body: String): Set<String> {
+        val bare = StringBuilder()
+        var i = 0
+        while (i < body.length) {
+            val close = when (body[i]) { '"' -> '"'; '[' -> ']'; else -> null }
+            if (close == null) {
+                bare.append(body[i++])
+                continue
+            }
+            i++
+            while (body[i] != close) i += if (body[i] == '\\') 2 else 1
+            i++
+            bare.append(' ')
+        }
+        return Regex("[a-zA-Z][a-zA-Z0-9-]*").findAll(bare).map { it.value }.toSet()
+    }
+
+    @Test
+    fun primitiveTypes() {
+        assertEquals("string", rules("""{"type": "string"}""")["root"])
+        assertEquals("integer", rules("""{"type": "integer"}""")["root"])
+        assertEquals("value", rules("{}")["root"])
+        assertEquals("value", rules("true")["root"])
+    }
+
+    @Test
+    fun requiredAndOptionalProperties() {
+        val r = rules(
+            """{"type": "object",
+                "properties": {"name": {"type": "string"}, "age": {"type": "integer"}},
+                "required": ["name"]}"""
+        )
+        assertEquals(""""{" ws root-name-kv ( "," ws root-age-kv )? "}" ws""", r["root"])
+        assertEquals(""""\"name\"" ws ":" ws string""", r["root-name-kv"])
+        assertEquals(""""\"age\"" ws ":" ws integer""", r["root-age-kv"])
+    }
+
+    @Test
+    fun allOptionalPropertiesAllowAnEmptyObject() {
+        val r = rules("""{"properties": {"a": {"type": "boolean"}, "b": {"type": "null"}}}""")
+        assertEquals(""""{" ws ( root-a-kv ( "," ws root-b-kv )? | ( root-b-kv )? ) "}" ws""", r["root"])
+        assertEquals(""""{" ws "}" ws""", rules("""{"type": "object", "properties": {}}""")["root"])
+    }
+
+    @Test
+    fun arrayBounds() {
+        assertEquals(
+            """"[" ws integer ( "," ws integer ){1,3} "]" ws""",
+            rules("""{"type": "array", "items": {"type": "integer"}, "minItems": 2, "maxItems": 4}""")["root"]
+        )
+        assertEquals(
+            """"[" ws ( number ( "," ws number )* )? "]" ws""",
+            rules("""{"type": "array", "items": {"type": "number"}}""")["root"]
+        )
+        assertEquals(""""[" ws "]" ws""", rules("""{"type": "array", "maxItems": 0}""")["root"])
+    }
+
+    @Test
+    fun stringLength() {
+        assertEquals(""""\"" char{1,8} "\"" ws""", rules("""{"type": "string", "minLength": 1, "maxLength": 8}""")["root"])
+        assertEquals(""""\"" char{2,} "\"" ws""", rules("""{"type": "string", "minLength": 2}""")["root"])
+    }
+
+    @Test
+    fun enumAndConst() {
+        assertEquals("""("\"red\"" | "\"green\"" | "1") ws""", rules("""{"enum": ["red", "green", 1]}""")["root"])
+        assertEquals(""""\"a\\\"b\"" ws""", rules("""{"const": "a\"b"}""")["root"])
+    }
+
+    @Test
+    fun alternativesAndTypeLists() {
+        assertEquals("string | null", rules("""{"anyOf": [{"type": "string"}, {"type": "null"}]}""")["root"])
+        assertEquals("integer | boolean", rules("""{"type": ["integer", "boolean"]}""")["root"])
+    }
+
+    @Test
+    fun identicalSubschemasShareARule() {
+        val r = rules(
+            """{"type": "object", "properties": {
+                "a": {"type": "string", "maxLength": 3},
+                "b": {"type": "string", "maxLength": 3}}}"""
+        )
+        assertEquals(""""\"b\"" ws ":" ws root-a""", r["root-b-kv"])
+        assertFalse("root-b" in r)
+    }
+
+    @Test
+    fun recursiveRef() {
+        val r = rules(
+            """{"${'$'}ref": "#/${'$'}defs/node",
+                "${'$'}defs": {"node": {"type": "object",
+                    "properties": {"value": {"type": "integer"},
+                                   "next": {"anyOf": [{"${'$'}ref": "#/${'$'}defs/node"}, {"type": "null"}]}},
+                    "required": ["value"]}}}"""
+        )
+        assertEquals("node", r["root"])
+        assertEquals("node-body", r["node"])
+        assertEquals("node | null", r["node-body-next"])
+    }
+
+    @Test
+    fun unsupportedSchemasThrow() {
+        assertFailsWith<IllegalArgumentException> { JsonSchemaGrammar.toGbnf("{not json") }
+        assertFailsWith<IllegalArgumentException> { JsonSchemaGrammar.toGbnf("""{"type": "date"}""") }
+        assertFailsWith<IllegalArgumentException> { JsonSchemaGrammar.toGbnf("""{"${'$'}ref": "other.json#/a"}""") }
+        assertFailsWith<IllegalArgumentException> { JsonSchemaGrammar.toGbnf("""{"${'$'}ref": "#/missing"}""") }
+        assertFailsWith<IllegalArgumentException> { JsonSchemaGrammar.toGbnf("42") }
+    }
+}
@@ -8,93 +8,781 @@
 extern "C" {
 #endif
 
+// ═══════════════════════════════════════════════════════════════
+//                         HANDLES
+// ═══════════════════════════════════════════════════════════════
+
+/** A loaded GGUF model. Shared by every session created on it. */
+typedef struct llm_model llm_model;
+
+/** One conversation: its own context, KV cache, sampler and cancel flag. */
+typedef struct llm_session llm_session;
+
+/** A BM25 keyword index for RAG retrieval. */
+typedef struct llm_bm25 llm_bm25;
+
+/** An embedding model with its own embeddings context. */
+typedef struct llm_embedder llm_embedder;
+
+/** An HNSW vector index for semantic RAG retrieval. */
+typedef struct llm_hnsw llm_hnsw;
+
 // ═══════════════════════════════════════════════════════════════
 //                         LIFECYCLE
 // ═══════════════════════════════════════════════════════════════
 
+/** KV cache element type. Quantized V requires flash attention. */
+typedef enum {
+    LLM_KV_F16  = 0,
+    LLM_KV_Q8_0 = 1,   // ~53% of F16 memory
+    LLM_KV_Q4_0 = 2,   // ~28% of F16 memory
+} llm_kv_type;
+
+/** Model load parameters. Start from llm_model_default_params(). */
+typedef struct {
+    /** CPU threads for inference. */
+    int         max_threads;
+    /** Use GPU acceleration (Metal on iOS). */
+    bool        use_gpu;
+    /**
+     * Sequences decoded together in one batch. 1 gives every session its own
+     * context; > 1 runs a continuous-batching scheduler that shares one
+     * context (split evenly) between all sessions.
+     */
+    int         n_parallel;
+    /**
+     * Optional smaller .gguf of the same model family used for speculative
+     * decoding (NULL = none). Requires n_parallel == 1.
+     */
+    const char *draft_model_path;
+    /** Memory budget for prompt prefixes shared across sessions (0 = off). */
+    int64_t     prefix_cache_bytes;
+
+    /**
+     * Context window in tokens. 0 uses the model's native context length from
+     * the GGUF metadata, which can be 32k-128k tokens and gigabytes of KV cache.
+     */
+    int         n_ctx;
+    /** Max tokens per decode call (0 = llama.cpp default). */
+    int         n_batch;
+    /** Physical batch size; bounds the compute buffer (0 = llama.cpp default). */
+    int         n_ubatch;
+    llm_kv_type type_k;
+    llm_kv_type type_v;
+    /** Flash attention: -1 auto, 0 off, 1 on. */
+    int         flash_attn;
+    bool        use_mmap;
+    /** Pin the weights in RAM. */
+    bool        use_mlock;
+    /** CPU threads for prompt prefill (0 = max_threads). */
+    int         batch_threads;
+    /**
+     * CPUs for the decode / prefill threads, bit i = CPU i (0 = unpinned;
+     * cpu_mask_batch 0 = cpu_mask). Apple platforms expose no CPU affinity,
+     * so the masks only limit the thread counts there.
+     */
+    uint64_t    cpu_mask;
+    uint64_t    cpu_mask_batch;
+    /** One thread per CPU of the mask instead of floating within it. */
+    bool        strict_cpu;
+    /**
+     * Most candidates one llm_generate_n call decodes side by side on a
+     * session with its own context (1 = no n-best). The KV cache of such
+     * sessions is unified so candidates share the prompt's cells.
+     */
+    int         max_candidates;
+    /**
+     * Continuations one llm_score_continuations pass decodes side by side on
+     * a session with its own context (1 = one at a time). The larger of this
+     * and max_candidates applies to both.
+     */
+    int         score_sequences;
+    /** Worker threads of the model's job executor (0 = n_parallel). */
+    int         job_workers;
+    /** Most jobs waiting to run; llm_job_submit refuses more. */
+    int         job_queue;
+} llm_model_params;
+
+/** Defaults: 4 threads, GPU on, one sequence, native context, F16 KV, mmap on. */
+llm_model_params llm_model_default_params(void);
+
 /**
- * Initialize the LLM engine with a GGUF model file.
+ * Load a GGUF model file.
  *
- * Context window size is not exposed — llama.cpp reads it from the model's
- * GGUF metadata and uses the model's native context length (n_ctx = 0).
+ * Loading the same file again (with the same GPU setting) returns the already
+ * loaded weights with an extra reference instead of a second copy; the first
+ * load decides every other parameter.
  *
  * @param model_path Absolute path to .gguf model file
- * @param max_threads CPU threads for inference
- * @param use_gpu Use GPU acceleration (Metal on iOS)
- * @return true if initialization succeeded
+ * @param params Load parameters (NULL = defaults)
+ * @return Model handle, or NULL if loading failed
+ */
+llm_model *llm_init(const char *model_path, const llm_model_params *params);
+
+/** Estimated memory for a model load, in bytes. */
+typedef struct {
+    int     n_ctx;          // effective context length per context
+    int64_t weights_bytes;  // model (+ draft) files
+    int64_t kv_bytes;       // KV caches of all contexts
+    int64_t compute_bytes;  // compute buffers of all contexts
+    int64_t total_bytes;
+} llm_memory_estimate;
+
+/**
+ * Estimate the memory llm_init(model_path, params) plus n_sessions sessions
+ * would use, reading only the GGUF metadata. Use it to pick n_ctx and KV
+ * types per device class before loading.
+ *
+ * @return false if the model metadata could not be read
+ */
+bool llm_estimate_memory(const char *model_path, const llm_model_params *params,
+                         int n_sessions, llm_memory_estimate *out);
+
+/**
+ * Release one reference to the model. Weights are unloaded with the last one.
+ * Free all sessions created on the model first.
+ */
+void llm_shutdown(llm_model *model);
+
+/**
+ * Create a session on a loaded model.
+ *
+ * @return Session handle, or NULL if the context could not be created
  */
-bool llm_init(const char *model_path, int max_threads, bool use_gpu);
+llm_session *llm_session_create(llm_model *model);
 
 /**
- * Release all LLM resources and unload the model.
+ * Free a session's context and KV cache. Does not release the model.
  */
-void llm_shutdown(void);
+void llm_session_free(llm_session *session);
+
+/** Result of llm_warm_prefix. */
+typedef enum {
+    LLM_SNAPSHOT_FAILED   = 0,
+    LLM_SNAPSHOT_RESTORED = 1,   // KV state loaded from disk
+    LLM_SNAPSHOT_REBUILT  = 2,   // prefix decoded, snapshot (re)written
+} llm_snapshot_status;
+
+/**
+ * Warm a session with the KV state of a conversation prefix (typically the
+ * system prompt) so the first generate only decodes what follows it.
+ *
+ * The snapshot file in cache_dir is keyed by model fingerprint and prefix
+ * token hash. A missing or stale snapshot is rebuilt (decode + write).
+ * Not supported for sessions on a model loaded with n_parallel > 1.
+ *
+ * @param session Session to warm
+ * @param roles   Array of role strings, usually just "system"
+ * @param contents Array of message content strings, parallel to roles
+ * @param count   Number of messages
+ * @param cache_dir Existing, writable directory for snapshot files
+ * @return One of llm_snapshot_status
+ */
+int llm_warm_prefix(
+    llm_session *session,
+    const char **roles,
+    const char **contents,
+    int count,
+    const char *cache_dir
+);
 
 // ═══════════════════════════════════════════════════════════════
 //                         GENERATION
 // ═══════════════════════════════════════════════════════════════
 
+/**
+ * Prefill progress: prompt tokens in the KV cache so far (including tokens
+ * reused from the previous request) out of the prompt's total. Called on the
+ * generating thread before the first chunk and after each decoded chunk.
+ */
+typedef void (*llm_on_progress)(int processed, int total, void *user);
+
+/** Timings and token counts of one generate call. */
+typedef struct {
+    int    prompt_tokens;      // after context fitting
+    int    cached_tokens;      // prompt tokens reused from the KV cache, not prefilled
+    int    generated_tokens;
+    double ttft_ms;            // call start → first token (queueing and prefill included)
+    double prefill_ms;
+    double decode_ms;          // end of prefill → last token, sampling included
+    double sample_ms;          // inside the sampler chain
+    double prefill_tps;        // prefilled tokens per second
+    double decode_tps;         // generated tokens per second
+    int    kv_peak;            // most KV cells the request's sequence held
+    int    n_ctx;              // cells available to the sequence
+    double cancel_ms;          // llm_cancel → return; -1 when not cancelled
+    int    stop_reason;        // 1 = a stop string, 2 = repetition ended it; 0 otherwise
+} llm_gen_metrics;
+
+/**
+ * Sampling and output settings of one request. Start from
+ * llm_gen_default_params(); strings and arrays are only read during the call.
+ */
+typedef struct {
+    int          max_tokens;
+    float        temperature;
+    float        top_p;
+    int          top_k;
+    float        repeat_penalty;
+    /** Sampling seed (UINT32_MAX = random); llm_generate_n candidate i uses seed + i. */
+    uint32_t     seed;
+    /**
+     * Prompt tokens per decode call; smaller chunks make llm_cancel and
+     * progress more responsive (0 = context's n_batch).
+     */
+    int          prefill_chunk;
+    /**
+     * Draft tokens proposed per verification step when the model has a draft
+     * model or prompt_lookup is set (0 = no speculation).
+     */
+    int          n_draft;
+    /**
+     * Propose the tokens that followed the latest earlier occurrence of the
+     * last n-gram, instead of asking a draft model.
+     */
+    bool         prompt_lookup;
+    /**
+     * Keep generating once the conversation outgrows the context: the oldest
+     * messages after the pinned tokens are evicted and the KV cache is shifted
+     * in place instead of re-prefilled. Ignored by llm_generate_n.
+     */
+    bool         context_shift;
+    /** Tokens pinned at the start of the context when shifting (< 0 = the leading system messages). */
+    int          n_keep;
+    /**
+     * Stop strings (may be NULL): generation ends before the first one in the
+     * output, which is neither streamed nor returned.
+     */
+    const char **stop;
+    int          stop_count;
+    /** End once that many trailing tokens are a short cycle repeated back to back (0 = off). */
+    int          repeat_stop_tokens;
+    /** GBNF the output must match, root rule "root" (may be NULL); nothing is generated when it does not parse. */
+    const char  *grammar;
+    /** Where packed RAG context goes in the messages (may be NULL). */
+    const char  *context_marker;
+    /**
+     * RAG chunks, best first, packed into context_tokens tokens and decoded
+     * as tokens in place of context_marker (may be NULL).
+     */
+    const char **context_chunks;
+    int          context_count;
+    int          context_tokens;
+} llm_gen_params;
+
+/** Defaults: 512 tokens, temperature 0.7, top_p 0.9, top_k 40, random seed, 8 draft tokens, no stops. */
+llm_gen_params llm_gen_default_params(void);
+
 /**
  * Generate a response for the given conversation (blocking).
  *
+ * @param session Session to generate on
  * @param roles   Array of role strings ("system", "user", "assistant")
  * @param contents Array of message content strings, parallel to roles
  * @param count   Number of messages
- * @param max_tokens Maximum tokens to generate
- * @param temperature Sampling temperature
- * @param top_p Nucleus sampling threshold
- * @param top_k Top-K sampling limit
- * @param repeat_penalty Repetition penalty
+ * @param params  Request settings (NULL = defaults)
+ * @param on_progress Optional prefill progress callback (may be NULL)
+ * @param progress_user User data passed to on_progress
+ * @param out_metrics Receives the request's metrics (may be NULL)
  * @return Generated text (caller must free with llm_free_string)
  */
 char *llm_generate(
+    llm_session *session,
     const char **roles,
     const char **contents,
     int count,
-    int max_tokens,
-    float temperature,
-    float top_p,
-    int top_k,
-    float repeat_penalty
+    const llm_gen_params *params,
+    llm_on_progress on_progress,
+    void *progress_user,
+    llm_gen_metrics *out_metrics
 );
 
 // Streaming callbacks (no on_complete — flow completes when llm_generate_stream returns)
-typedef void (*llm_on_token)(const char *token, void *user);
+// text is NUL-terminated, length bytes long, and always ends on a complete UTF-8 character.
+typedef void (*llm_on_text)(const char *text, int length, void *user);
 typedef void (*llm_on_error)(const char *message, void *user);
 
 /**
- * Stream a response token-by-token.
+ * Stream a response in batches of token text.
  *
+ * Pieces are coalesced and delivered after batch_tokens tokens or batch_ms
+ * milliseconds since the previous batch, whichever comes first, so the
+ * callback (and the Kotlin bridge behind it) runs far less often than once
+ * per token. A character split across tokens is held back until complete.
+ *
+ * @param session Session to generate on
  * @param roles   Array of role strings ("system", "user", "assistant")
  * @param contents Array of message content strings, parallel to roles
  * @param count   Number of messages
- * @param max_tokens Maximum tokens to generate
- * @param temperature Sampling temperature
- * @param top_p Nucleus sampling threshold
- * @param top_k Top-K sampling limit
- * @param repeat_penalty Repetition penalty
- * @param on_token Callback for each generated token piece
+ * @param params  Request settings, as for llm_generate (NULL = defaults)
+ * @param on_progress Optional prefill progress callback (may be NULL)
+ * @param batch_tokens Tokens per batch (<= 1 = every token)
+ * @param batch_ms Max delay of a batch in milliseconds (<= 0 = no limit)
+ * @param on_text Callback for each batch of generated text
  * @param on_error Callback for errors
+ * @param out_metrics Receives the request's metrics once it ends (may be NULL)
  * @param user User data passed to all callbacks
  */
 void llm_generate_stream(
+    llm_session *session,
+    const char **roles,
+    const char **contents,
+    int count,
+    const llm_gen_params *params,
+    llm_on_progress on_progress,
+    int batch_tokens,
+    int batch_ms,
+    llm_on_text on_text,
+    llm_on_error on_error,
+    llm_gen_metrics *out_metrics,
+    void *user
+);
+
+/**
+ * Generate up to n completions of one prompt (e.g. suggested replies): the
+ * prompt is prefilled once and all candidates are decoded together in one
+ * batch, each with its own sampler. n is capped by max_candidates (or
+ * n_parallel on a batching model).
+ *
+ * @param session Session to generate on
+ * @param roles, contents, count Conversation, as for llm_generate
+ * @param n Candidates wanted
+ * @param params Request settings, as for llm_generate (NULL = defaults);
+ *        stops and grammar apply to each candidate on its own
+ * @param on_progress Optional prefill progress callback (may be NULL)
+ * @param progress_user User data passed to on_progress
+ * @param out_texts Receives up to n strings (each freed with llm_free_string)
+ * @param out_metrics Receives the call's metrics; generated_tokens counts
+ *        every candidate (may be NULL)
+ * @return Number of strings written to out_texts (0 on failure)
+ */
+int llm_generate_n(
+    llm_session *session,
     const char **roles,
     const char **contents,
     int count,
-    int max_tokens,
-    float temperature,
-    float top_p,
-    int top_k,
-    float repeat_penalty,
-    llm_on_token on_token,
+    int n,
+    const llm_gen_params *params,
+    llm_on_progress on_progress,
+    void *progress_user,
+    char **out_texts,
+    llm_gen_metrics *out_metrics
+);
+
+// Streamed text of candidate `index`; same guarantees as llm_on_text.
+typedef void (*llm_on_candidate_text)(int index, const char *text, int length, void *user);
+
+/**
+ * Stream llm_generate_n: batches of every candidate's text, interleaved,
+ * coalesced per candidate as for llm_generate_stream.
+ *
+ * @param on_text Callback for each batch of a candidate's text
+ * @param on_error Callback for errors
+ * @param user User data passed to all callbacks
+ */
+void llm_generate_n_stream(
+    llm_session *session,
+    const char **roles,
+    const char **contents,
+    int count,
+    int n,
+    const llm_gen_params *params,
+    llm_on_progress on_progress,
+    int batch_tokens,
+    int batch_ms,
+    llm_on_candidate_text on_text,
     llm_on_error on_error,
+    llm_gen_metrics *out_metrics,
     void *user
 );
 
 /**
- * Cancel an in-progress generation.
+ * Log-probability of each of n continuations after the conversation, for
+ * classification and reranking without generating text. The prompt is
+ * prefilled once and the continuations are teacher-forced together, up to
+ * score_sequences per pass (max_candidates when larger). Needs a session
+ * with its own context.
+ *
+ * @param session Session to score on
+ * @param roles, contents, count Conversation, as for llm_generate
+ * @param continuations Candidate texts, tokenized without BOS/EOS
+ * @param n Number of continuations
+ * @param out_counts Receives each continuation's token count (n long)
+ * @param out_logprobs Receives every continuation's per-token
+ *        log-probabilities back to back; their sum is log P(continuation)
+ * @param capacity Length of out_logprobs: the sum of llm_count_tokens over
+ *        the continuations, or at most their total UTF-8 length plus n
+ * @return Number of log-probabilities written, -1 on failure or when
+ *         capacity is too small
+ */
+int llm_score_continuations(
+    llm_session *session,
+    const char **roles,
+    const char **contents,
+    int count,
+    const char **continuations,
+    int n,
+    int *out_counts,
+    float *out_logprobs,
+    int capacity
+);
+
+/**
+ * Cancel an in-progress generation on the given session. It stops inside the
+ * current decode (at the next step on a scheduler model); the request's
+ * llm_gen_metrics.cancel_ms reports how long that took.
+ */
+void llm_cancel(llm_session *session);
+
+/** Speculative-decoding counters accumulated since the session was created. */
+typedef struct {
+    int64_t drafted;    // tokens proposed by the draft model
+    int64_t accepted;   // proposals the target model agreed with
+    int64_t rounds;     // target verification passes
+} llm_spec_stats;
+
+/**
+ * Read a session's speculative-decoding counters. Safe to call while a
+ * generation is running. All zero when the model has no draft model.
+ */
+llm_spec_stats llm_speculative_stats(llm_session *session);
+
+/**
+ * Token count of each of count texts into out_counts, as plain text without
+ * BOS/EOS. Runs the tokenizer only, not the model.
+ */
+void llm_count_tokens(llm_model *model, const char **texts, int count, int *out_counts);
+
+/**
+ * Pack count chunks, best first, into at most max_tokens tokens separated by
+ * "\n\n---\n\n". A chunk that does not fit is cut at a token boundary if
+ * enough budget is left, else skipped. Writes the token ids to out_tokens
+ * (max_tokens long) and the tokens packed per chunk (0 = skipped) to
+ * out_chunk_tokens (count long, may be NULL).
+ * @return Number of tokens written
+ */
+int llm_pack_context(llm_model *model, const char **chunks, int count, int max_tokens,
+                     int32_t *out_tokens, int *out_chunk_tokens);
+
+/** Cross-session prefix cache counters of a model. */
+typedef struct {
+    int64_t lookups;        // prompts checked against the cache
+    int64_t hits;           // prompts that reused a cached prefix
+    int64_t tokens_reused;  // prompt tokens not prefilled thanks to hits
+    int64_t insertions;
+    int64_t evictions;
+    int64_t entries;
+    int64_t bytes_used;
+    int64_t budget_bytes;
+} llm_prefix_stats;
+
+/** Read a model's prefix cache counters. Safe to call at any time. */
+llm_prefix_stats llm_prefix_cache_stats(llm_model *model);
+
+// Histogram bucket i counts values below 2^i (bucket 0: below 1); the last
+// bucket counts everything larger.
+#define LLM_METRICS_BUCKETS 20
+
+/** Metrics of every request finished on a model, aggregated. */
+typedef struct {
+    int64_t requests;
+    int64_t prompt_tokens;
+    int64_t cached_tokens;
+    int64_t generated_tokens;
+    int64_t ttft_ms[LLM_METRICS_BUCKETS];
+    int64_t prefill_tps[LLM_METRICS_BUCKETS];
+    int64_t decode_tps[LLM_METRICS_BUCKETS];
+    int64_t cancel_ms[LLM_METRICS_BUCKETS];     // cancelled requests only
+} llm_metrics_histogram;
+
+/**
+ * Copy a model's aggregated metrics into out. reset clears them afterwards,
+ * so each poll covers the requests since the previous one.
+ */
+void llm_metrics_snapshot(llm_model *model, bool reset, llm_metrics_histogram *out);
+
+// ═══════════════════════════════════════════════════════════════
+//                            JOBS
+// ═══════════════════════════════════════════════════════════════
+
+/** State of an asynchronous generation job. */
+typedef enum {
+    LLM_JOB_UNKNOWN   = 0,   // never submitted, already taken or discarded
+    LLM_JOB_QUEUED    = 1,
+    LLM_JOB_RUNNING   = 2,
+    LLM_JOB_DONE      = 3,
+    LLM_JOB_CANCELLED = 4,
+    LLM_JOB_FAILED    = 5,   // the request could not run or a decode failed
+} llm_job_state;
+
+/**
+ * llm_generate as a job on the model's executor, returning at once. Jobs
+ * with a higher priority run first; jobs on one session run one at a time.
+ * The job reports no progress.
+ *
+ * @return Job id; 0 when the model's queue is full (retry after a
+ *         completion), -1 on failure
+ */
+int64_t llm_job_submit(
+    llm_session *session,
+    const char **roles,
+    const char **contents,
+    int count,
+    const llm_gen_params *params,
+    int priority
+);
+
+llm_job_state llm_job_poll(int64_t job);
+
+/**
+ * Cancel a job: a queued one never runs, a running one stops like
+ * llm_cancel. discard drops its result and leaves it off the completion
+ * channel. @return false if the job is unknown
+ */
+bool llm_job_cancel(int64_t job, bool discard);
+
+/**
+ * The completion channel shared by all models: writes up to max_ids ids of
+ * jobs finished since the last call, waiting up to timeout_ms (< 0 = forever)
+ * for the first. Ids beyond max_ids are returned by the next call.
+ * @return Number of ids written (0 on timeout)
+ */
+int llm_jobs_wait(int64_t *out_ids, int max_ids, int timeout_ms);
+
+/**
+ * Result of a finished job, which is then forgotten. Poll first to tell a
+ * failed job (LLM_JOB_FAILED, text empty or partial) from a done one.
+ * @return Generated text (free with llm_free_string), or NULL if the job is
+ *         not finished
+ */
+char *llm_job_take(int64_t job, llm_gen_metrics *out_metrics);
+
+// ═══════════════════════════════════════════════════════════════
+//                          THREADS
+// ═══════════════════════════════════════════════════════════════
+
+/** Thread configuration of a loaded model; fields as in llm_model_params. */
+typedef struct {
+    int      threads;
+    int      batch_threads;
+    uint64_t cpu_mask;
+    uint64_t cpu_mask_batch;
+    bool     strict_cpu;
+} llm_threads;
+
+/** Change a model's threads without reloading; sessions apply them before their next decode. */
+void llm_set_threads(llm_model *model, const llm_threads *threads);
+
+/** Read a model's current thread configuration. */
+llm_threads llm_get_threads(llm_model *model);
+
+/** Result of llm_autotune_threads. */
+typedef struct {
+    int    threads;         // fastest decode thread count
+    int    batch_threads;   // fastest prefill thread count
+    double decode_tps;
+    double prefill_tps;
+    bool   cached;          // read from the cache file, nothing measured
+} llm_thread_tuning;
+
+/**
+ * Measure decode and prefill throughput over a range of thread counts and
+ * apply the fastest of each (a few seconds). Results are cached in cache_path
+ * (NULL = always measure) per model, device and CPU masks.
+ * @return false if the measurement failed
+ */
+bool llm_autotune_threads(llm_model *model, const char *cache_path, llm_thread_tuning *out);
+
+// ═══════════════════════════════════════════════════════════════
+//                       RAG: BM25 INDEX
+// ═══════════════════════════════════════════════════════════════
+
+/** Create an empty index (k1 = 1.5, b = 0.75 are the usual values). */
+llm_bm25 *llm_bm25_create(float k1, float b);
+
+/**
+ * Memory-map an index written by llm_bm25_save. Searchable immediately;
+ * copied into memory on its first modification.
+ * @return NULL if the file is missing or not a valid index
+ */
+llm_bm25 *llm_bm25_load(const char *path);
+
+void llm_bm25_free(llm_bm25 *index);
+
+/**
+ * Index count documents. sources may be NULL, as may any of its entries.
+ * Writes the documents' ids (stable across save/load) to out_ids.
+ */
+void llm_bm25_add(llm_bm25 *index, const char **texts, const char **sources, int count, int64_t *out_ids);
+
+/** Remove a document. false if the id is unknown. */
+bool llm_bm25_remove(llm_bm25 *index, int64_t id);
+
+/** Number of indexed documents. */
+int llm_bm25_size(llm_bm25 *index);
+
+/** Write the index to path. */
+bool llm_bm25_save(llm_bm25 *index, const char *path);
+
+/** One result; text and source (NULL if none) are valid during the call only. */
+typedef void (*llm_bm25_on_hit)(int64_t id, float score, const char *text, const char *source, void *user);
+
+/**
+ * Find the top_k best-matching documents, calling on_hit for each, best first.
+ * @return Number of results
+ */
+int llm_bm25_search(llm_bm25 *index, const char *query, int top_k, llm_bm25_on_hit on_hit, void *user);
+
+// ═══════════════════════════════════════════════════════════════
+//                       RAG: EMBEDDINGS
+// ═══════════════════════════════════════════════════════════════
+
+/** How a text's token embeddings are pooled into one vector. */
+typedef enum {
+    LLM_POOLING_MODEL = 0,   // the model's own setting (mean if it has none)
+    LLM_POOLING_MEAN  = 1,
+    LLM_POOLING_CLS   = 2,
+    LLM_POOLING_LAST  = 3,
+} llm_pooling;
+
+/** Embedding model parameters. Start from llm_embed_default_params(). */
+typedef struct {
+    int         max_threads;
+    bool        use_gpu;
+    /** Tokens per decode call; also the per-text limit (longer texts are truncated). */
+    int         batch_tokens;
+    /** Texts decoded together in one call, each on its own sequence. */
+    int         batch_texts;
+    llm_pooling pooling;
+    /** L2-normalise vectors, so dot product = cosine similarity. */
+    bool        normalize;
+    /** Contexts, and so llm_embed calls that run at once (e.g. one per ingest thread). */
+    int         contexts;
+} llm_embed_params;
+
+llm_embed_params llm_embed_default_params(void);
+
+/** Load a GGUF embedding model. NULL on failure or for reranker models. */
+llm_embedder *llm_embedder_load(const char *model_path, const llm_embed_params *params);
+
+void llm_embedder_free(llm_embedder *embedder);
+
+/** Length of each vector. */
+int llm_embedder_dim(llm_embedder *embedder);
+
+/**
+ * Embed count texts into out (count * dim floats, row-major), batching as
+ * many as fit into each decode call.
+ * @return false if decoding failed
+ */
+bool llm_embed(llm_embedder *embedder, const char **texts, int count, float *out);
+
+// ═══════════════════════════════════════════════════════════════
+//                       RAG: HNSW INDEX
+// ═══════════════════════════════════════════════════════════════
+
+/** HNSW index parameters. Start from llm_hnsw_default_params() and set dim. */
+typedef struct {
+    /** Vector length (the embedding model's dimension). */
+    int  dim;
+    /** Links per node per level; more = better recall, more memory. */
+    int  m;
+    /** Search width while inserting. */
+    int  ef_construction;
+    /** Default search width for queries. */
+    int  ef_search;
+    /** Store vectors as int8 (a quarter of the memory). */
+    bool quantize;
+    /** Insert threads (0 = all cores). */
+    int  build_threads;
+} llm_hnsw_params;
+
+llm_hnsw_params llm_hnsw_default_params(void);
+
+/** Create an empty index. NULL if params->dim <= 0. */
+llm_hnsw *llm_hnsw_create(const llm_hnsw_params *params);
+
+/**
+ * Memory-map an index written by llm_hnsw_save. Searchable immediately;
+ * copied into memory on its first insert.
+ * @return NULL if the file is missing or not a valid index
+ */
+llm_hnsw *llm_hnsw_load(const char *path);
+
+void llm_hnsw_free(llm_hnsw *index);
+
+int llm_hnsw_dim(llm_hnsw *index);
+
+/**
+ * Insert count vectors (count * dim floats, row-major) with their texts.
+ * sources may be NULL, as may any of its entries. Writes the ids to out_ids.
+ */
+void llm_hnsw_add(llm_hnsw *index, const float *vectors, const char **texts, const char **sources,
+                  int count, int64_t *out_ids);
+
+/** Hide a vector from results. false if the id is unknown. */
+bool llm_hnsw_remove(llm_hnsw *index, int64_t id);
+
+/** Number of live vectors. */
+int llm_hnsw_size(llm_hnsw *index);
+
+/** Write the index to path. */
+bool llm_hnsw_save(llm_hnsw *index, const char *path);
+
+/**
+ * Find the top_k most similar vectors to query (dim floats), calling on_hit
+ * for each, best first; score is the cosine similarity. ef <= 0 uses the
+ * index's ef_search.
+ * @return Number of results
+ */
+int llm_hnsw_search(llm_hnsw *index, const float *query, int top_k, int ef, llm_bm25_on_hit on_hit, void *user);
+
+// ═══════════════════════════════════════════════════════════════
+//                       RAG: INGESTION
+// ═══════════════════════════════════════════════════════════════
+
+/** Ingestion parameters. Start from llm_ingest_default_params(). */
+typedef struct {
+    /** Tokens per chunk, and tokens shared by consecutive chunks. */
+    int         chunk_tokens;
+    int         overlap_tokens;
+    /** Worker threads (0 = all cores). */
+    int         threads;
+    /** Text read ahead of the workers, in bytes. */
+    int64_t     max_buffered_bytes;
+    /** GGUF model whose tokenizer sizes chunks; NULL = the embedder's model. */
+    const char *tokenizer_path;
+    /** Extensions of files taken from directories; NULL = txt, md, markdown. */
+    const char **extensions;
+    int         extension_count;
+    /** Index files written after a complete run, or NULL. */
+    const char *bm25_path;
+    const char *hnsw_path;
+} llm_ingest_params;
+
+typedef struct {
+    int64_t files;
+    int64_t failed_files;
+    int64_t bytes;
+    int64_t chunks;
+    int64_t tokens;
+    bool    cancelled;
+} llm_ingest_stats;
+
+llm_ingest_params llm_ingest_default_params(void);
+
+/** Called on the ingesting thread with bytes indexed and the corpus size. Return false to stop. */
+typedef bool (*llm_ingest_on_progress)(int64_t done, int64_t total, void *user);
+
+/**
+ * Chunk the files (and directories, recursively) in paths and add the chunks
+ * to bm25 and/or hnsw (either may be NULL, not both; hnsw needs embedder).
+ * Tokenization, indexing and embedding run on a worker pool.
+ * @return false if ingestion failed; out_stats is filled either way
  */
-void llm_cancel(void);
+bool llm_ingest(const char **paths, int path_count, llm_bm25 *bm25, llm_embedder *embedder, llm_hnsw *hnsw,
+                const llm_ingest_params *params, llm_ingest_stats *out_stats,
+                llm_ingest_on_progress on_progress, void *user);
 
 // ═══════════════════════════════════════════════════════════════
 //                         UTILITIES
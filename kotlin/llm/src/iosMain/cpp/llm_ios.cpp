@@ -1,211 +1,740 @@
 #include "../c_interop/include/llm_ios.h"
-#include "llama.h"
-
+#include "deviceai_llm_engine.h"
+#include "deviceai_llm_snapshot.h"
+#include "deviceai_llm_prefix_cache.h"
+#include "deviceai_llm_memory.h"
+#include "deviceai_llm_stream.h"
+#include "deviceai_llm_context.h"
+#include "deviceai_llm_bm25.h"
+#include "deviceai_llm_embed.h"
+#include "deviceai_llm_hnsw.h"
+#include "deviceai_llm_ingest.h"
+#include "deviceai_llm_pack.h"
+#include "deviceai_llm_metrics.h"
+#include "deviceai_llm_threads.h"
+#include "deviceai_llm_nbest.h"
+#include "deviceai_llm_jobs.h"
+#include "deviceai_llm_score.h"
+
+#include <algorithm>
+#include <iterator>
 #include <string>
 #include <vector>
-#include <atomic>
-#include <functional>
 #include <cstring>
+#include <cstdlib>
 #include <cstdio>
 
+// The opaque C handles are the shared engine's objects.
+static inline dai_llm_model    *unwrap(llm_model *m)    { return reinterpret_cast<dai_llm_model *>(m); }
+static inline dai_llm_session  *unwrap(llm_session *s)  { return reinterpret_cast<dai_llm_session *>(s); }
+static inline dai_llm_bm25     *unwrap(llm_bm25 *x)     { return reinterpret_cast<dai_llm_bm25 *>(x); }
+static inline dai_llm_embedder *unwrap(llm_embedder *e) { return reinterpret_cast<dai_llm_embedder *>(e); }
+static inline dai_llm_hnsw     *unwrap(llm_hnsw *x)     { return reinterpret_cast<dai_llm_hnsw *>(x); }
+
 // ═══════════════════════════════════════════════════════════════
-//                         Global state
+//              Chat-template prompt formatting
+// Accepts role/content arrays. Uses the model's embedded Jinja template
+// via llama_chat_apply_template (ChatML, Llama 3, Gemma, Mistral, etc.).
 // ═══════════════════════════════════════════════════════════════
 
-static llama_model   *g_model   = nullptr;
-static llama_context *g_ctx     = nullptr;
-static std::atomic<bool> g_cancel{false};
+// system_prefix, when given, receives the formatted leading system messages
+// (the tokens a context shift keeps pinned).
+static std::string build_full_prompt(
+    dai_llm_session *s, const char **roles, const char **contents, int count,
+    bool add_assistant = true, std::string *system_prefix = nullptr
+) {
+    if (!s || count <= 0) return "";
 
-// ═══════════════════════════════════════════════════════════════
-//                         Helpers
-// ═══════════════════════════════════════════════════════════════
+    std::vector<std::string> r, c;
+    r.reserve(count);
+    c.reserve(count);
+    for (int i = 0; i < count; i++) {
+        r.push_back(roles[i]    ? roles[i]    : "");
+        c.push_back(contents[i] ? contents[i] : "");
+    }
+    if (system_prefix) *system_prefix = dai_llm_context_system_prefix(s->model, r, c);
+    return dai_llm_format_chat(s->model, r, c, add_assistant);
+}
 
-static void cleanup() {
-    if (g_ctx)   { llama_free(g_ctx);           g_ctx   = nullptr; }
-    if (g_model) { llama_model_free(g_model);   g_model = nullptr; }
+static dai_llm_kv_type kv_type(llm_kv_type type) {
+    return type == LLM_KV_Q8_0 ? DAI_LLM_KV_Q8_0 : type == LLM_KV_Q4_0 ? DAI_LLM_KV_Q4_0 : DAI_LLM_KV_F16;
 }
 
-static llama_sampler *build_sampler(float temperature, float top_p, int top_k, float repeat_penalty) {
-    auto *chain = llama_sampler_chain_init(llama_sampler_chain_default_params());
-    llama_sampler_chain_add(chain, llama_sampler_init_top_k(top_k));
-    llama_sampler_chain_add(chain, llama_sampler_init_top_p(top_p, 1));
-    llama_sampler_chain_add(chain, llama_sampler_init_temp(temperature));
-    llama_sampler_chain_add(chain, llama_sampler_init_penalties(
-        64, repeat_penalty, 0.0f, 0.0f
-    ));
-    llama_sampler_chain_add(chain, llama_sampler_init_dist(LLAMA_DEFAULT_SEED));
-    return chain;
+static dai_llm_model_params model_params(const llm_model_params *in) {
+    llm_model_params src = in ? *in : llm_model_default_params();
+    dai_llm_model_params p;
+    p.n_threads          = src.max_threads;
+    p.use_gpu            = src.use_gpu;
+    p.n_parallel         = src.n_parallel;
+    p.draft_path         = src.draft_model_path ? src.draft_model_path : "";
+    p.prefix_cache_bytes = src.prefix_cache_bytes > 0 ? (size_t)src.prefix_cache_bytes : 0;
+    p.n_ctx              = src.n_ctx;
+    p.n_batch            = src.n_batch;
+    p.n_ubatch           = src.n_ubatch;
+    p.type_k             = kv_type(src.type_k);
+    p.type_v             = kv_type(src.type_v);
+    p.flash_attn         = src.flash_attn;
+    p.use_mmap           = src.use_mmap;
+    p.use_mlock          = src.use_mlock;
+    p.n_threads_batch    = src.batch_threads;
+    p.cpu_mask           = src.cpu_mask;
+    p.cpu_mask_batch     = src.cpu_mask_batch;
+    p.strict_cpu         = src.strict_cpu;
+    p.max_candidates     = src.max_candidates;
+    p.score_sequences    = src.score_sequences;
+    p.job_workers        = src.job_workers;
+    p.job_queue          = src.job_queue;
+    return p;
+}
+
+static dai_llm_progress_cb progress_cb(llm_on_progress on_progress, void *user) {
+    if (!on_progress) return nullptr;
+    return [on_progress, user](int processed, int total) { on_progress(processed, total, user); };
+}
+
+static void write_metrics(const dai_llm_gen_metrics &m, llm_gen_metrics *out) {
+    if (!out) return;
+    *out = { m.prompt_tokens, m.cached_tokens, m.generated_tokens,
+             m.ttft_ms, m.prefill_ms, m.decode_ms, m.sample_ms, m.prefill_tps, m.decode_tps,
+             m.kv_peak, m.n_ctx, m.cancel_ms, m.stop_reason };
 }
 
 // ═══════════════════════════════════════════════════════════════
-//              Chat-template prompt formatting
-// Accepts role/content arrays. Uses the model's embedded Jinja template
-// via llama_chat_apply_template (ChatML, Llama 3, Gemma, Mistral, etc.).
+//                         C API
 // ═══════════════════════════════════════════════════════════════
 
-static std::string build_full_prompt(const char **roles, const char **contents, int count) {
-    if (!g_model || count <= 0) return "";
+extern "C" {
+
+llm_gen_params llm_gen_default_params(void) {
+    dai_llm_gen_params d;
+    llm_gen_params p = {};
+    p.max_tokens         = d.max_tokens;
+    p.temperature        = d.temperature;
+    p.top_p              = d.top_p;
+    p.top_k              = d.top_k;
+    p.repeat_penalty     = d.repeat_penalty;
+    p.seed               = d.seed;
+    p.prefill_chunk      = d.prefill_chunk;
+    p.n_draft            = d.n_draft;
+    p.prompt_lookup      = d.prompt_lookup;
+    p.context_shift      = d.context_shift;
+    p.n_keep             = d.n_keep;
+    p.repeat_stop_tokens = d.repeat_stop_tokens;
+    return p;
+}
 
-    // MUST reserve before the loop — any reallocation of storage invalidates all
-    // .c_str() pointers already stored in msgs entries (dangling pointer UB).
-    std::vector<std::string>        storage;
-    std::vector<llama_chat_message> msgs;
-    storage.reserve(count * 2);
+llm_model_params llm_model_default_params(void) {
+    dai_llm_model_params d;
+    llm_model_params p;
+    p.max_threads        = d.n_threads;
+    p.use_gpu            = d.use_gpu;
+    p.n_parallel         = d.n_parallel;
+    p.draft_model_path   = nullptr;
+    p.prefix_cache_bytes = 0;
+    p.n_ctx              = d.n_ctx;
+    p.n_batch            = d.n_batch;
+    p.n_ubatch           = d.n_ubatch;
+    p.type_k             = LLM_KV_F16;
+    p.type_v             = LLM_KV_F16;
+    p.flash_attn         = d.flash_attn;
+    p.use_mmap           = d.use_mmap;
+    p.use_mlock          = d.use_mlock;
+    p.batch_threads      = d.n_threads_batch;
+    p.cpu_mask           = d.cpu_mask;
+    p.cpu_mask_batch     = d.cpu_mask_batch;
+    p.strict_cpu         = d.strict_cpu;
+    p.max_candidates     = d.max_candidates;
+    p.score_sequences    = d.score_sequences;
+    p.job_workers        = d.job_workers;
+    p.job_queue          = d.job_queue;
+    return p;
+}
 
-    for (int i = 0; i < count; i++) {
-        storage.push_back(roles[i]    ? roles[i]    : "");
-        storage.push_back(contents[i] ? contents[i] : "");
-        msgs.push_back({ storage[storage.size()-2].c_str(), storage.back().c_str() });
-    }
+llm_model *llm_init(const char *model_path, const llm_model_params *params) {
+    dai_llm_model *m = dai_llm_model_load(model_path ? model_path : "", model_params(params));
+    if (!m) fprintf(stderr, "[LlmIos] Failed to load model: %s\n", model_path);
+    return reinterpret_cast<llm_model *>(m);
+}
 
-    const char *tmpl = llama_model_chat_template(g_model, nullptr);
-    int32_t sz = llama_chat_apply_template(tmpl, msgs.data(), msgs.size(), true, nullptr, 0);
-    if (sz <= 0) return "";
+bool llm_estimate_memory(const char *model_path, const llm_model_params *params,
+                         int n_sessions, llm_memory_estimate *out) {
+    if (!model_path || !out) return false;
+    dai_llm_memory_estimate est;
+    if (!dai_llm_estimate_memory(model_path, model_params(params), n_sessions, est)) return false;
+    out->n_ctx         = est.n_ctx;
+    out->weights_bytes = (int64_t)est.weights_bytes;
+    out->kv_bytes      = (int64_t)est.kv_bytes;
+    out->compute_bytes = (int64_t)est.compute_bytes;
+    out->total_bytes   = (int64_t)est.total_bytes;
+    return true;
+}
+
+void llm_shutdown(llm_model *model) {
+    dai_llm_model_release(unwrap(model));
+}
+
+llm_session *llm_session_create(llm_model *model) {
+    dai_llm_session *s = dai_llm_session_create(unwrap(model));
+    if (!s) fprintf(stderr, "[LlmIos] Failed to create context\n");
+    return reinterpret_cast<llm_session *>(s);
+}
+
+void llm_session_free(llm_session *session) {
+    dai_llm_session_free(unwrap(session));
+}
+
+int llm_warm_prefix(
+    llm_session *session,
+    const char **roles, const char **contents, int count,
+    const char *cache_dir
+) {
+    auto *s = unwrap(session);
+    std::string prefix = build_full_prompt(s, roles, contents, count, /*add_assistant=*/false);
+    return dai_llm_session_warm(s, prefix, cache_dir ? cache_dir : "");
+}
+
+// Pack the RAG chunks with the session's tokenizer and have the engine
+// splice the tokens in where the marker appears in the prompt.
+static void splice_context(dai_llm_session *s, const char *marker, const char **chunks, int count, int max_tokens,
+                           dai_llm_gen_params &params) {
+    if (!s || !marker || !chunks) return;
+    std::vector<std::string> v;
+    for (int i = 0; i < count; i++) v.emplace_back(chunks[i] ? chunks[i] : "");
+    params.splice_marker = marker;
+    params.splice_tokens = dai_llm_pack_context(llama_model_get_vocab(s->model->model), v, max_tokens).tokens;
+}
+
+// A request's llm_gen_params as engine parameters, RAG chunks packed with
+// the session's tokenizer.
+static dai_llm_gen_params gen_params(dai_llm_session *s, const llm_gen_params *in) {
+    llm_gen_params src = in ? *in : llm_gen_default_params();
+    dai_llm_gen_params p;
+    p.max_tokens         = src.max_tokens;
+    p.temperature        = src.temperature;
+    p.top_p              = src.top_p;
+    p.top_k              = src.top_k;
+    p.repeat_penalty     = src.repeat_penalty;
+    p.seed               = src.seed;
+    p.prefill_chunk      = src.prefill_chunk;
+    p.n_draft            = src.n_draft;
+    p.prompt_lookup      = src.prompt_lookup;
+    p.context_shift      = src.context_shift;
+    p.n_keep             = src.n_keep;
+    p.repeat_stop_tokens = src.repeat_stop_tokens;
+    for (int i = 0; src.stop && i < src.stop_count; i++) {
+        if (src.stop[i]) p.stop.emplace_back(src.stop[i]);
+    }
+    if (src.grammar) p.grammar = src.grammar;
+    splice_context(s, src.context_marker, src.context_chunks, src.context_count, src.context_tokens, p);
+    return p;
+}
 
-    std::string out(sz, '\0');
-    llama_chat_apply_template(tmpl, msgs.data(), msgs.size(), true, out.data(), sz);
+char *llm_generate(
+    llm_session *session,
+    const char **roles, const char **contents, int count,
+    const llm_gen_params *gen,
+    llm_on_progress on_progress,
+    void *progress_user,
+    llm_gen_metrics *out_metrics
+) {
+    auto *s = unwrap(session);
+    auto params = gen_params(s, gen);
+    std::string full = build_full_prompt(s, roles, contents, count, true,
+                                         params.context_shift && params.n_keep < 0 ? &params.keep_prefix : nullptr);
+    dai_llm_gen_metrics metrics;
+    std::string result = dai_llm_generate(
+        s, full, params,
+        [](const std::string &) { return true; },
+        progress_cb(on_progress, progress_user),
+        &metrics
+    );
+    write_metrics(metrics, out_metrics);
+    char *out = (char *)malloc(result.size() + 1);
+    if (out) memcpy(out, result.c_str(), result.size() + 1);
     return out;
 }
 
-static std::string do_generate(
-    const std::string &full_prompt,
-    int max_tokens,
-    float temperature,
-    float top_p,
-    int top_k,
-    float repeat_penalty,
-    std::function<bool(const std::string &)> on_token
+void llm_generate_stream(
+    llm_session *session,
+    const char **roles, const char **contents, int count,
+    const llm_gen_params *gen,
+    llm_on_progress on_progress,
+    int batch_tokens,
+    int batch_ms,
+    llm_on_text on_text,
+    llm_on_error on_error,
+    llm_gen_metrics *out_metrics,
+    void *user
 ) {
-    if (!g_model || !g_ctx) return "";
-
-    llama_memory_clear(llama_get_memory(g_ctx), /*data=*/false);
-    llama_perf_context_reset(g_ctx);
-
-    const llama_vocab *vocab = llama_model_get_vocab(g_model);
-    int n_ctx_max = llama_n_ctx(g_ctx);
-    std::vector<llama_token> tokens(n_ctx_max);
-    int n_tokens = llama_tokenize(
-        vocab,
-        full_prompt.c_str(),
-        (int)full_prompt.size(),
-        tokens.data(),
-        n_ctx_max,
-        true, true
+    auto *s = unwrap(session);
+    auto params = gen_params(s, gen);
+    std::string full = build_full_prompt(s, roles, contents, count, true,
+                                         params.context_shift && params.n_keep < 0 ? &params.keep_prefix : nullptr);
+
+    dai_llm_stream_batcher batcher;
+    batcher.max_tokens = batch_tokens;
+    batcher.max_ms     = batch_ms;
+    batcher.on_text    = [&](const std::string &text) {
+        if (on_text) on_text(text.c_str(), (int)text.size(), user);
+        return true;
+    };
+
+    dai_llm_gen_metrics metrics;
+    dai_llm_generate(
+        s, full, params,
+        [&](const std::string &piece) -> bool {
+            return dai_llm_stream_push(batcher, piece) && !s->cancel.load();
+        },
+        progress_cb(on_progress, user),
+        &metrics
     );
-    if (n_tokens < 0) return "";
-    tokens.resize(n_tokens);
+    dai_llm_stream_finish(batcher);
+    write_metrics(metrics, out_metrics);
+    if (metrics.failed && on_error) on_error("Generation failed", user);
+    // Flow completes naturally when llm_generate_stream returns — no on_complete callback needed.
+}
 
-    llama_batch batch = llama_batch_get_one(tokens.data(), (int)tokens.size());
-    if (llama_decode(g_ctx, batch)) return "";
+int llm_generate_n(
+    llm_session *session,
+    const char **roles, const char **contents, int count,
+    int n,
+    const llm_gen_params *gen,
+    llm_on_progress on_progress,
+    void *progress_user,
+    char **out_texts,
+    llm_gen_metrics *out_metrics
+) {
+    auto *s = unwrap(session);
+    auto params = gen_params(s, gen);
+    params.context_shift = false;   // candidates share sequence 0's prompt cells
+    std::string full = build_full_prompt(s, roles, contents, count, true);
+    dai_llm_gen_metrics metrics;
+    std::vector<std::string> results = dai_llm_generate_n(
+        s, full, params, n,
+        [](int, const std::string &) { return true; },
+        progress_cb(on_progress, progress_user),
+        &metrics
+    );
+    write_metrics(metrics, out_metrics);
+    if (!out_texts) return 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        out_texts[i] = (char *)malloc(results[i].size() + 1);
+        if (out_texts[i]) memcpy(out_texts[i], results[i].c_str(), results[i].size() + 1);
+    }
+    return (int)results.size();
+}
 
-    auto *sampler = build_sampler(temperature, top_p, top_k, repeat_penalty);
+void llm_generate_n_stream(
+    llm_session *session,
+    const char **roles, const char **contents, int count,
+    int n,
+    const llm_gen_params *gen,
+    llm_on_progress on_progress,
+    int batch_tokens,
+    int batch_ms,
+    llm_on_candidate_text on_text,
+    llm_on_error on_error,
+    llm_gen_metrics *out_metrics,
+    void *user
+) {
+    auto *s = unwrap(session);
+    auto params = gen_params(s, gen);
+    params.context_shift = false;   // candidates share sequence 0's prompt cells
+    std::string full = build_full_prompt(s, roles, contents, count, true);
+
+    // One batcher per candidate: each holds back its own split characters.
+    std::vector<dai_llm_stream_batcher> batchers(std::max(0, n));
+    for (size_t i = 0; i < batchers.size(); i++) {
+        batchers[i].max_tokens = batch_tokens;
+        batchers[i].max_ms     = batch_ms;
+        batchers[i].on_text    = [on_text, user, i](const std::string &text) {
+            if (on_text) on_text((int)i, text.c_str(), (int)text.size(), user);
+            return true;
+        };
+    }
 
-    std::string result;
-    char piece_buf[256];
-    int n_generated = 0;
+    dai_llm_gen_metrics metrics;
+    std::vector<std::string> results = dai_llm_generate_n(
+        s, full, params, n,
+        [&](int index, const std::string &piece) -> bool {
+            return dai_llm_stream_push(batchers[index], piece) && !s->cancel.load();
+        },
+        progress_cb(on_progress, user),
+        &metrics
+    );
+    for (size_t i = 0; i < results.size(); i++) dai_llm_stream_finish(batchers[i]);
+    write_metrics(metrics, out_metrics);
+    if (metrics.failed && on_error) on_error("Generation failed", user);
+}
 
-    while (n_generated < max_tokens && !g_cancel.load()) {
-        llama_token token = llama_sampler_sample(sampler, g_ctx, -1);
-        llama_sampler_accept(sampler, token);
+int llm_score_continuations(
+    llm_session *session,
+    const char **roles, const char **contents, int count,
+    const char **continuations, int n,
+    int *out_counts,
+    float *out_logprobs,
+    int capacity
+) {
+    auto *s = unwrap(session);
+    std::string full = build_full_prompt(s, roles, contents, count, true);
+    std::vector<std::string> v;
+    for (int i = 0; i < n; i++) v.emplace_back(continuations[i] ? continuations[i] : "");
+
+    std::vector<dai_llm_continuation_score> scores;
+    if (!dai_llm_score_continuations(s, full, v, scores)) return -1;
+
+    size_t total = 0;
+    for (const dai_llm_continuation_score &score : scores) total += score.token_logprobs.size();
+    if (total > (size_t)capacity) return -1;
+
+    float *out = out_logprobs;
+    for (int i = 0; i < n; i++) {
+        out_counts[i] = (int)scores[i].token_logprobs.size();
+        out = std::copy(scores[i].token_logprobs.begin(), scores[i].token_logprobs.end(), out);
+    }
+    return (int)total;
+}
 
-        if (llama_vocab_is_eog(vocab, token)) break;
+void llm_cancel(llm_session *session) {
+    dai_llm_cancel(unwrap(session));
+}
 
-        int n = llama_token_to_piece(vocab, token, piece_buf, sizeof(piece_buf), 0, true);
-        if (n < 0) break;
+void llm_count_tokens(llm_model *model, const char **texts, int count, int *out_counts) {
+    dai_llm_model *m = unwrap(model);
+    std::vector<std::string> v;
+    for (int i = 0; i < count; i++) v.emplace_back(texts[i] ? texts[i] : "");
+    std::vector<int> counts = dai_llm_count_tokens(m ? llama_model_get_vocab(m->model) : nullptr, v);
+    for (int i = 0; i < count; i++) out_counts[i] = counts[i];
+}
 
-        std::string piece(piece_buf, n);
-        result += piece;
-        n_generated++;
+int llm_pack_context(llm_model *model, const char **chunks, int count, int max_tokens,
+                     int32_t *out_tokens, int *out_chunk_tokens) {
+    dai_llm_model *m = unwrap(model);
+    std::vector<std::string> v;
+    for (int i = 0; i < count; i++) v.emplace_back(chunks[i] ? chunks[i] : "");
+    dai_llm_packed_context packed = dai_llm_pack_context(m ? llama_model_get_vocab(m->model) : nullptr, v, max_tokens);
+    std::copy(packed.tokens.begin(), packed.tokens.end(), out_tokens);
+    if (out_chunk_tokens) std::copy(packed.chunk_tokens.begin(), packed.chunk_tokens.end(), out_chunk_tokens);
+    return (int)packed.tokens.size();
+}
 
-        if (!on_token(piece)) break;
+llm_spec_stats llm_speculative_stats(llm_session *session) {
+    dai_llm_spec_stats st = dai_llm_speculative_stats(unwrap(session));
+    return { st.n_drafted, st.n_accepted, st.n_rounds };
+}
 
-        llama_batch next = llama_batch_get_one(&token, 1);
-        if (llama_decode(g_ctx, next)) break;
-    }
+llm_prefix_stats llm_prefix_cache_stats(llm_model *model) {
+    dai_llm_model *m = unwrap(model);
+    dai_llm_prefix_stats st = dai_llm_prefix_cache_stats(m ? m->prefix_cache : nullptr);
+    return { st.lookups, st.hits, st.tokens_reused, st.insertions,
+             st.evictions, st.entries, st.bytes_used, st.budget_bytes };
+}
 
-    llama_sampler_free(sampler);
-    return result;
+static_assert(LLM_METRICS_BUCKETS == DAI_LLM_METRICS_BUCKETS, "bucket counts must match");
+
+void llm_metrics_snapshot(llm_model *model, bool reset, llm_metrics_histogram *out) {
+    if (!out) return;
+    dai_llm_model *m = unwrap(model);
+    dai_llm_metrics_histogram h = dai_llm_metrics_snapshot(m ? m->metrics : nullptr, reset);
+    out->requests         = h.requests;
+    out->prompt_tokens    = h.prompt_tokens;
+    out->cached_tokens    = h.cached_tokens;
+    out->generated_tokens = h.generated_tokens;
+    std::copy(std::begin(h.ttft_ms),     std::end(h.ttft_ms),     out->ttft_ms);
+    std::copy(std::begin(h.prefill_tps), std::end(h.prefill_tps), out->prefill_tps);
+    std::copy(std::begin(h.decode_tps),  std::end(h.decode_tps),  out->decode_tps);
+    std::copy(std::begin(h.cancel_ms),   std::end(h.cancel_ms),   out->cancel_ms);
 }
 
 // ═══════════════════════════════════════════════════════════════
-//                         C API
+//                           Jobs
 // ═══════════════════════════════════════════════════════════════
 
-extern "C" {
+int64_t llm_job_submit(
+    llm_session *session,
+    const char **roles, const char **contents, int count,
+    const llm_gen_params *gen,
+    int priority
+) {
+    auto *s = unwrap(session);
+    if (!s) return -1;
+    auto params = gen_params(s, gen);
+    std::string full = build_full_prompt(s, roles, contents, count, true,
+                                         params.context_shift && params.n_keep < 0 ? &params.keep_prefix : nullptr);
+    return dai_llm_job_submit(s, std::move(full), std::move(params), priority);
+}
 
-bool llm_init(const char *model_path, int max_threads, bool use_gpu) {
-    cleanup();
+llm_job_state llm_job_poll(int64_t job) {
+    return (llm_job_state)dai_llm_job_poll(job);
+}
 
-    llama_model_params mparams = llama_model_default_params();
-    mparams.n_gpu_layers = use_gpu ? 99 : 0;
+bool llm_job_cancel(int64_t job, bool discard) {
+    return dai_llm_job_cancel(job, discard);
+}
+
+int llm_jobs_wait(int64_t *out_ids, int max_ids, int timeout_ms) {
+    // Ids that did not fit in the caller's array last time.
+    static std::mutex           s_mutex;
+    static std::vector<int64_t> s_pending;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    if (s_pending.empty()) dai_llm_jobs_wait(s_pending, timeout_ms);
+    const int n = std::min(max_ids, (int)s_pending.size());
+    std::copy(s_pending.begin(), s_pending.begin() + n, out_ids);
+    s_pending.erase(s_pending.begin(), s_pending.begin() + n);
+    return n;
+}
+
+char *llm_job_take(int64_t job, llm_gen_metrics *out_metrics) {
+    dai_llm_job_result result;
+    if (!dai_llm_job_take(job, result)) return nullptr;
+    write_metrics(result.metrics, out_metrics);
+    char *out = (char *)malloc(result.text.size() + 1);
+    if (out) memcpy(out, result.text.c_str(), result.text.size() + 1);
+    return out;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          Threads
+// ═══════════════════════════════════════════════════════════════
+
+void llm_set_threads(llm_model *model, const llm_threads *threads) {
+    if (!threads) return;
+    dai_llm_threads t;
+    t.n_threads       = threads->threads;
+    t.n_threads_batch = threads->batch_threads;
+    t.cpu_mask        = threads->cpu_mask;
+    t.cpu_mask_batch  = threads->cpu_mask_batch;
+    t.strict_cpu      = threads->strict_cpu;
+    dai_llm_set_threads(unwrap(model), t);
+}
+
+llm_threads llm_get_threads(llm_model *model) {
+    dai_llm_threads t = dai_llm_get_threads(unwrap(model));
+    return { t.n_threads, t.n_threads_batch, t.cpu_mask, t.cpu_mask_batch, t.strict_cpu };
+}
+
+bool llm_autotune_threads(llm_model *model, const char *cache_path, llm_thread_tuning *out) {
+    dai_llm_thread_tuning r = dai_llm_threads_autotune(unwrap(model), cache_path ? cache_path : "");
+    if (r.n_threads <= 0) return false;
+    if (out) *out = { r.n_threads, r.n_threads_batch, r.decode_tps, r.prefill_tps, r.cached };
+    return true;
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                       RAG: BM25 index
+// ═══════════════════════════════════════════════════════════════
+
+llm_bm25 *llm_bm25_create(float k1, float b) {
+    return reinterpret_cast<llm_bm25 *>(dai_llm_bm25_create(k1, b));
+}
 
-    g_model = llama_model_load_from_file(model_path, mparams);
-    if (!g_model) {
-        fprintf(stderr, "[LlmIos] Failed to load model: %s\n", model_path);
-        return false;
+llm_bm25 *llm_bm25_load(const char *path) {
+    return reinterpret_cast<llm_bm25 *>(dai_llm_bm25_load(path ? path : ""));
+}
+
+void llm_bm25_free(llm_bm25 *index) {
+    dai_llm_bm25_free(unwrap(index));
+}
+
+void llm_bm25_add(llm_bm25 *index, const char **texts, const char **sources, int count, int64_t *out_ids) {
+    if (count <= 0) return;
+    std::vector<dai_llm_bm25_doc> docs(count);
+    for (int i = 0; i < count; i++) {
+        docs[i].text       = texts[i] ? texts[i] : "";
+        docs[i].has_source = sources && sources[i];
+        if (docs[i].has_source) docs[i].source = sources[i];
     }
+    std::vector<int64_t> ids = dai_llm_bm25_add(unwrap(index), docs);
+    for (int i = 0; i < count; i++) out_ids[i] = i < (int)ids.size() ? ids[i] : -1;
+}
 
-    llama_context_params cparams = llama_context_default_params();
-    // n_ctx = 0 → llama.cpp uses the model's native context size from GGUF metadata
-    cparams.n_ctx     = 0;
-    cparams.n_threads = max_threads;
-
-    g_ctx = llama_init_from_model(g_model, cparams);
-    if (!g_ctx) {
-        fprintf(stderr, "[LlmIos] Failed to create context\n");
-        llama_model_free(g_model);
-        g_model = nullptr;
-        return false;
+bool llm_bm25_remove(llm_bm25 *index, int64_t id) {
+    return dai_llm_bm25_remove(unwrap(index), id);
+}
+
+int llm_bm25_size(llm_bm25 *index) {
+    return (int)dai_llm_bm25_size(unwrap(index));
+}
+
+bool llm_bm25_save(llm_bm25 *index, const char *path) {
+    return dai_llm_bm25_save(unwrap(index), path ? path : "");
+}
+
+int llm_bm25_search(llm_bm25 *index, const char *query, int top_k, llm_bm25_on_hit on_hit, void *user) {
+    std::vector<dai_llm_bm25_hit> hits = dai_llm_bm25_search(unwrap(index), query ? query : "", top_k);
+    if (on_hit) {
+        for (const auto &h : hits) {
+            on_hit(h.id, h.score, h.text.c_str(), h.has_source ? h.source.c_str() : nullptr, user);
+        }
     }
+    return (int)hits.size();
+}
 
-    fprintf(stdout, "[LlmIos] Initialized: ctx=%d threads=%d gpu=%d\n",
-            llama_n_ctx(g_ctx), max_threads, use_gpu);
-    return true;
+llm_embed_params llm_embed_default_params(void) {
+    dai_llm_embed_params d;
+    llm_embed_params p;
+    p.max_threads  = d.n_threads;
+    p.use_gpu      = d.use_gpu;
+    p.batch_tokens = d.n_batch;
+    p.batch_texts  = d.n_seq_max;
+    p.pooling      = (llm_pooling)d.pooling;
+    p.normalize    = d.normalize;
+    p.contexts     = d.n_contexts;
+    return p;
 }
 
-void llm_shutdown(void) {
-    cleanup();
+llm_embedder *llm_embedder_load(const char *model_path, const llm_embed_params *params) {
+    const llm_embed_params src = params ? *params : llm_embed_default_params();
+    dai_llm_embed_params p;
+    p.n_threads  = src.max_threads;
+    p.use_gpu    = src.use_gpu;
+    p.n_batch    = src.batch_tokens;
+    p.n_seq_max  = src.batch_texts;
+    p.pooling    = (dai_llm_pooling)src.pooling;
+    p.normalize  = src.normalize;
+    p.n_contexts = src.contexts;
+    return reinterpret_cast<llm_embedder *>(dai_llm_embedder_load(model_path ? model_path : "", p));
 }
 
-char *llm_generate(
-    const char **roles, const char **contents, int count,
-    int max_tokens, float temperature,
-    float top_p, int top_k, float repeat_penalty
-) {
-    g_cancel = false;
-    std::string full = build_full_prompt(roles, contents, count);
-    std::string result = do_generate(
-        full, max_tokens, temperature, top_p, top_k, repeat_penalty,
-        [](const std::string &) { return true; }
-    );
-    char *out = (char *)malloc(result.size() + 1);
-    if (out) memcpy(out, result.c_str(), result.size() + 1);
-    return out;
+void llm_embedder_free(llm_embedder *embedder) {
+    dai_llm_embedder_free(unwrap(embedder));
 }
 
-void llm_generate_stream(
-    const char **roles, const char **contents, int count,
-    int max_tokens, float temperature,
-    float top_p, int top_k, float repeat_penalty,
-    llm_on_token on_token,
-    llm_on_error on_error,
-    void *user
-) {
-    g_cancel = false;
-    std::string full = build_full_prompt(roles, contents, count);
+int llm_embedder_dim(llm_embedder *embedder) {
+    return dai_llm_embedder_dim(unwrap(embedder));
+}
 
-    do_generate(
-        full, max_tokens, temperature, top_p, top_k, repeat_penalty,
-        [&](const std::string &piece) -> bool {
-            if (on_token) on_token(piece.c_str(), user);
-            return !g_cancel.load();
+bool llm_embed(llm_embedder *embedder, const char **texts, int count, float *out) {
+    std::vector<std::string> v(count > 0 ? count : 0);
+    for (int i = 0; i < count; i++) v[i] = texts[i] ? texts[i] : "";
+    return dai_llm_embed(unwrap(embedder), v, out);
+}
+
+llm_hnsw_params llm_hnsw_default_params(void) {
+    dai_llm_hnsw_params d;
+    llm_hnsw_params p;
+    p.dim             = d.dim;
+    p.m               = d.m;
+    p.ef_construction = d.ef_construction;
+    p.ef_search       = d.ef_search;
+    p.quantize        = d.quantize;
+    p.build_threads   = d.n_threads;
+    return p;
+}
+
+llm_hnsw *llm_hnsw_create(const llm_hnsw_params *params) {
+    const llm_hnsw_params src = params ? *params : llm_hnsw_default_params();
+    dai_llm_hnsw_params p;
+    p.dim             = src.dim;
+    p.m               = src.m;
+    p.ef_construction = src.ef_construction;
+    p.ef_search       = src.ef_search;
+    p.quantize        = src.quantize;
+    p.n_threads       = src.build_threads;
+    return reinterpret_cast<llm_hnsw *>(dai_llm_hnsw_create(p));
+}
+
+llm_hnsw *llm_hnsw_load(const char *path) {
+    return reinterpret_cast<llm_hnsw *>(dai_llm_hnsw_load(path ? path : ""));
+}
+
+void llm_hnsw_free(llm_hnsw *index) {
+    dai_llm_hnsw_free(unwrap(index));
+}
+
+int llm_hnsw_dim(llm_hnsw *index) {
+    return dai_llm_hnsw_dim(unwrap(index));
+}
+
+void llm_hnsw_add(llm_hnsw *index, const float *vectors, const char **texts, const char **sources,
+                  int count, int64_t *out_ids) {
+    if (count <= 0) return;
+    std::vector<dai_llm_hnsw_doc> docs(count);
+    for (int i = 0; i < count; i++) {
+        docs[i].text       = texts[i] ? texts[i] : "";
+        docs[i].has_source = sources && sources[i];
+        if (docs[i].has_source) docs[i].source = sources[i];
+    }
+    std::vector<int64_t> ids = dai_llm_hnsw_add(unwrap(index), vectors, docs);
+    for (int i = 0; i < count; i++) out_ids[i] = i < (int)ids.size() ? ids[i] : -1;
+}
+
+bool llm_hnsw_remove(llm_hnsw *index, int64_t id) {
+    return dai_llm_hnsw_remove(unwrap(index), id);
+}
+
+int llm_hnsw_size(llm_hnsw *index) {
+    return (int)dai_llm_hnsw_size(unwrap(index));
+}
+
+bool llm_hnsw_save(llm_hnsw *index, const char *path) {
+    return dai_llm_hnsw_save(unwrap(index), path ? path : "");
+}
+
+int llm_hnsw_search(llm_hnsw *index, const float *query, int top_k, int ef, llm_bm25_on_hit on_hit, void *user) {
+    std::vector<dai_llm_hnsw_hit> hits = dai_llm_hnsw_search(unwrap(index), query, top_k, ef);
+    if (on_hit) {
+        for (const auto &h : hits) {
+            on_hit(h.id, h.score, h.text.c_str(), h.has_source ? h.source.c_str() : nullptr, user);
         }
-    );
-    // Flow completes naturally when llm_generate_stream returns — no on_complete callback needed.
+    }
+    return (int)hits.size();
 }
 
-void llm_cancel(void) {
-    g_cancel = true;
+llm_ingest_params llm_ingest_default_params(void) {
+    dai_llm_ingest_params d;
+    llm_ingest_params p;
+    p.chunk_tokens       = d.chunk_tokens;
+    p.overlap_tokens     = d.overlap_tokens;
+    p.threads            = d.n_threads;
+    p.max_buffered_bytes = (int64_t)d.max_buffered_bytes;
+    p.tokenizer_path     = nullptr;
+    p.extensions         = nullptr;
+    p.extension_count    = 0;
+    p.bm25_path          = nullptr;
+    p.hnsw_path          = nullptr;
+    return p;
+}
+
+bool llm_ingest(const char **paths, int path_count, llm_bm25 *bm25, llm_embedder *embedder, llm_hnsw *hnsw,
+                const llm_ingest_params *params, llm_ingest_stats *out_stats,
+                llm_ingest_on_progress on_progress, void *user) {
+    const llm_ingest_params src = params ? *params : llm_ingest_default_params();
+    dai_llm_ingest_params p;
+    p.chunk_tokens       = src.chunk_tokens;
+    p.overlap_tokens     = src.overlap_tokens;
+    p.n_threads          = src.threads;
+    p.max_buffered_bytes = src.max_buffered_bytes > 0 ? (size_t)src.max_buffered_bytes : 0;
+    p.tokenizer_path     = src.tokenizer_path ? src.tokenizer_path : "";
+    p.bm25_path          = src.bm25_path ? src.bm25_path : "";
+    p.hnsw_path          = src.hnsw_path ? src.hnsw_path : "";
+    if (src.extensions) {
+        p.extensions.clear();
+        for (int i = 0; i < src.extension_count; i++) if (src.extensions[i]) p.extensions.emplace_back(src.extensions[i]);
+    }
+
+    std::vector<std::string> v;
+    for (int i = 0; i < path_count; i++) if (paths[i]) v.emplace_back(paths[i]);
+
+    dai_llm_ingest_progress_cb cb;
+    if (on_progress) {
+        cb = [on_progress, user](uint64_t done, uint64_t total) {
+            return on_progress((int64_t)done, (int64_t)total, user);
+        };
+    }
+
+    dai_llm_ingest_stats stats;
+    const bool ok = dai_llm_ingest(v, unwrap(bm25), unwrap(embedder), unwrap(hnsw), p, stats, cb);
+    if (out_stats) {
+        out_stats->files        = (int64_t)stats.files;
+        out_stats->failed_files = (int64_t)stats.failed_files;
+        out_stats->bytes        = (int64_t)stats.bytes;
+        out_stats->chunks       = (int64_t)stats.chunks;
+        out_stats->tokens       = (int64_t)stats.tokens;
+        out_stats->cancelled    = stats.cancelled;
+    }
+    return ok;
 }
 
 void llm_free_string(char *ptr) {
@@ -1,10 +1,13 @@
 package dev.deviceai.llm
 
+import dev.deviceai.core.JobCompletions
 import dev.deviceai.llm.native.*
 import dev.deviceai.llm.rag.RagAugmentor
+import dev.deviceai.llm.rag.RagContext
 import kotlinx.cinterop.*
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.channels.SendChannel
+import kotlinx.coroutines.channels.trySendBlocking
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.channelFlow
 import kotlinx.coroutines.flow.flowOn
@@ -13,21 +16,152 @@ import kotlin.time.measureTime
 /**
  * iOS actual implementation of [LlmCppBridge].
  *
- * Calls the unified dai_llm_* C API in deviceai_llm_engine directly
- * via cinterop — no intermediate C++ wrapper file.
+ * Calls the llm_* C API (llm_ios.h) via cinterop; the C API is a thin layer
+ * over the shared dai_llm_* core in deviceai_llm_engine. Native handles
+ * (llm_model / llm_session pointers) cross into Kotlin as raw [Long] values.
  */
 @Suppress("EXPECT_ACTUAL_CLASSIFIERS_ARE_IN_BETA_WARNING")
 @OptIn(ExperimentalForeignApi::class)
 actual object LlmCppBridge {
 
-    actual fun initLlm(modelPath: String, config: LlmInitConfig): Boolean =
-        llm_init(modelPath, config.maxThreads, config.useGpu)
+    actual fun initLlm(modelPath: String, config: LlmInitConfig): Long = memScoped {
+        llm_init(modelPath, modelParams(config).ptr).toLong()
+    }
+
+    actual fun estimateMemory(modelPath: String, config: LlmInitConfig, sessions: Int): MemoryEstimate? = memScoped {
+        val out = alloc<llm_memory_estimate>()
+        if (!llm_estimate_memory(modelPath, modelParams(config).ptr, sessions, out.ptr)) return null
+        MemoryEstimate(
+            contextSize = out.n_ctx, weightsBytes = out.weights_bytes, kvCacheBytes = out.kv_bytes,
+            computeBytes = out.compute_bytes, totalBytes = out.total_bytes
+        )
+    }
+
+    // Strings referenced by the struct live until the enclosing memScoped ends.
+    private fun MemScope.modelParams(config: LlmInitConfig): llm_model_params {
+        val p = alloc<llm_model_params>()
+        llm_model_default_params().place(p.ptr)
+        p.max_threads        = config.maxThreads
+        p.use_gpu            = config.useGpu
+        p.n_parallel         = config.parallelSequences
+        p.draft_model_path   = config.draftModelPath?.cstr?.ptr
+        p.prefix_cache_bytes = config.prefixCacheBytes
+        p.n_ctx              = config.contextSize
+        p.n_batch            = config.batchSize
+        p.n_ubatch           = config.microBatchSize
+        p.type_k             = config.kvCacheTypeK.ordinal.toUInt()
+        p.type_v             = config.kvCacheTypeV.ordinal.toUInt()
+        p.flash_attn         = when (config.flashAttention) { null -> -1; false -> 0; true -> 1 }
+        p.use_mmap           = config.useMmap
+        p.use_mlock          = config.useMlock
+        p.batch_threads      = config.batchThreads
+        p.cpu_mask           = config.cpuMask.toULong()
+        p.cpu_mask_batch     = config.batchCpuMask.toULong()
+        p.strict_cpu         = config.strictCpu
+        p.max_candidates     = config.maxCandidates
+        p.score_sequences    = config.scoreSequences
+        p.job_workers        = config.jobWorkers
+        p.job_queue          = config.jobQueueDepth
+        return p
+    }
+
+    actual fun shutdown(model: Long) = llm_shutdown(model.toCPointer())
+
+    actual fun createSession(model: Long): Long =
+        if (model == 0L) 0L else llm_session_create(model.toCPointer()).toLong()
+
+    actual fun closeSession(session: Long) {
+        if (session != 0L) llm_session_free(session.toCPointer())
+    }
+
+    actual fun warmPrefix(session: Long, messages: List<LlmMessage>, cacheDir: String): KvSnapshotStatus {
+        if (session == 0L || messages.isEmpty()) return KvSnapshotStatus.FAILED
+        val code = memScoped {
+            val rolesArr    = allocArray<CPointerVar<ByteVar>>(messages.size)
+            val contentsArr = allocArray<CPointerVar<ByteVar>>(messages.size)
+            messages.forEachIndexed { i, msg ->
+                rolesArr[i]    = msg.role.name.lowercase().cstr.getPointer(this)
+                contentsArr[i] = msg.content.cstr.getPointer(this)
+            }
+            llm_warm_prefix(session.toCPointer(), rolesArr, contentsArr, messages.size, cacheDir)
+        }
+        return KvSnapshotStatus.fromNative(code)
+    }
+
+    private fun MemScope.contextChunks(context: RagContext): CArrayPointer<CPointerVar<ByteVar>> {
+        val arr = allocArray<CPointerVar<ByteVar>>(context.chunks.size)
+        context.chunks.forEachIndexed { i, chunk -> arr[i] = chunk.cstr.getPointer(this) }
+        return arr
+    }
+
+    private fun MemScope.stopStrings(stop: List<String>): CArrayPointer<CPointerVar<ByteVar>>? {
+        if (stop.isEmpty()) return null
+        val arr = allocArray<CPointerVar<ByteVar>>(stop.size)
+        stop.forEachIndexed { i, s -> arr[i] = s.cstr.getPointer(this) }
+        return arr
+    }
+
+    // Strings and arrays referenced by the struct live until the enclosing memScoped ends.
+    private fun MemScope.genParams(
+        config: LlmGenConfig, context: RagContext?, seed: Int? = config.seed
+    ): llm_gen_params {
+        val p = alloc<llm_gen_params>()
+        llm_gen_default_params().place(p.ptr)
+        p.max_tokens         = config.maxTokens
+        p.temperature        = config.temperature
+        p.top_p              = config.topP
+        p.top_k              = config.topK
+        p.repeat_penalty     = config.repeatPenalty
+        p.seed               = (seed ?: -1).toUInt()
+        p.prefill_chunk      = config.prefillChunkSize
+        p.n_draft            = config.draftTokens
+        p.prompt_lookup      = config.promptLookup
+        p.context_shift      = config.contextShift
+        p.n_keep             = config.contextKeepTokens
+        p.stop               = stopStrings(config.stopSequences)
+        p.stop_count         = config.stopSequences.size
+        p.repeat_stop_tokens = config.repetitionStopTokens
+        p.grammar            = config.nativeGrammar()?.cstr?.ptr
+        if (context != null) {
+            p.context_marker = RagAugmentor.CONTEXT_MARKER.cstr.ptr
+            p.context_chunks = contextChunks(context)
+            p.context_count  = context.chunks.size
+            p.context_tokens = context.maxTokens
+        }
+        return p
+    }
 
-    actual fun shutdown() = llm_shutdown()
+    private fun llm_gen_metrics.toMetrics() = GenerationMetrics(
+        promptTokens = prompt_tokens, cachedTokens = cached_tokens, generatedTokens = generated_tokens,
+        ttftMs = ttft_ms, prefillMs = prefill_ms, decodeMs = decode_ms, sampleMs = sample_ms,
+        prefillTokensPerSecond = prefill_tps, decodeTokensPerSecond = decode_tps,
+        kvPeakCells = kv_peak, contextSize = n_ctx,
+        cancelLatencyMs = cancel_ms.takeIf { it >= 0 },
+        stoppedBy = EarlyStop.fromNative(stop_reason)
+    )
 
-    actual fun generate(messages: List<LlmMessage>, config: LlmGenConfig): LlmResult {
-        val augmented = if (config.ragStore != null) RagAugmentor.augment(messages, config) else messages
+    /** Callback state handed to C as the `user` pointer of a streaming call. */
+    private class StreamCallbacks(
+        val channel: SendChannel<String>,
+        val onProgress: ((Int, Int) -> Unit)?,
+    )
+
+    private val onProgressThunk = staticCFunction { processed: Int, total: Int, user: COpaquePointer? ->
+        user!!.asStableRef<(Int, Int) -> Unit>().get()(processed, total)
+    }
+
+    private val onStreamProgressThunk = staticCFunction { processed: Int, total: Int, user: COpaquePointer? ->
+        user!!.asStableRef<StreamCallbacks>().get().onProgress?.invoke(processed, total)
+        Unit
+    }
+
+    actual fun generate(session: Long, messages: List<LlmMessage>, config: LlmGenConfig): LlmResult {
+        val prompt = RagAugmentor.augment(messages, config)
+        val augmented = prompt.messages
+        val context = prompt.context
+        val progressRef = config.onPrefillProgress?.let { StableRef.create(it) }
         var text = ""
+        lateinit var metrics: GenerationMetrics
         val elapsed = measureTime {
             memScoped {
                 val rolesArr    = allocArray<CPointerVar<ByteVar>>(augmented.size)
@@ -36,37 +170,118 @@ actual object LlmCppBridge {
                     rolesArr[i]    = msg.role.name.lowercase().cstr.getPointer(this)
                     contentsArr[i] = msg.content.cstr.getPointer(this)
                 }
+                val m = alloc<llm_gen_metrics>()
                 val result = llm_generate(
+                    session.toCPointer(),
                     rolesArr, contentsArr, augmented.size,
-                    config.maxTokens, config.temperature,
-                    config.topP, config.topK, config.repeatPenalty
+                    genParams(config, context).ptr,
+                    if (progressRef != null) onProgressThunk else null,
+                    progressRef?.asCPointer(),
+                    m.ptr
                 )
                 text = result?.toKString()?.also { llm_free_string(result) } ?: ""
+                metrics = m.toMetrics()
             }
         }
+        progressRef?.dispose()
+        config.onMetrics?.invoke(metrics)
         return LlmResult(
             text = text,
-            tokenCount = text.split(" ").size,
-            promptTokenCount = 0,
+            tokenCount = metrics.generatedTokens,
+            promptTokenCount = metrics.promptTokens,
             finishReason = FinishReason.STOP,
-            generationTimeMs = elapsed.inWholeMilliseconds
+            generationTimeMs = elapsed.inWholeMilliseconds,
+            metrics = metrics
         )
     }
 
-    actual fun generateStream(messages: List<LlmMessage>, config: LlmGenConfig): Flow<String> =
+    /** Completion channel of every model's job executor, drained by one coroutine. */
+    private val jobs by lazy {
+        JobCompletions { timeoutMs ->
+            memScoped {
+                val ids = allocArray<LongVar>(JOB_BATCH)
+                val n = llm_jobs_wait(ids, JOB_BATCH, timeoutMs)
+                if (n == 0) null else LongArray(n) { ids[it] }
+            }
+        }
+    }
+
+    private const val JOB_BATCH = 64
+
+    actual suspend fun generateAsync(
+        session: Long, messages: List<LlmMessage>, config: LlmGenConfig, priority: Int
+    ): LlmResult {
+        val prompt = RagAugmentor.augment(messages, config)
+        val augmented = prompt.messages
+        val context = prompt.context
+        var cancelled = false
+        var failed = false
+        var text: String? = null
+        var metrics: GenerationMetrics? = null
+        val elapsed = measureTime {
+            val id = jobs.run(
+                submit = {
+                    memScoped {
+                        val rolesArr    = allocArray<CPointerVar<ByteVar>>(augmented.size)
+                        val contentsArr = allocArray<CPointerVar<ByteVar>>(augmented.size)
+                        augmented.forEachIndexed { i, msg ->
+                            rolesArr[i]    = msg.role.name.lowercase().cstr.getPointer(this)
+                            contentsArr[i] = msg.content.cstr.getPointer(this)
+                        }
+                        llm_job_submit(
+                            session.toCPointer(),
+                            rolesArr, contentsArr, augmented.size,
+                            genParams(config, context).ptr,
+                            priority
+                        )
+                    }
+                },
+                cancel = { llm_job_cancel(it, true) }
+            )
+            if (id > 0) memScoped {
+                val state = llm_job_poll(id)
+                cancelled = state == LLM_JOB_CANCELLED
+                failed = state == LLM_JOB_FAILED
+                val m = alloc<llm_gen_metrics>()
+                val result = llm_job_take(id, m.ptr)
+                if (result != null) {
+                    text = result.toKString().also { llm_free_string(result) }
+                    metrics = m.toMetrics()
+                }
+            }
+        }
+        metrics?.let { config.onMetrics?.invoke(it) }
+        return LlmResult(
+            text = text ?: "",
+            tokenCount = metrics?.generatedTokens ?: 0,
+            promptTokenCount = metrics?.promptTokens ?: 0,
+            finishReason = when {
+                text == null || failed -> FinishReason.ERROR
+                cancelled -> FinishReason.CANCELLED
+                else -> FinishReason.STOP
+            },
+            generationTimeMs = elapsed.inWholeMilliseconds,
+            metrics = metrics
+        )
+    }
+
+    actual fun generateStream(session: Long, messages: List<LlmMessage>, config: LlmGenConfig): Flow<String> =
         channelFlow {
-            val augmented = if (config.ragStore != null) RagAugmentor.augment(messages, config) else messages
+            val prompt = RagAugmentor.augment(messages, config)
+            val augmented = prompt.messages
+            val context = prompt.context
             val channel: SendChannel<String> = this
-            val ref = StableRef.create(channel)
+            val ref = StableRef.create(StreamCallbacks(channel, config.onPrefillProgress))
 
-            val onToken = staticCFunction { token: CPointer<ByteVar>?, user: COpaquePointer? ->
-                val ch = user!!.asStableRef<SendChannel<String>>().get()
-                val piece = token?.toKString() ?: return@staticCFunction
-                ch.trySend(piece)
+            val onText = staticCFunction { text: CPointer<ByteVar>?, length: Int, user: COpaquePointer? ->
+                val ch = user!!.asStableRef<StreamCallbacks>().get().channel
+                val batch = text?.readBytes(length)?.decodeToString() ?: return@staticCFunction
+                ch.trySendBlocking(batch)
+                Unit
             }
 
             val onError = staticCFunction { message: CPointer<ByteVar>?, user: COpaquePointer? ->
-                val ch = user!!.asStableRef<SendChannel<String>>().get()
+                val ch = user!!.asStableRef<StreamCallbacks>().get().channel
                 ch.close(RuntimeException(message?.toKString() ?: "Unknown error"))
                 Unit
             }
@@ -78,17 +293,247 @@ actual object LlmCppBridge {
                     rolesArr[i]    = msg.role.name.lowercase().cstr.getPointer(this)
                     contentsArr[i] = msg.content.cstr.getPointer(this)
                 }
+                val m = alloc<llm_gen_metrics>()
                 llm_generate_stream(
+                    session.toCPointer(),
                     rolesArr, contentsArr, augmented.size,
-                    config.maxTokens, config.temperature,
-                    config.topP, config.topK, config.repeatPenalty,
-                    onToken, onError,
+                    genParams(config, context).ptr,
+                    if (config.onPrefillProgress != null) onStreamProgressThunk else null,
+                    config.streamBatchTokens, config.streamBatchMillis,
+                    onText, onError,
+                    m.ptr,
                     ref.asCPointer()
                 )
+                config.onMetrics?.invoke(m.toMetrics())
             }
 
             ref.dispose()
         }.flowOn(Dispatchers.Default)
 
-    actual fun cancelGeneration() = llm_cancel()
+    actual fun generateN(
+        session: Long, messages: List<LlmMessage>, count: Int, config: LlmGenConfig, seed: Int?
+    ): NBestResult {
+        val prompt = RagAugmentor.augment(messages, config)
+        val augmented = prompt.messages
+        val context = prompt.context
+        val progressRef = config.onPrefillProgress?.let { StableRef.create(it) }
+        var texts = emptyList<String>()
+        lateinit var metrics: GenerationMetrics
+        val elapsed = measureTime {
+            memScoped {
+                val rolesArr    = allocArray<CPointerVar<ByteVar>>(augmented.size)
+                val contentsArr = allocArray<CPointerVar<ByteVar>>(augmented.size)
+                augmented.forEachIndexed { i, msg ->
+                    rolesArr[i]    = msg.role.name.lowercase().cstr.getPointer(this)
+                    contentsArr[i] = msg.content.cstr.getPointer(this)
+                }
+                val out = allocArray<CPointerVar<ByteVar>>(maxOf(count, 1))
+                val m = alloc<llm_gen_metrics>()
+                val n = llm_generate_n(
+                    session.toCPointer(),
+                    rolesArr, contentsArr, augmented.size,
+                    count, genParams(config, context, seed ?: config.seed).ptr,
+                    if (progressRef != null) onProgressThunk else null,
+                    progressRef?.asCPointer(),
+                    out, m.ptr
+                )
+                texts = List(n) { i -> out[i]?.let { p -> p.toKString().also { llm_free_string(p) } } ?: "" }
+                metrics = m.toMetrics()
+            }
+        }
+        progressRef?.dispose()
+        config.onMetrics?.invoke(metrics)
+        return NBestResult(candidates = texts, generationTimeMs = elapsed.inWholeMilliseconds, metrics = metrics)
+    }
+
+    /** Callback state handed to C as the `user` pointer of an n-best stream. */
+    private class CandidateStreamCallbacks(
+        val channel: SendChannel<CandidateText>,
+        val onProgress: ((Int, Int) -> Unit)?,
+    )
+
+    private val onCandidateProgressThunk = staticCFunction { processed: Int, total: Int, user: COpaquePointer? ->
+        user!!.asStableRef<CandidateStreamCallbacks>().get().onProgress?.invoke(processed, total)
+        Unit
+    }
+
+    actual fun generateNStream(
+        session: Long, messages: List<LlmMessage>, count: Int, config: LlmGenConfig, seed: Int?
+    ): Flow<CandidateText> =
+        channelFlow {
+            val prompt = RagAugmentor.augment(messages, config)
+            val augmented = prompt.messages
+            val context = prompt.context
+            val channel: SendChannel<CandidateText> = this
+            val ref = StableRef.create(CandidateStreamCallbacks(channel, config.onPrefillProgress))
+
+            val onText = staticCFunction { index: Int, text: CPointer<ByteVar>?, length: Int, user: COpaquePointer? ->
+                val ch = user!!.asStableRef<CandidateStreamCallbacks>().get().channel
+                val batch = text?.readBytes(length)?.decodeToString() ?: return@staticCFunction
+                ch.trySendBlocking(CandidateText(index, batch))
+                Unit
+            }
+
+            val onError = staticCFunction { message: CPointer<ByteVar>?, user: COpaquePointer? ->
+                val ch = user!!.asStableRef<CandidateStreamCallbacks>().get().channel
+                ch.close(RuntimeException(message?.toKString() ?: "Unknown error"))
+                Unit
+            }
+
+            memScoped {
+                val rolesArr    = allocArray<CPointerVar<ByteVar>>(augmented.size)
+                val contentsArr = allocArray<CPointerVar<ByteVar>>(augmented.size)
+                augmented.forEachIndexed { i, msg ->
+                    rolesArr[i]    = msg.role.name.lowercase().cstr.getPointer(this)
+                    contentsArr[i] = msg.content.cstr.getPointer(this)
+                }
+                val m = alloc<llm_gen_metrics>()
+                llm_generate_n_stream(
+                    session.toCPointer(),
+                    rolesArr, contentsArr, augmented.size,
+                    count, genParams(config, context, seed ?: config.seed).ptr,
+                    if (config.onPrefillProgress != null) onCandidateProgressThunk else null,
+                    config.streamBatchTokens, config.streamBatchMillis,
+                    onText, onError,
+                    m.ptr,
+                    ref.asCPointer()
+                )
+                config.onMetrics?.invoke(m.toMetrics())
+            }
+
+            ref.dispose()
+        }.flowOn(Dispatchers.Default)
+
+    actual fun scoreContinuations(
+        session: Long, messages: List<LlmMessage>, continuations: List<String>
+    ): List<ContinuationScore> {
+        if (session == 0L || continuations.isEmpty()) return emptyList()
+        val counts = IntArray(continuations.size)
+        // A continuation has at most one token per UTF-8 byte, plus a leading space piece.
+        val logprobs = FloatArray(continuations.sumOf { it.encodeToByteArray().size + 1 })
+        val n = memScoped {
+            val rolesArr    = allocArray<CPointerVar<ByteVar>>(messages.size)
+            val contentsArr = allocArray<CPointerVar<ByteVar>>(messages.size)
+            messages.forEachIndexed { i, msg ->
+                rolesArr[i]    = msg.role.name.lowercase().cstr.getPointer(this)
+                contentsArr[i] = msg.content.cstr.getPointer(this)
+            }
+            val textsArr = allocArray<CPointerVar<ByteVar>>(continuations.size)
+            continuations.forEachIndexed { i, text -> textsArr[i] = text.cstr.getPointer(this) }
+            counts.usePinned { pinnedCounts ->
+                logprobs.usePinned { pinnedLogprobs ->
+                    llm_score_continuations(
+                        session.toCPointer(), rolesArr, contentsArr, messages.size,
+                        textsArr, continuations.size,
+                        pinnedCounts.addressOf(0), pinnedLogprobs.addressOf(0), logprobs.size
+                    )
+                }
+            }
+        }
+        if (n < 0) return emptyList()
+        var at = 0
+        return counts.map { k ->
+            val tokens = logprobs.copyOfRange(at, at + k).asList()
+            at += k
+            ContinuationScore(tokens.sumOf { it.toDouble() }, tokens)
+        }
+    }
+
+    actual fun cancelGeneration(session: Long) = llm_cancel(session.toCPointer())
+
+    actual fun speculativeStats(session: Long): SpeculativeStats {
+        if (session == 0L) return SpeculativeStats(0, 0, 0)
+        return llm_speculative_stats(session.toCPointer()).useContents {
+            SpeculativeStats(draftedTokens = drafted, acceptedTokens = accepted, rounds = this.rounds)
+        }
+    }
+
+    actual fun prefixCacheStats(model: Long): PrefixCacheStats {
+        if (model == 0L) return PrefixCacheStats.EMPTY
+        return llm_prefix_cache_stats(model.toCPointer()).useContents {
+            PrefixCacheStats(
+                lookups = lookups, hits = hits, tokensReused = tokens_reused,
+                insertions = insertions, evictions = evictions, entries = entries,
+                bytesUsed = bytes_used, budgetBytes = budget_bytes
+            )
+        }
+    }
+
+    actual fun metricsHistogram(model: Long, reset: Boolean): MetricsHistogram {
+        if (model == 0L) return MetricsHistogram.EMPTY
+        return memScoped {
+            val h = alloc<llm_metrics_histogram>()
+            llm_metrics_snapshot(model.toCPointer(), reset, h.ptr)
+            val n = MetricsHistogram.BUCKETS
+            MetricsHistogram(
+                requests = h.requests, promptTokens = h.prompt_tokens,
+                cachedTokens = h.cached_tokens, generatedTokens = h.generated_tokens,
+                ttftMs = LongArray(n) { h.ttft_ms[it] },
+                prefillTokensPerSecond = LongArray(n) { h.prefill_tps[it] },
+                decodeTokensPerSecond = LongArray(n) { h.decode_tps[it] },
+                cancelLatencyMs = LongArray(n) { h.cancel_ms[it] },
+            )
+        }
+    }
+
+    actual fun setThreads(model: Long, config: ThreadConfig) {
+        if (model == 0L) return
+        memScoped {
+            val t = alloc<llm_threads>()
+            t.threads        = config.threads
+            t.batch_threads  = config.batchThreads
+            t.cpu_mask       = config.cpuMask.toULong()
+            t.cpu_mask_batch = config.batchCpuMask.toULong()
+            t.strict_cpu     = config.strictCpu
+            llm_set_threads(model.toCPointer(), t.ptr)
+        }
+    }
+
+    actual fun threadConfig(model: Long): ThreadConfig {
+        if (model == 0L) return ThreadConfig(threads = 0)
+        return llm_get_threads(model.toCPointer()).useContents {
+            ThreadConfig(threads, batch_threads, cpu_mask.toLong(), cpu_mask_batch.toLong(), strict_cpu)
+        }
+    }
+
+    actual fun autotuneThreads(model: Long, cachePath: String?): ThreadTuning? {
+        if (model == 0L) return null
+        return memScoped {
+            val r = alloc<llm_thread_tuning>()
+            if (!llm_autotune_threads(model.toCPointer(), cachePath, r.ptr)) return null
+            ThreadTuning(r.threads, r.batch_threads, r.decode_tps, r.prefill_tps, r.cached)
+        }
+    }
+
+    actual fun countTokens(model: Long, texts: List<String>): IntArray {
+        val counts = IntArray(texts.size)
+        if (model == 0L || texts.isEmpty()) return counts
+        memScoped {
+            val textsArr = allocArray<CPointerVar<ByteVar>>(texts.size)
+            texts.forEachIndexed { i, text -> textsArr[i] = text.cstr.getPointer(this) }
+            counts.usePinned { pinned ->
+                llm_count_tokens(model.toCPointer(), textsArr, texts.size, pinned.addressOf(0))
+            }
+        }
+        return counts
+    }
+
+    actual fun packContext(model: Long, chunks: List<String>, maxTokens: Int): PackedContext {
+        val chunkTokens = IntArray(chunks.size)
+        if (model == 0L || chunks.isEmpty() || maxTokens <= 0) return PackedContext(IntArray(0), chunkTokens)
+        val tokens = IntArray(maxTokens)
+        val n = memScoped {
+            val chunksArr = allocArray<CPointerVar<ByteVar>>(chunks.size)
+            chunks.forEachIndexed { i, chunk -> chunksArr[i] = chunk.cstr.getPointer(this) }
+            tokens.usePinned { pinnedTokens ->
+                chunkTokens.usePinned { pinnedCounts ->
+                    llm_pack_context(
+                        model.toCPointer(), chunksArr, chunks.size, maxTokens,
+                        pinnedTokens.addressOf(0), pinnedCounts.addressOf(0)
+                    )
+                }
+            }
+        }
+        return PackedContext(tokens.copyOf(n), chunkTokens)
+    }
 }
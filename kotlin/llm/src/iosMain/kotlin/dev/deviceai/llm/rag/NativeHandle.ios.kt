@@ -0,0 +1,30 @@
+package dev.deviceai.llm.rag
+
+import kotlin.concurrent.AtomicInt
+import kotlin.experimental.ExperimentalNativeApi
+import kotlin.native.ref.Cleaner
+import kotlin.native.ref.createCleaner
+
+@OptIn(ExperimentalNativeApi::class)
+internal actual class NativeHandle actual constructor(pointer: Long, free: (Long) -> Unit) {
+
+    private val state = State(pointer, free)
+
+    @Suppress("unused")
+    private val cleaner: Cleaner = createCleaner(state) { it.free() }
+
+    actual val pointer: Long get() = state.pointer
+
+    // The frame's reference to this handle is a GC root until the call returns.
+    actual fun <R> withPointer(block: (Long) -> R): R = block(state.pointer)
+
+    actual fun close() = state.free()
+
+    private class State(val pointer: Long, private val free: (Long) -> Unit) {
+        private val freed = AtomicInt(0)
+
+        fun free() {
+            if (freed.compareAndSet(0, 1)) free(pointer)
+        }
+    }
+}
@@ -0,0 +1,186 @@
+package dev.deviceai.llm.rag
+
+import dev.deviceai.llm.native.*
+import kotlinx.cinterop.*
+
+/**
+ * iOS actual implementation of [RagCppBridge] over the llm_bm25_*, llm_hnsw_*, llm_embed* and llm_ingest C API (llm_ios.h).
+ */
+@Suppress("EXPECT_ACTUAL_CLASSIFIERS_ARE_IN_BETA_WARNING")
+@OptIn(ExperimentalForeignApi::class)
+internal actual object RagCppBridge {
+
+    actual fun bm25Create(k1: Float, b: Float): Long = llm_bm25_create(k1, b).toLong()
+
+    actual fun bm25Load(path: String): Long = llm_bm25_load(path).toLong()
+
+    actual fun bm25Free(index: Long) {
+        if (index != 0L) llm_bm25_free(index.toCPointer())
+    }
+
+    actual fun bm25Add(index: Long, texts: List<String>, sources: List<String?>): LongArray = memScoped {
+        if (texts.isEmpty()) return LongArray(0)
+        val textsArr   = allocArray<CPointerVar<ByteVar>>(texts.size)
+        val sourcesArr = allocArray<CPointerVar<ByteVar>>(texts.size)
+        texts.forEachIndexed { i, text ->
+            textsArr[i]   = text.cstr.getPointer(this)
+            sourcesArr[i] = sources.getOrNull(i)?.cstr?.getPointer(this)
+        }
+        val ids = LongArray(texts.size)
+        ids.usePinned { pinned ->
+            llm_bm25_add(index.toCPointer(), textsArr, sourcesArr, texts.size, pinned.addressOf(0))
+        }
+        ids
+    }
+
+    actual fun bm25Remove(index: Long, id: Long): Boolean = llm_bm25_remove(index.toCPointer(), id)
+
+    actual fun bm25Size(index: Long): Int = llm_bm25_size(index.toCPointer())
+
+    actual fun bm25Save(index: Long, path: String): Boolean = llm_bm25_save(index.toCPointer(), path)
+
+    actual fun bm25Search(index: Long, query: String, topK: Int): List<RagChunk> {
+        val hits = ArrayList<RagChunk>(topK.coerceAtLeast(0))
+        val ref = StableRef.create(hits)
+        try {
+            llm_bm25_search(index.toCPointer(), query, topK, onHitThunk, ref.asCPointer())
+        } finally {
+            ref.dispose()
+        }
+        return hits
+    }
+
+    actual fun hnswCreate(dim: Int, config: HnswConfig): Long = memScoped {
+        val params = alloc<llm_hnsw_params>()
+        params.dim             = dim
+        params.m               = config.m
+        params.ef_construction = config.efConstruction
+        params.ef_search       = config.efSearch
+        params.quantize        = config.quantize
+        params.build_threads   = config.buildThreads
+        llm_hnsw_create(params.ptr).toLong()
+    }
+
+    actual fun hnswLoad(path: String): Long = llm_hnsw_load(path).toLong()
+
+    actual fun hnswFree(index: Long) {
+        if (index != 0L) llm_hnsw_free(index.toCPointer())
+    }
+
+    actual fun hnswDim(index: Long): Int = llm_hnsw_dim(index.toCPointer())
+
+    actual fun hnswAdd(index: Long, vectors: FloatArray, texts: List<String>, sources: List<String?>): LongArray = memScoped {
+        if (texts.isEmpty()) return LongArray(0)
+        val textsArr   = allocArray<CPointerVar<ByteVar>>(texts.size)
+        val sourcesArr = allocArray<CPointerVar<ByteVar>>(texts.size)
+        texts.forEachIndexed { i, text ->
+            textsArr[i]   = text.cstr.getPointer(this)
+            sourcesArr[i] = sources.getOrNull(i)?.cstr?.getPointer(this)
+        }
+        val ids = LongArray(texts.size)
+        vectors.usePinned { pinnedVectors ->
+            ids.usePinned { pinnedIds ->
+                llm_hnsw_add(index.toCPointer(), pinnedVectors.addressOf(0), textsArr, sourcesArr,
+                             texts.size, pinnedIds.addressOf(0))
+            }
+        }
+        ids
+    }
+
+    actual fun hnswRemove(index: Long, id: Long): Boolean = llm_hnsw_remove(index.toCPointer(), id)
+
+    actual fun hnswSize(index: Long): Int = llm_hnsw_size(index.toCPointer())
+
+    actual fun hnswSave(index: Long, path: String): Boolean = llm_hnsw_save(index.toCPointer(), path)
+
+    actual fun hnswSearch(index: Long, query: FloatArray, topK: Int, ef: Int): List<RagChunk> {
+        if (query.size < llm_hnsw_dim(index.toCPointer())) return emptyList()
+        val hits = ArrayList<RagChunk>(topK.coerceAtLeast(0))
+        val ref = StableRef.create(hits)
+        try {
+            query.usePinned { pinned ->
+                llm_hnsw_search(index.toCPointer(), pinned.addressOf(0), topK, ef, onHitThunk, ref.asCPointer())
+            }
+        } finally {
+            ref.dispose()
+        }
+        return hits
+    }
+
+    actual fun embedLoad(path: String, config: EmbeddingConfig): Long = memScoped {
+        val params = alloc<llm_embed_params>()
+        params.max_threads  = config.maxThreads
+        params.use_gpu      = config.useGpu
+        params.batch_tokens = config.batchTokens
+        params.batch_texts  = config.batchTexts
+        params.pooling      = config.pooling.ordinal.toUInt()
+        params.normalize    = config.normalize
+        params.contexts     = config.contexts
+        llm_embedder_load(path, params.ptr).toLong()
+    }
+
+    actual fun embedFree(embedder: Long) {
+        if (embedder != 0L) llm_embedder_free(embedder.toCPointer())
+    }
+
+    actual fun embedDim(embedder: Long): Int = llm_embedder_dim(embedder.toCPointer())
+
+    actual fun embed(embedder: Long, texts: List<String>): FloatArray? = memScoped {
+        val textsArr = allocArray<CPointerVar<ByteVar>>(texts.size)
+        texts.forEachIndexed { i, text -> textsArr[i] = text.cstr.getPointer(this) }
+        val out = FloatArray(texts.size * llm_embedder_dim(embedder.toCPointer()))
+        val ok = out.usePinned { pinned ->
+            llm_embed(embedder.toCPointer(), textsArr, texts.size, if (out.isEmpty()) null else pinned.addressOf(0))
+        }
+        if (ok) out else null
+    }
+
+    actual fun ingest(
+        paths: List<String>, bm25: Long, embedder: Long, hnsw: Long, config: IngestConfig,
+        bm25Path: String?, hnswPath: String?, onProgress: ((Long, Long) -> Boolean)?,
+    ): IngestStats? = memScoped {
+        val pathsArr = allocArray<CPointerVar<ByteVar>>(paths.size.coerceAtLeast(1))
+        paths.forEachIndexed { i, path -> pathsArr[i] = path.cstr.getPointer(this) }
+        // Never NULL: an empty list means every file, not the native defaults.
+        val extensionsArr = allocArray<CPointerVar<ByteVar>>(config.extensions.size.coerceAtLeast(1))
+        config.extensions.forEachIndexed { i, ext -> extensionsArr[i] = ext.cstr.getPointer(this) }
+
+        val params = alloc<llm_ingest_params>()
+        params.chunk_tokens       = config.chunkTokens
+        params.overlap_tokens     = config.overlapTokens
+        params.threads            = config.threads
+        params.max_buffered_bytes = config.maxBufferedBytes
+        params.tokenizer_path     = config.tokenizerModelPath?.cstr?.getPointer(this)
+        params.extensions         = extensionsArr
+        params.extension_count    = config.extensions.size
+        params.bm25_path          = bm25Path?.cstr?.getPointer(this)
+        params.hnsw_path          = hnswPath?.cstr?.getPointer(this)
+
+        val stats = alloc<llm_ingest_stats>()
+        val ref = onProgress?.let { StableRef.create(it) }
+        val ok = try {
+            llm_ingest(
+                pathsArr, paths.size, bm25.toCPointer(), embedder.toCPointer(), hnsw.toCPointer(),
+                params.ptr, stats.ptr, if (ref != null) onProgressThunk else null, ref?.asCPointer()
+            )
+        } finally {
+            ref?.dispose()
+        }
+        if (!ok) return null
+        IngestStats(
+            files = stats.files, failedFiles = stats.failed_files, bytes = stats.bytes,
+            chunks = stats.chunks, tokens = stats.tokens, cancelled = stats.cancelled
+        )
+    }
+
+    private val onProgressThunk = staticCFunction { done: Long, total: Long, user: COpaquePointer? ->
+        user!!.asStableRef<(Long, Long) -> Boolean>().get()(done, total)
+    }
+
+    private val onHitThunk = staticCFunction {
+            _: Long, score: Float, text: CPointer<ByteVar>?, source: CPointer<ByteVar>?, user: COpaquePointer? ->
+        user!!.asStableRef<ArrayList<RagChunk>>().get()
+            .add(RagChunk(text = text?.toKString() ?: "", source = source?.toKString(), score = score))
+        Unit
+    }
+}
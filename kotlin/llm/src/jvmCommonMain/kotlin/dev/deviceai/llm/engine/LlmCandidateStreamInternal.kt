@@ -0,0 +1,14 @@
+package dev.deviceai.llm.engine
+
+/**
+ * Internal JNI callback interface for n-best streams — implementation detail
+ * of [LlmJniEngine], the counterpart of [LlmStreamInternal].
+ *
+ * [onText] announces [length] bytes of UTF-8 of candidate [index] at [offset]
+ * in the stream ring buffer, wrapping past its end. The bytes stay valid until
+ * [onText] returns.
+ */
+internal interface LlmCandidateStreamInternal {
+    fun onText(index: Int, offset: Int, length: Int)
+    fun onError(message: String)
+}
@@ -0,0 +1,34 @@
+package dev.deviceai.llm.engine
+
+import dev.deviceai.llm.LlmGenConfig
+import dev.deviceai.llm.nativeGrammar
+import dev.deviceai.llm.rag.RagAugmentor
+import dev.deviceai.llm.rag.RagContext
+
+/**
+ * Internal JNI request parameters — implementation detail of [LlmJniEngine].
+ * Not part of the public SDK API. Callers use [LlmGenConfig] instead.
+ *
+ * One request's settings in a single object, so the nativeGenerate* calls do
+ * not grow a positional parameter per setting. Native code reads the fields
+ * by name (gen_params in deviceai_llm_jni.cpp).
+ */
+internal class LlmGenParamsInternal(config: LlmGenConfig, context: RagContext?, seed: Int? = config.seed) {
+    @JvmField val maxTokens: Int = config.maxTokens
+    @JvmField val temperature: Float = config.temperature
+    @JvmField val topP: Float = config.topP
+    @JvmField val topK: Int = config.topK
+    @JvmField val repeatPenalty: Float = config.repeatPenalty
+    @JvmField val seed: Int = seed ?: -1
+    @JvmField val prefillChunk: Int = config.prefillChunkSize
+    @JvmField val draftTokens: Int = config.draftTokens
+    @JvmField val promptLookup: Boolean = config.promptLookup
+    @JvmField val contextShift: Boolean = config.contextShift
+    @JvmField val keepTokens: Int = config.contextKeepTokens
+    @JvmField val stop: Array<String> = config.stopSequences.toTypedArray()
+    @JvmField val repeatStopTokens: Int = config.repetitionStopTokens
+    @JvmField val grammar: String? = config.nativeGrammar()
+    @JvmField val contextMarker: String? = context?.let { RagAugmentor.CONTEXT_MARKER }
+    @JvmField val contextChunks: Array<String>? = context?.chunks?.toTypedArray()
+    @JvmField val contextTokens: Int = context?.maxTokens ?: 0
+}
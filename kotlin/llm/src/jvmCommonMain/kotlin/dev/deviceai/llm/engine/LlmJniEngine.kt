@@ -1,15 +1,32 @@
 package dev.deviceai.llm.engine
 
+import dev.deviceai.core.JobCompletions
+import dev.deviceai.llm.CandidateText
+import dev.deviceai.llm.ContinuationScore
 import dev.deviceai.llm.FinishReason
+import dev.deviceai.llm.GenerationMetrics
+import dev.deviceai.llm.KvSnapshotStatus
 import dev.deviceai.llm.LlmEngine
 import dev.deviceai.llm.LlmGenConfig
 import dev.deviceai.llm.LlmInitConfig
 import dev.deviceai.llm.LlmMessage
 import dev.deviceai.llm.LlmResult
+import dev.deviceai.llm.MemoryEstimate
+import dev.deviceai.llm.MetricsHistogram
+import dev.deviceai.llm.NBestResult
+import dev.deviceai.llm.PackedContext
+import dev.deviceai.llm.PrefixCacheStats
+import dev.deviceai.llm.SpeculativeStats
+import dev.deviceai.llm.ThreadConfig
+import dev.deviceai.llm.ThreadTuning
+import dev.deviceai.llm.rag.RagAugmentor
+import dev.deviceai.llm.rag.RagContext
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.channels.trySendBlocking
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.channelFlow
 import kotlinx.coroutines.flow.flowOn
+import java.nio.ByteBuffer
 import kotlin.system.measureTimeMillis
 
 /**
@@ -22,70 +39,398 @@ internal object LlmJniEngine : LlmEngine {
         System.loadLibrary("deviceai_llm_jni")
     }
 
-    override fun init(modelPath: String, config: LlmInitConfig): Boolean =
-        nativeInit(modelPath, config.maxThreads, config.useGpu)
+    override fun init(modelPath: String, config: LlmInitConfig): Long =
+        nativeInit(
+            modelPath, config.maxThreads, config.useGpu,
+            config.parallelSequences, config.draftModelPath, config.prefixCacheBytes,
+            config.contextSize, config.batchSize, config.microBatchSize,
+            config.kvCacheTypeK.ordinal, config.kvCacheTypeV.ordinal, config.flashAttentionCode(),
+            config.useMmap, config.useMlock,
+            config.batchThreads, config.cpuMask, config.batchCpuMask, config.strictCpu,
+            config.maxCandidates, config.scoreSequences, config.jobWorkers, config.jobQueueDepth
+        )
+
+    override fun estimateMemory(modelPath: String, config: LlmInitConfig, sessions: Int): MemoryEstimate? {
+        val e = nativeEstimateMemory(
+            modelPath, config.maxThreads, config.useGpu,
+            config.parallelSequences, config.draftModelPath,
+            config.contextSize, config.batchSize, config.microBatchSize,
+            config.kvCacheTypeK.ordinal, config.kvCacheTypeV.ordinal, config.flashAttentionCode(),
+            config.useMmap, config.maxCandidates, config.scoreSequences, sessions
+        ) ?: return null
+        return MemoryEstimate(
+            contextSize = e[0].toInt(), weightsBytes = e[1], kvCacheBytes = e[2],
+            computeBytes = e[3], totalBytes = e[4]
+        )
+    }
+
+    private fun LlmInitConfig.flashAttentionCode(): Int = when (flashAttention) {
+        null  -> -1
+        false -> 0
+        true  -> 1
+    }
+
+    override fun shutdown(model: Long) = nativeShutdown(model)
 
-    override fun shutdown() = nativeShutdown()
+    override fun createSession(model: Long): Long =
+        if (model == 0L) 0L else nativeCreateSession(model)
 
-    override fun generate(messages: List<LlmMessage>, config: LlmGenConfig): LlmResult {
+    override fun closeSession(session: Long) {
+        if (session != 0L) nativeCloseSession(session)
+    }
+
+    override fun warmPrefix(session: Long, messages: List<LlmMessage>, cacheDir: String): KvSnapshotStatus {
+        if (session == 0L || messages.isEmpty()) return KvSnapshotStatus.FAILED
         val roles = messages.map { it.role.name.lowercase() }.toTypedArray()
         val contents = messages.map { it.content }.toTypedArray()
+        return KvSnapshotStatus.fromNative(nativeWarmPrefix(session, roles, contents, cacheDir))
+    }
+
+    override fun generate(session: Long, messages: List<LlmMessage>, config: LlmGenConfig): LlmResult =
+        generate(session, messages, config, null)
+
+    /** [generate] with RAG chunks packed natively at [RagAugmentor.CONTEXT_MARKER]. */
+    fun generate(session: Long, messages: List<LlmMessage>, config: LlmGenConfig, context: RagContext?): LlmResult {
+        val roles = messages.map { it.role.name.lowercase() }.toTypedArray()
+        val contents = messages.map { it.content }.toTypedArray()
+        val m = DoubleArray(GenerationMetrics.FIELDS)
         var text = ""
         val ms = measureTimeMillis {
             text = nativeGenerate(
-                roles, contents,
-                config.maxTokens, config.temperature,
-                config.topP, config.topK, config.repeatPenalty
+                session, roles, contents, LlmGenParamsInternal(config, context),
+                config.onPrefillProgress?.let(::LlmProgressInternal), m
             )
         }
+        val metrics = GenerationMetrics.fromArray(m)
+        config.onMetrics?.invoke(metrics)
         return LlmResult(
             text = text,
-            tokenCount = if (text.isBlank()) 0 else text.trim().split(Regex("\\s+")).size,
-            promptTokenCount = 0,
+            tokenCount = metrics.generatedTokens,
+            promptTokenCount = metrics.promptTokens,
             finishReason = FinishReason.STOP,
-            generationTimeMs = ms
+            generationTimeMs = ms,
+            metrics = metrics
+        )
+    }
+
+    override suspend fun generateAsync(
+        session: Long, messages: List<LlmMessage>, config: LlmGenConfig, priority: Int
+    ): LlmResult = generateAsync(session, messages, config, priority, null)
+
+    /** [generateAsync] with RAG chunks packed natively at [RagAugmentor.CONTEXT_MARKER]. */
+    suspend fun generateAsync(
+        session: Long, messages: List<LlmMessage>, config: LlmGenConfig, priority: Int, context: RagContext?
+    ): LlmResult {
+        val roles = messages.map { it.role.name.lowercase() }.toTypedArray()
+        val contents = messages.map { it.content }.toTypedArray()
+        val m = DoubleArray(GenerationMetrics.FIELDS)
+        var state = JOB_UNKNOWN
+        var text: String? = null
+        val ms = measureTimeMillis {
+            val id = jobs.run(
+                submit = {
+                    nativeSubmitGenerate(session, roles, contents, LlmGenParamsInternal(config, context), priority)
+                },
+                cancel = { nativeCancelJob(it, true) }
+            )
+            if (id > 0) {
+                state = nativePollJob(id)
+                text = nativeTakeJob(id, m)?.toString(Charsets.UTF_8)
+            }
+        }
+        val metrics = GenerationMetrics.fromArray(m)
+        if (text != null) config.onMetrics?.invoke(metrics)
+        return LlmResult(
+            text = text ?: "",
+            tokenCount = metrics.generatedTokens,
+            promptTokenCount = metrics.promptTokens,
+            finishReason = when {
+                text == null || state == JOB_FAILED -> FinishReason.ERROR
+                state == JOB_CANCELLED -> FinishReason.CANCELLED
+                else -> FinishReason.STOP
+            },
+            generationTimeMs = ms,
+            metrics = metrics
         )
     }
 
-    override fun generateStream(messages: List<LlmMessage>, config: LlmGenConfig): Flow<String> =
+    override fun generateStream(session: Long, messages: List<LlmMessage>, config: LlmGenConfig): Flow<String> =
+        generateStream(session, messages, config, null)
+
+    /** [generateStream] with RAG chunks packed natively at [RagAugmentor.CONTEXT_MARKER]. */
+    fun generateStream(
+        session: Long, messages: List<LlmMessage>, config: LlmGenConfig, context: RagContext?
+    ): Flow<String> =
         channelFlow {
             val roles = messages.map { it.role.name.lowercase() }.toTypedArray()
             val contents = messages.map { it.content }.toTypedArray()
+            val ring = streamRing.get()
+            val m = DoubleArray(GenerationMetrics.FIELDS)
             nativeGenerateStream(
-                roles, contents,
-                config.maxTokens, config.temperature,
-                config.topP, config.topK, config.repeatPenalty,
+                session, roles, contents, LlmGenParamsInternal(config, context),
+                config.onPrefillProgress?.let(::LlmProgressInternal),
+                ring.buffer, config.streamBatchTokens, config.streamBatchMillis,
                 object : LlmStreamInternal {
-                    override fun onToken(token: String) { trySend(token) }
+                    override fun onText(offset: Int, length: Int) { trySendBlocking(ring.read(offset, length)) }
                     override fun onError(message: String) { close(RuntimeException(message)) }
-                }
+                }, m
             )
+            config.onMetrics?.invoke(GenerationMetrics.fromArray(m))
         }.flowOn(Dispatchers.IO)
 
-    override fun cancelGeneration() = nativeCancel()
+    override fun generateN(
+        session: Long, messages: List<LlmMessage>, count: Int, config: LlmGenConfig, seed: Int?
+    ): NBestResult = generateN(session, messages, count, config, seed, null)
+
+    /** [generateN] with RAG chunks packed natively at [RagAugmentor.CONTEXT_MARKER]. */
+    fun generateN(
+        session: Long, messages: List<LlmMessage>, count: Int, config: LlmGenConfig, seed: Int?,
+        context: RagContext?
+    ): NBestResult {
+        val roles = messages.map { it.role.name.lowercase() }.toTypedArray()
+        val contents = messages.map { it.content }.toTypedArray()
+        val m = DoubleArray(GenerationMetrics.FIELDS)
+        var texts: List<String> = emptyList()
+        val ms = measureTimeMillis {
+            texts = nativeGenerateN(
+                session, roles, contents, count, LlmGenParamsInternal(config, context, seed ?: config.seed),
+                config.onPrefillProgress?.let(::LlmProgressInternal), m
+            )?.map { it.toString(Charsets.UTF_8) } ?: emptyList()
+        }
+        val metrics = GenerationMetrics.fromArray(m)
+        config.onMetrics?.invoke(metrics)
+        return NBestResult(candidates = texts, generationTimeMs = ms, metrics = metrics)
+    }
+
+    override fun generateNStream(
+        session: Long, messages: List<LlmMessage>, count: Int, config: LlmGenConfig, seed: Int?
+    ): Flow<CandidateText> = generateNStream(session, messages, count, config, seed, null)
+
+    /** [generateNStream] with RAG chunks packed natively at [RagAugmentor.CONTEXT_MARKER]. */
+    fun generateNStream(
+        session: Long, messages: List<LlmMessage>, count: Int, config: LlmGenConfig, seed: Int?,
+        context: RagContext?
+    ): Flow<CandidateText> =
+        channelFlow {
+            val roles = messages.map { it.role.name.lowercase() }.toTypedArray()
+            val contents = messages.map { it.content }.toTypedArray()
+            val ring = streamRing.get()
+            val m = DoubleArray(GenerationMetrics.FIELDS)
+            nativeGenerateNStream(
+                session, roles, contents, count, LlmGenParamsInternal(config, context, seed ?: config.seed),
+                config.onPrefillProgress?.let(::LlmProgressInternal),
+                ring.buffer, config.streamBatchTokens, config.streamBatchMillis,
+                object : LlmCandidateStreamInternal {
+                    override fun onText(index: Int, offset: Int, length: Int) {
+                        trySendBlocking(CandidateText(index, ring.read(offset, length)))
+                    }
+                    override fun onError(message: String) { close(RuntimeException(message)) }
+                }, m
+            )
+            config.onMetrics?.invoke(GenerationMetrics.fromArray(m))
+        }.flowOn(Dispatchers.IO)
+
+    override fun scoreContinuations(
+        session: Long, messages: List<LlmMessage>, continuations: List<String>
+    ): List<ContinuationScore> {
+        if (session == 0L || continuations.isEmpty()) return emptyList()
+        val roles = messages.map { it.role.name.lowercase() }.toTypedArray()
+        val contents = messages.map { it.content }.toTypedArray()
+        val counts = IntArray(continuations.size)
+        val logprobs = nativeScoreContinuations(session, roles, contents, continuations.toTypedArray(), counts)
+            ?: return emptyList()
+        var at = 0
+        return counts.map { n ->
+            val tokens = logprobs.copyOfRange(at, at + n).asList()
+            at += n
+            ContinuationScore(tokens.sumOf { it.toDouble() }, tokens)
+        }
+    }
+
+    override fun cancelGeneration(session: Long) = nativeCancel(session)
+
+    override fun speculativeStats(session: Long): SpeculativeStats {
+        if (session == 0L) return SpeculativeStats(0, 0, 0)
+        val s = nativeSpeculativeStats(session)
+        return SpeculativeStats(draftedTokens = s[0], acceptedTokens = s[1], rounds = s[2])
+    }
+
+    override fun prefixCacheStats(model: Long): PrefixCacheStats {
+        if (model == 0L) return PrefixCacheStats.EMPTY
+        val s = nativePrefixCacheStats(model)
+        return PrefixCacheStats(
+            lookups = s[0], hits = s[1], tokensReused = s[2], insertions = s[3],
+            evictions = s[4], entries = s[5], bytesUsed = s[6], budgetBytes = s[7]
+        )
+    }
+
+    override fun metricsHistogram(model: Long, reset: Boolean): MetricsHistogram {
+        if (model == 0L) return MetricsHistogram.EMPTY
+        return MetricsHistogram.fromArray(nativeMetricsHistogram(model, reset))
+    }
+
+    override fun setThreads(model: Long, config: ThreadConfig) {
+        if (model == 0L) return
+        nativeSetThreads(model, config.threads, config.batchThreads, config.cpuMask, config.batchCpuMask, config.strictCpu)
+    }
+
+    override fun threadConfig(model: Long): ThreadConfig {
+        if (model == 0L) return ThreadConfig(threads = 0)
+        val t = nativeGetThreads(model)
+        return ThreadConfig(t[0].toInt(), t[1].toInt(), t[2], t[3], t[4] != 0L)
+    }
+
+    override fun autotuneThreads(model: Long, cachePath: String?): ThreadTuning? {
+        if (model == 0L) return null
+        val r = nativeAutotuneThreads(model, cachePath) ?: return null
+        return ThreadTuning(r[0].toInt(), r[1].toInt(), r[2], r[3], r[4] != 0.0)
+    }
+
+    override fun countTokens(model: Long, texts: List<String>): IntArray {
+        if (model == 0L || texts.isEmpty()) return IntArray(texts.size)
+        return nativeCountTokens(model, texts.toTypedArray())
+    }
+
+    override fun packContext(model: Long, chunks: List<String>, maxTokens: Int): PackedContext {
+        val chunkTokens = IntArray(chunks.size)
+        if (model == 0L || chunks.isEmpty() || maxTokens <= 0) return PackedContext(IntArray(0), chunkTokens)
+        val tokens = nativePackContext(model, chunks.toTypedArray(), maxTokens, chunkTokens)
+        return PackedContext(tokens, chunkTokens)
+    }
+
+    // ──────────────────────────────────────────────────────────────
+    //                           JOBS
+    // ──────────────────────────────────────────────────────────────
+
+    // dai_llm_job_state values read back from nativePollJob.
+    private const val JOB_UNKNOWN = 0
+    private const val JOB_CANCELLED = 4
+    private const val JOB_FAILED = 5
+
+    /** Completion channel of every model's job executor, drained by one coroutine. */
+    private val jobs by lazy { JobCompletions(::nativeAwaitJobs) }
+
+    // ──────────────────────────────────────────────────────────────
+    //                      STREAM RING BUFFER
+    // ──────────────────────────────────────────────────────────────
+
+    private const val STREAM_RING_BYTES = 16 * 1024
+
+    /**
+     * Direct buffer native code writes streamed text into, plus a scratch array
+     * to decode it from. A stream blocks its thread until it ends, so one ring
+     * per thread is never shared by two streams.
+     */
+    private class StreamRing {
+        val buffer: ByteBuffer = ByteBuffer.allocateDirect(STREAM_RING_BYTES)
+        private val scratch = ByteArray(STREAM_RING_BYTES)
+
+        fun read(offset: Int, length: Int): String {
+            val first = minOf(length, buffer.capacity() - offset)
+            buffer.position(offset)
+            buffer.get(scratch, 0, first)
+            if (first < length) {
+                buffer.position(0)
+                buffer.get(scratch, first, length - first)
+            }
+            return scratch.decodeToString(0, length)
+        }
+    }
+
+    private val streamRing = ThreadLocal.withInitial { StreamRing() }
 
     // ──────────────────────────────────────────────────────────────
     //                    NATIVE DECLARATIONS
     // ──────────────────────────────────────────────────────────────
 
     private external fun nativeInit(
-        modelPath: String, maxThreads: Int, useGpu: Boolean
-    ): Boolean
+        modelPath: String, maxThreads: Int, useGpu: Boolean, parallelSequences: Int,
+        draftModelPath: String?, prefixCacheBytes: Long,
+        contextSize: Int, batchSize: Int, microBatchSize: Int,
+        kvTypeK: Int, kvTypeV: Int, flashAttention: Int,
+        useMmap: Boolean, useMlock: Boolean,
+        batchThreads: Int, cpuMask: Long, batchCpuMask: Long, strictCpu: Boolean,
+        maxCandidates: Int, scoreSequences: Int, jobWorkers: Int, jobQueue: Int
+    ): Long
+
+    private external fun nativeEstimateMemory(
+        modelPath: String, maxThreads: Int, useGpu: Boolean, parallelSequences: Int,
+        draftModelPath: String?,
+        contextSize: Int, batchSize: Int, microBatchSize: Int,
+        kvTypeK: Int, kvTypeV: Int, flashAttention: Int,
+        useMmap: Boolean, maxCandidates: Int, scoreSequences: Int, sessions: Int
+    ): LongArray?
+
+    private external fun nativeShutdown(model: Long)
+
+    private external fun nativeCreateSession(model: Long): Long
+
+    private external fun nativeCloseSession(session: Long)
 
-    private external fun nativeShutdown()
+    private external fun nativeWarmPrefix(
+        session: Long, roles: Array<String>, contents: Array<String>, cacheDir: String
+    ): Int
 
     private external fun nativeGenerate(
-        roles: Array<String>, contents: Array<String>,
-        maxTokens: Int, temperature: Float,
-        topP: Float, topK: Int, repeatPenalty: Float
+        session: Long, roles: Array<String>, contents: Array<String>, params: LlmGenParamsInternal,
+        progress: LlmProgressInternal?, metrics: DoubleArray?
     ): String
 
     private external fun nativeGenerateStream(
-        roles: Array<String>, contents: Array<String>,
-        maxTokens: Int, temperature: Float,
-        topP: Float, topK: Int, repeatPenalty: Float,
-        callback: LlmStreamInternal
+        session: Long, roles: Array<String>, contents: Array<String>, params: LlmGenParamsInternal,
+        progress: LlmProgressInternal?,
+        buffer: ByteBuffer, batchTokens: Int, batchMillis: Int,
+        callback: LlmStreamInternal, metrics: DoubleArray?
+    )
+
+    private external fun nativeGenerateN(
+        session: Long, roles: Array<String>, contents: Array<String>, count: Int, params: LlmGenParamsInternal,
+        progress: LlmProgressInternal?, metrics: DoubleArray?
+    ): Array<ByteArray>?
+
+    private external fun nativeGenerateNStream(
+        session: Long, roles: Array<String>, contents: Array<String>, count: Int, params: LlmGenParamsInternal,
+        progress: LlmProgressInternal?,
+        buffer: ByteBuffer, batchTokens: Int, batchMillis: Int,
+        callback: LlmCandidateStreamInternal, metrics: DoubleArray?
+    )
+
+    private external fun nativeScoreContinuations(
+        session: Long, roles: Array<String>, contents: Array<String>, continuations: Array<String>,
+        tokenCounts: IntArray
+    ): FloatArray?
+
+    private external fun nativeCancel(session: Long)
+
+    private external fun nativeSubmitGenerate(
+        session: Long, roles: Array<String>, contents: Array<String>, params: LlmGenParamsInternal, priority: Int
+    ): Long
+
+    private external fun nativePollJob(job: Long): Int
+
+    private external fun nativeCancelJob(job: Long, discard: Boolean): Boolean
+
+    private external fun nativeAwaitJobs(timeoutMs: Int): LongArray?
+
+    private external fun nativeTakeJob(job: Long, metrics: DoubleArray?): ByteArray?
+
+    private external fun nativeSpeculativeStats(session: Long): LongArray
+
+    private external fun nativePrefixCacheStats(model: Long): LongArray
+
+    private external fun nativeMetricsHistogram(model: Long, reset: Boolean): LongArray
+
+    private external fun nativeSetThreads(
+        model: Long, threads: Int, batchThreads: Int, cpuMask: Long, batchCpuMask: Long, strictCpu: Boolean
     )
 
-    private external fun nativeCancel()
+    private external fun nativeGetThreads(model: Long): LongArray
+
+    private external fun nativeAutotuneThreads(model: Long, cachePath: String?): DoubleArray?
+
+    private external fun nativeCountTokens(model: Long, texts: Array<String>): IntArray
+
+    private external fun nativePackContext(
+        model: Long, chunks: Array<String>, maxTokens: Int, chunkTokens: IntArray
+    ): IntArray
 }
@@ -0,0 +1,9 @@
+package dev.deviceai.llm.engine
+
+/**
+ * Internal JNI callback for prefill progress — implementation detail of [LlmJniEngine].
+ * Callers pass a lambda via [dev.deviceai.llm.LlmGenConfig.onPrefillProgress] instead.
+ */
+internal fun interface LlmProgressInternal {
+    fun onProgress(processed: Int, total: Int)
+}
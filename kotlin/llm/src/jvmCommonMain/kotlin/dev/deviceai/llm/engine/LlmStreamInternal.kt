@@ -3,8 +3,12 @@ package dev.deviceai.llm.engine
 /**
  * Internal JNI callback interface — implementation detail of [LlmJniEngine].
  * Not part of the public SDK API. Callers use Flow operators instead.
+ *
+ * Streamed text arrives in the direct ByteBuffer passed to nativeGenerateStream,
+ * used as a ring: [onText] announces [length] bytes of UTF-8 starting at [offset],
+ * wrapping past the end of the buffer. The bytes stay valid until [onText] returns.
  */
 internal interface LlmStreamInternal {
-    fun onToken(token: String)
+    fun onText(offset: Int, length: Int)
     fun onError(message: String)
 }
@@ -0,0 +1,9 @@
+package dev.deviceai.llm.engine
+
+/**
+ * Internal JNI callback for ingestion progress — implementation detail of [RagJniEngine].
+ * Callers pass a lambda to [dev.deviceai.llm.rag.RagIngestor.ingest] instead.
+ */
+internal fun interface RagIngestProgressInternal {
+    fun onProgress(done: Long, total: Long): Boolean
+}
@@ -0,0 +1,197 @@
+package dev.deviceai.llm.engine
+
+import dev.deviceai.llm.rag.EmbeddingConfig
+import dev.deviceai.llm.rag.HnswConfig
+import dev.deviceai.llm.rag.IngestConfig
+import dev.deviceai.llm.rag.IngestStats
+import dev.deviceai.llm.rag.RagChunk
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import java.nio.FloatBuffer
+
+/**
+ * JNI bindings for the native RAG indexes and embedding models, shared by
+ * Android and JVM desktop.
+ * Lives in the same native library as [LlmJniEngine].
+ */
+internal object RagJniEngine {
+
+    init {
+        System.loadLibrary("deviceai_llm_jni")
+    }
+
+    fun bm25Create(k1: Float, b: Float): Long = nativeBm25Create(k1, b)
+
+    fun bm25Load(path: String): Long = nativeBm25Load(path)
+
+    fun bm25Free(index: Long) {
+        if (index != 0L) nativeBm25Free(index)
+    }
+
+    fun bm25Add(index: Long, texts: List<String>, sources: List<String?>): LongArray =
+        nativeBm25Add(
+            index,
+            texts.toTypedArray(),
+            if (sources.isEmpty()) null else Array(texts.size) { sources.getOrNull(it) }
+        )
+
+    fun bm25Remove(index: Long, id: Long): Boolean = nativeBm25Remove(index, id)
+
+    fun bm25Size(index: Long): Int = nativeBm25Size(index)
+
+    fun bm25Save(index: Long, path: String): Boolean = nativeBm25Save(index, path)
+
+    fun bm25Search(index: Long, query: String, topK: Int): List<RagChunk> {
+        if (topK <= 0) return emptyList()
+        val scores = FloatArray(topK)
+        return chunks(nativeBm25Search(index, query, topK, scores) ?: return emptyList(), scores)
+    }
+
+    fun hnswCreate(dim: Int, config: HnswConfig): Long = nativeHnswCreate(
+        dim, config.m, config.efConstruction, config.efSearch, config.quantize, config.buildThreads
+    )
+
+    fun hnswLoad(path: String): Long = nativeHnswLoad(path)
+
+    fun hnswFree(index: Long) {
+        if (index != 0L) nativeHnswFree(index)
+    }
+
+    fun hnswDim(index: Long): Int = nativeHnswDim(index)
+
+    fun hnswAdd(index: Long, vectors: FloatArray, texts: List<String>, sources: List<String?>): LongArray =
+        nativeHnswAdd(
+            index,
+            vectors,
+            texts.toTypedArray(),
+            if (sources.isEmpty()) null else Array(texts.size) { sources.getOrNull(it) }
+        )
+
+    fun hnswRemove(index: Long, id: Long): Boolean = nativeHnswRemove(index, id)
+
+    fun hnswSize(index: Long): Int = nativeHnswSize(index)
+
+    fun hnswSave(index: Long, path: String): Boolean = nativeHnswSave(index, path)
+
+    fun hnswSearch(index: Long, query: FloatArray, topK: Int, ef: Int): List<RagChunk> {
+        if (topK <= 0) return emptyList()
+        val scores = FloatArray(topK)
+        return chunks(nativeHnswSearch(index, query, topK, ef, scores) ?: return emptyList(), scores)
+    }
+
+    /** Hits from a native search: UTF-8 text and source byte arrays, in pairs. */
+    private fun chunks(strings: Array<ByteArray?>, scores: FloatArray): List<RagChunk> =
+        List(strings.size / 2) { i ->
+            RagChunk(
+                text = strings[2 * i]?.toString(Charsets.UTF_8) ?: "",
+                source = strings[2 * i + 1]?.toString(Charsets.UTF_8),
+                score = scores[i]
+            )
+        }
+
+    fun embedLoad(path: String, config: EmbeddingConfig): Long = nativeEmbedLoad(
+        path, config.maxThreads, config.useGpu, config.batchTokens, config.batchTexts,
+        config.pooling.ordinal, config.normalize, config.contexts
+    )
+
+    fun embedFree(embedder: Long) {
+        if (embedder != 0L) nativeEmbedFree(embedder)
+    }
+
+    fun embedDim(embedder: Long): Int = nativeEmbedDim(embedder)
+
+    fun embed(embedder: Long, texts: List<String>): FloatArray? {
+        val size = texts.size * nativeEmbedDim(embedder)
+        val buffer = ByteBuffer.allocateDirect(size * Float.SIZE_BYTES).order(ByteOrder.nativeOrder()).asFloatBuffer()
+        if (!embedInto(embedder, texts, buffer)) return null
+        return FloatArray(size).also { buffer.get(it) }
+    }
+
+    /** The native side writes the vectors straight into [out]'s memory from index 0. */
+    fun embedInto(embedder: Long, texts: List<String>, out: FloatBuffer): Boolean {
+        require(out.isDirect && out.order() == ByteOrder.nativeOrder()) {
+            "Output must be a direct FloatBuffer in native byte order"
+        }
+        return nativeEmbed(embedder, texts.toTypedArray(), out)
+    }
+
+    fun ingest(
+        paths: List<String>, bm25: Long, embedder: Long, hnsw: Long, config: IngestConfig,
+        bm25Path: String?, hnswPath: String?, onProgress: ((Long, Long) -> Boolean)?,
+    ): IngestStats? {
+        val stats = nativeIngest(
+            paths.toTypedArray(), bm25, embedder, hnsw, config.tokenizerModelPath,
+            config.chunkTokens, config.overlapTokens, config.threads, config.maxBufferedBytes,
+            config.extensions.toTypedArray(), bm25Path, hnswPath,
+            onProgress?.let(::RagIngestProgressInternal)
+        ) ?: return null
+        return IngestStats(
+            files = stats[0], failedFiles = stats[1], bytes = stats[2],
+            chunks = stats[3], tokens = stats[4], cancelled = stats[5] != 0L
+        )
+    }
+
+    // ══════════════════════════════════════════════════════════════
+    //                      NATIVE DECLARATIONS
+    // ══════════════════════════════════════════════════════════════
+
+    private external fun nativeBm25Create(k1: Float, b: Float): Long
+
+    private external fun nativeBm25Load(path: String): Long
+
+    private external fun nativeBm25Free(index: Long)
+
+    private external fun nativeBm25Add(index: Long, texts: Array<String>, sources: Array<String?>?): LongArray
+
+    private external fun nativeBm25Remove(index: Long, id: Long): Boolean
+
+    private external fun nativeBm25Size(index: Long): Int
+
+    private external fun nativeBm25Save(index: Long, path: String): Boolean
+
+    private external fun nativeBm25Search(
+        index: Long, query: String, topK: Int, scores: FloatArray
+    ): Array<ByteArray?>?
+
+    private external fun nativeHnswCreate(
+        dim: Int, m: Int, efConstruction: Int, efSearch: Int, quantize: Boolean, nThreads: Int
+    ): Long
+
+    private external fun nativeHnswLoad(path: String): Long
+
+    private external fun nativeHnswFree(index: Long)
+
+    private external fun nativeHnswDim(index: Long): Int
+
+    private external fun nativeHnswAdd(
+        index: Long, vectors: FloatArray, texts: Array<String>, sources: Array<String?>?
+    ): LongArray
+
+    private external fun nativeHnswRemove(index: Long, id: Long): Boolean
+
+    private external fun nativeHnswSize(index: Long): Int
+
+    private external fun nativeHnswSave(index: Long, path: String): Boolean
+
+    private external fun nativeHnswSearch(
+        index: Long, query: FloatArray, topK: Int, ef: Int, scores: FloatArray
+    ): Array<ByteArray?>?
+
+    private external fun nativeEmbedLoad(
+        path: String, nThreads: Int, useGpu: Boolean,
+        batchTokens: Int, batchTexts: Int, pooling: Int, normalize: Boolean, contexts: Int
+    ): Long
+
+    private external fun nativeEmbedFree(embedder: Long)
+
+    private external fun nativeEmbedDim(embedder: Long): Int
+
+    private external fun nativeEmbed(embedder: Long, texts: Array<String>, out: FloatBuffer): Boolean
+
+    private external fun nativeIngest(
+        paths: Array<String>, bm25: Long, embedder: Long, hnsw: Long, tokenizerPath: String?,
+        chunkTokens: Int, overlapTokens: Int, nThreads: Int, maxBufferedBytes: Long,
+        extensions: Array<String>, bm25Path: String?, hnswPath: String?,
+        progress: RagIngestProgressInternal?
+    ): LongArray?
+}
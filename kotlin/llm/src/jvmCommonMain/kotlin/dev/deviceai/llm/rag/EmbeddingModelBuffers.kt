@@ -0,0 +1,23 @@
+package dev.deviceai.llm.rag
+
+import dev.deviceai.llm.engine.RagJniEngine
+import java.nio.FloatBuffer
+
+/**
+ * Embed [texts] straight into [out], with no intermediate [FloatArray]. Use this to
+ * hand vectors to an index or file without copying them through the Java heap.
+ *
+ * [out] must be a direct buffer in native byte order with room for
+ * `texts.size * dimension` floats, written row-major from index 0:
+ *
+ * ```kotlin
+ * val out = ByteBuffer.allocateDirect(texts.size * model.dimension * 4)
+ *     .order(ByteOrder.nativeOrder())
+ *     .asFloatBuffer()
+ * model.embedInto(texts, out)
+ * ```
+ *
+ * @return false if native decoding fails or [out] is too small
+ */
+fun EmbeddingModel.embedInto(texts: List<String>, out: FloatBuffer): Boolean =
+    RagJniEngine.embedInto(handle, texts, out)
@@ -0,0 +1,60 @@
+package dev.deviceai.llm.rag
+
+import java.lang.ref.PhantomReference
+import java.lang.ref.ReferenceQueue
+import java.util.concurrent.ConcurrentHashMap
+import java.util.concurrent.atomic.AtomicBoolean
+
+// java.lang.ref.Cleaner needs Android API 33, so this is the same mechanism by
+// hand: a phantom reference per handle and one daemon thread draining the queue.
+internal actual class NativeHandle actual constructor(pointer: Long, free: (Long) -> Unit) {
+
+    private val state = State(pointer, free)
+    private val ref = Cleanup(this, state).also { Cleaner.live.add(it) }
+
+    actual val pointer: Long get() = state.pointer
+
+    actual fun <R> withPointer(block: (Long) -> R): R {
+        try {
+            return block(state.pointer)
+        } finally {
+            synchronized(this) {}   // reachability fence; Reference.reachabilityFence needs API 28
+        }
+    }
+
+    actual fun close() {
+        Cleaner.live.remove(ref)
+        state.free()
+    }
+
+    private class State(val pointer: Long, private val free: (Long) -> Unit) {
+        private val freed = AtomicBoolean(false)
+
+        fun free() {
+            if (freed.compareAndSet(false, true)) free(pointer)
+        }
+    }
+
+    private class Cleanup(owner: NativeHandle, val state: State) :
+        PhantomReference<NativeHandle>(owner, Cleaner.queue)
+
+    private object Cleaner {
+        val queue = ReferenceQueue<NativeHandle>()
+
+        // Keeps each Cleanup reachable until its handle is closed or collected.
+        val live: MutableSet<Cleanup> = ConcurrentHashMap.newKeySet()
+
+        init {
+            Thread({
+                while (true) {
+                    val cleanup = queue.remove() as Cleanup
+                    live.remove(cleanup)
+                    cleanup.state.free()
+                }
+            }, "deviceai-native-cleaner").apply {
+                isDaemon = true
+                start()
+            }
+        }
+    }
+}
@@ -7,16 +7,49 @@ import kotlinx.coroutines.flow.Flow
 @Suppress("EXPECT_ACTUAL_CLASSIFIERS_ARE_IN_BETA_WARNING")
 actual object LlmCppBridge {
     actual fun initLlm(modelPath: String, config: LlmInitConfig) = LlmJniEngine.init(modelPath, config)
-    actual fun shutdown() = LlmJniEngine.shutdown()
-    actual fun generate(messages: List<LlmMessage>, config: LlmGenConfig) =
-        LlmJniEngine.generate(
-            if (config.ragStore != null) RagAugmentor.augment(messages, config) else messages,
-            config,
-        )
-    actual fun generateStream(messages: List<LlmMessage>, config: LlmGenConfig): Flow<String> =
-        LlmJniEngine.generateStream(
-            if (config.ragStore != null) RagAugmentor.augment(messages, config) else messages,
-            config,
-        )
-    actual fun cancelGeneration() = LlmJniEngine.cancelGeneration()
+    actual fun estimateMemory(modelPath: String, config: LlmInitConfig, sessions: Int) =
+        LlmJniEngine.estimateMemory(modelPath, config, sessions)
+    actual fun shutdown(model: Long) = LlmJniEngine.shutdown(model)
+    actual fun createSession(model: Long) = LlmJniEngine.createSession(model)
+    actual fun closeSession(session: Long) = LlmJniEngine.closeSession(session)
+    actual fun warmPrefix(session: Long, messages: List<LlmMessage>, cacheDir: String) =
+        LlmJniEngine.warmPrefix(session, messages, cacheDir)
+    actual fun generate(session: Long, messages: List<LlmMessage>, config: LlmGenConfig): LlmResult {
+        val prompt = RagAugmentor.augment(messages, config)
+        return LlmJniEngine.generate(session, prompt.messages, config, prompt.context)
+    }
+    actual suspend fun generateAsync(
+        session: Long, messages: List<LlmMessage>, config: LlmGenConfig, priority: Int
+    ): LlmResult {
+        val prompt = RagAugmentor.augment(messages, config)
+        return LlmJniEngine.generateAsync(session, prompt.messages, config, priority, prompt.context)
+    }
+    actual fun generateStream(session: Long, messages: List<LlmMessage>, config: LlmGenConfig): Flow<String> {
+        val prompt = RagAugmentor.augment(messages, config)
+        return LlmJniEngine.generateStream(session, prompt.messages, config, prompt.context)
+    }
+    actual fun generateN(
+        session: Long, messages: List<LlmMessage>, count: Int, config: LlmGenConfig, seed: Int?
+    ): NBestResult {
+        val prompt = RagAugmentor.augment(messages, config)
+        return LlmJniEngine.generateN(session, prompt.messages, count, config, seed, prompt.context)
+    }
+    actual fun generateNStream(
+        session: Long, messages: List<LlmMessage>, count: Int, config: LlmGenConfig, seed: Int?
+    ): Flow<CandidateText> {
+        val prompt = RagAugmentor.augment(messages, config)
+        return LlmJniEngine.generateNStream(session, prompt.messages, count, config, seed, prompt.context)
+    }
+    actual fun scoreContinuations(session: Long, messages: List<LlmMessage>, continuations: List<String>) =
+        LlmJniEngine.scoreContinuations(session, messages, continuations)
+    actual fun cancelGeneration(session: Long) = LlmJniEngine.cancelGeneration(session)
+    actual fun speculativeStats(session: Long) = LlmJniEngine.speculativeStats(session)
+    actual fun prefixCacheStats(model: Long) = LlmJniEngine.prefixCacheStats(model)
+    actual fun metricsHistogram(model: Long, reset: Boolean) = LlmJniEngine.metricsHistogram(model, reset)
+    actual fun setThreads(model: Long, config: ThreadConfig) = LlmJniEngine.setThreads(model, config)
+    actual fun threadConfig(model: Long) = LlmJniEngine.threadConfig(model)
+    actual fun autotuneThreads(model: Long, cachePath: String?) = LlmJniEngine.autotuneThreads(model, cachePath)
+    actual fun countTokens(model: Long, texts: List<String>) = LlmJniEngine.countTokens(model, texts)
+    actual fun packContext(model: Long, chunks: List<String>, maxTokens: Int) =
+        LlmJniEngine.packContext(model, chunks, maxTokens)
 }
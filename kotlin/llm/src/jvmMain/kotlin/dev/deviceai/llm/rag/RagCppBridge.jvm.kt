@@ -0,0 +1,35 @@
+package dev.deviceai.llm.rag
+
+import dev.deviceai.llm.engine.RagJniEngine
+
+@Suppress("EXPECT_ACTUAL_CLASSIFIERS_ARE_IN_BETA_WARNING")
+internal actual object RagCppBridge {
+    actual fun bm25Create(k1: Float, b: Float) = RagJniEngine.bm25Create(k1, b)
+    actual fun bm25Load(path: String) = RagJniEngine.bm25Load(path)
+    actual fun bm25Free(index: Long) = RagJniEngine.bm25Free(index)
+    actual fun bm25Add(index: Long, texts: List<String>, sources: List<String?>) =
+        RagJniEngine.bm25Add(index, texts, sources)
+    actual fun bm25Remove(index: Long, id: Long) = RagJniEngine.bm25Remove(index, id)
+    actual fun bm25Size(index: Long) = RagJniEngine.bm25Size(index)
+    actual fun bm25Save(index: Long, path: String) = RagJniEngine.bm25Save(index, path)
+    actual fun bm25Search(index: Long, query: String, topK: Int) = RagJniEngine.bm25Search(index, query, topK)
+    actual fun embedLoad(path: String, config: EmbeddingConfig) = RagJniEngine.embedLoad(path, config)
+    actual fun embedFree(embedder: Long) = RagJniEngine.embedFree(embedder)
+    actual fun embedDim(embedder: Long) = RagJniEngine.embedDim(embedder)
+    actual fun embed(embedder: Long, texts: List<String>) = RagJniEngine.embed(embedder, texts)
+    actual fun hnswCreate(dim: Int, config: HnswConfig) = RagJniEngine.hnswCreate(dim, config)
+    actual fun hnswLoad(path: String) = RagJniEngine.hnswLoad(path)
+    actual fun hnswFree(index: Long) = RagJniEngine.hnswFree(index)
+    actual fun hnswDim(index: Long) = RagJniEngine.hnswDim(index)
+    actual fun hnswAdd(index: Long, vectors: FloatArray, texts: List<String>, sources: List<String?>) =
+        RagJniEngine.hnswAdd(index, vectors, texts, sources)
+    actual fun hnswRemove(index: Long, id: Long) = RagJniEngine.hnswRemove(index, id)
+    actual fun hnswSize(index: Long) = RagJniEngine.hnswSize(index)
+    actual fun hnswSave(index: Long, path: String) = RagJniEngine.hnswSave(index, path)
+    actual fun hnswSearch(index: Long, query: FloatArray, topK: Int, ef: Int) =
+        RagJniEngine.hnswSearch(index, query, topK, ef)
+    actual fun ingest(
+        paths: List<String>, bm25: Long, embedder: Long, hnsw: Long, config: IngestConfig,
+        bm25Path: String?, hnswPath: String?, onProgress: ((Long, Long) -> Boolean)?,
+    ) = RagJniEngine.ingest(paths, bm25, embedder, hnsw, config, bm25Path, hnswPath, onProgress)
+}
@@ -2,6 +2,7 @@ package dev.deviceai
 
 import android.content.Context
 import androidx.compose.runtime.Composable
+import dev.deviceai.core.JobCompletions
 import androidx.compose.ui.platform.LocalContext
 import java.io.File
 
@@ -37,6 +38,15 @@ actual object SpeechBridge {
     actual fun transcribeAudio(samples: FloatArray): String =
         nativeTranscribeAudio(samples)
 
+    actual suspend fun transcribeAudioAsync(samples: FloatArray, priority: Int): String {
+        val job = jobs.run(
+            submit = { nativeSubmitTranscribeAudio(samples, priority) },
+            cancel = { nativeCancelSpeechJob(it, true) }
+        )
+        if (job < 0) return ""
+        return nativeTakeTranscription(job) ?: ""
+    }
+
     actual fun transcribeStream(samples: FloatArray, callback: SttStream) =
         nativeTranscribeStream(samples, callback)
 
@@ -61,6 +71,15 @@ actual object SpeechBridge {
     actual fun synthesize(text: String): ShortArray =
         nativeSynthesize(text)
 
+    actual suspend fun synthesizeAsync(text: String, priority: Int): ShortArray {
+        val job = jobs.run(
+            submit = { nativeSubmitSynthesize(text, priority) },
+            cancel = { nativeCancelSpeechJob(it, true) }
+        )
+        if (job < 0) return shortArrayOf()
+        return nativeTakeSynthesis(job) ?: shortArrayOf()
+    }
+
     actual fun synthesizeToFile(text: String, outputPath: String): Boolean =
         nativeSynthesizeToFile(text, outputPath)
 
@@ -94,6 +113,13 @@ actual object SpeechBridge {
         shutdownTts()
     }
 
+    // ══════════════════════════════════════════════════════════════
+    //                         ASYNC JOBS
+    // ══════════════════════════════════════════════════════════════
+
+    // Both engines' jobs complete through one native channel.
+    private val jobs by lazy { JobCompletions(::nativeAwaitSpeechJobs) }
+
     // ══════════════════════════════════════════════════════════════
     //                    NATIVE DECLARATIONS
     // ══════════════════════════════════════════════════════════════
@@ -113,6 +139,7 @@ actual object SpeechBridge {
     private external fun nativeTranscribe(audioPath: String): String
     private external fun nativeTranscribeDetailed(audioPath: String): TranscriptionResult
     private external fun nativeTranscribeAudio(samples: FloatArray): String
+    private external fun nativeSubmitTranscribeAudio(samples: FloatArray, priority: Int): Long
     private external fun nativeTranscribeStream(samples: FloatArray, callback: SttStream)
     private external fun nativeCancelStt()
     private external fun nativeShutdownStt()
@@ -128,8 +155,15 @@ actual object SpeechBridge {
     ): Boolean
 
     private external fun nativeSynthesize(text: String): ShortArray
+    private external fun nativeSubmitSynthesize(text: String, priority: Int): Long
     private external fun nativeSynthesizeToFile(text: String, outputPath: String): Boolean
     private external fun nativeSynthesizeStream(text: String, callback: TtsStream)
     private external fun nativeCancelTts()
     private external fun nativeShutdownTts()
+
+    // Jobs
+    private external fun nativeCancelSpeechJob(job: Long, discard: Boolean): Boolean
+    private external fun nativeAwaitSpeechJobs(timeoutMs: Int): LongArray?
+    private external fun nativeTakeTranscription(job: Long): String?
+    private external fun nativeTakeSynthesis(job: Long): ShortArray?
 }
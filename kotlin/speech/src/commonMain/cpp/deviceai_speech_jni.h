@@ -38,6 +38,14 @@ Java_dev_deviceai_SpeechBridge_nativeTranscribeAudio(
     JNIEnv *env, jobject thiz,
     jfloatArray samples);
 
+// Queue nativeTranscribeAudio on the STT executor; returns the job id, 0 when
+// the queue is full, -1 when STT is not initialised.
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_SpeechBridge_nativeSubmitTranscribeAudio(
+    JNIEnv *env, jobject thiz,
+    jfloatArray samples,
+    jint priority);
+
 JNIEXPORT void JNICALL
 Java_dev_deviceai_SpeechBridge_nativeTranscribeStream(
     JNIEnv *env, jobject thiz,
@@ -71,6 +79,14 @@ Java_dev_deviceai_SpeechBridge_nativeSynthesize(
     JNIEnv *env, jobject thiz,
     jstring text);
 
+// Queue nativeSynthesize on the TTS executor; returns the job id, 0 when the
+// queue is full, -1 when TTS is not initialised.
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_SpeechBridge_nativeSubmitSynthesize(
+    JNIEnv *env, jobject thiz,
+    jstring text,
+    jint priority);
+
 JNIEXPORT jboolean JNICALL
 Java_dev_deviceai_SpeechBridge_nativeSynthesizeToFile(
     JNIEnv *env, jobject thiz,
@@ -91,6 +107,34 @@ JNIEXPORT void JNICALL
 Java_dev_deviceai_SpeechBridge_nativeShutdownTts(
     JNIEnv *env, jobject thiz);
 
+// ═══════════════════════════════════════════════════════════════
+//                    ASYNC JOBS (STT and TTS)
+// ═══════════════════════════════════════════════════════════════
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_SpeechBridge_nativeCancelSpeechJob(
+    JNIEnv *env, jobject thiz,
+    jlong job,
+    jboolean discard);
+
+// Ids of jobs finished since the last call, or null after timeoutMs.
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_SpeechBridge_nativeAwaitSpeechJobs(
+    JNIEnv *env, jobject thiz,
+    jint timeoutMs);
+
+// Result of a finished transcription job, or null if it is unknown or unfinished.
+JNIEXPORT jstring JNICALL
+Java_dev_deviceai_SpeechBridge_nativeTakeTranscription(
+    JNIEnv *env, jobject thiz,
+    jlong job);
+
+// Result of a finished synthesis job, or null if it is unknown or unfinished.
+JNIEXPORT jshortArray JNICALL
+Java_dev_deviceai_SpeechBridge_nativeTakeSynthesis(
+    JNIEnv *env, jobject thiz,
+    jlong job);
+
 #ifdef __cplusplus
 }
 #endif
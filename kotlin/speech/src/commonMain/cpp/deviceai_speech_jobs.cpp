@@ -0,0 +1,275 @@
+/**
+ * deviceai_speech_jobs.cpp - Asynchronous STT/TTS jobs, and the JNI entry
+ * points shared by both engines to poll, cancel, await and take them.
+ *
+ * Shared between Android and Desktop (JVM) platforms.
+ */
+
+#include "deviceai_speech_jobs.h"
+#include "deviceai_speech_jni.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+// ═══════════════════════════════════════════════════════════════
+//                     PLATFORM-SPECIFIC LOGGING
+// ═══════════════════════════════════════════════════════════════
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOG_TAG "SpeechKMP-Jobs"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO,  LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGI(...) fprintf(stdout, "[SpeechKMP-Jobs INFO] "  __VA_ARGS__); fprintf(stdout, "\n")
+#define LOGE(...) fprintf(stderr, "[SpeechKMP-Jobs ERROR] " __VA_ARGS__); fprintf(stderr, "\n")
+#endif
+
+namespace {
+
+struct job {
+    int64_t  id       = 0;
+    int      priority = 0;
+    uint64_t seq      = 0;   // submission order, for FIFO among equal priorities
+
+    dai_speech_jobs  *owner = nullptr;
+    dai_speech_job_fn run;
+
+    std::atomic<bool> cancel{false};
+
+    // Guarded by g_mutex.
+    bool                  discard = false;
+    dai_speech_job_result result;
+};
+
+using job_ptr = std::shared_ptr<job>;
+
+} // namespace
+
+struct dai_speech_jobs {
+    std::string           name;
+    int                   max_queued = 16;
+    std::function<void()> cancel_running;
+
+    // Guarded by g_mutex.
+    std::condition_variable cv;        // a job was queued or the running one finished
+    std::vector<job_ptr>    queue;
+    job_ptr                 running;
+};
+
+// ═══════════════════════════════════════════════════════════════
+//                        Job registry
+// ═══════════════════════════════════════════════════════════════
+
+static std::mutex                           g_mutex;
+static std::condition_variable              g_done_cv;
+static std::unordered_map<int64_t, job_ptr> g_jobs;
+static std::vector<int64_t>                 g_completed;   // finished since the last wait
+static int64_t                              g_next_id  = 1;
+static uint64_t                             g_next_seq = 0;
+
+// Publish a finished job on the completion channel, or forget it when its
+// caller asked for the result to be discarded. Caller holds g_mutex.
+static void finish(const job_ptr &j, dai_speech_job_state state) {
+    j->result.state = state;
+    if (j->discard) {
+        g_jobs.erase(j->id);
+        return;
+    }
+    g_completed.push_back(j->id);
+    g_done_cv.notify_all();
+}
+
+// Highest-priority, oldest queued job, taken off the queue. Caller holds g_mutex.
+static job_ptr next_job(dai_speech_jobs *jobs) {
+    if (jobs->queue.empty()) return nullptr;
+    auto best = std::min_element(jobs->queue.begin(), jobs->queue.end(),
+                                 [](const job_ptr &a, const job_ptr &b) {
+                                     return a->priority != b->priority ? a->priority > b->priority
+                                                                       : a->seq < b->seq;
+                                 });
+    job_ptr j = *best;
+    jobs->queue.erase(best);
+    return j;
+}
+
+static void worker_loop(dai_speech_jobs *jobs) {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    for (;;) {
+        job_ptr j;
+        jobs->cv.wait(lock, [&] { return (j = next_job(jobs)) != nullptr; });
+
+        j->result.state = DAI_SPEECH_JOB_RUNNING;
+        jobs->running   = j;
+        lock.unlock();
+
+        dai_speech_job_result out;
+        const bool completed = j->run(j->cancel, out);
+
+        lock.lock();
+        jobs->running     = nullptr;
+        j->result.text    = std::move(out.text);
+        j->result.audio   = std::move(out.audio);
+        j->run            = nullptr;
+        finish(j, completed && !j->cancel ? DAI_SPEECH_JOB_DONE : DAI_SPEECH_JOB_CANCELLED);
+        jobs->cv.notify_all();   // dai_speech_jobs_drain may be waiting
+    }
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                            API
+// ═══════════════════════════════════════════════════════════════
+
+dai_speech_jobs *dai_speech_jobs_create(const char *name, int max_queued, std::function<void()> cancel_running) {
+    auto *jobs           = new dai_speech_jobs();
+    jobs->name           = name;
+    jobs->max_queued     = std::max(1, max_queued);
+    jobs->cancel_running = std::move(cancel_running);
+    std::thread(worker_loop, jobs).detach();
+
+    LOGI("%s job executor started (queue=%d)", name, jobs->max_queued);
+    return jobs;
+}
+
+int64_t dai_speech_job_submit(dai_speech_jobs *jobs, dai_speech_job_fn run, int priority) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    if ((int)jobs->queue.size() >= jobs->max_queued) return 0;
+
+    auto j = std::make_shared<job>();
+    j->id           = g_next_id++;
+    j->priority     = priority;
+    j->seq          = g_next_seq++;
+    j->owner        = jobs;
+    j->run          = std::move(run);
+    j->result.state = DAI_SPEECH_JOB_QUEUED;
+
+    g_jobs[j->id] = j;
+    jobs->queue.push_back(j);
+    jobs->cv.notify_all();   // shared with dai_speech_jobs_drain's wait
+    return j->id;
+}
+
+dai_speech_job_state dai_speech_job_poll(int64_t id) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_jobs.find(id);
+    return it == g_jobs.end() ? DAI_SPEECH_JOB_UNKNOWN : it->second->result.state;
+}
+
+// Caller holds g_mutex.
+static void cancel_job(const job_ptr &j) {
+    dai_speech_jobs *jobs = j->owner;
+    if (j->result.state == DAI_SPEECH_JOB_QUEUED) {
+        jobs->queue.erase(std::remove(jobs->queue.begin(), jobs->queue.end(), j), jobs->queue.end());
+        finish(j, DAI_SPEECH_JOB_CANCELLED);
+    } else if (j->result.state == DAI_SPEECH_JOB_RUNNING) {
+        // The flag first: the job checks it after resetting the engine's own
+        // cancel, so the interrupt is not lost if it lands before the inference.
+        j->cancel = true;
+        jobs->cancel_running();
+    }
+}
+
+bool dai_speech_job_cancel(int64_t id, bool discard) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_jobs.find(id);
+    if (it == g_jobs.end()) return false;
+    job_ptr j = it->second;
+
+    const dai_speech_job_state state = j->result.state;
+    if (state == DAI_SPEECH_JOB_QUEUED || state == DAI_SPEECH_JOB_RUNNING) {
+        j->discard = discard;
+        cancel_job(j);
+    } else if (discard) {
+        // Finished and waiting to be taken.
+        g_jobs.erase(it);
+        g_completed.erase(std::remove(g_completed.begin(), g_completed.end(), id), g_completed.end());
+    }
+    return true;
+}
+
+bool dai_speech_jobs_wait(std::vector<int64_t> &ids, int timeout_ms) {
+    ids.clear();
+    std::unique_lock<std::mutex> lock(g_mutex);
+    auto ready = [] { return !g_completed.empty(); };
+    if (timeout_ms < 0) g_done_cv.wait(lock, ready);
+    else if (!g_done_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready)) return false;
+    ids.swap(g_completed);
+    return true;
+}
+
+bool dai_speech_job_take(int64_t id, dai_speech_job_result &out) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    auto it = g_jobs.find(id);
+    if (it == g_jobs.end()) return false;
+
+    const dai_speech_job_state state = it->second->result.state;
+    if (state != DAI_SPEECH_JOB_DONE && state != DAI_SPEECH_JOB_CANCELLED) return false;
+    out = std::move(it->second->result);
+    g_jobs.erase(it);
+    return true;
+}
+
+void dai_speech_jobs_drain(dai_speech_jobs *jobs) {
+    if (!jobs) return;
+    std::unique_lock<std::mutex> lock(g_mutex);
+    for (const job_ptr &j : std::vector<job_ptr>(jobs->queue)) cancel_job(j);
+    if (jobs->running) cancel_job(jobs->running);
+    jobs->cv.wait(lock, [jobs] { return jobs->running == nullptr; });
+}
+
+// ═══════════════════════════════════════════════════════════════
+//                          JNI API
+// ═══════════════════════════════════════════════════════════════
+
+JNIEXPORT jboolean JNICALL
+Java_dev_deviceai_SpeechBridge_nativeCancelSpeechJob(
+    JNIEnv * /*env*/, jobject /*thiz*/,
+    jlong job, jboolean discard) {
+    return dai_speech_job_cancel((int64_t)job, discard == JNI_TRUE) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jlongArray JNICALL
+Java_dev_deviceai_SpeechBridge_nativeAwaitSpeechJobs(
+    JNIEnv *env, jobject /*thiz*/,
+    jint timeoutMs) {
+
+    std::vector<int64_t> ids;
+    if (!dai_speech_jobs_wait(ids, (int)timeoutMs)) return nullptr;
+
+    std::vector<jlong> out(ids.begin(), ids.end());
+    jlongArray result = env->NewLongArray((jsize)out.size());
+    if (result) env->SetLongArrayRegion(result, 0, (jsize)out.size(), out.data());
+    return result;
+}
+
+JNIEXPORT jstring JNICALL
+Java_dev_deviceai_SpeechBridge_nativeTakeTranscription(
+    JNIEnv *env, jobject /*thiz*/,
+    jlong job) {
+
+    dai_speech_job_result result;
+    if (!dai_speech_job_take((int64_t)job, result)) return nullptr;
+    return env->NewStringUTF(result.text.c_str());
+}
+
+JNIEXPORT jshortArray JNICALL
+Java_dev_deviceai_SpeechBridge_nativeTakeSynthesis(
+    JNIEnv *env, jobject /*thiz*/,
+    jlong job) {
+
+    dai_speech_job_result result;
+    if (!dai_speech_job_take((int64_t)job, result)) return nullptr;
+
+    jshortArray out = env->NewShortArray((jsize)result.audio.size());
+    if (out) {
+        env->SetShortArrayRegion(out, 0, (jsize)result.audio.size(),
+                                 reinterpret_cast<const jshort *>(result.audio.data()));
+    }
+    return out;
+}
@@ -0,0 +1,80 @@
+#ifndef DEVICEAI_SPEECH_JOBS_H
+#define DEVICEAI_SPEECH_JOBS_H
+
+/**
+ * deviceai_speech_jobs.h - Asynchronous STT/TTS jobs
+ *
+ * nativeTranscribeAudio and nativeSynthesize hold their caller for the whole
+ * inference, plus however long it waits for the engine mutex. The submit
+ * variants queue the request on the engine's executor and return a job id at
+ * once; the result is collected after the job shows up on the completion
+ * channel (same submit / poll / wait / take / cancel protocol as the LLM jobs).
+ *
+ * Each engine owns one executor: a single worker, since an engine runs one
+ * inference at a time, serving a bounded queue. Higher priorities run first,
+ * FIFO among equals. Both engines share one completion channel.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct dai_speech_jobs;
+
+enum dai_speech_job_state {
+    DAI_SPEECH_JOB_UNKNOWN   = 0,   // never submitted, already taken, or discarded
+    DAI_SPEECH_JOB_QUEUED    = 1,
+    DAI_SPEECH_JOB_RUNNING   = 2,
+    DAI_SPEECH_JOB_DONE      = 3,
+    DAI_SPEECH_JOB_CANCELLED = 4,
+};
+
+struct dai_speech_job_result {
+    dai_speech_job_state state = DAI_SPEECH_JOB_UNKNOWN;
+    std::string          text;    // STT
+    std::vector<int16_t> audio;   // TTS
+};
+
+/**
+ * The work of one job. cancel is set when the job is cancelled while running;
+ * returns false if the inference was cancelled.
+ */
+using dai_speech_job_fn = std::function<bool(const std::atomic<bool> &cancel, dai_speech_job_result &out)>;
+
+/**
+ * Start an executor. cancel_running interrupts the engine's current
+ * inference (the engine's own cancel). Executors live for the process.
+ */
+dai_speech_jobs *dai_speech_jobs_create(const char *name, int max_queued, std::function<void()> cancel_running);
+
+/** Queue run; returns the job id (> 0), or 0 when the queue is full. */
+int64_t dai_speech_job_submit(dai_speech_jobs *jobs, dai_speech_job_fn run, int priority = 0);
+
+dai_speech_job_state dai_speech_job_poll(int64_t id);
+
+/**
+ * Cancel a job: a queued one never runs, a running one is interrupted. It
+ * completes as DAI_SPEECH_JOB_CANCELLED, or with discard is dropped and left
+ * off the completion channel. False if the job is unknown.
+ */
+bool dai_speech_job_cancel(int64_t id, bool discard = false);
+
+/**
+ * Move the ids of jobs finished since the last call into ids (cleared first),
+ * waiting up to timeout_ms for the first one (< 0 waits indefinitely).
+ * Returns false on timeout.
+ */
+bool dai_speech_jobs_wait(std::vector<int64_t> &ids, int timeout_ms);
+
+/** Remove a finished (done or cancelled) job and hand over its result. */
+bool dai_speech_job_take(int64_t id, dai_speech_job_result &out);
+
+/**
+ * Cancel every queued and running job of the executor and wait for the
+ * running one to return, so the engine can be shut down.
+ */
+void dai_speech_jobs_drain(dai_speech_jobs *jobs);
+
+#endif // DEVICEAI_SPEECH_JOBS_H
@@ -9,6 +9,7 @@
  */
 
 #include "deviceai_speech_jni.h"
+#include "deviceai_speech_jobs.h"
 
 #include <string>
 #include <vector>
@@ -17,6 +18,7 @@
 #include <fstream>
 #include <cstring>
 #include <memory>
+#include <chrono>
 
 // ═══════════════════════════════════════════════════════════════
 //                     PLATFORM-SPECIFIC LOGGING
@@ -45,8 +47,44 @@
 static const SherpaOnnxOfflineTts *g_tts = nullptr;
 static std::mutex                  g_mutex;
 static std::atomic<bool>           g_cancel_requested{false};
+static std::atomic<long>           g_cancel_at_ms{0};   // now_ms() of the last cancel
 static int                         g_speaker_id = 0;
 
+// Executor for nativeSubmitSynthesize, created by the first initTts.
+static std::atomic<dai_speech_jobs *> g_jobs{nullptr};
+static constexpr int JOB_QUEUE_DEPTH = 16;
+
+static inline long now_ms() {
+    using namespace std::chrono;
+    return (long)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// sherpa-onnx calls this after each batch of config.max_num_sentences
+// sentences; returning 0 stops generation, so a cancel lands at the next
+// batch boundary instead of after the whole text.
+static int32_t tts_progress(const float * /*samples*/, int32_t /*n*/, float /*progress*/, void * /*arg*/) {
+    return g_cancel_requested.load(std::memory_order_relaxed) ? 0 : 1;
+}
+
+static const SherpaOnnxGeneratedAudio *tts_generate(const char *text) {
+    return SherpaOnnxOfflineTtsGenerateWithProgressCallbackWithArg(g_tts, text, g_speaker_id, 1.0f,
+                                                                  tts_progress, nullptr);
+}
+
+// nativeCancelTts, and the executor's interrupt for a running job.
+static void tts_request_cancel() {
+    g_cancel_at_ms     = now_ms();
+    g_cancel_requested = true;
+}
+
+// True when the synthesis that just returned was cancelled; logs how long the
+// cancel took to land.
+static bool tts_cancelled() {
+    if (!g_cancel_requested) return false;
+    LOGI("[LATENCY] cancel → return: %ld ms", now_ms() - g_cancel_at_ms.load());
+    return true;
+}
+
 static std::string jstring_to_string(JNIEnv *env, jstring jstr) {
     if (jstr == nullptr) return "";
     const char *chars = env->GetStringUTFChars(jstr, nullptr);
@@ -104,6 +142,55 @@ static bool write_wav_file(const std::string &path,
     return true;
 }
 
+// Synthesize text with the loaded voice as 16-bit PCM. Empty when not
+// initialised, synthesis fails or it is cancelled; *cancelled tells the last
+// case apart. job_cancel is an async job's own cancel flag, checked once the
+// engine is held so a cancel landing before the synthesis is not lost.
+static std::vector<int16_t> synthesize_pcm(const std::string &input,
+                                           const std::atomic<bool> *job_cancel = nullptr,
+                                           bool *cancelled = nullptr) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    if (!g_tts) {
+        LOGE("TTS not initialized");
+        return {};
+    }
+
+    g_cancel_requested = false;
+    if (job_cancel && *job_cancel) {
+        if (cancelled) *cancelled = true;
+        return {};
+    }
+
+    LOGD("Synthesizing: %s", input.c_str());
+
+    const SherpaOnnxGeneratedAudio *audio = tts_generate(input.c_str());
+
+    if (tts_cancelled() || !audio || audio->n == 0) {
+        if (g_cancel_requested) {
+            if (cancelled) *cancelled = true;
+        } else {
+            LOGE("Synthesis produced no audio");
+        }
+        if (audio) SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
+        return {};
+    }
+
+    LOGD("Synthesized %d samples", audio->n);
+
+    // Convert float → int16
+    std::vector<int16_t> pcm(audio->n);
+    for (int i = 0; i < audio->n; ++i) {
+        float v = audio->samples[i];
+        if (v >  1.0f) v =  1.0f;
+        if (v < -1.0f) v = -1.0f;
+        pcm[i] = static_cast<int16_t>(v * 32767.0f);
+    }
+
+    SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
+    return pcm;
+}
+
 JNIEXPORT jboolean JNICALL
 Java_dev_deviceai_SpeechBridge_nativeInitTts(
     JNIEnv *env, jobject /*thiz*/,
@@ -165,6 +252,8 @@ Java_dev_deviceai_SpeechBridge_nativeInitTts(
     }
 
     g_speaker_id = speakerId;
+    if (!g_jobs.load()) g_jobs = dai_speech_jobs_create("TTS", JOB_QUEUE_DEPTH, tts_request_cancel);
+
     LOGI("TTS initialized, sample_rate=%d, speaker_id=%d", SherpaOnnxOfflineTtsSampleRate(g_tts), g_speaker_id);
     return JNI_TRUE;
 }
@@ -174,42 +263,33 @@ Java_dev_deviceai_SpeechBridge_nativeSynthesize(
     JNIEnv *env, jobject /*thiz*/,
     jstring text) {
 
-    std::lock_guard<std::mutex> lock(g_mutex);
-
-    if (!g_tts) {
-        LOGE("TTS not initialized");
-        return env->NewShortArray(0);
-    }
-
-    g_cancel_requested = false;
+    std::vector<int16_t> pcm = synthesize_pcm(jstring_to_string(env, text));
 
-    std::string input = jstring_to_string(env, text);
-    LOGD("Synthesizing: %s", input.c_str());
-
-    const SherpaOnnxGeneratedAudio *audio =
-        SherpaOnnxOfflineTtsGenerate(g_tts, input.c_str(), g_speaker_id, 1.0f);
-
-    if (!audio || audio->n == 0) {
-        LOGE("Synthesis produced no audio");
-        if (audio) SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
-        return env->NewShortArray(0);
+    jshortArray result = env->NewShortArray((jsize)pcm.size());
+    if (result) {
+        env->SetShortArrayRegion(result, 0, (jsize)pcm.size(), reinterpret_cast<const jshort *>(pcm.data()));
     }
+    return result;
+}
 
-    LOGD("Synthesized %d samples", audio->n);
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_SpeechBridge_nativeSubmitSynthesize(
+    JNIEnv *env, jobject /*thiz*/,
+    jstring text,
+    jint priority) {
 
-    // Convert float → int16
-    jshortArray result = env->NewShortArray(audio->n);
-    std::vector<jshort> shorts(audio->n);
-    for (int i = 0; i < audio->n; ++i) {
-        float v = audio->samples[i];
-        if (v >  1.0f) v =  1.0f;
-        if (v < -1.0f) v = -1.0f;
-        shorts[i] = static_cast<jshort>(v * 32767.0f);
+    dai_speech_jobs *jobs = g_jobs.load();
+    if (!jobs) {
+        LOGE("TTS not initialized");
+        return -1;
     }
-    env->SetShortArrayRegion(result, 0, audio->n, shorts.data());
 
-    SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
-    return result;
+    std::string input = jstring_to_string(env, text);
+    return dai_speech_job_submit(jobs, [input](const std::atomic<bool> &cancel, dai_speech_job_result &out) {
+        bool cancelled = false;
+        out.audio = synthesize_pcm(input, &cancel, &cancelled);
+        return !cancelled;
+    }, (int)priority);
 }
 
 JNIEXPORT jboolean JNICALL
@@ -232,11 +312,10 @@ Java_dev_deviceai_SpeechBridge_nativeSynthesizeToFile(
 
     LOGD("Synthesizing to file: %s", path.c_str());
 
-    const SherpaOnnxGeneratedAudio *audio =
-        SherpaOnnxOfflineTtsGenerate(g_tts, input.c_str(), g_speaker_id, 1.0f);
+    const SherpaOnnxGeneratedAudio *audio = tts_generate(input.c_str());
 
-    if (!audio || audio->n == 0) {
-        LOGE("Synthesis produced no audio");
+    if (tts_cancelled() || !audio || audio->n == 0) {
+        if (!g_cancel_requested) LOGE("Synthesis produced no audio");
         if (audio) SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
         return JNI_FALSE;
     }
@@ -290,10 +369,9 @@ Java_dev_deviceai_SpeechBridge_nativeSynthesizeStream(
             tts_initialized = true;
             g_cancel_requested = false;
 
-            const SherpaOnnxGeneratedAudio *audio =
-                SherpaOnnxOfflineTtsGenerate(g_tts, input.c_str(), g_speaker_id, 1.0f);
+            const SherpaOnnxGeneratedAudio *audio = tts_generate(input.c_str());
 
-            was_cancelled = g_cancel_requested.load();
+            was_cancelled = tts_cancelled();
             if (!audio || audio->n == 0 || was_cancelled) {
                 cancelled_or_empty = true;
                 if (audio) SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
@@ -347,13 +425,16 @@ Java_dev_deviceai_SpeechBridge_nativeCancelTts(
     JNIEnv * /*env*/, jobject /*thiz*/) {
 
     LOGI("Cancel TTS requested");
-    g_cancel_requested = true;
+    tts_request_cancel();
 }
 
 JNIEXPORT void JNICALL
 Java_dev_deviceai_SpeechBridge_nativeShutdownTts(
     JNIEnv * /*env*/, jobject /*thiz*/) {
 
+    // Pending jobs complete as cancelled; the running one needs g_mutex to return.
+    dai_speech_jobs_drain(g_jobs.load());
+
     std::lock_guard<std::mutex> lock(g_mutex);
 
     if (g_tts) {
@@ -390,6 +471,12 @@ Java_dev_deviceai_SpeechBridge_nativeSynthesize(
     return env->NewShortArray(0);
 }
 
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_SpeechBridge_nativeSubmitSynthesize(
+    JNIEnv * /*env*/, jobject /*thiz*/, jstring /*text*/, jint /*priority*/) {
+    return -1;
+}
+
 JNIEXPORT jboolean JNICALL
 Java_dev_deviceai_SpeechBridge_nativeSynthesizeToFile(
     JNIEnv * /*env*/, jobject /*thiz*/,
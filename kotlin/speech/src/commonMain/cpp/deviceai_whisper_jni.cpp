@@ -5,6 +5,7 @@
  */
 
 #include "deviceai_speech_jni.h"
+#include "deviceai_speech_jobs.h"
 #include "whisper.h"
 
 #include <string>
@@ -14,6 +15,7 @@
 #include <mutex>
 #include <cstring>
 #include <fstream>
+#include <memory>
 #include <sstream>
 #include <chrono>
 
@@ -50,6 +52,11 @@ static struct whisper_context *g_ctx = nullptr;
 static struct whisper_full_params g_params;
 static std::mutex g_mutex;
 static std::atomic<bool> g_cancel_requested{false};
+static std::atomic<long> g_cancel_at_ms{0};     // now_ms() of the last cancel
+
+// Executor for nativeSubmitTranscribeAudio, created by the first initStt.
+static std::atomic<dai_speech_jobs *> g_jobs{nullptr};
+static constexpr int JOB_QUEUE_DEPTH = 16;
 
 // Configuration — all writes happen inside the mutex (initStt).
 // Reads from transcription functions are also mutex-protected.
@@ -213,6 +220,33 @@ static bool vad_trim(std::vector<float> &audio) {
     return true;
 }
 
+// ── Cancellation ──────────────────────────────────────────────────
+// whisper polls these during inference: abort_callback between graph nodes
+// of the encoder and decoder, encoder_begin_callback before each window.
+// A cancel therefore ends whisper_full_with_state within one graph compute
+// instead of after the whole transcription.
+static bool stt_abort(void * /*user*/) {
+    return g_cancel_requested.load(std::memory_order_relaxed);
+}
+
+static bool stt_encoder_begin(struct whisper_context * /*ctx*/, struct whisper_state * /*state*/, void * /*user*/) {
+    return !g_cancel_requested.load(std::memory_order_relaxed);
+}
+
+// nativeCancelStt, and the executor's interrupt for a running job.
+static void stt_request_cancel() {
+    g_cancel_at_ms     = now_ms();
+    g_cancel_requested = true;
+}
+
+// True when the inference that just returned was cancelled; logs how long the
+// cancel took to land.
+static bool stt_cancelled() {
+    if (!g_cancel_requested) return false;
+    LOGI("[LATENCY] cancel → return: %ld ms", now_ms() - g_cancel_at_ms.load());
+    return true;
+}
+
 // Helper: call onError callback and delete the message local ref.
 static void call_on_error(JNIEnv *env, jobject callback, jmethodID onError, const char *msg) {
     jstring s = env->NewStringUTF(msg);
@@ -220,6 +254,93 @@ static void call_on_error(JNIEnv *env, jobject callback, jmethodID onError, cons
     env->DeleteLocalRef(s);
 }
 
+// Helper: copy a Java float array out of the JVM heap.
+static std::vector<float> copy_samples(JNIEnv *env, jfloatArray samples) {
+    long t_start = now_ms();
+
+    jsize len    = env->GetArrayLength(samples);
+    jfloat *data = env->GetFloatArrayElements(samples, nullptr);
+    std::vector<float> audio(data, data + len);
+    env->ReleaseFloatArrayElements(samples, data, 0);
+
+    LOGI("[LATENCY] JNI copy: %ld ms  (%d samples = %.2f s)",
+         now_ms() - t_start, (int)audio.size(), (float)audio.size() / WHISPER_SAMPLE_RATE);
+    return audio;
+}
+
+// Transcribe 16 kHz mono samples with the loaded model: VAD trim, one
+// whisper_full pass, segment texts joined. Empty when not initialised, no
+// speech is found, inference fails or it is cancelled; *cancelled tells the
+// last case apart. job_cancel is an async job's own cancel flag, checked once
+// the engine is held so a cancel landing before the inference is not lost.
+static std::string transcribe_pcm(std::vector<float> audio,
+                                  const std::atomic<bool> *job_cancel = nullptr,
+                                  bool *cancelled = nullptr) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+
+    if (g_ctx == nullptr) {
+        LOGE("Whisper not initialized");
+        return "";
+    }
+
+    g_cancel_requested = false;
+    if (job_cancel && *job_cancel) {
+        if (cancelled) *cancelled = true;
+        return "";
+    }
+
+    float audio_sec = (float)audio.size() / WHISPER_SAMPLE_RATE;
+
+    // ── VAD ────────────────────────────────────────────────────────
+    if (g_use_vad) {
+        if (!vad_trim(audio)) {
+            LOGI("[VAD] no speech detected — skipping transcription");
+            return "";
+        }
+        audio_sec = (float)audio.size() / WHISPER_SAMPLE_RATE;
+    }
+
+    // ── Inference ──────────────────────────────────────────────────
+    std::string lang = g_language;
+    struct whisper_full_params params = make_params(lang, audio_sec);
+
+    LOGI("[WHISPER-CFG] audio_ctx=full max_tokens=%d (%.2fs after VAD)",
+         params.max_tokens, audio_sec);
+
+    struct whisper_state *state = whisper_init_state(g_ctx);
+    if (!state) {
+        LOGE("Failed to allocate whisper state");
+        return "";
+    }
+
+    long t_infer_start = now_ms();
+    const int rc = whisper_full_with_state(g_ctx, state, params, audio.data(), (int)audio.size());
+    if (stt_cancelled()) {
+        whisper_free_state(state);
+        if (cancelled) *cancelled = true;
+        return "";
+    }
+    if (rc != 0) {
+        whisper_free_state(state);
+        LOGE("Whisper inference failed");
+        return "";
+    }
+    long t_infer_done = now_ms();
+
+    LOGI("[LATENCY] whisper_full: %ld ms  (RTF=%.2fx)",
+         t_infer_done - t_infer_start,
+         (float)(t_infer_done - t_infer_start) / (audio_sec * 1000.0f));
+
+    std::string result;
+    int n_segments = whisper_full_n_segments_from_state(state);
+    for (int i = 0; i < n_segments; i++) {
+        const char *text = whisper_full_get_segment_text_from_state(state, i);
+        if (text) result += text;
+    }
+    whisper_free_state(state);
+    return result;
+}
+
 // ═══════════════════════════════════════════════════════════════
 //                        JNI FUNCTIONS
 // ═══════════════════════════════════════════════════════════════
@@ -278,6 +399,12 @@ Java_dev_deviceai_SpeechBridge_nativeInitStt(
     g_params.print_timestamps = false;
     g_params.single_segment  = g_single_segment;
     g_params.no_context      = g_no_context;
+    g_params.abort_callback                   = stt_abort;
+    g_params.abort_callback_user_data         = nullptr;
+    g_params.encoder_begin_callback           = stt_encoder_begin;
+    g_params.encoder_begin_callback_user_data = nullptr;
+
+    if (!g_jobs.load()) g_jobs = dai_speech_jobs_create("STT", JOB_QUEUE_DEPTH, stt_request_cancel);
 
     LOGI("Whisper model initialized successfully");
     return JNI_TRUE;
@@ -319,7 +446,12 @@ Java_dev_deviceai_SpeechBridge_nativeTranscribe(
         return env->NewStringUTF("");
     }
 
-    if (whisper_full_with_state(g_ctx, state, params, samples_16k.data(), (int)samples_16k.size()) != 0) {
+    const int rc = whisper_full_with_state(g_ctx, state, params, samples_16k.data(), (int)samples_16k.size());
+    if (stt_cancelled()) {
+        whisper_free_state(state);
+        return env->NewStringUTF("");
+    }
+    if (rc != 0) {
         whisper_free_state(state);
         LOGE("Whisper inference failed");
         return env->NewStringUTF("");
@@ -406,7 +538,12 @@ Java_dev_deviceai_SpeechBridge_nativeTranscribeDetailed(
         return make_empty();
     }
 
-    if (whisper_full_with_state(g_ctx, state, params, samples_16k.data(), (int)samples_16k.size()) != 0) {
+    const int rc = whisper_full_with_state(g_ctx, state, params, samples_16k.data(), (int)samples_16k.size());
+    if (stt_cancelled()) {
+        whisper_free_state(state);
+        return make_empty();
+    }
+    if (rc != 0) {
         whisper_free_state(state);
         LOGE("Whisper inference failed");
         return make_empty();
@@ -455,71 +592,32 @@ Java_dev_deviceai_SpeechBridge_nativeTranscribeAudio(
     JNIEnv *env, jobject /*thiz*/,
     jfloatArray samples) {
 
-    std::lock_guard<std::mutex> lock(g_mutex);
-
-    if (g_ctx == nullptr) {
-        LOGE("Whisper not initialized");
-        return env->NewStringUTF("");
-    }
-
-    g_cancel_requested = false;
-
     long t_jni_start = now_ms();
 
-    jsize len    = env->GetArrayLength(samples);
-    jfloat *data = env->GetFloatArrayElements(samples, nullptr);
-    std::vector<float> audio(data, data + len);
-    env->ReleaseFloatArrayElements(samples, data, 0);
+    std::string result = transcribe_pcm(copy_samples(env, samples));
 
-    long t_copy_done = now_ms();
-    float audio_sec  = (float)audio.size() / WHISPER_SAMPLE_RATE;
-    LOGI("[LATENCY] JNI copy: %ld ms  (%d samples = %.2f s)",
-         t_copy_done - t_jni_start, (int)audio.size(), audio_sec);
-
-    // ── VAD ────────────────────────────────────────────────────────
-    if (g_use_vad) {
-        if (!vad_trim(audio)) {
-            LOGI("[VAD] no speech detected — skipping transcription");
-            return env->NewStringUTF("");
-        }
-        audio_sec = (float)audio.size() / WHISPER_SAMPLE_RATE;
-    }
-
-    // ── Inference ──────────────────────────────────────────────────
-    std::string lang = g_language;
-    struct whisper_full_params params = make_params(lang, audio_sec);
-
-    LOGI("[WHISPER-CFG] audio_ctx=full max_tokens=%d (%.2fs after VAD)",
-         params.max_tokens, audio_sec);
-
-    struct whisper_state *state = whisper_init_state(g_ctx);
-    if (!state) {
-        LOGE("Failed to allocate whisper state");
-        return env->NewStringUTF("");
-    }
-
-    long t_infer_start = now_ms();
-    if (whisper_full_with_state(g_ctx, state, params, audio.data(), (int)audio.size()) != 0) {
-        whisper_free_state(state);
-        LOGE("Whisper inference failed");
-        return env->NewStringUTF("");
-    }
-    long t_infer_done = now_ms();
+    LOGI("[LATENCY] total: %ld ms", now_ms() - t_jni_start);
+    return env->NewStringUTF(result.c_str());
+}
 
-    LOGI("[LATENCY] whisper_full: %ld ms  (RTF=%.2fx)",
-         t_infer_done - t_infer_start,
-         (float)(t_infer_done - t_infer_start) / (audio_sec * 1000.0f));
+JNIEXPORT jlong JNICALL
+Java_dev_deviceai_SpeechBridge_nativeSubmitTranscribeAudio(
+    JNIEnv *env, jobject /*thiz*/,
+    jfloatArray samples,
+    jint priority) {
 
-    std::string result;
-    int n_segments = whisper_full_n_segments_from_state(state);
-    for (int i = 0; i < n_segments; i++) {
-        const char *text = whisper_full_get_segment_text_from_state(state, i);
-        if (text) result += text;
+    dai_speech_jobs *jobs = g_jobs.load();
+    if (!jobs) {
+        LOGE("Whisper not initialized");
+        return -1;
     }
-    whisper_free_state(state);
 
-    LOGI("[LATENCY] total: %ld ms", now_ms() - t_jni_start);
-    return env->NewStringUTF(result.c_str());
+    auto audio = std::make_shared<std::vector<float>>(copy_samples(env, samples));
+    return dai_speech_job_submit(jobs, [audio](const std::atomic<bool> &cancel, dai_speech_job_result &out) {
+        bool cancelled = false;
+        out.text = transcribe_pcm(std::move(*audio), &cancel, &cancelled);
+        return !cancelled;
+    }, (int)priority);
 }
 
 JNIEXPORT void JNICALL
@@ -629,7 +727,16 @@ Java_dev_deviceai_SpeechBridge_nativeTranscribeStream(
         return;
     }
 
-    if (whisper_full_with_state(g_ctx, state, params, audio.data(), (int)audio.size()) != 0) {
+    const int rc = whisper_full_with_state(g_ctx, state, params, audio.data(), (int)audio.size());
+    if (stt_cancelled()) {
+        // Cancelled streams end without a final result, as before.
+        whisper_free_state(state);
+        env->DeleteLocalRef(resultClass);
+        env->DeleteLocalRef(segmentClass);
+        env->DeleteLocalRef(listClass);
+        return;
+    }
+    if (rc != 0) {
         whisper_free_state(state);
         LOGE("Whisper inference failed");
         call_on_error(env, callback, onError, "Transcription failed");
@@ -699,13 +806,16 @@ Java_dev_deviceai_SpeechBridge_nativeCancelStt(
     JNIEnv * /*env*/, jobject /*thiz*/) {
 
     LOGI("Cancel STT requested");
-    g_cancel_requested = true;
+    stt_request_cancel();
 }
 
 JNIEXPORT void JNICALL
 Java_dev_deviceai_SpeechBridge_nativeShutdownStt(
     JNIEnv * /*env*/, jobject /*thiz*/) {
 
+    // Pending jobs complete as cancelled; the running one needs g_mutex to return.
+    dai_speech_jobs_drain(g_jobs.load());
+
     std::lock_guard<std::mutex> lock(g_mutex);
 
     if (g_ctx != nullptr) {
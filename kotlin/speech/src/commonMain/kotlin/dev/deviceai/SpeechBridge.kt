@@ -42,6 +42,18 @@ expect object SpeechBridge {
      */
     fun transcribeAudio(samples: FloatArray): String
 
+    /**
+     * Transcribe raw PCM audio without blocking a thread: the request is queued
+     * on the native STT executor and the caller suspends until it completes.
+     * Cancelling the coroutine cancels the transcription. On iOS the request
+     * runs on [kotlinx.coroutines.Dispatchers.IO] instead, ignoring [priority].
+     *
+     * @param samples Float array of audio samples (16kHz, mono, normalized -1.0 to 1.0)
+     * @param priority Queued requests with a higher priority run first
+     * @return Transcribed text; empty if STT is not initialised or was cancelled
+     */
+    suspend fun transcribeAudioAsync(samples: FloatArray, priority: Int = 0): String
+
     /**
      * Stream transcription with real-time callbacks.
      *
@@ -86,6 +98,18 @@ expect object SpeechBridge {
      */
     fun synthesize(text: String): ShortArray
 
+    /**
+     * Synthesize text without blocking a thread: the request is queued on the
+     * native TTS executor and the caller suspends until it completes.
+     * Cancelling the coroutine cancels the synthesis. On iOS the request runs
+     * on [kotlinx.coroutines.Dispatchers.IO] instead, ignoring [priority].
+     *
+     * @param text Text to synthesize
+     * @param priority Queued requests with a higher priority run first
+     * @return PCM audio samples (16-bit signed, 22050Hz, mono); empty on failure
+     */
+    suspend fun synthesizeAsync(text: String, priority: Int = 0): ShortArray
+
     /**
      * Synthesize text directly to a WAV file.
      *
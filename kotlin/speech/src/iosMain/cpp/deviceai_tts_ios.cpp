@@ -16,6 +16,7 @@
 #include <memory>
 #include <cstdlib>
 #include <algorithm>
+#include <chrono>
 
 // ═══════════════════════════════════════════════════════════════
 //                           LOGGING
@@ -34,8 +35,34 @@
 static const SherpaOnnxOfflineTts *g_tts = nullptr;
 static std::mutex                  g_mutex;
 static std::atomic<bool>           g_cancel_requested{false};
+static std::atomic<long>           g_cancel_at_ms{0};   // now_ms() of the last cancel
 static int                         g_speaker_id = 0;
 
+static inline long now_ms() {
+    using namespace std::chrono;
+    return (long)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// sherpa-onnx calls this after each batch of config.max_num_sentences
+// sentences; returning 0 stops generation, so a cancel lands at the next
+// batch boundary instead of after the whole text.
+static int32_t tts_progress(const float * /*samples*/, int32_t /*n*/, float /*progress*/, void * /*arg*/) {
+    return g_cancel_requested.load(std::memory_order_relaxed) ? 0 : 1;
+}
+
+static const SherpaOnnxGeneratedAudio *tts_generate(const char *text) {
+    return SherpaOnnxOfflineTtsGenerateWithProgressCallbackWithArg(g_tts, text, g_speaker_id, 1.0f,
+                                                                  tts_progress, nullptr);
+}
+
+// True when the synthesis that just returned was cancelled; logs how long the
+// cancel took to land.
+static bool tts_cancelled() {
+    if (!g_cancel_requested) return false;
+    LOG_DEBUG("Cancel → return: %ld ms", now_ms() - g_cancel_at_ms.load());
+    return true;
+}
+
 // Write mono 16-bit PCM WAV from float samples.
 static bool write_wav_file(const std::string &path,
                            const float *samples, int n_samples,
@@ -144,11 +171,10 @@ int16_t *speech_tts_synthesize(const char *text, int *out_length) {
 
     g_cancel_requested = false;
 
-    const SherpaOnnxGeneratedAudio *audio =
-        SherpaOnnxOfflineTtsGenerate(g_tts, text, g_speaker_id, 1.0f);
+    const SherpaOnnxGeneratedAudio *audio = tts_generate(text);
 
-    if (!audio || audio->n == 0) {
-        LOG_ERROR("Synthesis produced no audio");
+    if (tts_cancelled() || !audio || audio->n == 0) {
+        if (!g_cancel_requested) LOG_ERROR("Synthesis produced no audio");
         if (audio) SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
         *out_length = 0;
         return nullptr;
@@ -183,11 +209,10 @@ bool speech_tts_synthesize_to_file(const char *text, const char *output_path) {
 
     g_cancel_requested = false;
 
-    const SherpaOnnxGeneratedAudio *audio =
-        SherpaOnnxOfflineTtsGenerate(g_tts, text, g_speaker_id, 1.0f);
+    const SherpaOnnxGeneratedAudio *audio = tts_generate(text);
 
-    if (!audio || audio->n == 0) {
-        LOG_ERROR("Synthesis produced no audio");
+    if (tts_cancelled() || !audio || audio->n == 0) {
+        if (!g_cancel_requested) LOG_ERROR("Synthesis produced no audio");
         if (audio) SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
         return false;
     }
@@ -216,10 +241,9 @@ void speech_tts_synthesize_stream(const char *text,
 
     g_cancel_requested = false;
 
-    const SherpaOnnxGeneratedAudio *audio =
-        SherpaOnnxOfflineTtsGenerate(g_tts, text, g_speaker_id, 1.0f);
+    const SherpaOnnxGeneratedAudio *audio = tts_generate(text);
 
-    if (!audio || audio->n == 0 || g_cancel_requested) {
+    if (tts_cancelled() || !audio || audio->n == 0) {
         if (!g_cancel_requested && on_error) on_error("No audio generated", user);
         if (audio) SherpaOnnxDestroyOfflineTtsGeneratedAudio(audio);
         return;
@@ -245,6 +269,7 @@ void speech_tts_synthesize_stream(const char *text,
 }
 
 void speech_tts_cancel(void) {
+    g_cancel_at_ms = now_ms();
     g_cancel_requested = true;
 }
 
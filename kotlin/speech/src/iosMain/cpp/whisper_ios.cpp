@@ -12,6 +12,7 @@
 #include <cstring>
 #include <fstream>
 #include <sstream>
+#include <chrono>
 
 // ═══════════════════════════════════════════════════════════════
 //                          GLOBAL STATE
@@ -21,6 +22,7 @@ static struct whisper_context *g_ctx = nullptr;
 static struct whisper_full_params g_params;
 static std::mutex g_mutex;
 static std::atomic<bool> g_cancel_requested{false};
+static std::atomic<long> g_cancel_at_ms{0};     // now_ms() of the last cancel
 
 // Configuration
 static std::string g_language = "en";
@@ -46,6 +48,28 @@ static bool debug_enabled() {
 //                      HELPER FUNCTIONS
 // ═══════════════════════════════════════════════════════════════
 
+static inline long now_ms() {
+    using namespace std::chrono;
+    return (long)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// whisper polls these during inference (between graph nodes, and before each
+// encoder window), so a cancel ends whisper_full within one graph compute.
+static bool stt_abort(void * /*user*/) {
+    return g_cancel_requested.load(std::memory_order_relaxed);
+}
+
+static bool stt_encoder_begin(struct whisper_context * /*ctx*/, struct whisper_state * /*state*/, void * /*user*/) {
+    return !g_cancel_requested.load(std::memory_order_relaxed);
+}
+
+// True when the inference that just returned was cancelled.
+static bool stt_cancelled() {
+    if (!g_cancel_requested) return false;
+    LOG_DEBUG("Cancel → return: %ld ms", now_ms() - g_cancel_at_ms.load());
+    return true;
+}
+
 static char *strdup_safe(const std::string &str) {
     char *result = static_cast<char*>(malloc(str.size() + 1));
     if (result) {
@@ -201,6 +225,8 @@ bool speech_stt_init(const char *model_path, const char *language,
     g_params.print_progress = false;
     g_params.print_realtime = false;
     g_params.print_timestamps = false;
+    g_params.abort_callback = stt_abort;
+    g_params.encoder_begin_callback = stt_encoder_begin;
 
     LOG_DEBUG("Whisper model initialized successfully");
     return true;
@@ -225,7 +251,9 @@ char *speech_stt_transcribe(const char *audio_path) {
     std::vector<float> samples_16k;
     resample_to_16k(samples, sample_rate, samples_16k);
 
-    if (whisper_full(g_ctx, g_params, samples_16k.data(), samples_16k.size()) != 0) {
+    const int rc = whisper_full(g_ctx, g_params, samples_16k.data(), samples_16k.size());
+    if (stt_cancelled()) return strdup_safe("");
+    if (rc != 0) {
         LOG_ERROR("Whisper inference failed");
         return strdup_safe("");
     }
@@ -261,8 +289,9 @@ char *speech_stt_transcribe_detailed(const char *audio_path) {
     std::vector<float> samples_16k;
     resample_to_16k(samples, sample_rate, samples_16k);
 
-    if (whisper_full(g_ctx, g_params, samples_16k.data(), samples_16k.size()) != 0) {
-        LOG_ERROR("Whisper inference failed");
+    const int rc = whisper_full(g_ctx, g_params, samples_16k.data(), samples_16k.size());
+    if (stt_cancelled() || rc != 0) {
+        if (!g_cancel_requested) LOG_ERROR("Whisper inference failed");
         return strdup_safe("{\"text\":\"\",\"segments\":[],\"language\":\"en\",\"durationMs\":0}");
     }
 
@@ -297,7 +326,9 @@ char *speech_stt_transcribe_audio(const float *samples, int n_samples) {
 
     g_cancel_requested = false;
 
-    if (whisper_full(g_ctx, g_params, samples, n_samples) != 0) {
+    const int rc = whisper_full(g_ctx, g_params, samples, n_samples);
+    if (stt_cancelled()) return strdup_safe("");
+    if (rc != 0) {
         LOG_ERROR("Whisper inference failed");
         return strdup_safe("");
     }
@@ -329,7 +360,12 @@ void speech_stt_transcribe_stream(const float *samples, int n_samples,
 
     g_cancel_requested = false;
 
-    if (whisper_full(g_ctx, g_params, samples, n_samples) != 0) {
+    const int rc = whisper_full(g_ctx, g_params, samples, n_samples);
+    if (stt_cancelled()) {
+        if (on_error) on_error("Cancelled", user);
+        return;
+    }
+    if (rc != 0) {
         if (on_error) on_error("Transcription failed", user);
         return;
     }
@@ -367,6 +403,7 @@ void speech_stt_transcribe_stream(const float *samples, int n_samples,
 }
 
 void speech_stt_cancel(void) {
+    g_cancel_at_ms = now_ms();
     g_cancel_requested = true;
 }
 
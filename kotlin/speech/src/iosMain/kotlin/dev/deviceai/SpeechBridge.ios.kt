@@ -3,6 +3,9 @@ package dev.deviceai
 import androidx.compose.runtime.Composable
 import dev.deviceai.native.*
 import kotlinx.cinterop.*
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.IO
+import kotlinx.coroutines.withContext
 import platform.Foundation.*
 
 /**
@@ -50,6 +53,10 @@ actual object SpeechBridge {
         }
     }
 
+    // The iOS wrapper has no job executor; the blocking call moves off the caller's thread.
+    actual suspend fun transcribeAudioAsync(samples: FloatArray, priority: Int): String =
+        withContext(Dispatchers.IO) { transcribeAudio(samples) }
+
     actual fun transcribeStream(samples: FloatArray, callback: SttStream) {
         memScoped {
             val nativeSamples = allocArray<FloatVar>(samples.size)
@@ -114,6 +121,9 @@ actual object SpeechBridge {
         }
     }
 
+    actual suspend fun synthesizeAsync(text: String, priority: Int): ShortArray =
+        withContext(Dispatchers.IO) { synthesize(text) }
+
     actual fun synthesizeToFile(text: String, outputPath: String): Boolean =
         speech_tts_synthesize_to_file(text, outputPath)
 